@@ -0,0 +1,280 @@
+#ifndef CHOLESKY_FACTORIZATION_H
+#define CHOLESKY_FACTORIZATION_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemm_kernel.h"
+#include "trsm_kernel.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Cholesky factorization A = LL^T of a symmetric positive definite
+// matrix; takes about half the work and memory traffic of LU, needs no
+// pivoting, and once computed solves any number of systems Ax = b in
+// O(n^2) each
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Number of columns factored together as one panel
+	const size_t CHOLESKY_BLOCK_SIZE = 64;
+
+	template <typename DataType>
+	class CholeskyFactorization
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"CholeskyFactorization requires a floating point data type");
+
+	public:
+
+		// Constructor; factors given square matrix, converting its
+		// elements to DataType; only the lower triangle is read, and A is
+		// assumed to be symmetric; throws InvalidDimensions if the matrix
+		// isn't square
+		// If A turns out not to be positive definite, factoring stops at
+		// the first non-positive pivot, see isPositiveDefinite()
+		template <typename MatrixDataType>
+		explicit CholeskyFactorization(const DenseMatrix<MatrixDataType>& A) :
+			CholeskyFactorization(A.view())
+		{ }
+
+		// View version of constructor
+		template <typename ViewDataType>
+		explicit CholeskyFactorization(const MatrixView<ViewDataType>& A) :
+			_factor(A.rows(), A.rows()),
+			_positive_definite(true)
+		{
+			if (!A.isSquare())
+				throw InvalidDimensions();
+
+			// Only the lower triangle is copied
+			MatrixView<DataType> L = _factor.view();
+			for (size_t j = 0; j < A.cols(); ++j)
+			{
+				L.col(j).subView(j, A.rows()).assign(
+					A.col(j).subView(j, A.rows()));
+			}
+
+			factor();
+		}
+
+		// Returns number of rows and columns of the factored matrix
+		size_t size() const
+		{
+			return _factor.rows();
+		}
+
+		// Returns false if a pivot was zero, negative, or not a number,
+		// which happens exactly when A isn't positive definite, up to
+		// rounding; the factorization can then not be used
+		bool isPositiveDefinite() const
+		{
+			return _positive_definite;
+		}
+
+		// Returns the lower triangular factor L as a ColumnMajor matrix
+		// whose upper triangle is zero
+		const DenseMatrix<DataType>& lower() const
+		{
+			return _factor;
+		}
+
+		// Returns the determinant of the factored matrix
+		DataType determinant() const
+		{
+			DataType det = 1;
+			for (size_t k = 0; k < size(); ++k)
+			{
+				det *= _factor.at(k, k) * _factor.at(k, k);
+			}
+			return det;
+		}
+
+		// Returns the solution x of Ax = b; throws SingularMatrix if A
+		// isn't positive definite
+		template <typename VectorDataType>
+		MathVector<DataType> solve(const MathVector<VectorDataType>& b) const
+		{
+			std::vector<DataType> x(b.size());
+			VectorView<DataType> x_view(x.data(), x.size());
+			x_view.assign(b.view());
+
+			solveInPlace(x_view);
+			return MathVector<DataType>(std::move(x));
+		}
+
+		// Returns the solution X of AX = B for every column of B at once;
+		// result is ColumnMajor
+		template <typename MatrixDataType>
+		DenseMatrix<DataType> solve(const DenseMatrix<MatrixDataType>& B) const
+		{
+			DenseMatrix<DataType> X(B.view(), StorageType::ColumnMajor);
+			solveInPlace(X.view());
+			return X;
+		}
+
+		// Overwrites b with the solution x of Ax = b
+		void solveInPlace(const VectorView<DataType>& b) const
+		{
+			if (b.size() != size())
+				throw InvalidDimensions();
+
+			if (!_positive_definite)
+				throw SingularMatrix();
+
+			// Substitution runs on contiguous memory
+			if (!b.isContiguous())
+			{
+				std::vector<DataType> x = b.toStdVector();
+				solveContiguous(x.data());
+				b.assign(VectorView<const DataType>(x.data(), x.size()));
+				return;
+			}
+
+			solveContiguous(b.data());
+		}
+
+		// Overwrites every column of B with the solution of the system
+		// with that column as its right hand side; LY = B and L^T X = Y
+		// are each solved against all columns together by the blocked
+		// TRSM in trsm_kernel.h
+		void solveInPlace(const MatrixView<DataType>& B) const
+		{
+			if (B.rows() != size())
+				throw InvalidDimensions();
+
+			if (!_positive_definite)
+				throw SingularMatrix();
+
+			MatrixView<const DataType> L = _factor.view();
+			trsmParallel(L, TriangleType::Lower, DiagonalType::NonUnit, B);
+			trsmParallel(L.transposed(), TriangleType::Upper, DiagonalType::NonUnit, B);
+		}
+
+	private:
+
+		// Factors _factor in place with the blocked right-looking
+		// algorithm; each panel of CHOLESKY_BLOCK_SIZE columns is factored
+		// column by column, then the lower triangle of the rest of the
+		// matrix is updated by GEMMs on column blocks, which skip the
+		// upper triangle and so do half the work of the LU update
+		void factor()
+		{
+			const size_t n = size();
+			MatrixView<DataType> L = _factor.view();
+
+			for (size_t first = 0; first < n; first += CHOLESKY_BLOCK_SIZE)
+			{
+				const size_t last = std::min(first + CHOLESKY_BLOCK_SIZE, n);
+				if (!factorPanel(L, first, last))
+				{
+					_positive_definite = false;
+					break;
+				}
+
+				if (last < n)
+					updateTrailing(L.subView(last, n, first, last),
+						L.subView(last, n, last, n));
+			}
+
+			// Updates of diagonal blocks spill into the upper triangle
+			for (size_t j = 1; j < n; ++j)
+			{
+				L.col(j).subView(0, j).fill(0);
+			}
+		}
+
+		// Factors columns [first, last) of L, from row first down; returns
+		// false at the first pivot that isn't positive
+		bool factorPanel(const MatrixView<DataType>& L,
+			const size_t first,
+			const size_t last)
+		{
+			const size_t n = size();
+
+			for (size_t k = first; k < last; ++k)
+			{
+				DataType pivot = L(k, k);
+
+				// Negated so that NaN fails the test too
+				if (!(pivot > DataType(0)))
+					return false;
+
+				pivot = std::sqrt(pivot);
+				L(k, k) = pivot;
+				L.col(k).subView(k + 1, n).scale(1 / pivot);
+
+				// Updates the lower triangle of the panel columns to the
+				// right of k
+				for (size_t j = k + 1; j < last; ++j)
+				{
+					DataType factor = L(j, k);
+					if (factor != DataType(0))
+						axpyKernel(-factor, &L(j, k), &L(j, j), n - j);
+				}
+			}
+			return true;
+		}
+
+		// Sets the lower triangle of A22 to A22 - L21 * L21^T; A22 is
+		// split into blocks of columns, and each block only updates the
+		// rows from its diagonal block down, so the blocks form a
+		// staircase that covers the lower triangle, plus the upper halves
+		// of the diagonal blocks; blocks run as parallel tasks
+		static void updateTrailing(const MatrixView<const DataType>& L21,
+			const MatrixView<DataType>& A22)
+		{
+			const size_t m = A22.rows();
+			const size_t num_blocks = (m + CHOLESKY_BLOCK_SIZE - 1) / CHOLESKY_BLOCK_SIZE;
+
+			auto updateBlock = [&](const size_t block)
+			{
+				size_t first = block * CHOLESKY_BLOCK_SIZE;
+				size_t last = std::min(first + CHOLESKY_BLOCK_SIZE, m);
+				gemmBlocked(L21.subView(first, m, 0, L21.cols()),
+					L21.subView(first, last, 0, L21.cols()).transposed(),
+					A22.subView(first, m, first, last), GemmBlockSizes(), -1, 1);
+			};
+
+			if (m * m * L21.cols() < 2 * GEMM_PARALLEL_MIN_WORK)
+			{
+				for (size_t block = 0; block < num_blocks; ++block)
+				{
+					updateBlock(block);
+				}
+				return;
+			}
+
+			// Tallest blocks first, so the longest tasks start earliest
+			defaultThreadPool().parallelFor(num_blocks, updateBlock);
+		}
+
+		// Solves LL^T x = b in place on the contiguous right hand side b;
+		// Ly = b down the contiguous columns of L, then L^T x = y with its
+		// RowMajor transpose, a dot product per column of L
+		void solveContiguous(DataType* b) const
+		{
+			MatrixView<const DataType> L = _factor.view();
+			trsvBlocked(L, TriangleType::Lower, DiagonalType::NonUnit, b);
+			trsvBlocked(L.transposed(), TriangleType::Upper, DiagonalType::NonUnit, b);
+		}
+
+		// Lower triangular factor, ColumnMajor so that columns, which
+		// both factoring and solving stream through, are contiguous; the
+		// upper triangle is zero once factoring finishes
+		DenseMatrix<DataType> _factor;
+
+		bool _positive_definite;
+	};
+}
+
+#endif
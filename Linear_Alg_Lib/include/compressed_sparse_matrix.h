@@ -0,0 +1,456 @@
+#ifndef COMPRESSED_SPARSE_MATRIX_H
+#define COMPRESSED_SPARSE_MATRIX_H
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <functional>
+
+#include "sparse_matrix.h"
+#include "dense_matrix.h"
+#include "matrix_utils.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Sparse matrices in compressed sparse row (CSR) and compressed sparse
+// column (CSC) format; the nonzeros of every row of a CSRMatrix, or
+// every column of a CSCMatrix, called its lines, are stored
+// contiguously with their column or row indices in ascending order, and
+// a pointer array gives where each line starts, so a line is found in
+// O(1) and read as one contiguous stream
+// Both are built from the COO SparseMatrix by a stable parallel
+// counting sort, which also sums duplicate entries
+// Unlike SparseMatrix they are not derived from Matrix; inserting a
+// single element would shift every entry after it, so these formats
+// are built whole and then only read
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Fewest entries for which the conversions are split across threads
+	const size_t SPARSE_PARALLEL_MIN_NONZERO = 1 << 15;
+
+	// Stable counting sort by key of the num_entries entries listed in
+	// order_in, or of entries [0, num_entries) if order_in is null, where
+	// entry e has key keys[e] < num_keys; order_out receives the sorted
+	// entries, and pointers the num_keys + 1 offsets into order_out
+	// where the entries of each key start
+	// Every thread counts the keys of its own chunk of the input, and a
+	// prefix sum over keys, then chunks, gives every chunk the positions
+	// its entries are scattered to; the number of chunks is limited so
+	// that their counts take at most a few times the memory of the input
+	inline void countingSortByKey(const size_t* keys,
+		const size_t* order_in,
+		const size_t num_entries,
+		const size_t num_keys,
+		std::vector<size_t>& pointers,
+		std::vector<size_t>& order_out,
+		ThreadPool& pool = defaultThreadPool())
+	{
+		size_t num_chunks = 1;
+		if (num_entries >= SPARSE_PARALLEL_MIN_NONZERO)
+		{
+			num_chunks = std::min(pool.numThreads(),
+				1 + 4 * num_entries / std::max<size_t>(num_keys, 1));
+		}
+		const size_t chunk_size = (num_entries + num_chunks - 1) / num_chunks;
+
+		auto entry = [&](const size_t p)
+			{
+				return order_in ? order_in[p] : p;
+			};
+
+		auto forEachChunk = [&](const std::function<void(size_t, size_t, size_t)>& f)
+			{
+				auto chunk_task = [&](const size_t chunk)
+					{
+						size_t first = std::min(chunk * chunk_size, num_entries);
+						size_t last = std::min(first + chunk_size, num_entries);
+						f(chunk, first, last);
+					};
+
+				if (num_chunks == 1)
+					chunk_task(0);
+				else
+					pool.parallelFor(num_chunks, chunk_task);
+			};
+
+		// counts[chunk * num_keys + key] is the number of entries with
+		// given key in given chunk, and after the prefix sum the position
+		// of the next one
+		std::vector<size_t> counts(num_chunks * num_keys, 0);
+		forEachChunk([&](const size_t chunk, const size_t first, const size_t last)
+			{
+				size_t* chunk_counts = counts.data() + chunk * num_keys;
+				for (size_t p = first; p < last; ++p)
+				{
+					++chunk_counts[keys[entry(p)]];
+				}
+			});
+
+		pointers.assign(num_keys + 1, 0);
+		size_t offset = 0;
+		for (size_t key = 0; key < num_keys; ++key)
+		{
+			pointers[key] = offset;
+			for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+			{
+				size_t count = counts[chunk * num_keys + key];
+				counts[chunk * num_keys + key] = offset;
+				offset += count;
+			}
+		}
+		pointers[num_keys] = offset;
+
+		order_out.resize(num_entries);
+		forEachChunk([&](const size_t chunk, const size_t first, const size_t last)
+			{
+				size_t* chunk_offsets = counts.data() + chunk * num_keys;
+				for (size_t p = first; p < last; ++p)
+				{
+					size_t e = entry(p);
+					order_out[chunk_offsets[keys[e]]++] = e;
+				}
+			});
+	}
+
+	// Calls f(first_line, last_line) for consecutive bands of the lines
+	// of a compressed matrix with given pointer array, in parallel if the
+	// matrix is large; the bands hold about the same number of entries,
+	// rather than of lines, so a few long lines don't leave threads idle
+	template <typename Function>
+	inline void forEachLineBand(const std::vector<size_t>& pointers,
+		const Function& f,
+		ThreadPool& pool = defaultThreadPool())
+	{
+		const size_t num_lines = pointers.size() - 1;
+		const size_t num_entries = pointers.back();
+		if (num_entries < SPARSE_PARALLEL_MIN_NONZERO || pool.numThreads() == 1)
+		{
+			f(0, num_lines);
+			return;
+		}
+
+		// A few bands per thread, so that the pool can balance the rest
+		const size_t num_bands = 4 * pool.numThreads();
+		std::vector<size_t> bounds(num_bands + 1, num_lines);
+		bounds[0] = 0;
+		for (size_t band = 1; band < num_bands; ++band)
+		{
+			size_t target = num_entries / num_bands * band;
+			bounds[band] = static_cast<size_t>(std::lower_bound(
+				pointers.begin(), pointers.end() - 1, target) - pointers.begin());
+		}
+
+		pool.parallelFor(num_bands, [&](const size_t band)
+			{
+				if (bounds[band] < bounds[band + 1])
+					f(bounds[band], bounds[band + 1]);
+			});
+	}
+
+	// Compressed sparse matrix whose lines are its rows if Storage is
+	// RowMajor (CSR) and its columns if Storage is ColumnMajor (CSC); use
+	// the CSRMatrix and CSCMatrix aliases below
+	template <typename DataType, StorageType Storage>
+	class CompressedSparseMatrix
+	{
+	public:
+
+		// Constructor; converts given COO matrix, summing duplicate
+		// entries, which are kept as one explicit entry even if they sum
+		// to zero
+		// Two stable counting sorts, first by the index within a line and
+		// then by line, leave every line sorted without comparisons
+		explicit CompressedSparseMatrix(const SparseMatrix<DataType>& coo,
+			ThreadPool& pool = defaultThreadPool()) :
+			_rows(coo.rows()),
+			_cols(coo.cols())
+		{
+			const std::vector<size_t>& row_indices = coo.getRowIndices();
+			const std::vector<size_t>& col_indices = coo.getColIndices();
+			const std::vector<DataType>& coo_data = coo.getData();
+			const std::vector<size_t>& major = (Storage == StorageType::RowMajor) ?
+				row_indices : col_indices;
+			const std::vector<size_t>& minor = (Storage == StorageType::RowMajor) ?
+				col_indices : row_indices;
+			const size_t num_entries = coo_data.size();
+
+			std::vector<size_t> minor_pointers;
+			std::vector<size_t> minor_order;
+			countingSortByKey(minor.data(), nullptr, num_entries, numMinor(),
+				minor_pointers, minor_order, pool);
+
+			std::vector<size_t> sorted_pointers;
+			std::vector<size_t> order;
+			countingSortByKey(major.data(), minor_order.data(), num_entries, numLines(),
+				sorted_pointers, order, pool);
+
+			// Duplicates are now next to each other; counts the distinct
+			// indices of every line, then sums each run of duplicates
+			// into one entry
+			_pointers.assign(numLines() + 1, 0);
+			forEachLineBand(sorted_pointers, [&](const size_t first, const size_t last)
+				{
+					for (size_t line = first; line < last; ++line)
+					{
+						size_t distinct = 0;
+						for (size_t p = sorted_pointers[line]; p < sorted_pointers[line + 1]; ++p)
+						{
+							if (p == sorted_pointers[line] || minor[order[p]] != minor[order[p - 1]])
+								++distinct;
+						}
+						_pointers[line + 1] = distinct;
+					}
+				}, pool);
+
+			for (size_t line = 0; line < numLines(); ++line)
+			{
+				_pointers[line + 1] += _pointers[line];
+			}
+
+			_indices.resize(_pointers.back());
+			_data.resize(_pointers.back());
+			forEachLineBand(sorted_pointers, [&](const size_t first, const size_t last)
+				{
+					for (size_t line = first; line < last; ++line)
+					{
+						size_t q = _pointers[line];
+						for (size_t p = sorted_pointers[line]; p < sorted_pointers[line + 1]; ++p)
+						{
+							size_t index = minor[order[p]];
+							if (p > sorted_pointers[line] && index == _indices[q - 1])
+							{
+								_data[q - 1] += coo_data[order[p]];
+							}
+							else
+							{
+								_indices[q] = index;
+								_data[q] = coo_data[order[p]];
+								++q;
+							}
+						}
+					}
+				}, pool);
+		}
+
+		// Constructor; converts a matrix of the other format, CSR to CSC
+		// or CSC to CSR, with one stable counting sort of its entries by
+		// their index within a line, which keeps the new lines sorted
+		template <StorageType OtherStorage>
+		explicit CompressedSparseMatrix(const CompressedSparseMatrix<DataType, OtherStorage>& other,
+			ThreadPool& pool = defaultThreadPool()) :
+			_rows(other.rows()),
+			_cols(other.cols())
+		{
+			static_assert(OtherStorage != Storage,
+				"Conversion needs a matrix of the other format");
+
+			const std::vector<size_t>& other_pointers = other.getPointers();
+			const std::vector<size_t>& other_indices = other.getIndices();
+			const std::vector<DataType>& other_data = other.getData();
+
+			// Line of the other matrix each entry is in, which is its
+			// index within a line of this one
+			std::vector<size_t> other_lines(other.getNumNonzero());
+			forEachLineBand(other_pointers, [&](const size_t first, const size_t last)
+				{
+					for (size_t line = first; line < last; ++line)
+					{
+						std::fill(other_lines.begin() + other_pointers[line],
+							other_lines.begin() + other_pointers[line + 1], line);
+					}
+				}, pool);
+
+			std::vector<size_t> order;
+			countingSortByKey(other_indices.data(), nullptr, other_indices.size(), numLines(),
+				_pointers, order, pool);
+
+			_indices.resize(order.size());
+			_data.resize(order.size());
+			forEachLineBand(_pointers, [&](const size_t first, const size_t last)
+				{
+					for (size_t p = _pointers[first]; p < _pointers[last]; ++p)
+					{
+						_indices[p] = other_lines[order[p]];
+						_data[p] = other_data[order[p]];
+					}
+				}, pool);
+		}
+
+		// Constructor with the three arrays of the format; pointers has
+		// one element per line plus one, and the indices within every
+		// line must be strictly increasing
+		// Throws InvalidDimensions if the arrays are inconsistent, or
+		// OutOfBounds if an index is outside the matrix
+		CompressedSparseMatrix(std::vector<size_t> pointers_in,
+			std::vector<size_t> indices_in,
+			std::vector<DataType> data_in,
+			const size_t rows_in,
+			const size_t cols_in) :
+			_rows(rows_in),
+			_cols(cols_in),
+			_pointers(std::move(pointers_in)),
+			_indices(std::move(indices_in)),
+			_data(std::move(data_in))
+		{
+			if (_pointers.size() != numLines() + 1 || _pointers[0] != 0 ||
+				_pointers.back() != _indices.size() || _data.size() != _indices.size())
+			{
+				throw InvalidDimensions();
+			}
+
+			for (size_t line = 0; line < numLines(); ++line)
+			{
+				if (_pointers[line + 1] < _pointers[line])
+					throw InvalidDimensions();
+
+				for (size_t p = _pointers[line]; p < _pointers[line + 1]; ++p)
+				{
+					if (_indices[p] >= numMinor())
+						throw OutOfBounds();
+
+					if (p > _pointers[line] && _indices[p] <= _indices[p - 1])
+						throw InvalidDimensions();
+				}
+			}
+		}
+
+		size_t rows() const
+		{
+			return _rows;
+		}
+
+		size_t cols() const
+		{
+			return _cols;
+		}
+
+		// Returns number of stored entries
+		size_t getNumNonzero() const
+		{
+			return _data.size();
+		}
+
+		StorageType getStorageType() const
+		{
+			return Storage;
+		}
+
+		// Returns number of lines; rows for CSR, columns for CSC
+		size_t numLines() const
+		{
+			return (Storage == StorageType::RowMajor) ? _rows : _cols;
+		}
+
+		// Returns the offsets where the entries of every line start, with
+		// the number of entries at the end
+		const std::vector<size_t>& getPointers() const
+		{
+			return _pointers;
+		}
+
+		// Returns the column (CSR) or row (CSC) index of every entry
+		const std::vector<size_t>& getIndices() const
+		{
+			return _indices;
+		}
+
+		// Returns the value of every entry
+		const std::vector<DataType>& getData() const
+		{
+			return _data;
+		}
+
+		// Returns element at location (row, col); binary search within
+		// its line
+		DataType at(const size_t row, const size_t col) const
+		{
+			if (row >= _rows || col >= _cols)
+				throw OutOfBounds();
+
+			const size_t line = (Storage == StorageType::RowMajor) ? row : col;
+			const size_t index = (Storage == StorageType::RowMajor) ? col : row;
+			auto first = _indices.begin() + _pointers[line];
+			auto last = _indices.begin() + _pointers[line + 1];
+			auto found = std::lower_bound(first, last, index);
+			if (found == last || *found != index)
+				return 0;
+
+			return _data[found - _indices.begin()];
+		}
+
+		// Returns the transpose, which has the same arrays in the other
+		// format; the CSR arrays of a matrix are the CSC arrays of its
+		// transpose
+		CompressedSparseMatrix<DataType, flipStorageType(Storage)> transposed() const
+		{
+			return CompressedSparseMatrix<DataType, flipStorageType(Storage)>(
+				_pointers, _indices, _data, _cols, _rows);
+		}
+
+		// Returns the matrix in COO format, its entries in line order
+		SparseMatrix<DataType> toSparseMatrix() const
+		{
+			std::vector<size_t> lines(_indices.size());
+			for (size_t line = 0; line < numLines(); ++line)
+			{
+				std::fill(lines.begin() + _pointers[line],
+					lines.begin() + _pointers[line + 1], line);
+			}
+
+			if (Storage == StorageType::RowMajor)
+				return SparseMatrix<DataType>(_data, lines, _indices, _rows, _cols);
+			else
+				return SparseMatrix<DataType>(_data, _indices, lines, _rows, _cols);
+		}
+
+		// Returns the matrix as a DenseMatrix with the same storage type,
+		// so that every line is written contiguously
+		DenseMatrix<DataType> toDenseMatrix() const
+		{
+			DenseMatrix<DataType> dense(_rows, _cols, Storage);
+			MatrixView<DataType> lines = (Storage == StorageType::RowMajor) ?
+				dense.view() : dense.transposeView();
+			for (size_t line = 0; line < numLines(); ++line)
+			{
+				for (size_t p = _pointers[line]; p < _pointers[line + 1]; ++p)
+				{
+					lines(line, _indices[p]) = _data[p];
+				}
+			}
+			return dense;
+		}
+
+	private:
+
+		// Returns size of every line; columns for CSR, rows for CSC
+		size_t numMinor() const
+		{
+			return (Storage == StorageType::RowMajor) ? _cols : _rows;
+		}
+
+		size_t _rows;
+		size_t _cols;
+
+		// Offsets of the lines in _indices and _data, numLines() + 1 of
+		// them; line i is entries [_pointers[i], _pointers[i + 1])
+		std::vector<size_t> _pointers;
+
+		// Index within its line and value of every entry, sorted by line
+		// and then by index
+		std::vector<size_t> _indices;
+		std::vector<DataType> _data;
+	};
+
+	// Compressed sparse row matrix
+	template <typename DataType>
+	using CSRMatrix = CompressedSparseMatrix<DataType, StorageType::RowMajor>;
+
+	// Compressed sparse column matrix
+	template <typename DataType>
+	using CSCMatrix = CompressedSparseMatrix<DataType, StorageType::ColumnMajor>;
+}
+
+#endif
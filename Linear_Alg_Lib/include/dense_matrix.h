@@ -4,6 +4,8 @@
 #include <vector>
 #include "matrix.h"
 #include "matrix_utils.h"
+#include "matrix_view.h"
+#include "matrix_expression.h"
 #include "exceptions.h"
 
 // ------------------------------------------------------------------
@@ -14,6 +16,10 @@
 
 namespace LinAlg
 {
+	// Unevaluated product returned by operator*; see matrix_ops.h
+	template <typename DataType>
+	class MatrixProduct;
+
 	template <typename DataType>
 	class DenseMatrix : public Matrix<DataType, DenseMatrix<DataType> >
 	{
@@ -47,6 +53,43 @@ namespace LinAlg
 			_data = data_in;
 		}
 
+		// Constructor that copies the elements of given view; result has
+		// the given storage type, which defaults to the view's
+		template <typename ViewDataType>
+		explicit DenseMatrix(const MatrixView<ViewDataType>& view_in) :
+			DenseMatrix(view_in, view_in.getStorageType())
+		{ }
+
+		template <typename ViewDataType>
+		DenseMatrix(const MatrixView<ViewDataType>& view_in,
+			const StorageType storage_type_in) :
+			Matrix<DataType, DenseMatrix<DataType> >(
+				view_in.rows(), view_in.cols()),
+			_data(view_in.size()),
+			_storage_type(storage_type_in)
+		{
+			view().assign(view_in);
+		}
+
+		// Constructor that evaluates given expression, such as A + 2 * B,
+		// in a single pass; result has the storage type of the leftmost
+		// operand of the expression, see matrix_expression.h
+		template <typename Expression>
+		DenseMatrix(const MatrixExpression<Expression>& expression_in) :
+			Matrix<DataType, DenseMatrix<DataType> >(
+				expression_in.derived().rows(), expression_in.derived().cols()),
+			_data(expression_in.derived().rows() * expression_in.derived().cols()),
+			_storage_type(expression_in.derived().getStorageType())
+		{
+			evaluateInto(view(), expression_in);
+		}
+
+		// Constructor that evaluates given product, such as A * B; result
+		// has the storage type of the left operand
+		DenseMatrix(const MatrixProduct<DataType>& product_in) :
+			DenseMatrix(product_in.evaluate())
+		{ }
+
 		// Default constructor with optional storage type parameter; data 
 		// vector initialized to empty vector, rows, cols, and size 
 		// initialized to 0
@@ -57,6 +100,55 @@ namespace LinAlg
 			_storage_type(storage_type_in)
 		{ }
 
+		// Evaluates given expression into the matrix; when the dimensions
+		// and storage type already match, the elements are overwritten in
+		// place without allocating, so A = A + B is safe
+		template <typename Expression>
+		DenseMatrix<DataType>& operator=(
+			const MatrixExpression<Expression>& expression_in)
+		{
+			const Expression& expression = expression_in.derived();
+			if (this->_rows == expression.rows() &&
+				this->_cols == expression.cols() &&
+				_storage_type == expression.getStorageType())
+			{
+				evaluateInto(view(), expression_in);
+			}
+			else
+			{
+				*this = DenseMatrix<DataType>(expression_in);
+			}
+			return *this;
+		}
+
+		// += operator overload; adds a DenseMatrix, MatrixView, matrix 
+		// expression, or product in place without allocating, so 
+		// C += A * B accumulates the product straight into C; see addTo()
+		template <typename Operand>
+		DenseMatrix<DataType>& operator+=(const Operand& operand)
+		{
+			addTo(view(), operand);
+			return *this;
+		}
+
+		// -= operator overload; works like +=, see subtractFrom()
+		template <typename Operand>
+		DenseMatrix<DataType>& operator-=(const Operand& operand)
+		{
+			subtractFrom(view(), operand);
+			return *this;
+		}
+
+		// *= operator overload; scales every element in place
+		DenseMatrix<DataType>& operator*=(const DataType factor)
+		{
+			for (DataType& elt : _data)
+			{
+				elt *= factor;
+			}
+			return *this;
+		}
+
 		// Getter and setter functions
 
 		std::vector<DataType> getData() const
@@ -78,16 +170,111 @@ namespace LinAlg
 			return _storage_type;
 		}
 
+		// View functions; views read and write directly into _data and
+		// are invalidated by any operation that changes the dimensions
+		// of the matrix or replaces its data vector
+
+		// Returns view of the whole matrix, const version
+		MatrixView<const DataType> view() const
+		{
+			return MatrixView<const DataType>(
+				_data.data(), this->_rows, this->_cols, _storage_type);
+		}
+
+		// Returns view of the whole matrix, non-const version
+		MatrixView<DataType> view()
+		{
+			return MatrixView<DataType>(
+				_data.data(), this->_rows, this->_cols, _storage_type);
+		}
+
+		// Returns view of row pos, const version
+		VectorView<const DataType> rowView(const size_t pos) const
+		{
+			return view().row(pos);
+		}
+
+		// Returns view of row pos, non-const version
+		VectorView<DataType> rowView(const size_t pos)
+		{
+			return view().row(pos);
+		}
+
+		// Returns view of col pos, const version
+		VectorView<const DataType> colView(const size_t pos) const
+		{
+			return view().col(pos);
+		}
+
+		// Returns view of col pos, non-const version
+		VectorView<DataType> colView(const size_t pos)
+		{
+			return view().col(pos);
+		}
+
+		// Returns view of rows [first_row, last_row) and columns 
+		// [first_col, last_col), const version
+		MatrixView<const DataType> subMatrixView(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col) const
+		{
+			return view().subView(first_row, last_row, first_col, last_col);
+		}
+
+		// Returns view of rows [first_row, last_row) and columns 
+		// [first_col, last_col), non-const version
+		MatrixView<DataType> subMatrixView(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col)
+		{
+			return view().subView(first_row, last_row, first_col, last_col);
+		}
+
+		// Returns view of the transpose, const version; reads the same
+		// data with the storage type flipped, so costs nothing
+		MatrixView<const DataType> transposeView() const
+		{
+			return view().transposed();
+		}
+
+		// Returns view of the transpose, non-const version
+		MatrixView<DataType> transposeView()
+		{
+			return view().transposed();
+		}
+
+		// Transposes the matrix in place without moving any data; the 
+		// dimensions are swapped and the storage type flipped, since 
+		// ColumnMajor data for an m x n matrix is RowMajor data for its
+		// n x m transpose
+		void transpose()
+		{
+			std::swap(this->_rows, this->_cols);
+			_storage_type = flipStorageType(_storage_type);
+		}
+
+		// Returns the transpose as a new matrix; copies the data vector
+		// as is, with the opposite storage type
+		DenseMatrix<DataType> transposed() const
+		{
+			return DenseMatrix<DataType>(_data, this->_cols, this->_rows,
+				flipStorageType(_storage_type));
+		}
+
 		// Converts storage type from column major to row major by 
 		// rearranging data vector; if storage type is already row 
 		// major, does nothing
+		// Square and very large matrices are rearranged in place, see
+		// transposeData()
 		void convertToRowMajor()
 		{
 			if (_storage_type == StorageType::RowMajor)
 				return;
 
-			_data = convertToRowMajorHelper(
-				this->_data, this->_rows, this->_cols);
+			// Column major data is the row major data of the transpose
+			transposeData(this->_cols, this->_rows);
 			_storage_type = StorageType::RowMajor;
 		}
 
@@ -107,13 +294,14 @@ namespace LinAlg
 		// Converts storage type from row major to column major by 
 		// rearranging data vector; if storage type is already column 
 		// major, does nothing
+		// Square and very large matrices are rearranged in place, see
+		// transposeData()
 		void convertToColMajor()
 		{
 			if (_storage_type == StorageType::ColumnMajor)
 				return;
 
-			_data = convertToColMajorHelper(
-				this->_data, this->_rows, this->_cols);
+			transposeData(this->_rows, this->_cols);
 			_storage_type = StorageType::ColumnMajor;
 		}
 
@@ -145,31 +333,27 @@ namespace LinAlg
 		// Returns row pos as a MathVector
 		MathVector<DataType> row(const size_t pos) const override
 		{
-			return rowColHelper(pos, rowBounds(pos), rowIndices(pos), 
-				this->_rows, this->_cols, StorageType::RowMajor);
+			return MathVector<DataType>(rowView(pos));
 		}
 
 		// Returns col pos as a MathVector
 		MathVector<DataType> col(const size_t pos) const override
 		{
-			return rowColHelper(pos, colBounds(pos), colIndices(pos),
-				this->_cols, this->_rows, StorageType::ColumnMajor);
+			return MathVector<DataType>(colView(pos));
 		}
 
 		// Sets row pos to given MathVector
 		void setRow(const size_t pos,
 			const MathVector<DataType>& new_row) override
 		{
-			setHelper(pos, new_row, rowBounds(pos), rowIndices(pos),
-				this->_rows, this->_cols, StorageType::RowMajor);
+			rowView(pos).assign(new_row.view());
 		}
 
 		// Sets col pos to given MathVector
 		void setCol(const size_t pos,
 			const MathVector<DataType>& new_col) override
 		{
-			setHelper(pos, new_col, colBounds(pos), colIndices(pos),
-				this->_cols, this->_rows, StorageType::ColumnMajor);
+			colView(pos).assign(new_col.view());
 		}
 
 		// Adds given row to the matrix above row pos
@@ -205,35 +389,31 @@ namespace LinAlg
 		// Swaps the two rows at given positions
 		void swapRows(const size_t pos1, const size_t pos2) override
 		{
-			MathVector<DataType> row1 = row(pos1);
-			MathVector<DataType> row2 = row(pos2);
-			setRow(pos1, row2);
-			setRow(pos2, row1);
+			VectorView<DataType> row1 = rowView(pos1);
+			VectorView<DataType> row2 = rowView(pos2);
+			if (pos1 != pos2)
+				row1.swapWith(row2);
 		}
 
 		// Swaps the two columns at given positions
 		void swapCols(const size_t pos1, const size_t pos2) override
 		{
-			MathVector<DataType> col1 = col(pos1);
-			MathVector<DataType> col2 = col(pos2);
-			setCol(pos1, col2);
-			setCol(pos2, col1);
+			VectorView<DataType> col1 = colView(pos1);
+			VectorView<DataType> col2 = colView(pos2);
+			if (pos1 != pos2)
+				col1.swapWith(col2);
 		}
 
 		// Scales row pos by the given factor
 		void scaleRow(const size_t pos, const DataType factor) override
 		{
-			MathVector<DataType> row_to_scale = row(pos);
-			row_to_scale.scale(factor);
-			setRow(pos, row_to_scale);
+			rowView(pos).scale(factor);
 		}
 
 		// Scales col pos by the given factor
 		void scaleCol(const size_t pos, const DataType factor) override
 		{
-			MathVector<DataType> col_to_scale = col(pos);
-			col_to_scale.scale(factor);
-			setCol(pos, col_to_scale);
+			colView(pos).scale(factor);
 		}
 
 		// Returns matrix containing rows [first_row, last_row) and 
@@ -251,30 +431,8 @@ namespace LinAlg
 				throw OutOfBounds();
 			}
 
-			DenseMatrix<DataType> sub_matrix(_storage_type);
-
-			// Build matrix row by row or col by col depending on 
-			// storage type for performance purposes
-			if (_storage_type == StorageType::RowMajor)
-			{
-				for (size_t i = first_row; i < last_row; ++i)
-				{
-					MathVector<DataType> row_i = 
-						row(i).getSubVector(first_col, last_col);
-					sub_matrix.addRow(sub_matrix.rows(), row_i);
-				}
-			}
-			else
-			{
-				for (size_t i = first_col; i < last_col; ++i)
-				{
-					MathVector<DataType> col_i =
-						col(i).getSubVector(first_row, last_row);
-					sub_matrix.addCol(sub_matrix.cols(), col_i);
-				}
-			}
-
-			return sub_matrix;
+			return DenseMatrix<DataType>(
+				subMatrixView(first_row, last_row, first_col, last_col));
 		}
 
 		// Sets section of matrix including rows [first_row, last_row)
@@ -299,32 +457,8 @@ namespace LinAlg
 				throw InvalidDimensions();
 			}
 
-			if (_storage_type == StorageType::RowMajor)
-			{
-				size_t sub_matrix_i = 0;
-				for (size_t i = first_row; i < last_row; ++i)
-				{
-					MathVector<DataType> sub_row = 
-						new_sub_matrix.row(sub_matrix_i);
-					MathVector<DataType> new_row = row(i);
-					new_row.setSubVector(first_col, last_col, sub_row);
-					setRow(i, new_row);
-					++sub_matrix_i;
-				}
-			}
-			else
-			{
-				size_t sub_matrix_i = 0;
-				for (size_t i = first_col; i < last_col; ++i)
-				{
-					MathVector<DataType> sub_col =
-						new_sub_matrix.col(sub_matrix_i);
-					MathVector<DataType> new_col = col(i);
-					new_col.setSubVector(first_row, last_row, sub_col);
-					setCol(i, new_col);
-					++sub_matrix_i;
-				}
-			}
+			subMatrixView(first_row, last_row, first_col, last_col).assign(
+				new_sub_matrix.view());
 		}
 
 	private:
@@ -343,64 +477,22 @@ namespace LinAlg
 				return col * this->_rows + row;
 		}
 
-		// Helper for row() and col()
-		MathVector<DataType> rowColHelper(const size_t pos,
-			const std::pair<size_t, size_t>& bounds,
-			const std::vector<size_t>& indices,
-			const size_t num_of,
-			const size_t size_of,
-			const StorageType desired_storage_type) const
+		// Transposes _data, which holds a rows x cols matrix in row major
+		// order; square matrices, and matrices of at least
+		// TRANSPOSE_IN_PLACE_MIN_SIZE elements, are transposed in place,
+		// and smaller ones through a second buffer, which is faster
+		void transposeData(const size_t rows, const size_t cols)
 		{
-			if (pos >= num_of)
-				throw OutOfBounds();
-
-			std::vector<DataType> row_col_data(size_of);
-
-			if (_storage_type == desired_storage_type)
+			if (rows == cols || _data.size() >= TRANSPOSE_IN_PLACE_MIN_SIZE)
 			{
-				row_col_data = std::vector<DataType>(
-					_data.begin() + bounds.first, _data.begin() + bounds.second);
-			}
-			else
-			{
-				for (size_t i = 0; i < row_col_data.size(); ++i)
-				{
-					row_col_data[i] = _data[indices[i]];
-				}
+				transposeInPlace(_data.data(), rows, cols);
+				return;
 			}
 
-			return MathVector<DataType>(row_col_data);
-		}
-
-		// Helper for setRow() and setCol()
-		void setHelper(const size_t pos,
-			const MathVector<DataType>& new_row_col,
-			const std::pair<size_t, size_t>& bounds,
-			const std::vector<size_t>& indices,
-			const size_t num_of,
-			const size_t size_of,
-			const StorageType desired_storage_type)
-		{
-			if (pos >= num_of)
-				throw OutOfBounds();
-
-			if (new_row_col.size() != size_of)
-				throw InvalidDimensions();
-
-			std::vector<DataType> new_row_col_data = new_row_col.getData();
-
-			if (_storage_type == desired_storage_type)
-			{
-				std::copy(new_row_col_data.begin(), new_row_col_data.end(),
-					_data.begin() + bounds.first);
-			}
-			else
-			{
-				for (size_t i = 0; i < new_row_col_data.size(); ++i)
-				{
-					_data[indices[i]] = new_row_col_data[i];
-				}
-			}
+			std::vector<DataType> transposed(_data.size());
+			transposeInto(_data.data(), cols, transposed.data(), rows,
+				rows, cols);
+			_data.swap(transposed);
 		}
 
 		// Helper for addRow() and addCol()
@@ -491,38 +583,6 @@ namespace LinAlg
 			return { col_start, col_end };
 		}
 
-		// Returns vector of indices of the elements in row pos;
-		// assumes _storage_type is ColumnMajor and pos is in bounds
-		std::vector<size_t> rowIndices(const size_t pos) const
-		{
-			std::vector<size_t> row_indices(this->_cols);
-			size_t row_elt_index = pos;
-
-			for (size_t i = 0; i < row_indices.size(); ++i)
-			{
-				row_indices[i] = row_elt_index;
-				row_elt_index += this->_rows;
-			}
-
-			return row_indices;
-		}
-
-		// Returns vector of indices of the elements in col pos; 
-		// assumes _storage_type is RowMajor and pos is in bounds
-		std::vector<size_t> colIndices(const size_t pos) const
-		{
-			std::vector<size_t> col_indices(this->_rows);
-			size_t col_elt_index = pos;
-
-			for (size_t i = 0; i < col_indices.size(); ++i)
-			{
-				col_indices[i] = col_elt_index;
-				col_elt_index += this->_cols;
-			}
-
-			return col_indices;
-		}
-
 		// Vector to store data 
 		std::vector<DataType> _data;
 
@@ -50,6 +50,28 @@ namespace LinAlg
 			CustomException("Out of bounds index")
 		{ }
 	};
+
+	// Thrown when solving a system whose matrix is singular, so that no
+	// unique solution exists
+	class SingularMatrix : public CustomException
+	{
+	public:
+
+		SingularMatrix() :
+			CustomException("Singular matrix")
+		{ }
+	};
+
+	// Thrown when an iterative algorithm fails to converge within its
+	// iteration limit
+	class NoConvergence : public CustomException
+	{
+	public:
+
+		NoConvergence() :
+			CustomException("No convergence")
+		{ }
+	};
 }
 
 
@@ -0,0 +1,373 @@
+#ifndef GEMM_KERNEL_H
+#define GEMM_KERNEL_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "matrix_view.h"
+#include "exceptions.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+
+// ------------------------------------------------------------------
+// Cache-blocked general matrix multiplication engine; A and B are
+// split into panels that fit in cache, copied into packed buffers in
+// the exact order the micro-kernel reads them, and multiplied one
+// MR x NR register tile of C at a time
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Cache blocking parameters; a KC x NC panel of B is packed once and
+	// reused for every MC x KC block of A, which stays in L2 while it is
+	// multiplied against the whole panel
+	struct GemmBlockSizes
+	{
+		size_t MC = 128;
+		size_t KC = 256;
+		size_t NC = 2048;
+	};
+
+	// Products with fewer multiply-adds than this aren't worth splitting
+	// across threads
+	const size_t GEMM_PARALLEL_MIN_WORK = 64 * 64 * 64;
+
+	// Smallest tile of C handed to one thread; smaller tiles spend more
+	// time packing than multiplying
+	const size_t GEMM_MIN_TILE = 64;
+
+	// Returns n rounded up to the next multiple of factor
+	inline size_t roundUp(const size_t n, const size_t factor)
+	{
+		return ((n + factor - 1) / factor) * factor;
+	}
+
+	// Packs the mc x kc block of A starting at (first_row, first_col),
+	// scaled by alpha, into A_pack as consecutive slivers of GEMM_MR rows;
+	// within a sliver, column p is stored as GEMM_MR adjacent elements;
+	// rows past the edge of A are filled with zeros
+	template <typename DataType>
+	inline void packBlockA(const MatrixView<const DataType>& A,
+		const size_t first_row,
+		const size_t first_col,
+		const size_t mc,
+		const size_t kc,
+		DataType* A_pack,
+		const DataType alpha)
+	{
+		const size_t row_stride = A.rowStride();
+		const size_t col_stride = A.colStride();
+
+		for (size_t ir = 0; ir < mc; ir += GEMM_MR)
+		{
+			size_t sliver_rows = std::min(GEMM_MR, mc - ir);
+			const DataType* A_sliver = A.data() +
+				(first_row + ir) * row_stride + first_col * col_stride;
+
+			for (size_t p = 0; p < kc; ++p)
+			{
+				for (size_t i = 0; i < sliver_rows; ++i)
+				{
+					A_pack[i] = alpha * A_sliver[i * row_stride + p * col_stride];
+				}
+				for (size_t i = sliver_rows; i < GEMM_MR; ++i)
+				{
+					A_pack[i] = 0;
+				}
+				A_pack += GEMM_MR;
+			}
+		}
+	}
+
+	// Packs the kc x nc block of B starting at (first_row, first_col) into
+	// B_pack as consecutive slivers of GEMM_NR columns; within a sliver,
+	// row p is stored as GEMM_NR adjacent elements; columns past the edge
+	// of B are filled with zeros
+	template <typename DataType>
+	inline void packBlockB(const MatrixView<const DataType>& B,
+		const size_t first_row,
+		const size_t first_col,
+		const size_t kc,
+		const size_t nc,
+		DataType* B_pack)
+	{
+		const size_t row_stride = B.rowStride();
+		const size_t col_stride = B.colStride();
+
+		for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+		{
+			size_t sliver_cols = std::min(GEMM_NR, nc - jr);
+			const DataType* B_sliver = B.data() +
+				first_row * row_stride + (first_col + jr) * col_stride;
+
+			for (size_t p = 0; p < kc; ++p)
+			{
+				for (size_t j = 0; j < sliver_cols; ++j)
+				{
+					B_pack[j] = B_sliver[p * row_stride + j * col_stride];
+				}
+				for (size_t j = sliver_cols; j < GEMM_NR; ++j)
+				{
+					B_pack[j] = 0;
+				}
+				B_pack += GEMM_NR;
+			}
+		}
+	}
+
+	// Computes the GEMM_MR x GEMM_NR tile A_sliver * B_sliver over kc
+	// steps in registers, with the SIMD tile kernel for float and double,
+	// and adds the top-left m x n corner of it to beta * C, whose element
+	// (i, j) is at C[i * row_stride + j * col_stride]; if beta is 0, C is
+	// overwritten without being read
+	template <typename DataType>
+	inline void gemmMicroKernel(const size_t kc,
+		const DataType* A_sliver,
+		const DataType* B_sliver,
+		DataType* C,
+		const size_t row_stride,
+		const size_t col_stride,
+		const size_t m,
+		const size_t n,
+		const DataType beta)
+	{
+		DataType tile[GEMM_MR * GEMM_NR];
+		gemmTileKernel(kc, A_sliver, B_sliver, tile);
+
+		// Scaling by beta is folded into the store, so C is only
+		// traversed once
+		for (size_t i = 0; i < m; ++i)
+		{
+			DataType* C_row = C + i * row_stride;
+			if (beta == DataType(1))
+			{
+				for (size_t j = 0; j < n; ++j)
+				{
+					C_row[j * col_stride] += tile[i * GEMM_NR + j];
+				}
+			}
+			else if (beta == DataType(0))
+			{
+				for (size_t j = 0; j < n; ++j)
+				{
+					C_row[j * col_stride] = tile[i * GEMM_NR + j];
+				}
+			}
+			else
+			{
+				for (size_t j = 0; j < n; ++j)
+				{
+					C_row[j * col_stride] = beta * C_row[j * col_stride] + tile[i * GEMM_NR + j];
+				}
+			}
+		}
+	}
+
+	// Multiplies a packed mc x kc block of A by a packed kc x nc panel of
+	// B and adds the result to beta times the mc x nc block of C starting
+	// at C_block
+	template <typename DataType>
+	inline void gemmMacroKernel(const size_t mc,
+		const size_t nc,
+		const size_t kc,
+		const DataType* A_pack,
+		const DataType* B_pack,
+		DataType* C_block,
+		const size_t row_stride,
+		const size_t col_stride,
+		const DataType beta)
+	{
+		for (size_t jr = 0; jr < nc; jr += GEMM_NR)
+		{
+			size_t n = std::min(GEMM_NR, nc - jr);
+			const DataType* B_sliver = B_pack + jr * kc;
+
+			for (size_t ir = 0; ir < mc; ir += GEMM_MR)
+			{
+				size_t m = std::min(GEMM_MR, mc - ir);
+				const DataType* A_sliver = A_pack + ir * kc;
+				DataType* C_tile = C_block +
+					ir * row_stride + jr * col_stride;
+
+				gemmMicroKernel(kc, A_sliver, B_sliver, C_tile,
+					row_stride, col_stride, m, n, beta);
+			}
+		}
+	}
+
+	// Returns a packing buffer owned by the calling thread that holds at
+	// least size elements; slot 0 is used for A and slot 1 for B
+	// Buffers only ever grow, so once a thread has multiplied matrices of
+	// some size, further products up to that size don't allocate
+	template <typename DataType>
+	inline DataType* gemmPackBuffer(const size_t slot, const size_t size)
+	{
+		thread_local std::vector<DataType> buffers[2];
+
+		std::vector<DataType>& buffer = buffers[slot];
+		if (buffer.size() < size)
+			buffer.resize(size);
+		return buffer.data();
+	}
+
+	// Computes C = alpha * A * B + beta * C with the blocked, packed 
+	// algorithm; A, B, and C may have any storage types and leading 
+	// dimensions, but C must not overlap A or B
+	// Following BLAS, if beta is 0 the old contents of C are never read,
+	// so C may start out uninitialized, and if alpha is 0 A and B are
+	// never read, so NaN or Inf in them don't reach C
+	template <typename DataType>
+	inline void gemmBlocked(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		const GemmBlockSizes& block_sizes = GemmBlockSizes(),
+		const typename NonDeduced<DataType>::type alpha = 1,
+		const typename NonDeduced<DataType>::type beta = 1)
+	{
+		if (A.cols() != B.rows() ||
+			C.rows() != A.rows() ||
+			C.cols() != B.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		const size_t m = C.rows();
+		const size_t n = C.cols();
+		const size_t k = A.cols();
+
+		if (m == 0 || n == 0)
+			return;
+
+		// With nothing to multiply, only the scaling of C is left
+		if (k == 0 || alpha == DataType(0))
+		{
+			if (beta == DataType(0))
+				C.fill(0);
+			else if (beta != DataType(1))
+			{
+				for (size_t i = 0; i < C.numLines(); ++i)
+				{
+					C.line(i).scale(beta);
+				}
+			}
+			return;
+		}
+
+		// Packed buffers are sized for the largest block actually used,
+		// so small products don't grow them to full-sized panels
+		const size_t MC = std::min(block_sizes.MC, roundUp(m, GEMM_MR));
+		const size_t KC = std::min(block_sizes.KC, k);
+		const size_t NC = std::min(block_sizes.NC, roundUp(n, GEMM_NR));
+
+		DataType* A_pack = gemmPackBuffer<DataType>(0, roundUp(MC, GEMM_MR) * KC);
+		DataType* B_pack = gemmPackBuffer<DataType>(1, roundUp(NC, GEMM_NR) * KC);
+
+		const size_t row_stride = C.rowStride();
+		const size_t col_stride = C.colStride();
+
+		for (size_t jc = 0; jc < n; jc += NC)
+		{
+			size_t nc = std::min(NC, n - jc);
+
+			for (size_t pc = 0; pc < k; pc += KC)
+			{
+				size_t kc = std::min(KC, k - pc);
+				packBlockB(B, pc, jc, kc, nc, B_pack);
+
+				// C is scaled by beta as the first panel is added to it
+				DataType panel_beta = (pc == 0) ? beta : DataType(1);
+
+				for (size_t ic = 0; ic < m; ic += MC)
+				{
+					size_t mc = std::min(MC, m - ic);
+					packBlockA(A, ic, pc, mc, kc, A_pack, alpha);
+
+					DataType* C_block = C.data() +
+						ic * row_stride + jc * col_stride;
+					gemmMacroKernel(mc, nc, kc, A_pack, B_pack,
+						C_block, row_stride, col_stride, panel_beta);
+				}
+			}
+		}
+	}
+
+	// Chooses the tile dimensions used to split an m x n block of C
+	// across num_threads threads; aims for about four tiles per thread so
+	// uneven tiles still balance, and keeps the tile grid close to the
+	// shape of C, which minimizes how often A and B are packed
+	inline void gemmTileGrid(const size_t m,
+		const size_t n,
+		const size_t num_threads,
+		size_t& tile_rows,
+		size_t& tile_cols)
+	{
+		const double target_tiles = 4.0 * num_threads;
+
+		size_t max_grid_rows = std::max<size_t>(1, m / GEMM_MIN_TILE);
+		size_t max_grid_cols = std::max<size_t>(1, n / GEMM_MIN_TILE);
+
+		size_t grid_rows = static_cast<size_t>(
+			std::lround(std::sqrt(target_tiles * m / n)));
+		grid_rows = std::min(std::max<size_t>(grid_rows, 1), max_grid_rows);
+
+		size_t grid_cols = static_cast<size_t>(
+			std::ceil(target_tiles / grid_rows));
+		grid_cols = std::min(std::max<size_t>(grid_cols, 1), max_grid_cols);
+
+		tile_rows = roundUp((m + grid_rows - 1) / grid_rows, GEMM_MR);
+		tile_cols = roundUp((n + grid_cols - 1) / grid_cols, GEMM_NR);
+	}
+
+	// Computes C = alpha * A * B + beta * C like gemmBlocked, but splits
+	// C into 2D tiles that are multiplied in parallel on given pool; every
+	// tile packs its own panels, so threads never share writable memory
+	// Small products run serially on the calling thread
+	template <typename DataType>
+	inline void gemmParallel(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		ThreadPool& pool = defaultThreadPool(),
+		const GemmBlockSizes& block_sizes = GemmBlockSizes(),
+		const typename NonDeduced<DataType>::type alpha = 1,
+		const typename NonDeduced<DataType>::type beta = 1)
+	{
+		if (A.cols() != B.rows() ||
+			C.rows() != A.rows() ||
+			C.cols() != B.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		const size_t m = C.rows();
+		const size_t n = C.cols();
+		const size_t k = A.cols();
+
+		if (pool.numThreads() == 1 || m * n * k < GEMM_PARALLEL_MIN_WORK)
+		{
+			gemmBlocked(A, B, C, block_sizes, alpha, beta);
+			return;
+		}
+
+		size_t tile_rows, tile_cols;
+		gemmTileGrid(m, n, pool.numThreads(), tile_rows, tile_cols);
+
+		const size_t grid_rows = (m + tile_rows - 1) / tile_rows;
+		const size_t grid_cols = (n + tile_cols - 1) / tile_cols;
+
+		pool.parallelFor(grid_rows * grid_cols, [&](const size_t tile)
+		{
+			size_t first_row = (tile / grid_cols) * tile_rows;
+			size_t first_col = (tile % grid_cols) * tile_cols;
+			size_t last_row = std::min(first_row + tile_rows, m);
+			size_t last_col = std::min(first_col + tile_cols, n);
+
+			gemmBlocked(A.subView(first_row, last_row, 0, k),
+				B.subView(0, k, first_col, last_col),
+				C.subView(first_row, last_row, first_col, last_col),
+				block_sizes, alpha, beta);
+		});
+	}
+}
+
+#endif
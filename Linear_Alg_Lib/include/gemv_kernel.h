@@ -0,0 +1,195 @@
+#ifndef GEMV_KERNEL_H
+#define GEMV_KERNEL_H
+
+#include <vector>
+#include <algorithm>
+
+#include "matrix_view.h"
+#include "exceptions.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+// ------------------------------------------------------------------
+// Matrix-vector multiplication engine; the matrix is streamed through
+// once in whichever order it is stored, with rows reduced by
+// dotKernel() or columns accumulated by axpyKernel(), so every pass
+// over memory is contiguous and vectorized
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Products over matrices with fewer elements than this run on one
+	// thread; smaller ones fit in cache and finish before the threads
+	// would start
+	const size_t GEMV_PARALLEL_MIN_SIZE = 1 << 16;
+
+	// Fewest rows of y computed by one thread
+	const size_t GEMV_MIN_BAND = 64;
+
+	// Scales y by beta; if beta is 0, y is overwritten without being read
+	template <typename DataType>
+	inline void gemvScale(const VectorView<DataType>& y,
+		const DataType beta)
+	{
+		if (beta == DataType(0))
+			y.fill(0);
+		else if (beta != DataType(1))
+			y.scale(beta);
+	}
+
+	// Computes y = alpha * A * x + beta * y for a RowMajor A one row at a
+	// time, each row a contiguous dot product with x, which must be
+	// contiguous
+	template <typename DataType>
+	inline void gemvRows(const ConstMatrixView<DataType>& A,
+		const DataType* x,
+		const VectorView<DataType>& y,
+		const DataType alpha,
+		const DataType beta)
+	{
+		const size_t ld = A.leadingDim();
+		for (size_t i = 0; i < A.rows(); ++i)
+		{
+			DataType dot = dotKernel(A.data() + i * ld, x, A.cols());
+			y[i] = (beta == DataType(0)) ?
+				alpha * dot : alpha * dot + beta * y[i];
+		}
+	}
+
+	// Computes y += alpha * A * x for a ColumnMajor A one column at a
+	// time, adding each contiguous column scaled by alpha * x[j] to y,
+	// which must be contiguous
+	template <typename DataType>
+	inline void gemvCols(const ConstMatrixView<DataType>& A,
+		const VectorView<const DataType>& x,
+		DataType* y,
+		const DataType alpha)
+	{
+		const size_t ld = A.leadingDim();
+		for (size_t j = 0; j < A.cols(); ++j)
+		{
+			DataType factor = alpha * x[j];
+			if (factor != DataType(0))
+				axpyKernel(factor, A.data() + j * ld, y, A.rows());
+		}
+	}
+
+	// Computes y = alpha * A * x + beta * y; A may have either storage
+	// type and any leading dimension, and x and y any stride, but y must
+	// not overlap A or x
+	// Matrices are split into bands of rows across given pool when they
+	// are tall, and into panels of columns, each summed into its own copy
+	// of y, when they are too short to give every thread a band, such as
+	// the transpose of a tall ColumnMajor matrix
+	// Following BLAS, if beta is 0 the old contents of y are never read
+	template <typename DataType>
+	inline void gemvParallel(const ConstMatrixView<DataType>& A,
+		const ConstVectorView<DataType>& x,
+		const VectorView<DataType>& y,
+		ThreadPool& pool = defaultThreadPool(),
+		const typename NonDeduced<DataType>::type alpha = 1,
+		const typename NonDeduced<DataType>::type beta = 1)
+	{
+		if (A.cols() != x.size() || A.rows() != y.size())
+			throw InvalidDimensions();
+
+		const size_t m = A.rows();
+		const size_t n = A.cols();
+
+		if (m == 0)
+			return;
+
+		if (n == 0)
+		{
+			gemvScale(y, beta);
+			return;
+		}
+
+		// Kernels need contiguous vectors; strided ones go through copies
+		std::vector<DataType> x_copy, y_copy;
+		const DataType* x_data = x.data();
+		if (!x.isContiguous())
+		{
+			x_copy = x.toStdVector();
+			x_data = x_copy.data();
+		}
+
+		VectorView<DataType> y_out = y;
+		if (!y.isContiguous())
+		{
+			y_copy = y.toStdVector();
+			y_out = VectorView<DataType>(y_copy.data(), m);
+		}
+
+		const size_t num_threads = pool.numThreads();
+		const bool parallel = num_threads > 1 && m * n >= GEMV_PARALLEL_MIN_SIZE;
+		const size_t band_rows = parallel ?
+			std::max(GEMV_MIN_BAND, (m + 4 * num_threads - 1) / (4 * num_threads)) : m;
+		const size_t num_bands = (m + band_rows - 1) / band_rows;
+
+		if (parallel && num_bands < num_threads)
+		{
+			// Short, wide matrix; each panel of columns sums into its own
+			// vector, and the vectors are added into y at the end
+			const size_t num_panels = std::min(num_threads, n);
+			const size_t panel_cols = (n + num_panels - 1) / num_panels;
+			std::vector<DataType> partials(num_panels * m);
+
+			pool.parallelFor(num_panels, [&](const size_t panel)
+			{
+				size_t first = panel * panel_cols;
+				size_t last = std::min(first + panel_cols, n);
+				if (first >= last)
+					return;
+
+				DataType* partial = partials.data() + panel * m;
+				if (A.getStorageType() == StorageType::RowMajor)
+				{
+					gemvRows(A.subView(0, m, first, last), x_data + first,
+						VectorView<DataType>(partial, m), alpha, DataType(0));
+				}
+				else
+				{
+					gemvCols(A.subView(0, m, first, last),
+						VectorView<const DataType>(x_data + first, last - first),
+						partial, alpha);
+				}
+			});
+
+			gemvScale(y_out, beta);
+			for (size_t panel = 0; panel < num_panels; ++panel)
+			{
+				axpyKernel(DataType(1), partials.data() + panel * m,
+					y_out.data(), m);
+			}
+		}
+		else if (A.getStorageType() == StorageType::RowMajor)
+		{
+			pool.parallelFor(num_bands, [&](const size_t band)
+			{
+				size_t first = band * band_rows;
+				size_t last = std::min(first + band_rows, m);
+				gemvRows(A.subView(first, last, 0, n), x_data,
+					y_out.subView(first, last), alpha, beta);
+			});
+		}
+		else
+		{
+			VectorView<const DataType> x_view(x_data, n);
+			pool.parallelFor(num_bands, [&](const size_t band)
+			{
+				size_t first = band * band_rows;
+				size_t last = std::min(first + band_rows, m);
+				VectorView<DataType> y_band = y_out.subView(first, last);
+				gemvScale(y_band, beta);
+				gemvCols(A.subView(first, last, 0, n), x_view,
+					y_band.data(), alpha);
+			});
+		}
+
+		if (!y.isContiguous())
+			y.assign(VectorView<const DataType>(y_copy.data(), m));
+	}
+}
+
+#endif
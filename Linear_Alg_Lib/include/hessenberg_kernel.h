@@ -0,0 +1,523 @@
+#ifndef HESSENBERG_KERNEL_H
+#define HESSENBERG_KERNEL_H
+
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <limits>
+
+#include "dense_matrix.h"
+#include "matrix_view.h"
+#include "householder_kernel.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Eigenvalue tools for small, nonsymmetric upper Hessenberg matrices,
+// such as the projections built by the Arnoldi process; eigenvalues
+// come from the Francis double shift QR algorithm, so complex
+// conjugate pairs never need complex arithmetic, implicit QR steps
+// with chosen shifts filter a Hessenberg matrix while accumulating the
+// orthogonal transformation, and eigenvectors come from inverse
+// iteration
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Most QR iterations spent on one eigenvalue before giving up
+	const size_t HESSENBERG_MAX_ITERATIONS = 30;
+
+	// Returns the eigenvalues of the upper Hessenberg matrix H; complex
+	// conjugate pairs are adjacent, the one with positive imaginary part
+	// first; elements below the subdiagonal are never read
+	// Throws InvalidDimensions if H isn't square, and NoConvergence in the
+	// rare case the QR iteration doesn't converge
+	template <typename DataType>
+	inline std::vector<std::complex<DataType> > hessenbergEigenvalues(
+		const ConstMatrixView<DataType>& H)
+	{
+		if (!H.isSquare())
+			throw InvalidDimensions();
+
+		const size_t n = H.rows();
+		const DataType eps = std::numeric_limits<DataType>::epsilon();
+		DenseMatrix<DataType> work(H, StorageType::ColumnMajor);
+		MatrixView<DataType> a = work.view();
+		std::vector<std::complex<DataType> > values(n);
+
+		// Scale of the matrix, used where a subdiagonal element has no
+		// nonzero neighbours to be judged against
+		DataType norm = 0;
+		for (size_t j = 0; j < n; ++j)
+		{
+			for (size_t i = 0; i <= std::min(j + 1, n - 1); ++i)
+			{
+				norm += std::abs(a(i, j));
+			}
+		}
+
+		// Eigenvalues of rows and columns [last, n) have been found, and
+		// shift_total was subtracted from the diagonal by exceptional
+		// shifts
+		DataType shift_total = 0;
+		size_t last = n;
+		size_t iterations = 0;
+		while (last > 0)
+		{
+			const size_t end = last - 1;
+
+			// Start of the unreduced block that ends at row end
+			size_t low = end;
+			for (; low > 0; --low)
+			{
+				DataType s = std::abs(a(low - 1, low - 1)) + std::abs(a(low, low));
+				if (s == DataType(0))
+					s = norm;
+				if (std::abs(a(low, low - 1)) <= eps * s)
+				{
+					a(low, low - 1) = 0;
+					break;
+				}
+			}
+
+			DataType x = a(end, end);
+			if (low == end)
+			{
+				values[end] = x + shift_total;
+				last -= 1;
+				iterations = 0;
+				continue;
+			}
+
+			DataType y = a(end - 1, end - 1);
+			DataType w = a(end, end - 1) * a(end - 1, end);
+			if (low == end - 1)
+			{
+				// A 2 x 2 block has split off; its eigenvalues are either
+				// both real or a conjugate pair
+				DataType p = (y - x) / 2;
+				DataType q = p * p + w;
+				DataType z = std::sqrt(std::abs(q));
+				x += shift_total;
+				if (q >= DataType(0))
+				{
+					z = p + std::copysign(z, p);
+					values[end - 1] = values[end] = x + z;
+					if (z != DataType(0))
+						values[end] = x - w / z;
+				}
+				else
+				{
+					values[end - 1] = std::complex<DataType>(x + p, z);
+					values[end] = std::complex<DataType>(x + p, -z);
+				}
+				last -= 2;
+				iterations = 0;
+				continue;
+			}
+
+			if (iterations == HESSENBERG_MAX_ITERATIONS)
+				throw NoConvergence();
+
+			// Exceptional shifts break the rare cycles the standard
+			// shifts can fall into
+			if (iterations == 10 || iterations == 20)
+			{
+				shift_total += x;
+				for (size_t i = 0; i <= end; ++i)
+				{
+					a(i, i) -= x;
+				}
+				DataType s = std::abs(a(end, end - 1)) + std::abs(a(end - 1, end - 2));
+				x = y = DataType(0.75) * s;
+				w = DataType(-0.4375) * s * s;
+			}
+			++iterations;
+
+			// The step starts at the lowest row where two consecutive
+			// subdiagonal elements are small enough to leave it
+			// unaffected by the rows above
+			size_t first = end - 2;
+			DataType p = 0, q = 0, r = 0, z = 0;
+			for (; ; --first)
+			{
+				z = a(first, first);
+				r = x - z;
+				DataType s = y - z;
+				p = (r * s - w) / a(first + 1, first) + a(first, first + 1);
+				q = a(first + 1, first + 1) - z - r - s;
+				r = a(first + 2, first + 1);
+				s = std::abs(p) + std::abs(q) + std::abs(r);
+				if (s != DataType(0))
+				{
+					p /= s;
+					q /= s;
+					r /= s;
+				}
+				if (first == low)
+					break;
+
+				DataType u = std::abs(a(first, first - 1)) * (std::abs(q) + std::abs(r));
+				DataType v = std::abs(p) * (std::abs(a(first - 1, first - 1)) +
+					std::abs(z) + std::abs(a(first + 1, first + 1)));
+				if (u <= eps * v)
+					break;
+			}
+
+			for (size_t i = first + 2; i <= end; ++i)
+			{
+				a(i, i - 2) = 0;
+				if (i != first + 2)
+					a(i, i - 3) = 0;
+			}
+
+			// Double shift QR step on rows and columns [low, end], with
+			// the bulge chased down the subdiagonal by 3 x 3 reflectors
+			for (size_t k = first; k < end; ++k)
+			{
+				if (k != first)
+				{
+					p = a(k, k - 1);
+					q = a(k + 1, k - 1);
+					r = (k != end - 1) ? a(k + 2, k - 1) : DataType(0);
+					x = std::abs(p) + std::abs(q) + std::abs(r);
+					if (x != DataType(0))
+					{
+						p /= x;
+						q /= x;
+						r /= x;
+					}
+				}
+
+				DataType s = std::copysign(std::sqrt(p * p + q * q + r * r), p);
+				if (s == DataType(0))
+					continue;
+
+				if (k == first)
+				{
+					if (low != first)
+						a(k, k - 1) = -a(k, k - 1);
+				}
+				else
+				{
+					a(k, k - 1) = -s * x;
+				}
+
+				p += s;
+				x = p / s;
+				y = q / s;
+				z = r / s;
+				q /= p;
+				r /= p;
+
+				for (size_t j = k; j <= end; ++j)
+				{
+					p = a(k, j) + q * a(k + 1, j);
+					if (k != end - 1)
+					{
+						p += r * a(k + 2, j);
+						a(k + 2, j) -= p * z;
+					}
+					a(k + 1, j) -= p * y;
+					a(k, j) -= p * x;
+				}
+
+				for (size_t i = low; i <= std::min(end, k + 3); ++i)
+				{
+					p = x * a(i, k) + y * a(i, k + 1);
+					if (k != end - 1)
+					{
+						p += z * a(i, k + 2);
+						a(i, k + 2) -= p * r;
+					}
+					a(i, k + 1) -= p * q;
+					a(i, k) -= p;
+				}
+			}
+		}
+
+		return values;
+	}
+
+	// Applies the reflector I - tau v v^T, where v = [1, tail] has given
+	// length of at most 3, to rows and columns [k, k + length) of H,
+	// overwriting H with P H P, and to the same columns of Q
+	// Only columns [k, n) of the rows and rows [0, last_row] of the
+	// columns are touched, as the rest of them are zero
+	template <typename DataType>
+	inline void hessenbergReflect(const MatrixView<DataType>& H,
+		const MatrixView<DataType>& Q,
+		const size_t k,
+		const size_t length,
+		const DataType* tail,
+		const DataType tau,
+		const size_t last_row)
+	{
+		const DataType v[3] = { 1, tail[0], length > 2 ? tail[1] : DataType(0) };
+
+		for (size_t j = k; j < H.cols(); ++j)
+		{
+			DataType sum = 0;
+			for (size_t i = 0; i < length; ++i)
+			{
+				sum += v[i] * H(k + i, j);
+			}
+			sum *= tau;
+			for (size_t i = 0; i < length; ++i)
+			{
+				H(k + i, j) -= sum * v[i];
+			}
+		}
+
+		auto reflect_columns = [&](const MatrixView<DataType>& C, const size_t rows)
+		{
+			for (size_t r = 0; r < rows; ++r)
+			{
+				DataType sum = 0;
+				for (size_t i = 0; i < length; ++i)
+				{
+					sum += v[i] * C(r, k + i);
+				}
+				sum *= tau;
+				for (size_t i = 0; i < length; ++i)
+				{
+					C(r, k + i) -= sum * v[i];
+				}
+			}
+		};
+
+		reflect_columns(H, last_row + 1);
+		reflect_columns(Q, Q.rows());
+	}
+
+	// Runs one implicit QR step on the unreduced block of H in rows and
+	// columns [low, high], given the first column of the shift polynomial
+	// applied to the block, of length bulge (2 for one shift, 3 for two);
+	// every reflector zeroes the bulge the one before it left below the
+	// subdiagonal
+	template <typename DataType>
+	inline void hessenbergChase(const MatrixView<DataType>& H,
+		const MatrixView<DataType>& Q,
+		const size_t low,
+		const size_t high,
+		const DataType* first_column,
+		const size_t bulge)
+	{
+		for (size_t k = low; k < high; ++k)
+		{
+			const size_t length = std::min(bulge, high - k + 1);
+			DataType x[3];
+			for (size_t i = 0; i < length; ++i)
+			{
+				x[i] = (k == low) ? first_column[i] : H(k + i, k - 1);
+			}
+
+			DataType tau = householderReflector(x, length);
+			if (k != low)
+			{
+				H(k, k - 1) = x[0];
+				for (size_t i = 1; i < length; ++i)
+				{
+					H(k + i, k - 1) = 0;
+				}
+			}
+
+			if (tau != DataType(0))
+				hessenbergReflect(H, Q, k, length, x + 1, tau, std::min(high, k + length));
+		}
+	}
+
+	// Calls step(low, high) for every unreduced diagonal block of the
+	// upper Hessenberg H with more than one row, after setting negligible
+	// subdiagonal elements to zero
+	template <typename DataType, typename Func>
+	inline void forEachUnreducedBlock(const MatrixView<DataType>& H,
+		const Func& step)
+	{
+		const size_t n = H.rows();
+		const DataType eps = std::numeric_limits<DataType>::epsilon();
+
+		size_t low = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			bool split = (i + 1 == n);
+			if (!split && std::abs(H(i + 1, i)) <=
+				eps * (std::abs(H(i, i)) + std::abs(H(i + 1, i + 1))))
+			{
+				H(i + 1, i) = 0;
+				split = true;
+			}
+
+			if (split)
+			{
+				if (i > low)
+					step(low, i);
+				low = i + 1;
+			}
+		}
+	}
+
+	// Applies one implicit QR step with the real shift to the square upper
+	// Hessenberg H, which is overwritten with Z^T H Z for the orthogonal Z
+	// of the step, and overwrites Q, which has H.rows() columns, with Q Z
+	// Blocks split off by zero subdiagonal elements are stepped separately
+	template <typename DataType>
+	inline void hessenbergShiftStep(const MatrixView<DataType>& H,
+		const DataType shift,
+		const MatrixView<DataType>& Q)
+	{
+		forEachUnreducedBlock(H, [&](const size_t low, const size_t high)
+		{
+			DataType first_column[2] = { H(low, low) - shift, H(low + 1, low) };
+			hessenbergChase(H, Q, low, high, first_column, 2);
+		});
+	}
+
+	// Applies one implicit double shift QR step with the shifts mu and
+	// conj(mu) to H, accumulating the transformation into Q as for
+	// hessenbergShiftStep(); the step is equivalent to two complex single
+	// shift steps, but runs in real arithmetic
+	template <typename DataType>
+	inline void hessenbergDoubleShiftStep(const MatrixView<DataType>& H,
+		const std::complex<DataType>& shift,
+		const MatrixView<DataType>& Q)
+	{
+		const DataType sum = 2 * shift.real();
+		const DataType product = std::norm(shift);
+
+		forEachUnreducedBlock(H, [&](const size_t low, const size_t high)
+		{
+			// First column of (H - mu I)(H - conj(mu) I), scaled to avoid
+			// overflow
+			DataType first_column[3] = {
+				H(low, low) * H(low, low) + H(low, low + 1) * H(low + 1, low) -
+					sum * H(low, low) + product,
+				H(low + 1, low) * (H(low, low) + H(low + 1, low + 1) - sum),
+				(low + 1 < high) ? H(low + 1, low) * H(low + 2, low + 1) : DataType(0) };
+
+			DataType scale = std::abs(first_column[0]) + std::abs(first_column[1]) +
+				std::abs(first_column[2]);
+			if (scale == DataType(0))
+				return;
+			for (DataType& element : first_column)
+			{
+				element /= scale;
+			}
+			hessenbergChase(H, Q, low, high, first_column, 3);
+		});
+	}
+
+	// Returns the eigenvector of the upper Hessenberg H for its eigenvalue
+	// lambda by inverse iteration, which converges in a step or two as
+	// lambda is already accurate; the vector has unit length, and its
+	// largest element is real and positive, so real eigenvalues have
+	// real eigenvectors
+	template <typename DataType>
+	inline std::vector<std::complex<DataType> > hessenbergEigenvector(
+		const ConstMatrixView<DataType>& H,
+		const std::complex<DataType>& lambda)
+	{
+		using Complex = std::complex<DataType>;
+
+		if (!H.isSquare())
+			throw InvalidDimensions();
+
+		const size_t n = H.rows();
+		std::vector<Complex> y(n, Complex(1));
+		if (n == 0)
+			return y;
+
+		DataType norm = 0;
+		for (size_t j = 0; j < n; ++j)
+		{
+			for (size_t i = 0; i <= std::min(j + 1, n - 1); ++i)
+			{
+				norm = std::max(norm, std::abs(H(i, j)));
+			}
+		}
+
+		// Pivots that are exactly zero, as they are when lambda is an
+		// exact eigenvalue, are replaced by a perturbation far below the
+		// accuracy of lambda
+		const DataType tiny = std::max(norm, DataType(1)) *
+			std::numeric_limits<DataType>::epsilon();
+
+		// LU factors of H - lambda I, RowMajor; pivoting only ever swaps
+		// neighbouring rows, since every column has a single element below
+		// the diagonal
+		std::vector<Complex> lu(n * n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t j = (i > 0) ? i - 1 : 0; j < n; ++j)
+			{
+				lu[i * n + j] = H(i, j);
+			}
+			lu[i * n + i] -= lambda;
+		}
+
+		std::vector<Complex> multipliers(n);
+		std::vector<bool> swapped(n, false);
+		for (size_t k = 0; k + 1 < n; ++k)
+		{
+			Complex* row = &lu[k * n];
+			Complex* next = &lu[(k + 1) * n];
+			if (std::abs(next[k]) > std::abs(row[k]))
+			{
+				std::swap_ranges(row + k, row + n, next + k);
+				swapped[k] = true;
+			}
+			if (row[k] == Complex(0))
+				row[k] = tiny;
+
+			multipliers[k] = next[k] / row[k];
+			for (size_t j = k + 1; j < n; ++j)
+			{
+				next[j] -= multipliers[k] * row[j];
+			}
+			next[k] = 0;
+		}
+		if (lu[n * n - 1] == Complex(0))
+			lu[n * n - 1] = tiny;
+
+		for (size_t iteration = 0; iteration < 3; ++iteration)
+		{
+			for (size_t k = 0; k + 1 < n; ++k)
+			{
+				if (swapped[k])
+					std::swap(y[k], y[k + 1]);
+				y[k + 1] -= multipliers[k] * y[k];
+			}
+
+			for (size_t i = n; i-- > 0; )
+			{
+				Complex sum = y[i];
+				for (size_t j = i + 1; j < n; ++j)
+				{
+					sum -= lu[i * n + j] * y[j];
+				}
+				y[i] = sum / lu[i * n + i];
+			}
+
+			DataType length = 0;
+			size_t largest = 0;
+			for (size_t i = 0; i < n; ++i)
+			{
+				length += std::norm(y[i]);
+				if (std::abs(y[i]) > std::abs(y[largest]))
+					largest = i;
+			}
+
+			// Unit length, with the phase that makes y[largest] real
+			Complex factor = std::conj(y[largest]) /
+				(std::abs(y[largest]) * std::sqrt(length));
+			for (Complex& element : y)
+			{
+				element *= factor;
+			}
+		}
+
+		return y;
+	}
+}
+
+#endif
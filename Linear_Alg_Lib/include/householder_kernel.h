@@ -0,0 +1,140 @@
+#ifndef HOUSEHOLDER_KERNEL_H
+#define HOUSEHOLDER_KERNEL_H
+
+#include <vector>
+#include <cmath>
+
+#include "dense_matrix.h"
+#include "matrix_view.h"
+#include "matrix_utils.h"
+#include "simd_kernels.h"
+#include "gemm_kernel.h"
+#include "thread_pool.h"
+
+// ------------------------------------------------------------------
+// Householder reflectors H = I - tau v v^T, shared by the factorizations
+// that reduce a matrix with them; single reflectors are formed and
+// applied with vectorized dot products and axpys, and a panel of them is
+// combined into the compact WY form I - V T V^T, which applies to a
+// whole matrix as three GEMMs
+// Reflectors are stored the LAPACK way: v[0] = 1 is implied and only the
+// rest of v is kept, in the column below the element the reflector
+// zeroes out
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Turns the contiguous x into the reflector H with Hx = beta * e_1;
+	// x[0] is overwritten with beta and the rest of x with the tail of
+	// v; returns tau, which is 0, making H the identity, if the tail of
+	// x is already zero
+	template <typename DataType>
+	inline DataType householderReflector(DataType* x, const size_t length)
+	{
+		if (length < 2)
+			return 0;
+
+		DataType alpha = x[0];
+		DataType sigma = dotKernel(x + 1, x + 1, length - 1);
+		if (sigma == DataType(0))
+			return 0;
+
+		DataType beta = std::sqrt(alpha * alpha + sigma);
+		if (alpha > DataType(0))
+			beta = -beta;
+
+		VectorView<DataType>(x + 1, length - 1).scale(1 / (alpha - beta));
+		x[0] = beta;
+		return (beta - alpha) / beta;
+	}
+
+	// Applies the reflector with given tau and v = [1, v_tail] to the
+	// contiguous c of given length: c -= tau (v^T c) v
+	template <typename DataType>
+	inline void applyHouseholder(const DataType* v_tail,
+		const DataType tau,
+		DataType* c,
+		const size_t length)
+	{
+		if (tau == DataType(0) || length == 0)
+			return;
+
+		DataType w = tau * (c[0] + dotKernel(v_tail, c + 1, length - 1));
+		c[0] -= w;
+		axpyKernel(-w, v_tail, c + 1, length - 1);
+	}
+
+	// Forms the upper triangular T with H_0 H_1 ... H_{nb-1} = I - V T V^T
+	// for the reflectors in the columns of the ColumnMajor V, where
+	// column j has its implied 1 at row j, and tau[0, nb); one column at
+	// a time, T(j, j) = tau_j and T[0, j)(j) = -tau_j T[0, j)[0, j) V^T v_j
+	template <typename DataType>
+	inline void householderBlockFactor(const ConstMatrixView<DataType>& V,
+		const DataType* tau,
+		const MatrixView<DataType>& T)
+	{
+		const size_t m = V.rows();
+		const size_t nb = V.cols();
+		std::vector<DataType> z(nb);
+
+		for (size_t j = 0; j < nb; ++j)
+		{
+			T(j, j) = tau[j];
+
+			// z = V[0, j)^T v_j, using that v_j is zero above row j
+			for (size_t p = 0; p < j; ++p)
+			{
+				z[p] = V(j, p) + dotKernel(&V(0, p) + j + 1, &V(0, j) + j + 1, m - j - 1);
+			}
+
+			for (size_t r = 0; r < j; ++r)
+			{
+				DataType sum = 0;
+				for (size_t p = r; p < j; ++p)
+				{
+					sum += T(r, p) * z[p];
+				}
+				T(r, j) = -tau[j] * sum;
+			}
+		}
+	}
+
+	// Computes C = (I - V op(T) V^T) C, where V and T are as for
+	// householderBlockFactor(); with trans_T Transpose this applies
+	// H_{nb-1} ... H_0, and otherwise H_0 ... H_{nb-1}
+	// Runs as three GEMMs across given pool, through a copy of V with its
+	// unit diagonal and zero upper triangle filled in
+	template <typename DataType>
+	inline void applyHouseholderBlock(const ConstMatrixView<DataType>& V,
+		const ConstMatrixView<DataType>& T,
+		const MatrixView<DataType>& C,
+		const TransposeOp trans_T,
+		ThreadPool& pool = defaultThreadPool())
+	{
+		const size_t nb = V.cols();
+		const size_t nc = C.cols();
+		if (V.rows() != C.rows())
+			throw InvalidDimensions();
+		if (nc == 0 || nb == 0)
+			return;
+
+		DenseMatrix<DataType> V_full(V, StorageType::ColumnMajor);
+		for (size_t j = 0; j < nb; ++j)
+		{
+			V_full.colView(j).subView(0, j).fill(0);
+			V_full.at(j, j) = 1;
+		}
+
+		// W = V^T C, then W = op(T) W, then C -= V W
+		DenseMatrix<DataType> W(nb, nc);
+		gemmParallel(V_full.transposeView(), C, W.view(), pool, GemmBlockSizes(), 1, 0);
+
+		DenseMatrix<DataType> TW(nb, nc);
+		gemmParallel(applyTranspose(T, trans_T), W.view(), TW.view(), pool,
+			GemmBlockSizes(), 1, 0);
+
+		gemmParallel(V_full.view(), TW.view(), C, pool, GemmBlockSizes(), -1, 1);
+	}
+}
+
+#endif
@@ -0,0 +1,585 @@
+#ifndef KRYLOV_EIGENSOLVER_H
+#define KRYLOV_EIGENSOLVER_H
+
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <type_traits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemv_kernel.h"
+#include "gemm_kernel.h"
+#include "hessenberg_kernel.h"
+#include "symmetric_eigensolver.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Krylov subspace eigensolvers for a few eigenpairs at one end of the
+// spectrum of a large matrix, which only has to be multiplied with
+// vectors; any operator that maps a MathVector to a MathVector will do,
+// such as a lambda around a sparse product
+// An orthonormal basis of m = O(k) vectors is built by the Arnoldi
+// process, the eigenpairs of the small projected matrix approximate
+// those of the operator, and the basis is shrunk to the wanted part and
+// extended again until they converge, so memory stays at O(nk)
+// Every new basis vector is orthogonalized against the whole basis
+// twice, each pass two GEMVs on the basis as a dense matrix, which
+// keeps the basis orthonormal to working precision
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Which end of the spectrum to compute
+	enum class EigenTarget { Largest, Smallest };
+
+	// Fewest vectors in a basis; a basis of 2k + 1 vectors is used when
+	// that is more
+	const size_t KRYLOV_MIN_DIMENSION = 20;
+
+	// Most restarts before giving up
+	const size_t KRYLOV_MAX_RESTARTS = 1000;
+
+	// Orthonormal basis V of a Krylov subspace and the projection
+	// H = V^T A V of the operator A onto it, in the Arnoldi relation
+	// A V[0, m) = V[0, m + 1) H, where H is upper Hessenberg with m + 1
+	// rows and m columns
+	template <typename DataType>
+	class ArnoldiProcess
+	{
+	public:
+
+		// Constructor; creates a basis of m vectors of given size, plus
+		// the residual direction, starting from a random unit vector
+		ArnoldiProcess(const size_t size_in,
+			const size_t dimension_in) :
+			_basis(size_in, dimension_in + 1),
+			_projection(dimension_in + 1, dimension_in),
+			_generator(std::mt19937::default_seed)
+		{
+			randomize(0);
+		}
+
+		size_t size() const
+		{
+			return _basis.rows();
+		}
+
+		// Returns number of basis vectors, m
+		size_t dimension() const
+		{
+			return _projection.cols();
+		}
+
+		// Returns the m x m projection of the operator onto the basis
+		MatrixView<const DataType> projection() const
+		{
+			return _projection.subMatrixView(0, dimension(), 0, dimension());
+		}
+
+		MatrixView<DataType> projection()
+		{
+			return _projection.subMatrixView(0, dimension(), 0, dimension());
+		}
+
+		// Returns the norm of the residual left after the last basis
+		// vector, H(m, m - 1); it is zero when the basis spans an
+		// invariant subspace
+		DataType residualNorm() const
+		{
+			return _projection.at(dimension(), dimension() - 1);
+		}
+
+		// Sets the projection's element (row, col)
+		void setProjection(const size_t row,
+			const size_t col,
+			const DataType value)
+		{
+			_projection.at(row, col) = value;
+		}
+
+		// Extends the basis from first to m vectors by Arnoldi steps; step
+		// j multiplies vector j by the operator and orthogonalizes the
+		// product against vectors [0, j] into vector j + 1, which
+		// fills in column j of the projection
+		template <typename Operator>
+		void extend(const Operator& op,
+			const size_t first)
+		{
+			for (size_t j = first; j < dimension(); ++j)
+			{
+				MathVector<DataType> product = op(MathVector<DataType>(_basis.colView(j)));
+				if (product.size() != size())
+					throw InvalidDimensions();
+
+				_basis.colView(j + 1).assign(product.view());
+				_projection.colView(j).fill(0);
+				_projection.at(j + 1, j) = orthogonalize(j + 1, &_projection.at(0, j));
+			}
+		}
+
+		// Replaces vectors [0, cols) of the basis with the first cols
+		// columns of V[0, m) Y, for given m x cols Y, in one GEMM
+		void rotate(const ConstMatrixView<DataType>& Y)
+		{
+			const size_t cols = Y.cols();
+			DenseMatrix<DataType> rotated = combine(Y);
+			_basis.subMatrixView(0, size(), 0, cols).assign(rotated.view());
+		}
+
+		// Returns V[0, m) Y as a ColumnMajor matrix
+		DenseMatrix<DataType> combine(const ConstMatrixView<DataType>& Y) const
+		{
+			DenseMatrix<DataType> result(size(), Y.cols());
+			gemmParallel(_basis.subMatrixView(0, size(), 0, dimension()), Y,
+				result.view(), defaultThreadPool(), GemmBlockSizes(), 1, 0);
+			return result;
+		}
+
+		// Returns view of basis vector j
+		VectorView<DataType> vector(const size_t j)
+		{
+			return _basis.colView(j);
+		}
+
+		// Orthogonalizes basis vector count against vectors [0, count) and
+		// normalizes it, adding the projections it lost to coefficients;
+		// returns its norm after orthogonalization, or 0 if that was
+		// negligible, in which case the vector is replaced by a random one
+		// orthogonal to the rest, or by zero if the basis spans the whole
+		// space
+		DataType orthogonalize(const size_t count,
+			DataType* coefficients)
+		{
+			VectorView<DataType> v = _basis.colView(count);
+			const DataType original = norm(v);
+			project(count, coefficients);
+
+			DataType beta = norm(v);
+			if (beta > std::numeric_limits<DataType>::epsilon() * original)
+			{
+				v.scale(1 / beta);
+				return beta;
+			}
+
+			if (count == size())
+			{
+				v.fill(0);
+				return 0;
+			}
+
+			std::vector<DataType> discarded(count);
+			randomize(count);
+			project(count, discarded.data());
+			v.scale(1 / norm(v));
+			return 0;
+		}
+
+	private:
+
+		// Returns Euclidean norm of the contiguous v
+		static DataType norm(const VectorView<DataType>& v)
+		{
+			return std::sqrt(dotKernel(v.data(), v.data(), v.size()));
+		}
+
+		// Subtracts the projection onto vectors [0, count) from vector
+		// count twice, since one pass of classical Gram-Schmidt leaves
+		// errors in proportion to the condition of the vectors, and a
+		// second pass brings them down to rounding
+		void project(const size_t count,
+			DataType* coefficients)
+		{
+			if (count == 0)
+				return;
+
+			MatrixView<const DataType> V = _basis.subMatrixView(0, size(), 0, count);
+			VectorView<DataType> v = _basis.colView(count);
+			std::vector<DataType> h(count);
+			VectorView<DataType> h_view(h.data(), count);
+
+			for (size_t pass = 0; pass < 2; ++pass)
+			{
+				gemvParallel(V.transposed(), ConstVectorView<DataType>(v), h_view,
+					defaultThreadPool(), 1, 0);
+				gemvParallel(V, ConstVectorView<DataType>(h_view), v,
+					defaultThreadPool(), -1, 1);
+				axpyKernel(DataType(1), h.data(), coefficients, count);
+			}
+		}
+
+		// Fills basis vector j with a random unit vector
+		void randomize(const size_t j)
+		{
+			std::uniform_real_distribution<DataType> distribution(-1, 1);
+			VectorView<DataType> v = _basis.colView(j);
+			for (size_t i = 0; i < v.size(); ++i)
+			{
+				v[i] = distribution(_generator);
+			}
+			v.scale(1 / norm(v));
+		}
+
+		// Basis vectors as columns, with the residual direction last
+		DenseMatrix<DataType> _basis;
+
+		// Upper Hessenberg projection, with the residual norm in its last
+		// row
+		DenseMatrix<DataType> _projection;
+
+		// Source of starting vectors; seeded the same way every time, so
+		// results are reproducible
+		std::mt19937 _generator;
+	};
+
+	// Returns number of basis vectors for k eigenpairs of an operator on
+	// vectors of given size; throws InvalidDimensions unless 0 < k <= size
+	inline size_t krylovDimension(const size_t size,
+		const size_t k)
+	{
+		if (k == 0 || k > size)
+			throw InvalidDimensions();
+		return std::min(size, std::max(2 * k + 1, KRYLOV_MIN_DIMENSION));
+	}
+
+	// Lanczos eigensolver for the k largest or smallest eigenvalues of a
+	// symmetric operator and their eigenvectors; the projection is
+	// symmetric, so its eigenpairs come from SymmetricEigensolver
+	// Restarts are thick restarts, which keep the Ritz vectors nearest the
+	// wanted end of the spectrum and their coupling to the residual, and
+	// are equivalent to implicit restarts with the unwanted Ritz values as
+	// shifts, but stable however close those get to the wanted ones
+	template <typename DataType>
+	class LanczosEigensolver
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"LanczosEigensolver requires a floating point data type");
+
+	public:
+
+		// Constructor; computes the k eigenpairs at given end of the
+		// spectrum of the symmetric operator op on vectors of given size,
+		// where op(x) returns the product with the MathVector x
+		// Eigenpairs have converged when their residual norm is below
+		// tolerance times the largest eigenvalue magnitude seen; a
+		// tolerance of 0 means machine epsilon
+		// Throws InvalidDimensions unless 0 < k <= size, and NoConvergence
+		// if the eigenpairs haven't converged after KRYLOV_MAX_RESTARTS
+		template <typename Operator>
+		LanczosEigensolver(const Operator& op,
+			const size_t size,
+			const size_t k,
+			const EigenTarget target = EigenTarget::Largest,
+			const DataType tolerance = 0) :
+			_eigenvectors(0, 0),
+			_restarts(0)
+		{
+			const size_t m = krylovDimension(size, k);
+			const DataType threshold = (tolerance > DataType(0)) ?
+				tolerance : std::numeric_limits<DataType>::epsilon();
+			ArnoldiProcess<DataType> process(size, m);
+
+			size_t kept = 0;
+			while (true)
+			{
+				process.extend(op, kept);
+
+				// Ritz values in order from the wanted end
+				SymmetricEigensolver<DataType> ritz(process.projection());
+				MathVector<DataType> values = ritz.eigenvalues();
+				const DenseMatrix<DataType>& vectors = ritz.eigenvectors();
+				std::vector<size_t> order(m);
+				for (size_t i = 0; i < m; ++i)
+				{
+					order[i] = (target == EigenTarget::Largest) ? m - 1 - i : i;
+				}
+
+				// The residual of Ritz pair i is the residual norm times the
+				// last element of its eigenvector
+				const DataType beta = process.residualNorm();
+				const DataType scale = std::max(std::abs(values[0]), std::abs(values[m - 1]));
+				bool converged = true;
+				for (size_t i = 0; i < k && converged; ++i)
+				{
+					converged = std::abs(beta * vectors.at(m - 1, order[i])) <= threshold * scale;
+				}
+
+				if (converged)
+				{
+					DenseMatrix<DataType> wanted(m, k);
+					std::vector<DataType> wanted_values(k);
+					for (size_t i = 0; i < k; ++i)
+					{
+						wanted.colView(i).assign(vectors.colView(order[i]));
+						wanted_values[i] = values[order[i]];
+					}
+					_eigenvalues = MathVector<DataType>(std::move(wanted_values));
+					_eigenvectors = process.combine(wanted.view());
+					return;
+				}
+
+				if (_restarts == KRYLOV_MAX_RESTARTS)
+					throw NoConvergence();
+				++_restarts;
+
+				// Keeps the wanted Ritz pairs and half of the rest nearest
+				// to them; the projection becomes the kept Ritz values on the
+				// diagonal, bordered by their couplings to the residual
+				kept = k + (m - k) / 2;
+				DenseMatrix<DataType> Y(m, kept);
+				for (size_t i = 0; i < kept; ++i)
+				{
+					Y.colView(i).assign(vectors.colView(order[i]));
+				}
+				process.rotate(Y.view());
+				process.vector(kept).assign(process.vector(m));
+
+				process.projection().fill(0);
+				for (size_t i = 0; i < kept; ++i)
+				{
+					DataType coupling = beta * Y.at(m - 1, i);
+					process.setProjection(i, i, values[order[i]]);
+					process.setProjection(kept, i, coupling);
+					process.setProjection(i, kept, coupling);
+				}
+			}
+		}
+
+		// Returns the eigenvalues, in order from the requested end of the
+		// spectrum
+		MathVector<DataType> eigenvalues() const
+		{
+			return _eigenvalues;
+		}
+
+		// Returns the orthonormal eigenvectors as the columns of a
+		// ColumnMajor matrix, column i belonging to eigenvalue i
+		const DenseMatrix<DataType>& eigenvectors() const
+		{
+			return _eigenvectors;
+		}
+
+		// Returns number of restarts it took to converge
+		size_t restarts() const
+		{
+			return _restarts;
+		}
+
+	private:
+
+		MathVector<DataType> _eigenvalues;
+
+		DenseMatrix<DataType> _eigenvectors;
+
+		size_t _restarts;
+	};
+
+	// Arnoldi eigensolver for the k eigenvalues of largest or smallest
+	// magnitude of a general operator and their eigenvectors; eigenvalues
+	// of a real operator are real or complex conjugate pairs, and both of
+	// a pair are always returned together
+	// Restarts are implicit restarts as in ARPACK: the unwanted Ritz values
+	// are applied to the projection as shifts of implicit QR steps, which
+	// filters them out of the basis without any multiplications by the
+	// operator; conjugate pairs of shifts are applied together as real
+	// double shift steps
+	template <typename DataType>
+	class ArnoldiEigensolver
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"ArnoldiEigensolver requires a floating point data type");
+
+	public:
+
+		// Constructor; computes the k eigenpairs at given end of the
+		// spectrum of the operator op on vectors of given size, ordered by
+		// magnitude; if the k-th eigenvalue belongs to a complex conjugate
+		// pair, so does the next, and k + 1 eigenpairs are returned
+		// Tolerance and exceptions are as for LanczosEigensolver
+		template <typename Operator>
+		ArnoldiEigensolver(const Operator& op,
+			const size_t size,
+			const size_t k,
+			const EigenTarget target = EigenTarget::Largest,
+			const DataType tolerance = 0) :
+			_eigenvectors(0, 0),
+			_restarts(0)
+		{
+			const size_t m = krylovDimension(size, k);
+			const DataType threshold = (tolerance > DataType(0)) ?
+				tolerance : std::numeric_limits<DataType>::epsilon();
+			ArnoldiProcess<DataType> process(size, m);
+
+			size_t kept = 0;
+			while (true)
+			{
+				process.extend(op, kept);
+
+				std::vector<Complex> values = hessenbergEigenvalues<DataType>(process.projection());
+				sortValues(values, target);
+				const size_t wanted = withConjugate(values, k);
+
+				const DataType beta = process.residualNorm();
+				DataType scale = 0;
+				for (const Complex& value : values)
+				{
+					scale = std::max(scale, std::abs(value));
+				}
+
+				// Only the first of a pair needs checking, as its conjugate
+				// has the conjugate eigenvector
+				std::vector<std::vector<Complex> > vectors(wanted);
+				bool converged = true;
+				for (size_t i = 0; i < wanted && converged; ++i)
+				{
+					if (values[i].imag() < DataType(0))
+						continue;
+					vectors[i] = hessenbergEigenvector(process.projection(), values[i]);
+					converged = std::abs(beta * vectors[i][m - 1]) <= threshold * scale;
+				}
+
+				if (converged)
+				{
+					values.resize(wanted);
+					_eigenvalues = std::move(values);
+					formEigenvectors(process, vectors);
+					return;
+				}
+
+				if (_restarts == KRYLOV_MAX_RESTARTS)
+					throw NoConvergence();
+				++_restarts;
+
+				// Keeps the wanted Ritz values and half of the rest nearest
+				// to them, filtering out the others as shifts; a conjugate
+				// pair on the boundary goes to the shifts, so the
+				// projection stays real
+				kept = wanted + (m - wanted) / 2;
+				if (values[kept - 1].imag() > DataType(0))
+					--kept;
+				MatrixView<DataType> H = process.projection();
+				DenseMatrix<DataType> Q(m, m);
+				for (size_t i = 0; i < m; ++i)
+				{
+					Q.at(i, i) = 1;
+				}
+
+				for (size_t i = kept; i < m; ++i)
+				{
+					if (values[i].imag() == DataType(0))
+						hessenbergShiftStep(H, values[i].real(), Q.view());
+					else if (values[i].imag() > DataType(0))
+						hessenbergDoubleShiftStep(H, values[i], Q.view());
+				}
+
+				// A V Q = V Q H' + r e_m^T Q, whose first kept columns are
+				// again an Arnoldi relation, with the residual
+				// (V Q)(kept) H'(kept, kept - 1) + r Q(m - 1, kept - 1)
+				const DataType residual_factor = beta * Q.at(m - 1, kept - 1);
+				process.rotate(Q.subMatrixView(0, m, 0, kept + 1));
+
+				VectorView<DataType> residual = process.vector(kept);
+				residual.scale(H(kept, kept - 1));
+				axpyKernel(residual_factor, process.vector(m).data(), residual.data(), size);
+
+				process.setProjection(kept, kept - 1,
+					process.orthogonalize(kept, &H(0, kept - 1)));
+			}
+		}
+
+		// Returns the eigenvalues, in order of magnitude from the requested
+		// end of the spectrum, with each conjugate pair adjacent and the
+		// one with positive imaginary part first
+		const std::vector<std::complex<DataType> >& eigenvalues() const
+		{
+			return _eigenvalues;
+		}
+
+		// Returns the unit length eigenvectors as the columns of a real
+		// ColumnMajor matrix, in the layout of LAPACK's dgeev: column i
+		// belongs to real eigenvalue i, and for a conjugate pair i, i + 1,
+		// columns i and i + 1 are the real and imaginary parts of the
+		// eigenvector of eigenvalue i, whose conjugate belongs to i + 1
+		const DenseMatrix<DataType>& eigenvectors() const
+		{
+			return _eigenvectors;
+		}
+
+		// Returns number of restarts it took to converge
+		size_t restarts() const
+		{
+			return _restarts;
+		}
+
+	private:
+
+		using Complex = std::complex<DataType>;
+
+		// Sorts values by magnitude from the wanted end; values of equal
+		// magnitude are ordered by real and then imaginary part, which
+		// keeps conjugate pairs adjacent, positive imaginary part first
+		static void sortValues(std::vector<Complex>& values,
+			const EigenTarget target)
+		{
+			std::sort(values.begin(), values.end(),
+				[target](const Complex& a, const Complex& b)
+				{
+					DataType abs_a = std::abs(a);
+					DataType abs_b = std::abs(b);
+					if (abs_a != abs_b)
+						return (target == EigenTarget::Largest) ? abs_a > abs_b : abs_a < abs_b;
+					if (a.real() != b.real())
+						return a.real() > b.real();
+					return a.imag() > b.imag();
+				});
+		}
+
+		// Returns count, or count + 1 if the first count values would
+		// separate a conjugate pair
+		static size_t withConjugate(const std::vector<Complex>& values,
+			const size_t count)
+		{
+			if (count < values.size() && values[count - 1].imag() > DataType(0))
+				return count + 1;
+			return count;
+		}
+
+		// Forms the eigenvectors from the eigenvectors of the projection,
+		// given for every real eigenvalue and the first of every pair
+		void formEigenvectors(const ArnoldiProcess<DataType>& process,
+			const std::vector<std::vector<Complex> >& vectors)
+		{
+			const size_t m = process.dimension();
+			const size_t count = vectors.size();
+			DenseMatrix<DataType> Y(m, count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (_eigenvalues[i].imag() < DataType(0))
+					continue;
+
+				for (size_t r = 0; r < m; ++r)
+				{
+					Y.at(r, i) = vectors[i][r].real();
+					if (_eigenvalues[i].imag() > DataType(0))
+						Y.at(r, i + 1) = vectors[i][r].imag();
+				}
+			}
+			_eigenvectors = process.combine(Y.view());
+		}
+
+		std::vector<Complex> _eigenvalues;
+
+		DenseMatrix<DataType> _eigenvectors;
+
+		size_t _restarts;
+	};
+}
+
+#endif
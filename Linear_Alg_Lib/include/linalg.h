@@ -7,13 +7,26 @@
 #include "matrix.h"
 #include "dense_matrix.h"
 #include "sparse_matrix.h"
+#include "compressed_sparse_matrix.h"
+#include "spmv_kernel.h"
 #include "matrix_ops.h"
 #include "matrix_utils.h"
 #include "linear_solver.h"
+#include "lu_factorization.h"
+#include "cholesky_factorization.h"
+#include "qr_factorization.h"
+#include "tsqr_factorization.h"
+#include "symmetric_eigensolver.h"
+#include "krylov_eigensolver.h"
+#include "singular_value_decomposition.h"
 
 #include "exceptions.h"
 #include "lib_utils.h"
 #include "ops_utils.h"
+#include "simd_kernels.h"
+#include "transpose_kernel.h"
+#include "matrix_expression.h"
+#include "thread_pool.h"
 
 // ------------------------------------------------------------------
 // Contains every header file in library
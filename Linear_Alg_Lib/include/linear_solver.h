@@ -2,8 +2,17 @@
 #define LINEAR_SOLVER_H
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
 #include "dense_matrix.h"
 #include "math_vector.h"
+#include "matrix_view.h"
+#include "matrix_utils.h"
+#include "trsm_kernel.h"
+#include "lu_factorization.h"
+#include "cholesky_factorization.h"
+#include "qr_factorization.h"
 
 // ------------------------------------------------------------------
 // Functions for solving linear systems
@@ -24,32 +33,292 @@ namespace LinAlg
 	// solution x to the system; if successful, returns true and puts the solution vector 
 	// into the output parameter x; if not, returns false
 	// Will only find solution if A is invertible
+	// If trans_A is Transpose, solves the system A^T x = b instead; the
+	// transpose is read in place and never formed
 	template <typename DataType>
 	inline bool solveLinearEquation(const DenseMatrix<DataType>& A,
 		const MathVector<DataType>& b, 
-		MathVector<double>& x)
+		MathVector<double>& x,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
+	{
+		return solveLinearEquation(A.view(), b, x, trans_A);
+	}
+
+	// View version of solveLinearEquation; A can be any view into a 
+	// DenseMatrix, such as a sub-matrix
+	// Solves with the blocked, multithreaded LU factorization in 
+	// lu_factorization.h, so large systems run at close to GEMM speed;
+	// to solve against many b with the same A, use LUFactorization
+	// directly and factor only once
+	template <typename ViewDataType, typename DataType>
+	inline bool solveLinearEquation(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
 	{
 		// If A isn't square, system won't have a unique solution
 		// The system is invalid if the size of b isn't equal to the rows in A
 		if (!A.isSquare() || A.rows() != b.size())
 			return false;
 
-		return gaussianElimination(A, b, x);
+		// A pivot that is zero only up to rounding still means there is
+		// no unique solution, so the test is relative to the size of A
+		LUFactorization<double> lu(A);
+		if (lu.isNumericallySingular())
+			return false;
+
+		x = lu.solve(b, trans_A);
+		return true;
+	}
+
+	// Most refinement steps solveMixedPrecision() takes before giving up on the
+	// single precision factors
+	const size_t MAX_REFINEMENT_ITERATIONS = 30;
+
+	// Returns view of A as doubles; views that already hold doubles are returned
+	// as they are, and any other view is copied into storage
+	inline MatrixView<const double> doubleMatrixView(const MatrixView<const double>& A,
+		DenseMatrix<double>&)
+	{
+		return A;
+	}
+
+	inline MatrixView<const double> doubleMatrixView(const MatrixView<double>& A,
+		DenseMatrix<double>&)
+	{
+		return A;
+	}
+
+	template <typename ViewDataType>
+	inline MatrixView<const double> doubleMatrixView(const MatrixView<ViewDataType>& A,
+		DenseMatrix<double>& storage)
+	{
+		storage = DenseMatrix<double>(A);
+		return storage.view();
+	}
+
+	// Returns the infinity norm of A, its largest absolute row sum
+	inline double infinityNorm(const MatrixView<const double>& A)
+	{
+		std::vector<double> row_sums(A.rows());
+		for (size_t line = 0; line < A.numLines(); ++line)
+		{
+			VectorView<const double> elements = A.line(line);
+			for (size_t i = 0; i < elements.size(); ++i)
+			{
+				row_sums[A.getStorageType() == StorageType::RowMajor ? line : i] +=
+					std::abs(elements[i]);
+			}
+		}
+		return row_sums.empty() ? 0 : *std::max_element(row_sums.begin(), row_sums.end());
+	}
+
+	// Returns the largest absolute element of v
+	inline double infinityNorm(const std::vector<double>& v)
+	{
+		double norm = 0;
+		for (double val : v)
+		{
+			norm = std::max(norm, std::abs(val));
+		}
+		return norm;
+	}
+
+	// Solves Ax = b like solveLinearEquation, but factors A in single precision,
+	// which halves the memory of the factors and doubles the SIMD width of the
+	// factorization, then recovers full double precision accuracy by iterative
+	// refinement: the residual r = b - Ax is computed in double, the correction
+	// Ad = r is solved with the single precision factors, and x += d, until the
+	// residual is as small as a double precision solve would leave it
+	// If single precision can't handle A, because the float factors are
+	// singular or the refinement stops converging, as happens for
+	// ill-conditioned matrices, falls back to solveLinearEquation in double
+	// precision; the result is as accurate either way
+	template <typename DataType>
+	inline bool solveMixedPrecision(const DenseMatrix<DataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		return solveMixedPrecision(A.view(), b, x);
+	}
+
+	// View version of solveMixedPrecision
+	template <typename ViewDataType, typename DataType>
+	inline bool solveMixedPrecision(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		if (!A.isSquare() || A.rows() != b.size())
+			return false;
+
+		const size_t n = A.rows();
+		DenseMatrix<double> storage(0, 0);
+		MatrixView<const double> A_double = doubleMatrixView(A, storage);
+		MathVector<double> b_double = convertToDoublesVector(b);
+
+		LUFactorization<float> lu(A_double);
+		if (!lu.isNumericallySingular())
+		{
+			// Stopping test of LAPACK's dsgesv: the residual is within rounding
+			// of what a backward stable double precision solve gives
+			const double tolerance = infinityNorm(A_double) *
+				std::sqrt(static_cast<double>(n)) * std::numeric_limits<double>::epsilon();
+
+			std::vector<float> correction(n);
+			VectorView<float> correction_view(correction.data(), n);
+			correction_view.assign(b_double.view());
+			lu.solveInPlace(correction_view);
+			std::vector<double> solution(correction.begin(), correction.end());
+			VectorView<double> solution_view(solution.data(), n);
+
+			std::vector<double> residual(n);
+			VectorView<double> residual_view(residual.data(), n);
+			double previous_norm = std::numeric_limits<double>::infinity();
+
+			for (size_t iteration = 0; iteration < MAX_REFINEMENT_ITERATIONS; ++iteration)
+			{
+				// r = b - Ax in double precision
+				residual_view.assign(b_double.view());
+				gemvParallel(A_double, solution_view, residual_view,
+					defaultThreadPool(), -1, 1);
+
+				double residual_norm = infinityNorm(residual);
+				if (residual_norm <= infinityNorm(solution) * tolerance)
+				{
+					x = MathVector<double>(std::move(solution));
+					return true;
+				}
+
+				// Each step should shrink the residual by about the condition
+				// number times float epsilon; if it doesn't even halve, the
+				// matrix is too ill-conditioned, and NaNs fail this too
+				if (!(residual_norm < 0.5 * previous_norm))
+					break;
+				previous_norm = residual_norm;
+
+				correction_view.assign(residual_view);
+				lu.solveInPlace(correction_view);
+				for (size_t i = 0; i < n; ++i)
+				{
+					solution[i] += correction[i];
+				}
+			}
+		}
+
+		return solveLinearEquation(A_double, b_double, x);
+	}
+
+	// Given a symmetric matrix A and vector b representing a system Ax = b, tries to
+	// find a unique solution x to the system; if successful, returns true and puts the
+	// solution vector into the output parameter x; if not, returns false
+	// Only the lower triangle of A is read; Cholesky factorization, which does half
+	// the work of LU, is tried first, and the system falls back to LU if A turns out
+	// not to be positive definite
+	template <typename DataType>
+	inline bool solveSymmetricLinearEquation(const DenseMatrix<DataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		return solveSymmetricLinearEquation(A.view(), b, x);
+	}
+
+	// View version of solveSymmetricLinearEquation
+	template <typename ViewDataType, typename DataType>
+	inline bool solveSymmetricLinearEquation(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		if (!A.isSquare() || A.rows() != b.size())
+			return false;
+
+		// A positive definite matrix has a positive diagonal, so anything
+		// else goes straight to LU; otherwise Cholesky finds out itself,
+		// stopping at the first pivot that isn't positive
+		bool positive_diagonal = true;
+		for (size_t i = 0; i < A.rows() && positive_diagonal; ++i)
+		{
+			positive_diagonal = A(i, i) > 0;
+		}
+
+		if (positive_diagonal)
+		{
+			CholeskyFactorization<double> cholesky(A);
+			if (cholesky.isPositiveDefinite())
+			{
+				x = cholesky.solve(b);
+				return true;
+			}
+		}
+
+		// LU reads both triangles, so the upper one is mirrored from the
+		// lower one first
+		DenseMatrix<double> symmetric(A, StorageType::ColumnMajor);
+		for (size_t j = 1; j < symmetric.cols(); ++j)
+		{
+			symmetric.colView(j).subView(0, j).assign(
+				static_cast<const DenseMatrix<double>&>(symmetric).rowView(j).subView(0, j));
+		}
+		return solveLinearEquation(symmetric, convertToDoublesVector(b), x);
+	}
+
+	// Given an m x n matrix A with m >= n and a vector b of size m, finds the x that
+	// minimizes ||Ax - b||, which solves Ax = b exactly if any solution does; if
+	// successful, returns true and puts the solution into the output parameter x; if
+	// not, returns false
+	// Fails if A has more columns than rows or its columns aren't linearly
+	// independent, in which case the minimizer isn't unique
+	// Solves with the blocked Householder QR factorization in qr_factorization.h; to
+	// solve against many b with the same A, use QRFactorization directly
+	template <typename DataType>
+	inline bool solveLeastSquares(const DenseMatrix<DataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		return solveLeastSquares(A.view(), b, x);
+	}
+
+	// View version of solveLeastSquares
+	template <typename ViewDataType, typename DataType>
+	inline bool solveLeastSquares(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x)
+	{
+		if (A.rows() < A.cols() || A.rows() != b.size())
+			return false;
+
+		QRFactorization<double> qr(A);
+		if (!qr.isFullRank())
+			return false;
+
+		x = qr.solve(b);
+		return true;
 	}
 
 	// Given a matrix A and vector b representing a system Ax = b, uses Guassian 
 	// elimination to try to solve the system; if successful, returns true and 
 	// puts the solution vector into the output parameter x; if not, returns false.
 	// Guassian elimination will fail if the given matrix A is not invertible
+	// If trans_A is Transpose, solves A^T x = b instead
 	template <typename DataType>
 	inline bool gaussianElimination(const DenseMatrix<DataType>& A,
 		const MathVector<DataType>& b,
-		MathVector<double>& x)
+		MathVector<double>& x,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
+	{
+		return gaussianElimination(A.view(), b, x, trans_A);
+	}
+
+	// View version of gaussianElimination
+	template <typename ViewDataType, typename DataType>
+	inline bool gaussianElimination(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		MathVector<double>& x,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
 	{
 		DenseMatrix<double> U;
 		MathVector<double> y;
 
-		if (!convertToUpperTriangular(A, b, U, y))
+		if (!convertToUpperTriangular(A, b, U, y, trans_A))
 			return false;
 
 		x = solveUpperTriangularSystem(U, y);
@@ -60,21 +329,34 @@ namespace LinAlg
 	// equivalent system Ux = y, where U is an upper triangular matrix; puts U and
 	// y into output parameters; returns true if given system can be converted to
 	// an upper triangular system, and false if not
+	// If trans_A is Transpose, starts from the system A^T x = b instead
 	template <typename DataType>
 	inline bool convertToUpperTriangular(const DenseMatrix<DataType>& A,
 		const MathVector<DataType>& b,
 		DenseMatrix<double>& U,
-		MathVector<double>& y)
+		MathVector<double>& y,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
+	{
+		return convertToUpperTriangular(A.view(), b, U, y, trans_A);
+	}
+
+	// View version of convertToUpperTriangular; rows are updated in place
+	// through views, so elimination does no per-row allocations
+	template <typename ViewDataType, typename DataType>
+	inline bool convertToUpperTriangular(const MatrixView<ViewDataType>& A,
+		const MathVector<DataType>& b,
+		DenseMatrix<double>& U,
+		MathVector<double>& y,
+		const TransposeOp trans_A = TransposeOp::NoTranspose)
 	{
 		// Data type of U and y must be doubles to prevent data loss during scaling
-		U = convertToDoublesMatrix(A);
+		// Algorithm is more efficient when U is row major; the transpose
+		// is taken while copying, so it costs no extra pass
+		U = DenseMatrix<double>(applyTranspose(A, trans_A), StorageType::RowMajor);
 		y = convertToDoublesVector(b);
 
-		// Algorithm is more efficient when U is row major
-		U.convertToRowMajor();
-
 		// Iterate through the pivots/diagonal elements of U
-		for (int i = 0; i < U.rows(); ++i)
+		for (size_t i = 0; i < U.rows(); ++i)
 		{
 			maximizePivot(U, y, i);
 			double pivot = U.at(i, i);
@@ -88,20 +370,17 @@ namespace LinAlg
 			double scale_factor = 1 / pivot;
 			U.scaleRow(i, scale_factor);
 			y[i] *= scale_factor;
-			MathVector<double> pivot_row = U.row(i);
+			VectorView<const double> pivot_row = U.rowView(i);
 
 			// Make all numbers in pivot column below the pivot equal to 0 by subtracting 
 			// scaled pivot row
-			for (int j = i + 1; j < U.rows(); ++j)
+			for (size_t j = i + 1; j < U.rows(); ++j)
 			{
 				double pivot_col_elt = U.at(j, i);
 				if (areEqual(pivot_col_elt, 0))
 					continue;
 
-				MathVector<double> new_row = U.row(j);
-				MathVector<double> scaled_pivot_row = pivot_row.scaled(pivot_col_elt);
-				new_row -= scaled_pivot_row;
-				U.setRow(j, new_row);
+				U.rowView(j).addScaled(pivot_row, -pivot_col_elt);
 				y[j] -= y[i] * pivot_col_elt;
 			}
 		}
@@ -109,8 +388,8 @@ namespace LinAlg
 		return true;
 	}
 
-	// Rearranges the rows of the matrix A so that the largest value in col pivot_row
-	// below pivot_row is in row pivot_row; prevents dividing by a very small number during 
+	// Rearranges the rows of the matrix A so that the value of largest magnitude in col
+	// pivot_row below pivot_row is in row pivot_row; prevents dividing by a very small number during 
 	// Gaussian elimination
 	template <typename DataType>
 	inline void maximizePivot(DenseMatrix<DataType>& A,
@@ -118,35 +397,115 @@ namespace LinAlg
 		const size_t pivot_row)
 	{
 		// Find index of max value in pivot column below pivot row
-		std::vector<DataType> pivot_col_data = A.col(pivot_row).getData();
-		auto max_val_it = std::max_element(pivot_col_data.begin() + pivot_row, pivot_col_data.end());
-		size_t max_val_index = max_val_it - pivot_col_data.begin();
+		VectorView<const DataType> pivot_col = 
+			static_cast<const DenseMatrix<DataType>&>(A).colView(pivot_row);
+		size_t max_val_index = pivot_row;
+		for (size_t i = pivot_row + 1; i < pivot_col.size(); ++i)
+		{
+			if (std::abs(pivot_col[i]) > std::abs(pivot_col[max_val_index]))
+				max_val_index = i;
+		}
 
 		// Swap pivot_row and i of max value in pivot column in both A and b
 		A.swapRows(pivot_row, max_val_index);
 		b.swap(pivot_row, max_val_index);
 	}
 
+	// Overwrites x with the solution of op(A) x = x, where op transposes A if
+	// trans_A is Transpose, and A is the triangle of a square matrix given by
+	// uplo; with DiagonalType::Unit the diagonal is taken to be all ones
+	// Follows BLAS in not checking for zeros on the diagonal, which give
+	// infinities or NaNs in x; x must not overlap A
+	// Solves with the blocked kernels in trsm_kernel.h, which read A in its own
+	// storage order and allocate nothing unless x is strided
+	template <typename DataType>
+	inline void trsv(const TriangleType uplo,
+		const TransposeOp trans_A,
+		const DiagonalType diag,
+		const ConstMatrixView<DataType>& A,
+		const VectorView<DataType>& x)
+	{
+		if (!A.isSquare() || A.rows() != x.size())
+			throw InvalidDimensions();
+
+		// The transpose of a triangle is the other triangle of the
+		// transposed view
+		MatrixView<const DataType> op_A = applyTranspose(A, trans_A);
+		TriangleType op_uplo = (trans_A == TransposeOp::Transpose) ?
+			flipTriangleType(uplo) : uplo;
+
+		if (!x.isContiguous())
+		{
+			std::vector<DataType> x_copy = x.toStdVector();
+			trsvBlocked(op_A, op_uplo, diag, x_copy.data());
+			x.assign(VectorView<const DataType>(x_copy.data(), x_copy.size()));
+			return;
+		}
+
+		trsvBlocked(op_A, op_uplo, diag, x.data());
+	}
+
+	// DenseMatrix and MathVector version of trsv
+	template <typename DataType>
+	inline void trsv(const TriangleType uplo,
+		const TransposeOp trans_A,
+		const DiagonalType diag,
+		const DenseMatrix<DataType>& A,
+		MathVector<DataType>& x)
+	{
+		trsv<DataType>(uplo, trans_A, diag, A.view(), x.view());
+	}
+
+	// Overwrites B with the solution X of op(A) X = B for every column of B at
+	// once; arguments are as for trsv(), and B must not overlap A
+	// Diagonal blocks are solved by substitution and the rest of B is updated
+	// by GEMMs, with the columns of large systems split across
+	// defaultThreadPool()
+	template <typename DataType>
+	inline void trsm(const TriangleType uplo,
+		const TransposeOp trans_A,
+		const DiagonalType diag,
+		const ConstMatrixView<DataType>& A,
+		const MatrixView<DataType>& B)
+	{
+		TriangleType op_uplo = (trans_A == TransposeOp::Transpose) ?
+			flipTriangleType(uplo) : uplo;
+		trsmParallel(applyTranspose(A, trans_A), op_uplo, diag, B);
+	}
+
+	// DenseMatrix version of trsm
+	template <typename DataType>
+	inline void trsm(const TriangleType uplo,
+		const TransposeOp trans_A,
+		const DiagonalType diag,
+		const DenseMatrix<DataType>& A,
+		DenseMatrix<DataType>& B)
+	{
+		trsm<DataType>(uplo, trans_A, diag, A.view(), B.view());
+	}
+
 	// Given an upper triangular matrix U and vector y representing a system
 	// Ux = y, returns the solution to the system as a vector
+	// Back substitution runs through trsv(), so U is read in its own storage
+	// order and only its upper triangle is accessed
 	inline MathVector<double> solveUpperTriangularSystem(const DenseMatrix<double>& U,
 		const MathVector<double>& y)
 	{
-
 		MathVector<double> x = y;
+		trsv<double>(TriangleType::Upper, TransposeOp::NoTranspose, DiagonalType::NonUnit,
+			U.view(), x.view());
+		return x;
+	}
 
-		// Iterate backwards over pivots
-		for (int i = U.rows() - 1; i >= 0; --i)
-		{
-			double pivot_soln_elt = x[i];
-			// Iterate over elements above pivot
-			for (int j = 0; j < i; ++j)
-			{
-				double pivot_col_elt = U.at(j, i);
-				x[j] -= (pivot_col_elt * pivot_soln_elt);
-			}
-		}
-
+	// Given a lower triangular matrix L and vector y representing a system
+	// Lx = y, returns the solution to the system as a vector, found by forward
+	// substitution; only the lower triangle of L is accessed
+	inline MathVector<double> solveLowerTriangularSystem(const DenseMatrix<double>& L,
+		const MathVector<double>& y)
+	{
+		MathVector<double> x = y;
+		trsv<double>(TriangleType::Lower, TransposeOp::NoTranspose, DiagonalType::NonUnit,
+			L.view(), x.view());
 		return x;
 	}
 
@@ -154,19 +513,7 @@ namespace LinAlg
 	template <typename DataType>
 	inline DenseMatrix<double> convertToDoublesMatrix(const DenseMatrix<DataType>& mat)
 	{
-		std::vector<double> converted_mat_data;
-		converted_mat_data.reserve(mat.size());
-		std::vector<DataType> mat_data = mat.getData();
-
-		for (DataType val : mat_data)
-		{
-			converted_mat_data.push_back((double)val);
-		}
-		
-		return DenseMatrix<double>(converted_mat_data, 
-			mat.rows(), 
-			mat.cols(), 
-			mat.getStorageType());
+		return DenseMatrix<double>(mat.view());
 	}
 
 	// Given vector with a templated type, returns a vector of doubles
@@ -0,0 +1,382 @@
+#ifndef LU_FACTORIZATION_H
+#define LU_FACTORIZATION_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <type_traits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemm_kernel.h"
+#include "trsm_kernel.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// LU factorization with partial pivoting, PA = LU; a square matrix is
+// factored once, after which any number of systems Ax = b are solved
+// in O(n^2) each instead of eliminating A again for every b
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Number of columns factored together as one panel; the update of
+	// the rest of the matrix by each panel is one GEMM of this depth
+	const size_t LU_BLOCK_SIZE = 64;
+
+	template <typename DataType>
+	class LUFactorization
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"LUFactorization requires a floating point data type");
+
+	public:
+
+		// Constructor; factors given square matrix, converting its
+		// elements to DataType; throws InvalidDimensions if the matrix
+		// isn't square
+		template <typename MatrixDataType>
+		explicit LUFactorization(const DenseMatrix<MatrixDataType>& A) :
+			LUFactorization(A.view())
+		{ }
+
+		// View version of constructor
+		template <typename ViewDataType>
+		explicit LUFactorization(const MatrixView<ViewDataType>& A) :
+			_factors(A, StorageType::ColumnMajor),
+			_pivots(A.rows()),
+			_singular(false),
+			_max_element(0)
+		{
+			if (!A.isSquare())
+				throw InvalidDimensions();
+
+			factor();
+		}
+
+		// Returns number of rows and columns of the factored matrix
+		size_t size() const
+		{
+			return _factors.rows();
+		}
+
+		// Returns true if a pivot was exactly zero, in which case the
+		// factorization exists but can't be used to solve systems
+		bool isSingular() const
+		{
+			return _singular;
+		}
+
+		// Returns true if some pivot is negligible next to the largest
+		// element of the factored matrix, |u_kk| <= n eps max |a_ij|;
+		// the matrix is then singular to working precision, and solving
+		// with it only amplifies rounding into a meaningless answer
+		bool isNumericallySingular() const
+		{
+			const DataType tolerance = static_cast<DataType>(size()) *
+				std::numeric_limits<DataType>::epsilon() * _max_element;
+			for (size_t k = 0; k < size(); ++k)
+			{
+				if (!(std::abs(_factors.at(k, k)) > tolerance))
+					return true;
+			}
+			return _singular;
+		}
+
+		// Returns L and U packed into one ColumnMajor matrix; U is the
+		// upper triangle including the diagonal, and L the strict lower
+		// triangle, with its unit diagonal implied
+		const DenseMatrix<DataType>& getFactors() const
+		{
+			return _factors;
+		}
+
+		// Returns the row interchanges, in the order they were made; at
+		// step k, row k was swapped with row getPivots()[k]
+		const std::vector<size_t>& getPivots() const
+		{
+			return _pivots;
+		}
+
+		// Returns the unit lower triangular factor L
+		DenseMatrix<DataType> lower() const
+		{
+			DenseMatrix<DataType> L(size(), size());
+			for (size_t j = 0; j < size(); ++j)
+			{
+				L.at(j, j) = 1;
+				for (size_t i = j + 1; i < size(); ++i)
+				{
+					L.at(i, j) = _factors.at(i, j);
+				}
+			}
+			return L;
+		}
+
+		// Returns the upper triangular factor U
+		DenseMatrix<DataType> upper() const
+		{
+			DenseMatrix<DataType> U(size(), size());
+			for (size_t j = 0; j < size(); ++j)
+			{
+				for (size_t i = 0; i <= j; ++i)
+				{
+					U.at(i, j) = _factors.at(i, j);
+				}
+			}
+			return U;
+		}
+
+		// Returns the permutation P as a vector; row i of PA is row
+		// permutation()[i] of A
+		std::vector<size_t> permutation() const
+		{
+			std::vector<size_t> perm(size());
+			for (size_t i = 0; i < perm.size(); ++i)
+			{
+				perm[i] = i;
+			}
+			for (size_t k = 0; k < _pivots.size(); ++k)
+			{
+				std::swap(perm[k], perm[_pivots[k]]);
+			}
+			return perm;
+		}
+
+		// Returns the determinant of the factored matrix
+		DataType determinant() const
+		{
+			DataType det = 1;
+			for (size_t k = 0; k < size(); ++k)
+			{
+				det *= _factors.at(k, k);
+				if (_pivots[k] != k)
+					det = -det;
+			}
+			return det;
+		}
+
+		// Returns the solution x of Ax = b, or of A^T x = b if trans_A is
+		// Transpose; throws SingularMatrix if A is singular
+		template <typename VectorDataType>
+		MathVector<DataType> solve(const MathVector<VectorDataType>& b,
+			const TransposeOp trans_A = TransposeOp::NoTranspose) const
+		{
+			std::vector<DataType> x(b.size());
+			VectorView<DataType> x_view(x.data(), x.size());
+			x_view.assign(b.view());
+
+			solveInPlace(x_view, trans_A);
+			return MathVector<DataType>(std::move(x));
+		}
+
+		// Returns the solution X of AX = B, or of A^T X = B if trans_A is
+		// Transpose, for every column of B at once; result is ColumnMajor
+		template <typename MatrixDataType>
+		DenseMatrix<DataType> solve(const DenseMatrix<MatrixDataType>& B,
+			const TransposeOp trans_A = TransposeOp::NoTranspose) const
+		{
+			DenseMatrix<DataType> X(B.view(), StorageType::ColumnMajor);
+			solveInPlace(X.view(), trans_A);
+			return X;
+		}
+
+		// Overwrites b with the solution x of Ax = b, or of A^T x = b if
+		// trans_A is Transpose
+		void solveInPlace(const VectorView<DataType>& b,
+			const TransposeOp trans_A = TransposeOp::NoTranspose) const
+		{
+			if (b.size() != size())
+				throw InvalidDimensions();
+
+			if (_singular)
+				throw SingularMatrix();
+
+			// Substitution runs on contiguous memory
+			if (!b.isContiguous())
+			{
+				std::vector<DataType> x = b.toStdVector();
+				solveContiguous(x.data(), trans_A);
+				b.assign(VectorView<const DataType>(x.data(), x.size()));
+				return;
+			}
+
+			solveContiguous(b.data(), trans_A);
+		}
+
+		// Overwrites every column of B with the solution of the system
+		// with that column as its right hand side; the rows of B are
+		// permuted once, and both triangles are solved against all
+		// columns together by the blocked TRSM in trsm_kernel.h
+		void solveInPlace(const MatrixView<DataType>& B,
+			const TransposeOp trans_A = TransposeOp::NoTranspose) const
+		{
+			if (B.rows() != size())
+				throw InvalidDimensions();
+
+			if (_singular)
+				throw SingularMatrix();
+
+			MatrixView<const DataType> lu = _factors.view();
+			if (trans_A == TransposeOp::NoTranspose)
+			{
+				for (size_t k = 0; k < _pivots.size(); ++k)
+				{
+					if (_pivots[k] != k)
+						B.row(k).swapWith(B.row(_pivots[k]));
+				}
+				trsmParallel(lu, TriangleType::Lower, DiagonalType::Unit, B);
+				trsmParallel(lu, TriangleType::Upper, DiagonalType::NonUnit, B);
+				return;
+			}
+
+			trsmParallel(lu.transposed(), TriangleType::Lower, DiagonalType::NonUnit, B);
+			trsmParallel(lu.transposed(), TriangleType::Upper, DiagonalType::Unit, B);
+			for (size_t k = _pivots.size(); k-- > 0; )
+			{
+				if (_pivots[k] != k)
+					B.row(k).swapWith(B.row(_pivots[k]));
+			}
+		}
+
+	private:
+
+		// Factors _factors in place with the blocked right-looking
+		// algorithm; each panel of LU_BLOCK_SIZE columns is factored
+		// unblocked, the rows of U to its right are solved against its
+		// unit lower triangle, and the rest of the matrix is updated by a
+		// single GEMM, split across defaultThreadPool(), which is where
+		// nearly all the work of a large factorization happens
+		void factor()
+		{
+			const size_t n = size();
+			MatrixView<DataType> lu = _factors.view();
+
+			for (size_t j = 0; j < n; ++j)
+			{
+				VectorView<DataType> col_j = lu.col(j);
+				for (size_t i = 0; i < n; ++i)
+				{
+					_max_element = std::max(_max_element, std::abs(col_j[i]));
+				}
+			}
+
+			for (size_t first = 0; first < n; first += LU_BLOCK_SIZE)
+			{
+				const size_t last = std::min(first + LU_BLOCK_SIZE, n);
+				factorPanel(lu, first, last);
+				if (last == n)
+					break;
+
+				// A12 = L11^-1 A12, then A22 -= L21 * A12
+				MatrixView<DataType> A12 = lu.subView(first, last, last, n);
+				trsmParallel(lu.subView(first, last, first, last),
+					TriangleType::Lower, DiagonalType::Unit, A12);
+				gemmParallel(lu.subView(last, n, first, last), A12,
+					lu.subView(last, n, last, n), defaultThreadPool(),
+					GemmBlockSizes(), -1, 1);
+			}
+		}
+
+		// Factors columns [first, last) of lu, from row first down, one
+		// column at a time; the pivot is the entry of largest magnitude
+		// on or below the diagonal, and whole rows are swapped so that
+		// the parts of L and U outside the panel follow the permutation
+		// The rank-1 updates only reach columns inside the panel
+		void factorPanel(const MatrixView<DataType>& lu,
+			const size_t first,
+			const size_t last)
+		{
+			const size_t n = size();
+
+			for (size_t k = first; k < last; ++k)
+			{
+				VectorView<DataType> col_k = lu.col(k);
+
+				size_t pivot_row = k;
+				DataType max_val = std::abs(col_k[k]);
+				for (size_t i = k + 1; i < n; ++i)
+				{
+					if (std::abs(col_k[i]) > max_val)
+					{
+						max_val = std::abs(col_k[i]);
+						pivot_row = i;
+					}
+				}
+
+				_pivots[k] = pivot_row;
+				if (pivot_row != k)
+					lu.row(k).swapWith(lu.row(pivot_row));
+
+				DataType pivot = col_k[k];
+				if (pivot == DataType(0))
+				{
+					// Column is already zero below the diagonal, so there
+					// is nothing to eliminate
+					_singular = true;
+					continue;
+				}
+
+				// Multipliers of L replace the column below the pivot
+				DataType* multipliers = col_k.data() + k + 1;
+				col_k.subView(k + 1, n).scale(1 / pivot);
+
+				for (size_t j = k + 1; j < last; ++j)
+				{
+					DataType factor = lu(k, j);
+					if (factor != DataType(0))
+						axpyKernel(-factor, multipliers, &lu(k + 1, j), n - k - 1);
+				}
+			}
+		}
+
+		// Solves in place on the contiguous right hand side b
+		void solveContiguous(DataType* b, const TransposeOp trans_A) const
+		{
+			MatrixView<const DataType> lu = _factors.view();
+
+			if (trans_A == TransposeOp::NoTranspose)
+			{
+				// Pb, then Ly = Pb and Ux = y
+				for (size_t k = 0; k < _pivots.size(); ++k)
+				{
+					std::swap(b[k], b[_pivots[k]]);
+				}
+
+				trsvBlocked(lu, TriangleType::Lower, DiagonalType::Unit, b);
+				trsvBlocked(lu, TriangleType::Upper, DiagonalType::NonUnit, b);
+				return;
+			}
+
+			// A^T = U^T L^T P, so U^T y = b, then L^T z = y, then x = P^T z;
+			// the transposes are RowMajor views of the same factors
+			trsvBlocked(lu.transposed(), TriangleType::Lower, DiagonalType::NonUnit, b);
+			trsvBlocked(lu.transposed(), TriangleType::Upper, DiagonalType::Unit, b);
+
+			for (size_t k = _pivots.size(); k-- > 0; )
+			{
+				std::swap(b[k], b[_pivots[k]]);
+			}
+		}
+
+		// L and U packed together, ColumnMajor so that columns, which
+		// both factoring and solving stream through, are contiguous
+		DenseMatrix<DataType> _factors;
+
+		// Row swapped with row k at step k of the factorization
+		std::vector<size_t> _pivots;
+
+		bool _singular;
+
+		// Largest magnitude of an element of the factored matrix, which
+		// isNumericallySingular() measures the pivots against
+		DataType _max_element;
+	};
+}
+
+#endif
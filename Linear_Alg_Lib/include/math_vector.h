@@ -3,9 +3,12 @@
 
 #include <vector>
 #include <cmath>
+#include <utility>
 
 #include "lib_utils.h"
 #include "exceptions.h"
+#include "matrix_view.h"
+#include "matrix_expression.h"
 
 // ------------------------------------------------------------------
 // Templated class defining a column vector
@@ -23,11 +26,45 @@ namespace LinAlg
 			_data(data_in)
 		{ }
 
+		// Creates a vector that takes ownership of given std::vector's
+		// elements without copying them
+		MathVector(std::vector<DataType>&& data_in) :
+			_data(std::move(data_in))
+		{ }
+
+		// Creates a vector with a copy of the elements of given view
+		template <typename ViewDataType>
+		explicit MathVector(const VectorView<ViewDataType>& view_in) :
+			_data(view_in.toStdVector())
+		{ }
+
+		// Creates a vector by evaluating given expression, such as
+		// a + 2 * b, in a single pass; see matrix_expression.h
+		template <typename Expression>
+		MathVector(const VectorExpression<Expression>& expression_in) :
+			_data(expression_in.derived().size())
+		{
+			evaluateInto(view(), expression_in);
+		}
+
 		// Default constructor; creates a vector with no elements
 		MathVector() :
 			_data(std::vector<DataType>())
 		{ }
 
+		// Evaluates given expression into the vector; when the sizes
+		// match, the elements are overwritten in place without allocating
+		template <typename Expression>
+		MathVector<DataType>& operator=(
+			const VectorExpression<Expression>& expression_in)
+		{
+			if (_data.size() == expression_in.derived().size())
+				evaluateInto(view(), expression_in);
+			else
+				*this = MathVector<DataType>(expression_in);
+			return *this;
+		}
+
 		// Getter and setter functions
 
 		std::vector<DataType> getData() const
@@ -45,6 +82,18 @@ namespace LinAlg
 			return _data.size();
 		}
 
+		// Returns view of the whole vector, const version
+		VectorView<const DataType> view() const
+		{
+			return VectorView<const DataType>(_data.data(), _data.size());
+		}
+
+		// Returns view of the whole vector, non-const version
+		VectorView<DataType> view()
+		{
+			return VectorView<DataType>(_data.data(), _data.size());
+		}
+
 		// Subscript operator overload for MathVector class, const version
 		DataType operator[](const size_t index) const
 		{
@@ -57,20 +106,28 @@ namespace LinAlg
 			return _data[index];
 		}
 
-		// += operator overload
+		// += operator overload; the sum is an expression evaluated straight
+		// into the vector, so no temporary is allocated
 		MathVector<DataType>& operator+=(const MathVector<DataType>& vec)
 		{
 			*this = *this + vec;
 			return *this;
 		}
 
-		// -= operator overload
+		// -= operator overload; see +=
 		MathVector<DataType>& operator-=(const MathVector<DataType>& vec)
 		{
 			*this = *this - vec;
 			return *this;
 		}
 
+		// *= operator overload; scales every element in place
+		MathVector<DataType>& operator*=(const DataType factor)
+		{
+			scale(factor);
+			return *this;
+		}
+
 		// Swaps the elements at the given positions
 		void swap(const size_t pos1, const size_t pos2)
 		{
@@ -100,18 +157,13 @@ namespace LinAlg
 			if (new_sub_vec.size() != last - first)
 				throw InvalidDimensions();
 
-			std::vector<DataType> new_data = new_sub_vec.getData();
-			std::copy(
-				new_data.begin(), new_data.end(), _data.begin() + first);
+			view().subView(first, last).assign(new_sub_vec.view());
 		}
 
 		// Scales every element of the vector by the given value
 		void scale(const DataType factor)
 		{
-			for (int i = 0; i < _data.size(); ++i)
-			{
-				_data[i] *= factor;
-			}
+			view().scale(factor);
 		}
 
 		// Returns vector with every element scaled by the given value
@@ -3,6 +3,9 @@
 
 #include "math_vector.h"
 #include "ops_utils.h"
+#include "matrix_expression.h"
+
+#include <type_traits>
 
 // ------------------------------------------------------------------
 // Operator overloads and other operations for MathVector class
@@ -46,54 +49,182 @@ namespace LinAlg
 		return stream;
 	}
 
-	// Addition operator overload for MathVector class
+	// Maps the types that can appear in a vector expression to the node
+	// that represents them, like MatrixExpressionOf in matrix_ops.h
+	template <typename Type>
+	struct VectorExpressionOf
+	{ };
+
 	template <typename DataType>
-	inline MathVector<DataType> operator+(const MathVector<DataType>& vec1,
-		const MathVector<DataType>& vec2)
+	struct VectorExpressionOf<MathVector<DataType> >
 	{
-		if (vec1.size() != vec2.size())
-			throw InvalidDimensions();
+		using type = VectorOperand<DataType>;
 
-		std::vector<DataType> result_data = addStdVectors(
-			vec1.getData(), vec2.getData());
-		MathVector<DataType> result(result_data);
-		return result;
-	}
+		static type make(const MathVector<DataType>& vec)
+		{
+			return type(vec.view());
+		}
+	};
 
-	// Subtraction operator overload for MathVector class
 	template <typename DataType>
-	inline MathVector<DataType> operator-(const MathVector<DataType>& vec1,
-		const MathVector<DataType>& vec2)
+	struct VectorExpressionOf<VectorView<DataType> >
 	{
-		if (vec1.size() != vec2.size())
-			throw InvalidDimensions();
+		using type = VectorOperand<typename VectorView<DataType>::ValueType>;
 
-		std::vector<DataType> result_data = subtractStdVectors(
-			vec1.getData(), vec2.getData());
-		MathVector<DataType> result(result_data);
-		return result;
-	}
+		static type make(const VectorView<DataType>& view)
+		{
+			return type(view);
+		}
+	};
 
-	// Returns dot product of two given vectors; vectors must be of equal 
-	// length
 	template <typename DataType>
-	inline DataType dotProduct(const MathVector<DataType>& vec1,
-		const MathVector<DataType>& vec2)
+	struct VectorExpressionOf<VectorOperand<DataType> >
+	{
+		using type = VectorOperand<DataType>;
+
+		static const type& make(const type& expression)
+		{
+			return expression;
+		}
+	};
+
+	template <typename Left, typename Right, typename Op>
+	struct VectorExpressionOf<VectorBinaryExpression<Left, Right, Op> >
 	{
+		using type = VectorBinaryExpression<Left, Right, Op>;
+
+		static const type& make(const type& expression)
+		{
+			return expression;
+		}
+	};
+
+	template <typename Expression>
+	struct VectorExpressionOf<VectorScaledExpression<Expression> >
+	{
+		using type = VectorScaledExpression<Expression>;
+
+		static const type& make(const type& expression)
+		{
+			return expression;
+		}
+	};
+
+	// Addition operator overload for MathVector, VectorView, and vector
+	// expressions; returns an expression that is evaluated in one pass
+	// when assigned to a MathVector
+	template <typename Left, typename Right>
+	inline VectorBinaryExpression<typename VectorExpressionOf<Left>::type,
+		typename VectorExpressionOf<Right>::type, AddOp> operator+(
+		const Left& vec1, const Right& vec2)
+	{
+		return VectorBinaryExpression<typename VectorExpressionOf<Left>::type,
+			typename VectorExpressionOf<Right>::type, AddOp>(
+				VectorExpressionOf<Left>::make(vec1),
+				VectorExpressionOf<Right>::make(vec2));
+	}
+
+	// Subtraction operator overload for MathVector, VectorView, and 
+	// vector expressions; see operator+
+	template <typename Left, typename Right>
+	inline VectorBinaryExpression<typename VectorExpressionOf<Left>::type,
+		typename VectorExpressionOf<Right>::type, SubtractOp> operator-(
+		const Left& vec1, const Right& vec2)
+	{
+		return VectorBinaryExpression<typename VectorExpressionOf<Left>::type,
+			typename VectorExpressionOf<Right>::type, SubtractOp>(
+				VectorExpressionOf<Left>::make(vec1),
+				VectorExpressionOf<Right>::make(vec2));
+	}
+
+	// Scalar multiplication overloads for MathVector, VectorView, and 
+	// vector expressions
+	template <typename Scalar, typename Operand>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		VectorScaledExpression<typename VectorExpressionOf<Operand>::type> >::type
+		operator*(const Scalar factor, const Operand& operand)
+	{
+		using Expression = typename VectorExpressionOf<Operand>::type;
+		return VectorScaledExpression<Expression>(
+			VectorExpressionOf<Operand>::make(operand),
+			static_cast<typename Expression::ValueType>(factor));
+	}
+
+	template <typename Operand, typename Scalar>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		VectorScaledExpression<typename VectorExpressionOf<Operand>::type> >::type
+		operator*(const Operand& operand, const Scalar factor)
+	{
+		return factor * operand;
+	}
+
+	// == and != overloads comparing a MathVector with an unevaluated 
+	// expression
+	template <typename DataType, typename Expression>
+	inline bool operator==(const MathVector<DataType>& lhs,
+		const VectorExpression<Expression>& rhs)
+	{
+		return lhs == MathVector<DataType>(rhs);
+	}
+
+	template <typename Expression, typename DataType>
+	inline bool operator==(const VectorExpression<Expression>& lhs,
+		const MathVector<DataType>& rhs)
+	{
+		return MathVector<DataType>(lhs) == rhs;
+	}
+
+	template <typename DataType, typename Expression>
+	inline bool operator!=(const MathVector<DataType>& lhs,
+		const VectorExpression<Expression>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	template <typename Expression, typename DataType>
+	inline bool operator!=(const VectorExpression<Expression>& lhs,
+		const MathVector<DataType>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// Returns dot product of two given vector views; views must be of 
+	// equal length
+	template <typename DataType1, typename DataType2>
+	inline typename VectorView<DataType1>::ValueType dotProduct(
+		const VectorView<DataType1>& vec1,
+		const VectorView<DataType2>& vec2)
+	{
+		using DataType = typename VectorView<DataType1>::ValueType;
+
 		if (vec1.size() != vec2.size())
 			throw InvalidDimensions();
 
-		std::vector<DataType> data1 = vec1.getData();
-		std::vector<DataType> data2 = vec2.getData();
+		// Contiguous fast path; runs the SIMD kernels for supported types
+		if (vec1.isContiguous() && vec2.isContiguous())
+		{
+			const DataType* data1 = vec1.data();
+			const DataType* data2 = vec2.data();
+			return dotKernel(data1, data2, vec1.size());
+		}
 
 		DataType result = 0;
 		for (size_t i = 0; i < vec1.size(); ++i)
 		{
-			result += data1[i] * data2[i];
+			result += vec1[i] * vec2[i];
 		}
 		return result;
 	}
 
+	// Returns dot product of two given vectors; vectors must be of equal 
+	// length
+	template <typename DataType>
+	inline DataType dotProduct(const MathVector<DataType>& vec1,
+		const MathVector<DataType>& vec2)
+	{
+		return dotProduct(vec1.view(), vec2.view());
+	}
+
 	// Returns cross product of two given vectors; vectors both must 
 	// of length 3, otherwise the cross product isn't defined
 	// Note: Could cause issues with a MathVector<size_t>, as the cross 
@@ -58,18 +58,21 @@ namespace LinAlg
 			return _rows == _cols;
 		}
 
-		// += operator overload
+		// += operator overload; derived classes that can update their
+		// elements in place, such as DenseMatrix, hide this version
 		MatrixType& operator+=(const MatrixType& mat)
 		{
-			*this = *this + mat;
-			return *this;
+			MatrixType& self = static_cast<MatrixType&>(*this);
+			self = self + mat;
+			return self;
 		}
 
-		// -= operator overload
+		// -= operator overload; see +=
 		MatrixType& operator-=(const MatrixType& mat)
 		{
-			*this = *this - mat;
-			return *this;
+			MatrixType& self = static_cast<MatrixType&>(*this);
+			self = self - mat;
+			return self;
 		}
 
 		// Returns element at location (row, col), const version
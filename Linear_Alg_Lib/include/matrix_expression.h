@@ -0,0 +1,570 @@
+#ifndef MATRIX_EXPRESSION_H
+#define MATRIX_EXPRESSION_H
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "matrix_view.h"
+#include "exceptions.h"
+#include "thread_pool.h"
+
+// ------------------------------------------------------------------
+// Expression templates for element-wise arithmetic; operator+,
+// operator-, and scaling by a scalar return lightweight expression
+// objects instead of matrices or vectors, and the whole expression is
+// evaluated in one pass, with one output allocation, when it is
+// assigned to a DenseMatrix or MathVector
+// Expressions only refer to their operands, so they must be evaluated
+// before any operand is destroyed or resized; avoid storing them in
+// auto variables
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Base class of every matrix expression; Derived provides
+	//   ValueType                      - element type of the result
+	//   rows(), cols()                 - dimensions
+	//   getStorageType()               - storage type of the result
+	//   hasUnitStride(order)           - true if every operand is stored
+	//                                    in given order
+	//   lineCursor<UnitStride>(pos, order)
+	//                                  - cursor over row pos if order is
+	//                                    RowMajor, or col pos if not; its
+	//                                    operator[](j) computes element j
+	//   aliases(out)                   - true if an operand overlaps view
+	//                                    out without being laid out
+	//                                    exactly like it
+	template <typename Derived>
+	class MatrixExpression
+	{
+	public:
+
+		const Derived& derived() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+	};
+
+	// Leaf of a matrix expression; reads the elements of a view
+	template <typename DataType>
+	class MatrixOperand : public MatrixExpression<MatrixOperand<DataType> >
+	{
+	public:
+
+		using ValueType = DataType;
+
+		// Reads one line of the view; with UnitStride, the elements of
+		// the line are known to be adjacent
+		template <bool UnitStride>
+		class Cursor
+		{
+		public:
+
+			Cursor(const DataType* data_in, const size_t stride_in) :
+				_data(data_in),
+				_stride(stride_in)
+			{ }
+
+			DataType operator[](const size_t index) const
+			{
+				return UnitStride ? _data[index] : _data[index * _stride];
+			}
+
+		private:
+
+			const DataType* _data;
+			size_t _stride;
+		};
+
+		explicit MatrixOperand(const MatrixView<const DataType>& view_in) :
+			_view(view_in)
+		{ }
+
+		size_t rows() const
+		{
+			return _view.rows();
+		}
+
+		size_t cols() const
+		{
+			return _view.cols();
+		}
+
+		StorageType getStorageType() const
+		{
+			return _view.getStorageType();
+		}
+
+		bool hasUnitStride(const StorageType order) const
+		{
+			return _view.getStorageType() == order;
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> lineCursor(const size_t pos,
+			const StorageType order) const
+		{
+			if (order == StorageType::RowMajor)
+				return Cursor<UnitStride>(
+					_view.data() + pos * _view.rowStride(), _view.colStride());
+			else
+				return Cursor<UnitStride>(
+					_view.data() + pos * _view.colStride(), _view.rowStride());
+		}
+
+		// An operand that is out itself is safe to evaluate in place, as
+		// each element is read before it is written; any other overlap,
+		// such as a transposed view of out, is not
+		template <typename OutType>
+		bool aliases(const MatrixView<OutType>& out) const
+		{
+			const bool same_layout = std::is_same<DataType,
+				typename std::remove_const<OutType>::type>::value &&
+				static_cast<const void*>(_view.data()) == static_cast<const void*>(out.data()) &&
+				_view.rowStride() == out.rowStride() &&
+				_view.colStride() == out.colStride();
+			return !same_layout && viewsOverlap(_view, out);
+		}
+
+	private:
+
+		MatrixView<const DataType> _view;
+	};
+
+	// Element-wise combination of two matrix expressions with Op, such as
+	// AddOp or SubtractOp; the result has the data and storage types of
+	// the left expression
+	template <typename Left, typename Right, typename Op>
+	class MatrixBinaryExpression :
+		public MatrixExpression<MatrixBinaryExpression<Left, Right, Op> >
+	{
+	public:
+
+		using ValueType = typename Left::ValueType;
+
+		template <bool UnitStride>
+		class Cursor
+		{
+		public:
+
+			Cursor(const typename Left::template Cursor<UnitStride>& left_in,
+				const typename Right::template Cursor<UnitStride>& right_in) :
+				_left(left_in),
+				_right(right_in)
+			{ }
+
+			ValueType operator[](const size_t index) const
+			{
+				return static_cast<ValueType>(
+					Op()(_left[index], _right[index]));
+			}
+
+		private:
+
+			typename Left::template Cursor<UnitStride> _left;
+			typename Right::template Cursor<UnitStride> _right;
+		};
+
+		// Constructor; throws InvalidDimensions if the dimensions of the
+		// operands differ
+		MatrixBinaryExpression(const Left& left_in, const Right& right_in) :
+			_left(left_in),
+			_right(right_in)
+		{
+			if (_left.rows() != _right.rows() || _left.cols() != _right.cols())
+				throw InvalidDimensions();
+		}
+
+		size_t rows() const
+		{
+			return _left.rows();
+		}
+
+		size_t cols() const
+		{
+			return _left.cols();
+		}
+
+		StorageType getStorageType() const
+		{
+			return _left.getStorageType();
+		}
+
+		bool hasUnitStride(const StorageType order) const
+		{
+			return _left.hasUnitStride(order) && _right.hasUnitStride(order);
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> lineCursor(const size_t pos,
+			const StorageType order) const
+		{
+			return Cursor<UnitStride>(
+				_left.template lineCursor<UnitStride>(pos, order),
+				_right.template lineCursor<UnitStride>(pos, order));
+		}
+
+		template <typename OutType>
+		bool aliases(const MatrixView<OutType>& out) const
+		{
+			return _left.aliases(out) || _right.aliases(out);
+		}
+
+	private:
+
+		// Sub-expressions are held by value; they only refer to data
+		Left _left;
+		Right _right;
+	};
+
+	// Matrix expression multiplied element-wise by a scalar
+	template <typename Expression>
+	class MatrixScaledExpression :
+		public MatrixExpression<MatrixScaledExpression<Expression> >
+	{
+	public:
+
+		using ValueType = typename Expression::ValueType;
+
+		template <bool UnitStride>
+		class Cursor
+		{
+		public:
+
+			Cursor(const typename Expression::template Cursor<UnitStride>& expression_in,
+				const ValueType factor_in) :
+				_expression(expression_in),
+				_factor(factor_in)
+			{ }
+
+			ValueType operator[](const size_t index) const
+			{
+				return _factor * _expression[index];
+			}
+
+		private:
+
+			typename Expression::template Cursor<UnitStride> _expression;
+			ValueType _factor;
+		};
+
+		MatrixScaledExpression(const Expression& expression_in,
+			const ValueType factor_in) :
+			_expression(expression_in),
+			_factor(factor_in)
+		{ }
+
+		size_t rows() const
+		{
+			return _expression.rows();
+		}
+
+		size_t cols() const
+		{
+			return _expression.cols();
+		}
+
+		StorageType getStorageType() const
+		{
+			return _expression.getStorageType();
+		}
+
+		bool hasUnitStride(const StorageType order) const
+		{
+			return _expression.hasUnitStride(order);
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> lineCursor(const size_t pos,
+			const StorageType order) const
+		{
+			return Cursor<UnitStride>(
+				_expression.template lineCursor<UnitStride>(pos, order),
+				_factor);
+		}
+
+		template <typename OutType>
+		bool aliases(const MatrixView<OutType>& out) const
+		{
+			return _expression.aliases(out);
+		}
+
+	private:
+
+		Expression _expression;
+		ValueType _factor;
+	};
+
+	// Evaluations with fewer elements than this run on one thread
+	const size_t EXPRESSION_PARALLEL_MIN_SIZE = 1 << 16;
+
+	// Writes lines [first_line, last_line) of expression into out
+	template <typename DataType, typename Expression, bool UnitStride>
+	inline void evaluateLines(const MatrixView<DataType>& out,
+		const Expression& expression,
+		const size_t first_line,
+		const size_t last_line)
+	{
+		const StorageType order = out.getStorageType();
+
+		for (size_t i = first_line; i < last_line; ++i)
+		{
+			VectorView<DataType> out_line = out.line(i);
+			DataType* out_data = out_line.data();
+			auto cursor = expression.template lineCursor<UnitStride>(i, order);
+
+			for (size_t j = 0; j < out_line.size(); ++j)
+			{
+				out_data[j] = static_cast<DataType>(cursor[j]);
+			}
+		}
+	}
+
+	// Evaluates expression into out in a single pass over the storage
+	// order of out; operands stored in the other order are read in place
+	// with a stride, so layout conversion happens inside the pass
+	// Large expressions are split into bands of lines across
+	// defaultThreadPool()
+	// out may be an operand of expression, as each element only depends
+	// on the elements at the same position; if another operand overlaps
+	// out, such as out.transposed(), the expression is evaluated into a
+	// temporary first
+	template <typename DataType, typename Derived>
+	inline void evaluateInto(const MatrixView<DataType>& out,
+		const MatrixExpression<Derived>& expression_in)
+	{
+		const Derived& expression = expression_in.derived();
+
+		if (out.rows() != expression.rows() || out.cols() != expression.cols())
+			throw InvalidDimensions();
+
+		if (expression.aliases(out))
+		{
+			std::vector<DataType> temp(out.size());
+			MatrixView<DataType> temp_view(temp.data(), out.rows(), out.cols(),
+				out.getStorageType());
+			evaluateInto(temp_view, expression_in);
+			out.assign(temp_view);
+			return;
+		}
+
+		const size_t num_lines = out.numLines();
+		const bool unit_stride = expression.hasUnitStride(out.getStorageType());
+
+		auto evaluate = [&](const size_t first_line, const size_t last_line)
+		{
+			if (unit_stride)
+				evaluateLines<DataType, Derived, true>(
+					out, expression, first_line, last_line);
+			else
+				evaluateLines<DataType, Derived, false>(
+					out, expression, first_line, last_line);
+		};
+
+		if (out.size() < EXPRESSION_PARALLEL_MIN_SIZE)
+		{
+			evaluate(0, num_lines);
+			return;
+		}
+
+		ThreadPool& pool = defaultThreadPool();
+		const size_t num_bands = std::min(num_lines, 4 * pool.numThreads());
+		const size_t band_size = (num_lines + num_bands - 1) / num_bands;
+
+		pool.parallelFor(num_bands, [&](const size_t band)
+		{
+			size_t first_line = band * band_size;
+			evaluate(first_line, std::min(first_line + band_size, num_lines));
+		});
+	}
+
+	// Base class of every vector expression; Derived provides ValueType,
+	// size(), hasUnitStride(), and cursor<UnitStride>(), which work like
+	// their matrix counterparts
+	template <typename Derived>
+	class VectorExpression
+	{
+	public:
+
+		const Derived& derived() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+	};
+
+	// Leaf of a vector expression; reads the elements of a view
+	template <typename DataType>
+	class VectorOperand : public VectorExpression<VectorOperand<DataType> >
+	{
+	public:
+
+		using ValueType = DataType;
+
+		template <bool UnitStride>
+		using Cursor = typename MatrixOperand<DataType>::template Cursor<UnitStride>;
+
+		explicit VectorOperand(const VectorView<const DataType>& view_in) :
+			_view(view_in)
+		{ }
+
+		size_t size() const
+		{
+			return _view.size();
+		}
+
+		bool hasUnitStride() const
+		{
+			return _view.isContiguous();
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> cursor() const
+		{
+			return Cursor<UnitStride>(_view.data(), _view.stride());
+		}
+
+	private:
+
+		VectorView<const DataType> _view;
+	};
+
+	// Element-wise combination of two vector expressions with Op; the
+	// result has the data type of the left expression
+	template <typename Left, typename Right, typename Op>
+	class VectorBinaryExpression :
+		public VectorExpression<VectorBinaryExpression<Left, Right, Op> >
+	{
+	public:
+
+		using ValueType = typename Left::ValueType;
+
+		template <bool UnitStride>
+		class Cursor
+		{
+		public:
+
+			Cursor(const typename Left::template Cursor<UnitStride>& left_in,
+				const typename Right::template Cursor<UnitStride>& right_in) :
+				_left(left_in),
+				_right(right_in)
+			{ }
+
+			ValueType operator[](const size_t index) const
+			{
+				return static_cast<ValueType>(
+					Op()(_left[index], _right[index]));
+			}
+
+		private:
+
+			typename Left::template Cursor<UnitStride> _left;
+			typename Right::template Cursor<UnitStride> _right;
+		};
+
+		// Constructor; throws InvalidDimensions if the sizes of the
+		// operands differ
+		VectorBinaryExpression(const Left& left_in, const Right& right_in) :
+			_left(left_in),
+			_right(right_in)
+		{
+			if (_left.size() != _right.size())
+				throw InvalidDimensions();
+		}
+
+		size_t size() const
+		{
+			return _left.size();
+		}
+
+		bool hasUnitStride() const
+		{
+			return _left.hasUnitStride() && _right.hasUnitStride();
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> cursor() const
+		{
+			return Cursor<UnitStride>(_left.template cursor<UnitStride>(),
+				_right.template cursor<UnitStride>());
+		}
+
+	private:
+
+		Left _left;
+		Right _right;
+	};
+
+	// Vector expression multiplied element-wise by a scalar
+	template <typename Expression>
+	class VectorScaledExpression :
+		public VectorExpression<VectorScaledExpression<Expression> >
+	{
+	public:
+
+		using ValueType = typename Expression::ValueType;
+
+		template <bool UnitStride>
+		using Cursor = typename MatrixScaledExpression<Expression>::template Cursor<UnitStride>;
+
+		VectorScaledExpression(const Expression& expression_in,
+			const ValueType factor_in) :
+			_expression(expression_in),
+			_factor(factor_in)
+		{ }
+
+		size_t size() const
+		{
+			return _expression.size();
+		}
+
+		bool hasUnitStride() const
+		{
+			return _expression.hasUnitStride();
+		}
+
+		template <bool UnitStride>
+		Cursor<UnitStride> cursor() const
+		{
+			return Cursor<UnitStride>(
+				_expression.template cursor<UnitStride>(), _factor);
+		}
+
+	private:
+
+		Expression _expression;
+		ValueType _factor;
+	};
+
+	// Evaluates expression into out in a single pass; out may be an
+	// operand of expression, but must not partially overlap one
+	template <typename DataType, typename Derived>
+	inline void evaluateInto(const VectorView<DataType>& out,
+		const VectorExpression<Derived>& expression_in)
+	{
+		const Derived& expression = expression_in.derived();
+
+		if (out.size() != expression.size())
+			throw InvalidDimensions();
+
+		if (out.isContiguous() && expression.hasUnitStride())
+		{
+			DataType* out_data = out.data();
+			auto cursor = expression.template cursor<true>();
+			for (size_t i = 0; i < out.size(); ++i)
+			{
+				out_data[i] = static_cast<DataType>(cursor[i]);
+			}
+		}
+		else
+		{
+			auto cursor = expression.template cursor<false>();
+			for (size_t i = 0; i < out.size(); ++i)
+			{
+				out[i] = static_cast<DataType>(cursor[i]);
+			}
+		}
+	}
+}
+
+#endif
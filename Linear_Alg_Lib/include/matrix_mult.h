@@ -1,7 +1,16 @@
 #ifndef MATRIX_MULT_H
 #define MATRIX_MULT_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <random>
+
 #include "linalg.h"
+#include "gemm_kernel.h"
+#include "gemv_kernel.h"
 
 // ------------------------------------------------------------------
 // Implementations of matrix multiplication algorithms
@@ -9,186 +18,976 @@
 
 namespace LinAlg
 {
-	// Performs basic multiplication algorithm based on mathematical 
+	// Performs basic multiplication algorithm based on mathematical
 	// definition of matrix multiplication; doesn't worry about storage
-	// formats of A and B; found to be slower than basicMultWithConversion, 
+	// formats of A and B; found to be slower than basicMultWithConversion,
 	// so not used
 	template<typename DataType>
 	inline DenseMatrix<DataType> basicMultNoConversion(
 		const DenseMatrix<DataType>& A,
 		const DenseMatrix<DataType>& B)
 	{
-		std::vector<DataType> product_data(A.rows() * B.cols());
-		DenseMatrix<DataType> product(
-			product_data, A.rows(), B.cols(), A.getStorageType());
+		DenseMatrix<DataType> product(A.rows(), B.cols(), A.getStorageType());
 
 		for (size_t i = 0; i < product.rows(); ++i)
 		{
 			for (size_t j = 0; j < product.cols(); ++j)
 			{
-				product.at(i, j) = dotProduct(A.row(i), B.col(j));
+				product.at(i, j) = dotProduct(A.rowView(i), B.colView(j));
 			}
 		}
 
 		return product;
 	}
 
-	// Performs basic multiplication algorithm based on mathematical 
+	// Computes C = A * B using the basic multiplication algorithm; all
+	// three views must have compatible dimensions, and C must not
+	// overlap A or B
+	// Rows of A and columns of B are read through views, so no elements
+	// are copied; for best performance, A should be RowMajor and B
+	// ColumnMajor so that both are traversed contiguously
+	template<typename DataType>
+	inline void basicMult(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C)
+	{
+		if (A.cols() != B.rows() ||
+			C.rows() != A.rows() ||
+			C.cols() != B.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		for (size_t i = 0; i < C.rows(); ++i)
+		{
+			VectorView<const DataType> A_row = A.row(i);
+			for (size_t j = 0; j < C.cols(); ++j)
+			{
+				C(i, j) = dotProduct(A_row, B.col(j));
+			}
+		}
+	}
+
+	// Performs basic multiplication algorithm based on mathematical
 	// definition of matrix multiplication
 	// Converting A to RowMajor and B to ColMajor improves performance
 	// over not doing the conversion
-	// For multiplying two 300 x 300 matrices: 
+	// For multiplying two 300 x 300 matrices:
 	// ColMajor * ColMajor: 30% faster
 	// ColMajor * RowMajor: 55% faster
 	// RowMajor * RowMajor: 34% faster
 	// RowMajor * ColMajor: 1% slower
 	template<typename DataType>
+	inline DenseMatrix<DataType> basicMultWithConversion(
+		const MatrixView<const DataType>& A,
+		const MatrixView<const DataType>& B,
+		const StorageType storage_type)
+	{
+		DenseMatrix<DataType> product(A.rows(), B.cols(), storage_type);
+
+		// Only convert operands that aren't already in the preferred
+		// storage order
+		DenseMatrix<DataType> converted_A, converted_B;
+		MatrixView<const DataType> A_row_major = A;
+		MatrixView<const DataType> B_col_major = B;
+
+		if (A.getStorageType() != StorageType::RowMajor)
+		{
+			converted_A = DenseMatrix<DataType>(A, StorageType::RowMajor);
+			A_row_major = converted_A.view();
+		}
+
+		if (B.getStorageType() != StorageType::ColumnMajor)
+		{
+			converted_B = DenseMatrix<DataType>(B, StorageType::ColumnMajor);
+			B_col_major = converted_B.view();
+		}
+
+		basicMult(A_row_major, B_col_major, product.view());
+		return product;
+	}
+
+	// DenseMatrix version of basicMultWithConversion; result has the
+	// same storage type as A
+	template<typename DataType>
 	inline DenseMatrix<DataType> basicMultWithConversion(
 		const DenseMatrix<DataType>& A,
 		const DenseMatrix<DataType>& B)
 	{
-		std::vector<DataType> product_data(A.rows() * B.cols());
-		DenseMatrix<DataType> product(
-			product_data, A.rows(), B.cols(), A.getStorageType());
+		return basicMultWithConversion(A.view(), B.view(), A.getStorageType());
+	}
 
-		DenseMatrix<DataType> converted_A = A.convertToRowMajor();
-		DenseMatrix<DataType> converted_B = B.convertToColMajor();
+	// Multiplies A and B with the cache-blocked, packed GEMM engine in
+	// gemm_kernel.h; works directly on any combination of storage types,
+	// so no conversion is needed; result has given storage type
+	// For multiplying two 800 x 800 double matrices with full compiler 
+	// optimizations, roughly 7x faster than basicMultWithConversion on a
+	// single thread; large products are split across defaultThreadPool()
+	template<typename DataType>
+	inline DenseMatrix<DataType> blockedMult(
+		const MatrixView<const DataType>& A,
+		const MatrixView<const DataType>& B,
+		const StorageType storage_type)
+	{
+		if (A.cols() != B.rows())
+			throw InvalidDimensions();
 
-		for (size_t i = 0; i < product.rows(); ++i)
+		DenseMatrix<DataType> product(A.rows(), B.cols(), storage_type);
+		gemmParallel(A, B, product.view());
+		return product;
+	}
+
+	// DenseMatrix version of blockedMult; result has the same storage 
+	// type as A
+	template<typename DataType>
+	inline DenseMatrix<DataType> blockedMult(
+		const DenseMatrix<DataType>& A,
+		const DenseMatrix<DataType>& B)
+	{
+		return blockedMult(A.view(), B.view(), A.getStorageType());
+	}
+
+	// BLAS-style general matrix multiply; computes
+	// C = alpha * op(A) * op(B) + beta * C in place, where op transposes
+	// its operand if the matching flag is Transpose
+	// Runs on the blocked GEMM engine in gemm_kernel.h, split across
+	// defaultThreadPool() for large products; transposed operands are read
+	// in place, and beta is applied as the first panel of the product is
+	// added to C, so C is never copied or scaled in a separate pass
+	// If beta is 0, the old contents of C are ignored; C must not overlap
+	// A or B
+	template<typename DataType>
+	inline void gemm(const TransposeOp trans_A,
+		const TransposeOp trans_B,
+		const typename NonDeduced<DataType>::type alpha,
+		const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const typename NonDeduced<DataType>::type beta,
+		const MatrixView<DataType>& C)
+	{
+		gemmParallel(applyTranspose(A, trans_A), applyTranspose(B, trans_B),
+			C, defaultThreadPool(), GemmBlockSizes(), alpha, beta);
+	}
+
+	// DenseMatrix version of gemm
+	template<typename DataType>
+	inline void gemm(const TransposeOp trans_A,
+		const TransposeOp trans_B,
+		const typename NonDeduced<DataType>::type alpha,
+		const DenseMatrix<DataType>& A,
+		const DenseMatrix<DataType>& B,
+		const typename NonDeduced<DataType>::type beta,
+		DenseMatrix<DataType>& C)
+	{
+		gemm<DataType>(trans_A, trans_B, alpha, A.view(), B.view(), beta,
+			C.view());
+	}
+
+	// BLAS-style matrix-vector multiply; computes
+	// y = alpha * op(A) * x + beta * y in place, where op transposes A if
+	// trans_A is Transpose
+	// Streams A once in its own storage order with the vectorized kernels
+	// in gemv_kernel.h, split across defaultThreadPool() for large
+	// matrices; A^T * x reads A in place
+	// If beta is 0, the old contents of y are ignored; y must not overlap
+	// A or x
+	template<typename DataType>
+	inline void gemv(const TransposeOp trans_A,
+		const typename NonDeduced<DataType>::type alpha,
+		const ConstMatrixView<DataType>& A,
+		const ConstVectorView<DataType>& x,
+		const typename NonDeduced<DataType>::type beta,
+		const VectorView<DataType>& y)
+	{
+		gemvParallel(applyTranspose(A, trans_A), x, y, defaultThreadPool(),
+			alpha, beta);
+	}
+
+	// DenseMatrix and MathVector version of gemv
+	template<typename DataType>
+	inline void gemv(const TransposeOp trans_A,
+		const typename NonDeduced<DataType>::type alpha,
+		const DenseMatrix<DataType>& A,
+		const MathVector<DataType>& x,
+		const typename NonDeduced<DataType>::type beta,
+		MathVector<DataType>& y)
+	{
+		gemv<DataType>(trans_A, alpha, A.view(), x.view(), beta, y.view());
+	}
+
+	// Returns number of recursion levels of Strassen's algorithm whose
+	// seven products should run as parallel tasks on num_threads threads;
+	// enough levels to give every thread a couple of tasks to balance
+	inline size_t strassenParallelDepth(const size_t num_threads)
+	{
+		size_t depth = 0;
+		for (size_t tasks = 1; num_threads > 1 && tasks < 2 * num_threads;
+			tasks *= 7)
 		{
-			for (size_t j = 0; j < product.cols(); ++j)
+			++depth;
+		}
+		return depth;
+	}
+
+	// Returns true if strassenInto() multiplies an m x k matrix by a
+	// k x n matrix directly instead of recursing
+	inline bool strassenBaseCase(const size_t m,
+		const size_t k,
+		const size_t n,
+		const size_t threshold)
+	{
+		return m <= threshold || k <= threshold || n <= threshold;
+	}
+
+	// Returns number of workspace elements strassenInto() needs to
+	// multiply an m x k matrix by a k x n matrix; follows the same
+	// recursion as strassenInto(), and is also enough for
+	// strassenWinogradInto(), whose levels never need more
+	// Serial levels need three quadrant-sized temporaries, so for square
+	// matrices the total is about n^2; every parallel level needs
+	// separate temporaries for each of its seven concurrent products
+	inline size_t strassenWorkspaceSize(const size_t m,
+		const size_t k,
+		const size_t n,
+		const size_t threshold,
+		const size_t parallel_depth)
+	{
+		if (strassenBaseCase(m, k, n, threshold))
+			return 0;
+
+		if (!isEven(m) || !isEven(k) || !isEven(n))
+		{
+			return strassenWorkspaceSize(m - m % 2, k - k % 2, n - n % 2,
+				threshold, parallel_depth);
+		}
+
+		const size_t m2 = m / 2;
+		const size_t k2 = k / 2;
+		const size_t n2 = n / 2;
+
+		if (parallel_depth > 0)
+		{
+			size_t child = strassenWorkspaceSize(m2, k2, n2, threshold,
+				parallel_depth - 1);
+			return 4 * m2 * n2 + 7 * (m2 * k2 + k2 * n2 + child);
+		}
+
+		return m2 * k2 + k2 * n2 + m2 * n2 +
+			strassenWorkspaceSize(m2, k2, n2, threshold, 0);
+	}
+
+	// Returns a rows x cols matrix carved off the front of workspace and
+	// advances workspace past it
+	template<typename DataType>
+	inline MatrixView<DataType> takeWorkspace(DataType*& workspace,
+		const size_t rows,
+		const size_t cols,
+		const StorageType storage_type)
+	{
+		MatrixView<DataType> view(workspace, rows, cols, storage_type);
+		workspace += rows * cols;
+		return view;
+	}
+
+	// Partitions given matrix into 4 equal sub-matrices; puts views of
+	// the sub-matrices into output parameters
+	template<typename DataType>
+	inline void partitionMatrix(const MatrixView<DataType>& A,
+		MatrixView<DataType>& A_11,
+		MatrixView<DataType>& A_12,
+		MatrixView<DataType>& A_21,
+		MatrixView<DataType>& A_22)
+	{
+		size_t partition_rows = A.rows() / 2;
+		size_t partition_cols = A.cols() / 2;
+
+		A_11 = A.subView(0, partition_rows, 0, partition_cols);
+		A_12 = A.subView(0, partition_rows, partition_cols, A.cols());
+		A_21 = A.subView(partition_rows, A.rows(), 0, partition_cols);
+		A_22 = A.subView(partition_rows, A.rows(), partition_cols, A.cols());
+	}
+
+	// Quadrant views of the operands of one level of Strassen's algorithm
+	template<typename DataType>
+	struct StrassenQuadrants
+	{
+		MatrixView<const DataType> A_11, A_12, A_21, A_22;
+		MatrixView<const DataType> B_11, B_12, B_21, B_22;
+
+		StrassenQuadrants(const MatrixView<const DataType>& A,
+			const MatrixView<const DataType>& B)
+		{
+			partitionMatrix(A, A_11, A_12, A_21, A_22);
+			partitionMatrix(B, B_11, B_12, B_21, B_22);
+		}
+
+		// Sets left and right to the factors of product M_(index + 1);
+		// quadrant sums are written into T_1 and T_2, and plain quadrants
+		// are viewed in place
+		void operands(const size_t index,
+			const MatrixView<DataType>& T_1,
+			const MatrixView<DataType>& T_2,
+			MatrixView<const DataType>& left,
+			MatrixView<const DataType>& right) const
+		{
+			switch (index)
 			{
-				product.at(i, j) =
-					dotProduct(converted_A.row(i), converted_B.col(j));
+			case 0:
+				elementwiseViews(T_1, A_11, A_22, AddOp());
+				elementwiseViews(T_2, B_11, B_22, AddOp());
+				left = T_1;
+				right = T_2;
+				break;
+			case 1:
+				elementwiseViews(T_1, A_21, A_22, AddOp());
+				left = T_1;
+				right = B_11;
+				break;
+			case 2:
+				elementwiseViews(T_2, B_12, B_22, SubtractOp());
+				left = A_11;
+				right = T_2;
+				break;
+			case 3:
+				elementwiseViews(T_2, B_21, B_11, SubtractOp());
+				left = A_22;
+				right = T_2;
+				break;
+			case 4:
+				elementwiseViews(T_1, A_11, A_12, AddOp());
+				left = T_1;
+				right = B_22;
+				break;
+			case 5:
+				elementwiseViews(T_1, A_21, A_11, SubtractOp());
+				elementwiseViews(T_2, B_11, B_12, AddOp());
+				left = T_1;
+				right = T_2;
+				break;
+			default:
+				elementwiseViews(T_1, A_12, A_22, SubtractOp());
+				elementwiseViews(T_2, B_21, B_22, AddOp());
+				left = T_1;
+				right = T_2;
+				break;
 			}
 		}
+	};
 
-		return product;
+	// Adds b to a in place
+	template<typename DataType>
+	inline void addInPlace(const MatrixView<DataType>& a,
+		const ConstMatrixView<DataType>& b)
+	{
+		elementwiseViews(a, a, b, AddOp());
+	}
+
+	// Subtracts b from a in place
+	template<typename DataType>
+	inline void subtractInPlace(const MatrixView<DataType>& a,
+		const ConstMatrixView<DataType>& b)
+	{
+		elementwiseViews(a, a, b, SubtractOp());
+	}
+
+	// Completes C = A * B after the even-sized leading block of C has
+	// been computed from the even-sized leading blocks of A and B; the
+	// odd row, column, and inner index that were peeled off are applied
+	// with the blocked GEMM engine
+	template<typename DataType>
+	inline void strassenPeelFixup(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		const size_t m_even,
+		const size_t k_even,
+		const size_t n_even,
+		ThreadPool& pool)
+	{
+		const size_t m = C.rows();
+		const size_t k = A.cols();
+		const size_t n = C.cols();
+
+		// Rank-1 update from the last column of A and last row of B
+		if (k_even < k)
+		{
+			gemmParallel(A.subView(0, m_even, k_even, k),
+				B.subView(k_even, k, 0, n_even),
+				C.subView(0, m_even, 0, n_even), pool);
+		}
+
+		// Last column of C, including its bottom corner
+		if (n_even < n)
+		{
+			gemmParallel(A, B.subView(0, k, n_even, n),
+				C.subView(0, m, n_even, n), pool, GemmBlockSizes(), 1, 0);
+		}
+
+		// Last row of C, excluding its right corner
+		if (m_even < m)
+		{
+			gemmParallel(A.subView(m_even, m, 0, k),
+				B.subView(0, k, 0, n_even), C.subView(m_even, m, 0, n_even),
+				pool, GemmBlockSizes(), 1, 0);
+		}
+	}
+
+	// Computes C = A * B with Strassen's algorithm, writing straight into
+	// C; every temporary is carved out of workspace, which must hold at
+	// least strassenWorkspaceSize() elements, so nothing is allocated
+	// apart from the packing buffers of the base case
+	// Odd dimensions are handled by peeling off the last row, column, or
+	// inner index instead of padding; the seven products of the top
+	// parallel_depth levels run as tasks on pool
+	template<typename DataType>
+	inline void strassenInto(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		const size_t threshold,
+		DataType* workspace,
+		ThreadPool& pool,
+		const size_t parallel_depth)
+	{
+		if (A.cols() != B.rows() ||
+			C.rows() != A.rows() ||
+			C.cols() != B.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		const size_t m = A.rows();
+		const size_t k = A.cols();
+		const size_t n = B.cols();
+
+		if (strassenBaseCase(m, k, n, threshold))
+		{
+			gemmParallel(A, B, C, pool, GemmBlockSizes(), 1, 0);
+			return;
+		}
+
+		if (!isEven(m) || !isEven(k) || !isEven(n))
+		{
+			const size_t m_even = m - m % 2;
+			const size_t k_even = k - k % 2;
+			const size_t n_even = n - n % 2;
+
+			strassenInto(A.subView(0, m_even, 0, k_even),
+				B.subView(0, k_even, 0, n_even),
+				C.subView(0, m_even, 0, n_even),
+				threshold, workspace, pool, parallel_depth);
+			strassenPeelFixup(A, B, C, m_even, k_even, n_even, pool);
+			return;
+		}
+
+		const size_t m2 = m / 2;
+		const size_t k2 = k / 2;
+		const size_t n2 = n / 2;
+
+		StrassenQuadrants<DataType> quadrants(A, B);
+
+		MatrixView<DataType> C_11, C_12, C_21, C_22;
+		partitionMatrix(C, C_11, C_12, C_21, C_22);
+
+		if (parallel_depth > 0)
+		{
+			// M_1, M_2, and M_3 go straight into C_11, C_21, and C_12; the
+			// rest need their own storage since all seven are computed
+			// at once
+			MatrixView<DataType> M[7] = { C_11, C_21, C_12 };
+			for (size_t i = 3; i < 7; ++i)
+			{
+				M[i] = takeWorkspace(workspace, m2, n2, C.getStorageType());
+			}
+
+			const size_t task_size = m2 * k2 + k2 * n2 +
+				strassenWorkspaceSize(m2, k2, n2, threshold, parallel_depth - 1);
+
+			// The products are independent, so they are spawned as tasks
+			// with disjoint slices of the workspace; idle threads steal
+			// them, along with the tasks they spawn
+			auto product = [&, workspace](const size_t i)
+			{
+				DataType* task_workspace = workspace + i * task_size;
+				MatrixView<DataType> T_1 = takeWorkspace(
+					task_workspace, m2, k2, A.getStorageType());
+				MatrixView<DataType> T_2 = takeWorkspace(
+					task_workspace, k2, n2, B.getStorageType());
+
+				MatrixView<const DataType> left, right;
+				quadrants.operands(i, T_1, T_2, left, right);
+				strassenInto(left, right, M[i], threshold, task_workspace,
+					pool, parallel_depth - 1);
+			};
+
+			TaskGroup group(pool);
+			for (size_t i = 1; i < 7; ++i)
+			{
+				group.run([&product, i]() { product(i); });
+			}
+			product(0);
+			group.wait();
+
+			// C_22 = M_1 - M_2 + M_3 + M_6, read before C_11, C_12, and
+			// C_21 are updated
+			elementwiseViews(C_22, C_11, C_21, SubtractOp());
+			addInPlace(C_22, C_12);
+			addInPlace(C_22, M[5]);
+
+			addInPlace(C_11, M[3]);
+			subtractInPlace(C_11, M[4]);
+			addInPlace(C_11, M[6]);
+			addInPlace(C_12, M[4]);
+			addInPlace(C_21, M[3]);
+			return;
+		}
+
+		// The quadrants of C double as accumulators, so one level only
+		// needs the two operand temporaries and one product temporary
+		MatrixView<DataType> T_1 = takeWorkspace(
+			workspace, m2, k2, A.getStorageType());
+		MatrixView<DataType> T_2 = takeWorkspace(
+			workspace, k2, n2, B.getStorageType());
+		MatrixView<DataType> M = takeWorkspace(
+			workspace, m2, n2, C.getStorageType());
+
+		MatrixView<const DataType> left, right;
+		auto product = [&](const size_t i, const MatrixView<DataType>& out)
+		{
+			quadrants.operands(i, T_1, T_2, left, right);
+			strassenInto(left, right, out, threshold, workspace, pool, 0);
+		};
+
+		// C_11 = C_22 = M_1
+		product(0, C_11);
+		C_22.assign(C_11);
+
+		// C_21 = M_2, C_22 -= M_2
+		product(1, C_21);
+		subtractInPlace(C_22, C_21);
+
+		// C_12 = M_3, C_22 += M_3
+		product(2, C_12);
+		addInPlace(C_22, C_12);
+
+		// C_11 += M_4, C_21 += M_4
+		product(3, M);
+		addInPlace(C_11, M);
+		addInPlace(C_21, M);
+
+		// C_11 -= M_5, C_12 += M_5
+		product(4, M);
+		subtractInPlace(C_11, M);
+		addInPlace(C_12, M);
+
+		// C_22 += M_6
+		product(5, M);
+		addInPlace(C_22, M);
+
+		// C_11 += M_7
+		product(6, M);
+		addInPlace(C_11, M);
+	}
+
+	// Performs Strassen's algorithm for matrix multiplication on views
+	// of A and B; switches back to the blocked GEMM engine once one 
+	// dimension drops below threshold; result has given storage type
+	// All temporaries come from a single workspace allocated up front;
+	// see strassenInto()
+	// The seven products of the top levels of recursion run in parallel
+	// on defaultThreadPool(); see strassenParallelDepth()
+	template<typename DataType>
+	inline DenseMatrix<DataType> strassen(
+		const MatrixView<const DataType>& A,
+		const MatrixView<const DataType>& B,
+		const size_t threshold,
+		const StorageType storage_type)
+	{
+		if (A.cols() != B.rows())
+			throw InvalidDimensions();
+
+		ThreadPool& pool = defaultThreadPool();
+		size_t parallel_depth = strassenParallelDepth(pool.numThreads());
+
+		DenseMatrix<DataType> C(A.rows(), B.cols(), storage_type);
+		std::vector<DataType> workspace(strassenWorkspaceSize(A.rows(),
+			A.cols(), B.cols(), threshold, parallel_depth));
+
+		strassenInto(A, B, C.view(), threshold, workspace.data(), pool,
+			parallel_depth);
+		return C;
 	}
 
 	// Performs Strassen's algorithm for matrix multiplication; switches
-	// back to basicMultWithConversion once one dimension of matrix drops
-	// below threshold
+	// back to the blocked GEMM engine once one dimension of matrix drops
+	// below threshold; result has the same storage type as A
 	template<typename DataType>
 	inline DenseMatrix<DataType> strassen(
 		const DenseMatrix<DataType>& A,
 		const DenseMatrix<DataType>& B,
 		const size_t threshold)
 	{
-		// Switches to basic multiplication algorithm once matrices get
-		// small enough for performance reasons
-		if (A.rows() <= threshold ||
-			A.cols() <= threshold ||
-			B.rows() <= threshold ||
-			B.cols() <= threshold)
+		return strassen(A.view(), B.view(), threshold, A.getStorageType());
+	}
+
+	// Computes C = A * B with the Winograd variant of Strassen's
+	// algorithm, which needs 15 quadrant additions per level instead of
+	// 18; otherwise works like strassenInto(), including its workspace,
+	// which must hold at least strassenWorkspaceSize() elements
+	// With S_1 = A_21 + A_22, S_2 = S_1 - A_11, S_3 = A_11 - A_21,
+	// S_4 = A_12 - S_2, T_1 = B_12 - B_11, T_2 = B_22 - T_1,
+	// T_3 = B_22 - B_12, and T_4 = T_2 - B_21, the products are
+	// P_1 = A_11 B_11, P_2 = A_12 B_21, P_3 = S_4 B_22, P_4 = A_22 T_4,
+	// P_5 = S_1 T_1, P_6 = S_2 T_2, and P_7 = S_3 T_3, and with
+	// U_2 = P_1 + P_6 and U_3 = U_2 + P_7, the result is
+	// C_11 = P_1 + P_2, C_12 = U_2 + P_5 + P_3, C_21 = U_3 - P_4, and
+	// C_22 = U_3 + P_5
+	template<typename DataType>
+	inline void strassenWinogradInto(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		const size_t threshold,
+		DataType* workspace,
+		ThreadPool& pool,
+		const size_t parallel_depth)
+	{
+		if (A.cols() != B.rows() ||
+			C.rows() != A.rows() ||
+			C.cols() != B.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		const size_t m = A.rows();
+		const size_t k = A.cols();
+		const size_t n = B.cols();
+
+		if (strassenBaseCase(m, k, n, threshold))
+		{
+			gemmParallel(A, B, C, pool, GemmBlockSizes(), 1, 0);
+			return;
+		}
+
+		if (!isEven(m) || !isEven(k) || !isEven(n))
+		{
+			const size_t m_even = m - m % 2;
+			const size_t k_even = k - k % 2;
+			const size_t n_even = n - n % 2;
+
+			strassenWinogradInto(A.subView(0, m_even, 0, k_even),
+				B.subView(0, k_even, 0, n_even),
+				C.subView(0, m_even, 0, n_even),
+				threshold, workspace, pool, parallel_depth);
+			strassenPeelFixup(A, B, C, m_even, k_even, n_even, pool);
+			return;
+		}
+
+		const size_t m2 = m / 2;
+		const size_t k2 = k / 2;
+		const size_t n2 = n / 2;
+		const StorageType A_type = A.getStorageType();
+		const StorageType B_type = B.getStorageType();
+		const StorageType C_type = C.getStorageType();
+
+		MatrixView<const DataType> A_11, A_12, A_21, A_22, B_11, B_12, B_21, B_22;
+		partitionMatrix(A, A_11, A_12, A_21, A_22);
+		partitionMatrix(B, B_11, B_12, B_21, B_22);
+
+		MatrixView<DataType> C_11, C_12, C_21, C_22;
+		partitionMatrix(C, C_11, C_12, C_21, C_22);
+
+		if (parallel_depth > 0)
 		{
-			return basicMultWithConversion(A, B);
+			// All eight operand sums are formed up front so the seven
+			// products can run at once; P_3, P_5, P_6, and P_7 go straight
+			// into quadrants of C
+			MatrixView<DataType> S[4], T[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				S[i] = takeWorkspace(workspace, m2, k2, A_type);
+				T[i] = takeWorkspace(workspace, k2, n2, B_type);
+			}
+			MatrixView<DataType> P_1 = takeWorkspace(workspace, m2, n2, C_type);
+			MatrixView<DataType> P_2 = takeWorkspace(workspace, m2, n2, C_type);
+			MatrixView<DataType> P_4 = takeWorkspace(workspace, m2, n2, C_type);
+
+			elementwiseViews(S[0], A_21, A_22, AddOp());
+			elementwiseViews(S[1], S[0], A_11, SubtractOp());
+			elementwiseViews(S[2], A_11, A_21, SubtractOp());
+			elementwiseViews(S[3], A_12, S[1], SubtractOp());
+			elementwiseViews(T[0], B_12, B_11, SubtractOp());
+			elementwiseViews(T[1], B_22, T[0], SubtractOp());
+			elementwiseViews(T[2], B_22, B_12, SubtractOp());
+			elementwiseViews(T[3], T[1], B_21, SubtractOp());
+
+			const MatrixView<const DataType> left[7] = {
+				A_11, A_12, S[3], A_22, S[0], S[1], S[2] };
+			const MatrixView<const DataType> right[7] = {
+				B_11, B_21, B_22, T[3], T[0], T[1], T[2] };
+			const MatrixView<DataType> out[7] = {
+				P_1, P_2, C_11, P_4, C_22, C_12, C_21 };
+
+			const size_t task_size =
+				strassenWorkspaceSize(m2, k2, n2, threshold, parallel_depth - 1);
+
+			auto product = [&, workspace](const size_t i)
+			{
+				strassenWinogradInto(left[i], right[i], out[i], threshold,
+					workspace + i * task_size, pool, parallel_depth - 1);
+			};
+
+			TaskGroup group(pool);
+			for (size_t i = 1; i < 7; ++i)
+			{
+				group.run([&product, i]() { product(i); });
+			}
+			product(0);
+			group.wait();
+
+			// C_12 = U_2 = P_1 + P_6, C_21 = U_3 = U_2 + P_7,
+			// C_12 = U_2 + P_5 + P_3, C_22 = U_3 + P_5, C_21 = U_3 - P_4,
+			// and C_11 = P_1 + P_2
+			addInPlace(C_12, P_1);
+			addInPlace(C_21, C_12);
+			addInPlace(C_12, C_22);
+			addInPlace(C_22, C_21);
+			addInPlace(C_12, C_11);
+			subtractInPlace(C_21, P_4);
+			elementwiseViews(C_11, P_1, P_2, AddOp());
+			return;
 		}
 
-		bool A_padded_row, A_padded_col, B_padded_row, B_padded_col;
-		A_padded_row = A_padded_col = B_padded_row = B_padded_col = false;
+		// Schedule of Boyer, Dumas, Pernet, and Zhou, "Memory efficient
+		// scheduling of Strassen-Winograd's matrix multiplication
+		// algorithm"; the quadrants of C hold intermediate products, so
+		// one level only needs an A-sized and a B-sized temporary, plus
+		// one for P_1
+		MatrixView<DataType> X = takeWorkspace(workspace, m2, k2, A_type);
+		MatrixView<DataType> Y = takeWorkspace(workspace, k2, n2, B_type);
+		MatrixView<DataType> P_1 = takeWorkspace(workspace, m2, n2, C_type);
+
+		auto product = [&](const MatrixView<const DataType>& left,
+			const MatrixView<const DataType>& right,
+			const MatrixView<DataType>& out)
+		{
+			strassenWinogradInto(left, right, out, threshold, workspace, pool, 0);
+		};
+
+		// C_21 = P_7 = S_3 T_3
+		elementwiseViews(X, A_11, A_21, SubtractOp());
+		elementwiseViews(Y, B_22, B_12, SubtractOp());
+		product(X, Y, C_21);
+
+		// C_22 = P_5 = S_1 T_1
+		elementwiseViews(X, A_21, A_22, AddOp());
+		elementwiseViews(Y, B_12, B_11, SubtractOp());
+		product(X, Y, C_22);
+
+		// C_12 = P_6 = S_2 T_2
+		elementwiseViews(Y, B_22, Y, SubtractOp());
+		elementwiseViews(X, X, A_11, SubtractOp());
+		product(X, Y, C_12);
+
+		// C_11 = P_3 = S_4 B_22
+		elementwiseViews(X, A_12, X, SubtractOp());
+		product(X, B_22, C_11);
 
-		DenseMatrix<DataType> padded_A = 
-			padMatrix(A, A_padded_row, A_padded_col);
-		DenseMatrix<DataType> padded_B = 
-			padMatrix(B, B_padded_row, B_padded_col);
+		// C_12 = U_2, C_21 = U_3, C_12 = U_2 + P_5, C_22 = U_3 + P_5,
+		// and C_12 = U_2 + P_5 + P_3
+		product(A_11, B_11, P_1);
+		addInPlace(C_12, P_1);
+		addInPlace(C_21, C_12);
+		addInPlace(C_12, C_22);
+		addInPlace(C_22, C_21);
+		addInPlace(C_12, C_11);
 
-		DenseMatrix<DataType> A_11, A_12, A_21, A_22, B_11, B_12, B_21, B_22;
-		partitionMatrix(padded_A, A_11, A_12, A_21, A_22);
-		partitionMatrix(padded_B, B_11, B_12, B_21, B_22);
+		// C_21 = U_3 - P_4 with P_4 = A_22 T_4
+		elementwiseViews(Y, Y, B_21, SubtractOp());
+		product(A_22, Y, C_11);
+		subtractInPlace(C_21, C_11);
 
-		DenseMatrix<DataType> M_1 = strassen(A_11 + A_22, B_11 + B_22, threshold);
-		DenseMatrix<DataType> M_2 = strassen(A_21 + A_22, B_11, threshold);
-		DenseMatrix<DataType> M_3 = strassen(A_11, B_12 - B_22, threshold);
-		DenseMatrix<DataType> M_4 = strassen(A_22, B_21 - B_11, threshold);
-		DenseMatrix<DataType> M_5 = strassen(A_11 + A_12, B_22, threshold);
-		DenseMatrix<DataType> M_6 = strassen(A_21 - A_11, B_11 + B_12, threshold);
-		DenseMatrix<DataType> M_7 = strassen(A_12 - A_22, B_21 + B_22, threshold);
+		// C_11 = P_1 + P_2
+		product(A_12, B_21, C_11);
+		addInPlace(C_11, P_1);
+	}
+
+	// Performs the Winograd variant of Strassen's algorithm on views of
+	// A and B; switches back to the blocked GEMM engine once one
+	// dimension drops below threshold; result has given storage type
+	template<typename DataType>
+	inline DenseMatrix<DataType> strassenWinograd(
+		const MatrixView<const DataType>& A,
+		const MatrixView<const DataType>& B,
+		const size_t threshold,
+		const StorageType storage_type)
+	{
+		if (A.cols() != B.rows())
+			throw InvalidDimensions();
+
+		ThreadPool& pool = defaultThreadPool();
+		size_t parallel_depth = strassenParallelDepth(pool.numThreads());
+
+		DenseMatrix<DataType> C(A.rows(), B.cols(), storage_type);
+		std::vector<DataType> workspace(strassenWorkspaceSize(A.rows(),
+			A.cols(), B.cols(), threshold, parallel_depth));
+
+		strassenWinogradInto(A, B, C.view(), threshold, workspace.data(),
+			pool, parallel_depth);
+		return C;
+	}
+
+	// Performs the Winograd variant of Strassen's algorithm; result has
+	// the same storage type as A
+	template<typename DataType>
+	inline DenseMatrix<DataType> strassenWinograd(
+		const DenseMatrix<DataType>& A,
+		const DenseMatrix<DataType>& B,
+		const size_t threshold)
+	{
+		return strassenWinograd(A.view(), B.view(), threshold, A.getStorageType());
+	}
 
-		DenseMatrix<DataType> C(padded_A.rows(), padded_B.cols(), A.getStorageType());
+	// Smallest and largest square sizes the crossover tuner measures; it
+	// doubles from the smallest, so these are the sizes it can report
+	const size_t STRASSEN_MIN_CROSSOVER = 256;
+	const size_t STRASSEN_MAX_CROSSOVER = 4096;
 
-		DenseMatrix<DataType> C_11 = M_1 + M_4 - M_5 + M_7;
-		DenseMatrix<DataType> C_12 = M_3 + M_5;
-		DenseMatrix<DataType> C_21 = M_2 + M_4;
-		DenseMatrix<DataType> C_22 = M_1 - M_2 + M_3 + M_6;
+	// Value of strassenCrossover() when no measured size favored
+	// Strassen-Winograd
+	const size_t STRASSEN_NO_CROSSOVER = std::numeric_limits<size_t>::max();
 
-		constructFromSubMatrices(C, C_11, C_12, C_21, C_22);
+	// Crossover used until tuneStrassenCrossover() or
+	// setStrassenCrossover() is called; a fixed size, so that products
+	// round the same way on every run
+	const size_t STRASSEN_DEFAULT_CROSSOVER = 2048;
 
-		// Don't need to check A_padded_col and B_padded_row; if one is 
-		// true, the other must be true as well, and C is unchanged if
-		// both are true
-		if (B_padded_col)
-			C.removeCol(C.cols() - 1);
+	// Crossover tuning results for one data type
+	struct StrassenTuning
+	{
+		// Serializes tuneStrassenCrossover() calls
+		std::mutex mutex;
 
-		if (A_padded_row)
-			C.removeRow(C.rows() - 1);
+		// Smallest dimension at which adaptiveMult() uses
+		// Strassen-Winograd
+		std::atomic<size_t> crossover{ STRASSEN_DEFAULT_CROSSOVER };
+	};
 
-		return C;	
+	// Returns the tuning results for given data type; a separate copy
+	// exists for every data type, created on first use
+	template<typename DataType>
+	inline StrassenTuning& strassenTuning()
+	{
+		static StrassenTuning tuning;
+		return tuning;
 	}
 
-	// Returns a matrix with same data as A, but with an extra row 
-	// and/or column filled with zeros for "padding", ensuring A has 
-	// an even number of rows and columns
+	// Returns true if one level of Strassen-Winograd on top of the
+	// blocked GEMM engine multiplies two random n x n matrices faster
+	// than the blocked GEMM engine alone; each is timed twice and the
+	// faster run counts
 	template<typename DataType>
-	inline DenseMatrix<DataType> padMatrix(const DenseMatrix<DataType>& A, 
-		bool& padded_row,
-		bool& padded_col)
+	inline bool strassenWinogradWins(const size_t n)
 	{
-		DenseMatrix<DataType> padded_A = A;
-		if (!isEven(A.rows()))
+		using namespace std::chrono;
+
+		// A private generator leaves the caller's rand() sequence alone
+		std::mt19937 generator(static_cast<unsigned>(n));
+		std::uniform_int_distribution<int> distribution(0, 99);
+		std::vector<DataType> data1(n * n), data2(n * n);
+		for (size_t i = 0; i < n * n; ++i)
 		{
-			std::vector<DataType> zeros(padded_A.cols(), 0);
-			MathVector<DataType> padding(zeros);
-			padded_A.addRow(A.rows(), padding);
-			padded_row = true;
+			data1[i] = static_cast<DataType>(distribution(generator));
+			data2[i] = static_cast<DataType>(distribution(generator));
 		}
+		DenseMatrix<DataType> A(data1, n, n);
+		DenseMatrix<DataType> B(data2, n, n);
 
-		if (!isEven(A.cols()))
+		auto bestTime = [](const std::function<void()>& f)
 		{
-			std::vector<DataType> zeros(padded_A.rows(), 0);
-			MathVector<DataType> padding(zeros);
-			padded_A.addCol(A.cols(), padding);
-			padded_col = true;
-		}
+			nanoseconds best = nanoseconds::max();
+			for (size_t i = 0; i < 2; ++i)
+			{
+				auto start = steady_clock::now();
+				f();
+				best = std::min(best, duration_cast<nanoseconds>(
+					steady_clock::now() - start));
+			}
+			return best;
+		};
+
+		nanoseconds gemm_time = bestTime([&]() { blockedMult(A, B); });
+		nanoseconds winograd_time = bestTime([&]() {
+			strassenWinograd(A, B, n - 1); });
 
-		return padded_A;
+		return winograd_time < gemm_time;
 	}
 
-	// Partitions given matrix into 4 equal sub-matrices; puts sub-matrices
-	// into output parameters
+	// Returns the smallest dimension at which adaptiveMult() uses
+	// Strassen-Winograd for given data type, or STRASSEN_NO_CROSSOVER if
+	// it never does; never measures anything
 	template<typename DataType>
-	inline void partitionMatrix(const DenseMatrix<DataType>& A,
-		DenseMatrix<DataType>& A_11,
-		DenseMatrix<DataType>& A_12,
-		DenseMatrix<DataType>& A_21,
-		DenseMatrix<DataType>& A_22)
+	inline size_t strassenCrossover()
 	{
-		size_t partition_rows = A.rows() / 2;
-		size_t partition_cols = A.cols() / 2;
+		return strassenTuning<DataType>().crossover.load(std::memory_order_relaxed);
+	}
 
-		A_11 = A.getSubMatrix(0, partition_rows, 0, partition_cols);
-		A_12 = A.getSubMatrix(0, partition_rows, partition_cols, A.cols());
-		A_21 = A.getSubMatrix(partition_rows, A.rows(), 0, partition_cols);
-		A_22 = A.getSubMatrix(partition_rows, A.rows(), partition_cols, A.cols());
+	// Measures the smallest dimension at which a level of
+	// Strassen-Winograd beats the blocked GEMM engine for given data type
+	// on this machine, doubling from STRASSEN_MIN_CROSSOVER up to
+	// max_size, and makes adaptiveMult() use it; returns the new
+	// crossover, or STRASSEN_NO_CROSSOVER if no measured size favored
+	// Strassen-Winograd
+	// Takes a few multiplications of every measured size, with the
+	// current thread count, and the result depends on machine load, so
+	// call it once at startup, not before every product
+	template<typename DataType>
+	inline size_t tuneStrassenCrossover(
+		const size_t max_size = STRASSEN_MAX_CROSSOVER)
+	{
+		StrassenTuning& tuning = strassenTuning<DataType>();
+		std::lock_guard<std::mutex> lock(tuning.mutex);
+
+		size_t crossover = STRASSEN_NO_CROSSOVER;
+		for (size_t n = STRASSEN_MIN_CROSSOVER;
+			n <= std::min(max_size, STRASSEN_MAX_CROSSOVER); n *= 2)
+		{
+			if (strassenWinogradWins<DataType>(n))
+			{
+				crossover = n;
+				break;
+			}
+		}
+
+		tuning.crossover.store(crossover, std::memory_order_relaxed);
+		return crossover;
 	}
 
-	// Constructs matrix C from given sub_matrices C_11, C_12, C_21, and C_22;
-	// assumes C is a zero-initialized matrix with the correct dimensions
-	template<typename DataType> 
-	inline void constructFromSubMatrices(DenseMatrix<DataType>& C,
-		const DenseMatrix<DataType>& C_11,
-		const DenseMatrix<DataType>& C_12,
-		const DenseMatrix<DataType>& C_21,
-		const DenseMatrix<DataType>& C_22)
+	// Sets the crossover for given data type without measuring;
+	// STRASSEN_NO_CROSSOVER turns Strassen-Winograd off in adaptiveMult()
+	template<typename DataType>
+	inline void setStrassenCrossover(const size_t crossover)
 	{
-		size_t partition_rows = C.rows() / 2;
-		size_t partition_cols = C.cols() / 2;
+		strassenTuning<DataType>().crossover.store(crossover, std::memory_order_relaxed);
+	}
+
+	// Multiplies A and B with Strassen-Winograd if every dimension is at
+	// least strassenCrossover(), and with the blocked GEMM engine
+	// otherwise; result has given storage type
+	template<typename DataType>
+	inline DenseMatrix<DataType> adaptiveMult(
+		const MatrixView<const DataType>& A,
+		const MatrixView<const DataType>& B,
+		const StorageType storage_type)
+	{
+		if (A.cols() != B.rows())
+			throw InvalidDimensions();
+
+		size_t min_dim = std::min(std::min(A.rows(), A.cols()), B.cols());
+
+		size_t crossover = strassenCrossover<DataType>();
+		if (min_dim >= crossover)
+			return strassenWinograd(A, B, crossover - 1, storage_type);
 
-		C.setSubMatrix(0, partition_rows, 0, partition_cols, C_11);
-		C.setSubMatrix(0, partition_rows, partition_cols, C.cols(), C_12);
-		C.setSubMatrix(partition_rows, C.rows(), 0, partition_cols, C_21);
-		C.setSubMatrix(partition_rows, C.rows(), partition_cols, C.cols(), C_22);
+		return blockedMult(A, B, storage_type);
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,10 @@
 #include "math_vector.h"
 #include "ops_utils.h"
 #include "matrix_mult.h"
+#include "matrix_expression.h"
+#include "spmv_kernel.h"
+
+#include <type_traits>
 
 // ------------------------------------------------------------------
 // Operator overloads for DenseMatrix class
@@ -78,106 +82,592 @@ namespace LinAlg
 		return stream;
 	}
 
-	// Addition overload for DenseMatrix class; returns a DenseMatrix with 
-	// the same StorageType as mat1
+	// Maps the types that can appear in a matrix expression to the node
+	// that represents them; DenseMatrix and MatrixView become leaves that
+	// read their elements, and expressions are used as they are
+	// Has no type member for any other type, which removes the operator
+	// overloads below from overload resolution
+	template <typename Type>
+	struct MatrixExpressionOf
+	{ };
+
 	template <typename DataType>
-	inline DenseMatrix<DataType> operator+(const DenseMatrix<DataType>& mat1,
-		const DenseMatrix<DataType>& mat2)
+	struct MatrixExpressionOf<DenseMatrix<DataType> >
 	{
-		// Check that both matrices have the same dimensions
-		if (!sameDimension(mat1, mat2))
-			throw InvalidDimensions();
+		using type = MatrixOperand<DataType>;
 
-		// Check that both matrices have the same storage format
-		if (mat1.getStorageType() == mat2.getStorageType())
+		static type make(const DenseMatrix<DataType>& mat)
 		{
-			// Add the data vectors together and return a new DenseMatrix
-			std::vector<DataType> result_data = addStdVectors(mat1.getData(), mat2.getData());
-			DenseMatrix<DataType> result(
-				result_data, mat1.rows(), mat1.cols(), mat1.getStorageType());
-			return result;
+			return type(mat.view());
 		}
-		// If the matrices' storage formats don't match
-		std::vector<DataType> data2_converted;
+	};
 
-		if (mat1.getStorageType() == StorageType::RowMajor)
+	template <typename DataType>
+	struct MatrixExpressionOf<MatrixView<DataType> >
+	{
+		using type = MatrixOperand<typename MatrixView<DataType>::ValueType>;
+
+		static type make(const MatrixView<DataType>& view)
 		{
-			// Mat2 must be column major, so convert it's data vector to 
-			// row major for easy addition
-			data2_converted = convertToRowMajorHelper(
-				mat2.getData(), mat2.rows(), mat2.cols());
+			return type(view);
 		}
-		else
+	};
+
+	template <typename DataType>
+	struct MatrixExpressionOf<MatrixOperand<DataType> >
+	{
+		using type = MatrixOperand<DataType>;
+
+		static const type& make(const type& expression)
 		{
-			// Mat2 must be row major, so convert it's data vector to column major
-			data2_converted = convertToColMajorHelper(
-				mat2.getData(), mat2.rows(), mat2.cols());
+			return expression;
 		}
+	};
 
-		std::vector<DataType> result_data = addStdVectors(mat1.getData(), data2_converted);
-		DenseMatrix<DataType> result(
-			result_data, mat1.rows(), mat2.cols(), mat1.getStorageType());
-		return result;
+	template <typename Left, typename Right, typename Op>
+	struct MatrixExpressionOf<MatrixBinaryExpression<Left, Right, Op> >
+	{
+		using type = MatrixBinaryExpression<Left, Right, Op>;
+
+		static const type& make(const type& expression)
+		{
+			return expression;
+		}
+	};
+
+	template <typename Expression>
+	struct MatrixExpressionOf<MatrixScaledExpression<Expression> >
+	{
+		using type = MatrixScaledExpression<Expression>;
+
+		static const type& make(const type& expression)
+		{
+			return expression;
+		}
+	};
+
+	// Addition overload for DenseMatrix, MatrixView, and matrix 
+	// expressions; returns an expression that is evaluated when assigned
+	// to a DenseMatrix, which gets the same StorageType as lhs
+	// Storage types of the operands don't need to match, as mismatched 
+	// elements are read in place without converting
+	template <typename Left, typename Right>
+	inline MatrixBinaryExpression<typename MatrixExpressionOf<Left>::type,
+		typename MatrixExpressionOf<Right>::type, AddOp> operator+(
+		const Left& lhs, const Right& rhs)
+	{
+		return MatrixBinaryExpression<typename MatrixExpressionOf<Left>::type,
+			typename MatrixExpressionOf<Right>::type, AddOp>(
+				MatrixExpressionOf<Left>::make(lhs),
+				MatrixExpressionOf<Right>::make(rhs));
+	}
+
+	// Subtraction overload for DenseMatrix, MatrixView, and matrix 
+	// expressions; see operator+
+	template <typename Left, typename Right>
+	inline MatrixBinaryExpression<typename MatrixExpressionOf<Left>::type,
+		typename MatrixExpressionOf<Right>::type, SubtractOp> operator-(
+		const Left& lhs, const Right& rhs)
+	{
+		return MatrixBinaryExpression<typename MatrixExpressionOf<Left>::type,
+			typename MatrixExpressionOf<Right>::type, SubtractOp>(
+				MatrixExpressionOf<Left>::make(lhs),
+				MatrixExpressionOf<Right>::make(rhs));
+	}
+
+	// Scalar multiplication overload for DenseMatrix, MatrixView, and 
+	// matrix expressions; returns an expression like operator+
+	template <typename Scalar, typename Operand>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		MatrixScaledExpression<typename MatrixExpressionOf<Operand>::type> >::type
+		operator*(const Scalar factor, const Operand& operand)
+	{
+		using Expression = typename MatrixExpressionOf<Operand>::type;
+		return MatrixScaledExpression<Expression>(
+			MatrixExpressionOf<Operand>::make(operand),
+			static_cast<typename Expression::ValueType>(factor));
+	}
+
+	template <typename Operand, typename Scalar>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		MatrixScaledExpression<typename MatrixExpressionOf<Operand>::type> >::type
+		operator*(const Operand& operand, const Scalar factor)
+	{
+		return factor * operand;
+	}
+
+	// == and != overloads comparing a DenseMatrix with an unevaluated 
+	// expression; the expression is evaluated first
+	template <typename DataType, typename Expression>
+	inline bool operator==(const DenseMatrix<DataType>& lhs,
+		const MatrixExpression<Expression>& rhs)
+	{
+		return lhs == DenseMatrix<DataType>(rhs);
 	}
 
-	// Subtraction overload for DenseMatrix class; returns a DenseMatrix with 
-	// the same StorageType as mat1
+	template <typename Expression, typename DataType>
+	inline bool operator==(const MatrixExpression<Expression>& lhs,
+		const DenseMatrix<DataType>& rhs)
+	{
+		return DenseMatrix<DataType>(lhs) == rhs;
+	}
+
+	template <typename DataType, typename Expression>
+	inline bool operator!=(const DenseMatrix<DataType>& lhs,
+		const MatrixExpression<Expression>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	template <typename Expression, typename DataType>
+	inline bool operator!=(const MatrixExpression<Expression>& lhs,
+		const DenseMatrix<DataType>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// Unevaluated product of two matrices, returned by operator*; 
+	// converts to a DenseMatrix with the same storage type as lhs using
+	// adaptiveMult(), or is accumulated straight into an existing matrix
+	// by C += A * B and C -= A * B without a temporary
+	// Refers to the data of its operands, like the expressions in 
+	// matrix_expression.h, so it must be used before they change
 	template <typename DataType>
-	inline DenseMatrix<DataType> operator-(const DenseMatrix<DataType>& mat1,
-		const DenseMatrix<DataType>& mat2)
+	class MatrixProduct
 	{
-		// Check that both matrices have the same dimensions
-		if (!sameDimension(mat1, mat2))
-			throw InvalidDimensions();
+	public:
+
+		// Constructor; throws InvalidDimensions if lhs.cols() doesn't
+		// match rhs.rows()
+		MatrixProduct(const MatrixView<const DataType>& lhs_in,
+			const MatrixView<const DataType>& rhs_in,
+			const StorageType storage_type_in) :
+			_lhs(lhs_in),
+			_rhs(rhs_in),
+			_storage_type(storage_type_in)
+		{
+			if (_lhs.cols() != _rhs.rows())
+				throw InvalidDimensions();
+		}
+
+		const MatrixView<const DataType>& lhs() const
+		{
+			return _lhs;
+		}
 
-		// Check that both matrices have the same storage format
-		if (mat1.getStorageType() == mat2.getStorageType())
+		const MatrixView<const DataType>& rhs() const
 		{
-			// Subract the data vectors and return a new DenseMatrix
-			std::vector<DataType> result_data = subtractStdVectors(
-				mat1.getData(), mat2.getData());
-			DenseMatrix<DataType> result(
-				result_data, mat1.rows(), mat1.cols(), mat1.getStorageType());
-			return result;
+			return _rhs;
 		}
 
-		// If the matrices' storage formats don't match
-		std::vector<DataType> data2_converted;
+		size_t rows() const
+		{
+			return _lhs.rows();
+		}
+
+		size_t cols() const
+		{
+			return _rhs.cols();
+		}
 
-		if (mat1.getStorageType() == StorageType::RowMajor)
+		StorageType getStorageType() const
 		{
-			// Mat2 must be column major, so convert it's data vector to row 
-			// major for easy addition
-			data2_converted = convertToRowMajorHelper(
-				mat2.getData(), mat2.rows(), mat2.cols());
+			return _storage_type;
 		}
-		else
+
+		// Returns the product as a new DenseMatrix; large products use 
+		// Strassen-Winograd past strassenCrossover(), see adaptiveMult()
+		DenseMatrix<DataType> evaluate() const
 		{
-			// Mat2 must be row major, so convert it's data vector to column major
-			data2_converted = convertToColMajorHelper(
-				mat2.getData(), mat2.rows(), mat2.cols());
+			return adaptiveMult(_lhs, _rhs, _storage_type);
 		}
 
-		std::vector<DataType> result_data = subtractStdVectors(
-			mat1.getData(), data2_converted);
-		DenseMatrix<DataType> result(
-			result_data, mat1.rows(), mat2.cols(), mat1.getStorageType());
+	private:
+
+		MatrixView<const DataType> _lhs;
+		MatrixView<const DataType> _rhs;
+		StorageType _storage_type;
+	};
+
+	// Matrix multiplication overload for DenseMatrix; returns a product
+	// that evaluates to a DenseMatrix with the same storage type as mat1
+	template <typename DataType>
+	inline MatrixProduct<DataType> operator*(const DenseMatrix<DataType>& mat1,
+		const DenseMatrix<DataType>& mat2)
+	{
+		return MatrixProduct<DataType>(
+			mat1.view(), mat2.view(), mat1.getStorageType());
+	}
+
+	// Matrix multiplication overload for MatrixView class; returns a 
+	// product that evaluates to a DenseMatrix with the same storage type
+	// as view1
+	template <typename DataType1, typename DataType2>
+	inline MatrixProduct<typename MatrixView<DataType1>::ValueType> operator*(
+		const MatrixView<DataType1>& view1,
+		const MatrixView<DataType2>& view2)
+	{
+		using DataType = typename MatrixView<DataType1>::ValueType;
+
+		return MatrixProduct<DataType>(view1, view2, view1.getStorageType());
+	}
+
+	// Matrix-vector multiplication overload; streams the matrix once in
+	// its own storage order, see gemv()
+	template <typename DataType>
+	inline MathVector<DataType> operator*(const DenseMatrix<DataType>& mat,
+		const MathVector<DataType>& vec)
+	{
+		return mat.view() * vec.view();
+	}
+
+	// Matrix-vector multiplication overload for views; a transposed view
+	// gives A^T * x without copying A
+	template <typename DataType1, typename DataType2>
+	inline MathVector<typename MatrixView<DataType1>::ValueType> operator*(
+		const MatrixView<DataType1>& mat_view,
+		const VectorView<DataType2>& vec_view)
+	{
+		using DataType = typename MatrixView<DataType1>::ValueType;
+
+		MathVector<DataType> result(std::vector<DataType>(mat_view.rows()));
+		gemv<DataType>(TransposeOp::NoTranspose, 1, mat_view, vec_view, 0,
+			result.view());
+		return result;
+	}
+
+	// Returns op(A) * x for a CSR or CSC matrix A, where op(A) is A or its
+	// transpose; see spmvParallel()
+	template <typename DataType, StorageType Storage>
+	inline MathVector<DataType> product(const CompressedSparseMatrix<DataType, Storage>& A,
+		const TransposeOp trans,
+		const MathVector<DataType>& x)
+	{
+		const size_t size = (trans == TransposeOp::NoTranspose) ? A.rows() : A.cols();
+		MathVector<DataType> result(std::vector<DataType>(size, 0));
+		spmvParallel(A, trans, x.view(), result.view(), defaultThreadPool(), 1, 0);
 		return result;
 	}
 
-	// Matrix multiplication overload for DenseMatrix; returns a DenseMatrix with the 
-	// the same storage type as mat1
+	// COO version of product()
 	template <typename DataType>
-	inline DenseMatrix<DataType> operator*(const DenseMatrix<DataType>& mat1,
-		const DenseMatrix<DataType>& mat2)
+	inline MathVector<DataType> product(const SparseMatrix<DataType>& A,
+		const TransposeOp trans,
+		const MathVector<DataType>& x)
+	{
+		const size_t size = (trans == TransposeOp::NoTranspose) ? A.rows() : A.cols();
+		MathVector<DataType> result(std::vector<DataType>(size, 0));
+		spmvParallel(A, trans, x.view(), result.view(), defaultThreadPool(), 1, 0);
+		return result;
+	}
+
+	// Sparse matrix-vector multiplication overloads
+	template <typename DataType, StorageType Storage>
+	inline MathVector<DataType> operator*(const CompressedSparseMatrix<DataType, Storage>& A,
+		const MathVector<DataType>& x)
+	{
+		return product(A, TransposeOp::NoTranspose, x);
+	}
+
+	template <typename DataType>
+	inline MathVector<DataType> operator*(const SparseMatrix<DataType>& A,
+		const MathVector<DataType>& x)
+	{
+		return product(A, TransposeOp::NoTranspose, x);
+	}
+
+	// Returns the product op(A) * op(B), where op transposes its operand
+	// if the matching flag is Transpose; transposed operands are read in
+	// place, so the Gram matrix A^T * A costs no copy of A
+	// Evaluates to a DenseMatrix with the same storage type as A
+	template <typename DataType>
+	inline MatrixProduct<DataType> product(const DenseMatrix<DataType>& A,
+		const TransposeOp trans_A,
+		const DenseMatrix<DataType>& B,
+		const TransposeOp trans_B)
+	{
+		return product(A.view(), trans_A, B.view(), trans_B);
+	}
+
+	// View version of product
+	template <typename DataType1, typename DataType2>
+	inline MatrixProduct<typename MatrixView<DataType1>::ValueType> product(
+		const MatrixView<DataType1>& A,
+		const TransposeOp trans_A,
+		const MatrixView<DataType2>& B,
+		const TransposeOp trans_B)
+	{
+		using DataType = typename MatrixView<DataType1>::ValueType;
+
+		return MatrixProduct<DataType>(applyTranspose(A, trans_A),
+			applyTranspose(B, trans_B), A.getStorageType());
+	}
+
+	// Products combined with other operands are evaluated first, then 
+	// the rest is applied in place; a product on the right of + or - is
+	// accumulated straight into the result, so C + A * B costs one
+	// allocation
+
+	template <typename DataType, typename Operand>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value,
+		DenseMatrix<DataType> >::type operator+(
+		const MatrixProduct<DataType>& product, const Operand& operand)
+	{
+		DenseMatrix<DataType> result = product.evaluate();
+		result += operand;
+		return result;
+	}
+
+	template <typename Operand, typename DataType>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value,
+		DenseMatrix<DataType> >::type 
+		operator+(const Operand& operand, const MatrixProduct<DataType>& product)
 	{
-		if (mat1.cols() != mat2.rows())
-			throw InvalidDimensions();
+		DenseMatrix<DataType> result = MatrixExpressionOf<Operand>::make(operand);
+		result += product;
+		return result;
+	}
+
+	template <typename DataType, typename Operand>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value,
+		DenseMatrix<DataType> >::type operator-(
+		const MatrixProduct<DataType>& product, const Operand& operand)
+	{
+		DenseMatrix<DataType> result = product.evaluate();
+		result -= operand;
+		return result;
+	}
+
+	template <typename Operand, typename DataType>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value,
+		DenseMatrix<DataType> >::type
+		operator-(const Operand& operand, const MatrixProduct<DataType>& product)
+	{
+		DenseMatrix<DataType> result = MatrixExpressionOf<Operand>::make(operand);
+		result -= product;
+		return result;
+	}
+
+	template <typename DataType>
+	inline DenseMatrix<DataType> operator+(const MatrixProduct<DataType>& product1,
+		const MatrixProduct<DataType>& product2)
+	{
+		DenseMatrix<DataType> result = product1.evaluate();
+		result += product2;
+		return result;
+	}
+
+	template <typename DataType>
+	inline DenseMatrix<DataType> operator-(const MatrixProduct<DataType>& product1,
+		const MatrixProduct<DataType>& product2)
+	{
+		DenseMatrix<DataType> result = product1.evaluate();
+		result -= product2;
+		return result;
+	}
+
+	// Scalar multiplication overloads for products
+	template <typename Scalar, typename DataType>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		DenseMatrix<DataType> >::type operator*(const Scalar factor,
+		const MatrixProduct<DataType>& product)
+	{
+		DenseMatrix<DataType> result = product.evaluate();
+		result *= static_cast<DataType>(factor);
+		return result;
+	}
+
+	template <typename DataType, typename Scalar>
+	inline typename std::enable_if<std::is_arithmetic<Scalar>::value,
+		DenseMatrix<DataType> >::type operator*(
+		const MatrixProduct<DataType>& product, const Scalar factor)
+	{
+		return factor * product;
+	}
+
+	// Chained products, such as A * B * C, evaluate the inner product
+	template <typename DataType>
+	inline DenseMatrix<DataType> operator*(const MatrixProduct<DataType>& product,
+		const DenseMatrix<DataType>& mat)
+	{
+		DenseMatrix<DataType> lhs = product.evaluate();
+		return adaptiveMult<DataType>(lhs.view(), mat.view(), lhs.getStorageType());
+	}
+
+	template <typename DataType>
+	inline DenseMatrix<DataType> operator*(const DenseMatrix<DataType>& mat,
+		const MatrixProduct<DataType>& product)
+	{
+		DenseMatrix<DataType> rhs = product.evaluate();
+		return adaptiveMult<DataType>(mat.view(), rhs.view(), mat.getStorageType());
+	}
+
+	template <typename DataType>
+	inline DenseMatrix<DataType> operator*(const MatrixProduct<DataType>& product1,
+		const MatrixProduct<DataType>& product2)
+	{
+		DenseMatrix<DataType> lhs = product1.evaluate();
+		DenseMatrix<DataType> rhs = product2.evaluate();
+		return adaptiveMult<DataType>(lhs.view(), rhs.view(), lhs.getStorageType());
+	}
+
+	// == and != overloads comparing a DenseMatrix with a product
+	template <typename DataType>
+	inline bool operator==(const DenseMatrix<DataType>& lhs,
+		const MatrixProduct<DataType>& rhs)
+	{
+		return lhs == rhs.evaluate();
+	}
+
+	template <typename DataType>
+	inline bool operator==(const MatrixProduct<DataType>& lhs,
+		const DenseMatrix<DataType>& rhs)
+	{
+		return lhs.evaluate() == rhs;
+	}
+
+	template <typename DataType>
+	inline bool operator!=(const DenseMatrix<DataType>& lhs,
+		const MatrixProduct<DataType>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	template <typename DataType>
+	inline bool operator!=(const MatrixProduct<DataType>& lhs,
+		const DenseMatrix<DataType>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	// In-place and destination-passing operations; these write into
+	// storage the caller already owns and never allocate, so they can run
+	// in inner loops; the destination must have the right dimensions, or
+	// InvalidDimensions is thrown, and keeps its storage type
+
+	// Adds operand, which may be a DenseMatrix, MatrixView, or matrix 
+	// expression, to out in place; out may appear in operand, but must
+	// not partially overlap any of its operands
+	template <typename DataType, typename Operand>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value>::type addTo(
+		const MatrixView<DataType>& out, const Operand& operand)
+	{
+		evaluateInto(out, out + operand);
+	}
+
+	// Adds product to out in place with the blocked GEMM engine; if out
+	// overlaps an operand of the product, as in C += C * B, the product is
+	// evaluated into a temporary first
+	template <typename DataType>
+	inline void addTo(const MatrixView<DataType>& out,
+		const MatrixProduct<DataType>& product)
+	{
+		if (viewsOverlap(out, product.lhs()) || viewsOverlap(out, product.rhs()))
+		{
+			DenseMatrix<DataType> temp = product.evaluate();
+			addTo(out, temp);
+			return;
+		}
+
+		multiplyAdd(product.lhs(), product.rhs(), out);
+	}
+
+	// Subtracts operand from out in place; see addTo()
+	template <typename DataType, typename Operand>
+	inline typename std::enable_if<std::is_class<
+		typename MatrixExpressionOf<Operand>::type>::value>::type subtractFrom(
+		const MatrixView<DataType>& out, const Operand& operand)
+	{
+		evaluateInto(out, out - operand);
+	}
+
+	// Subtracts product from out in place; see addTo()
+	template <typename DataType>
+	inline void subtractFrom(const MatrixView<DataType>& out,
+		const MatrixProduct<DataType>& product)
+	{
+		if (viewsOverlap(out, product.lhs()) || viewsOverlap(out, product.rhs()))
+		{
+			DenseMatrix<DataType> temp = product.evaluate();
+			subtractFrom(out, temp);
+			return;
+		}
 
-		return basicMultWithConversion(mat1, mat2);
+		multiplyAdd(product.lhs(), product.rhs(), out, -1);
 	}
 
-	
+	// Sets out = a + b, where a and b may be DenseMatrix, MatrixView, or
+	// matrix expressions; out may also be one of them
+	template <typename Left, typename Right, typename DataType>
+	inline void add(const Left& a, const Right& b, const MatrixView<DataType>& out)
+	{
+		evaluateInto(out, a + b);
+	}
+
+	template <typename Left, typename Right, typename DataType>
+	inline void add(const Left& a, const Right& b, DenseMatrix<DataType>& out)
+	{
+		add(a, b, out.view());
+	}
+
+	// Sets out = a - b; see add()
+	template <typename Left, typename Right, typename DataType>
+	inline void subtract(const Left& a, const Right& b, const MatrixView<DataType>& out)
+	{
+		evaluateInto(out, a - b);
+	}
+
+	template <typename Left, typename Right, typename DataType>
+	inline void subtract(const Left& a, const Right& b, DenseMatrix<DataType>& out)
+	{
+		subtract(a, b, out.view());
+	}
+
+	// Sets C += alpha * A * B with the blocked GEMM engine, split across
+	// defaultThreadPool() for large products; C must not overlap A or B
+	template <typename DataType>
+	inline void multiplyAdd(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C,
+		const typename NonDeduced<DataType>::type alpha = 1)
+	{
+		gemm<DataType>(TransposeOp::NoTranspose, TransposeOp::NoTranspose,
+			alpha, A, B, 1, C);
+	}
+
+	template <typename DataType>
+	inline void multiplyAdd(const DenseMatrix<DataType>& A,
+		const DenseMatrix<DataType>& B,
+		DenseMatrix<DataType>& C,
+		const typename NonDeduced<DataType>::type alpha = 1)
+	{
+		multiplyAdd(A.view(), B.view(), C.view(), alpha);
+	}
+
+	// Sets C = A * B with the blocked GEMM engine; unlike operator*, never
+	// switches to Strassen-Winograd, which needs a workspace; C must not
+	// overlap A or B
+	template <typename DataType>
+	inline void multiply(const ConstMatrixView<DataType>& A,
+		const ConstMatrixView<DataType>& B,
+		const MatrixView<DataType>& C)
+	{
+		gemm<DataType>(TransposeOp::NoTranspose, TransposeOp::NoTranspose,
+			1, A, B, 0, C);
+	}
+
+	template <typename DataType>
+	inline void multiply(const DenseMatrix<DataType>& A,
+		const DenseMatrix<DataType>& B,
+		DenseMatrix<DataType>& C)
+	{
+		multiply(A.view(), B.view(), C.view());
+	}
 }
 
 #endif
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "transpose_kernel.h"
+
 // ------------------------------------------------------------------
 // Utility functions for matrix classes and operations
 // ------------------------------------------------------------------
@@ -16,6 +18,43 @@ namespace LinAlg
 		RowMajor
 	};
 
+	// Whether an operand of a product or solver is used as given or
+	// transposed; transposing never moves data, see MatrixView::transposed()
+	enum class TransposeOp {
+		NoTranspose,
+		Transpose
+	};
+
+	// Which triangle of a matrix a triangular solve reads; the other one
+	// is never accessed
+	enum class TriangleType {
+		Lower,
+		Upper
+	};
+
+	// Whether the diagonal of a triangular matrix is read, or taken to be
+	// all ones without being accessed
+	enum class DiagonalType {
+		NonUnit,
+		Unit
+	};
+
+	// Returns the other triangle; the lower triangle of a matrix is the
+	// upper triangle of its transpose
+	inline TriangleType flipTriangleType(const TriangleType triangle)
+	{
+		return (triangle == TriangleType::Lower) ?
+			TriangleType::Upper : TriangleType::Lower;
+	}
+
+	// Returns the other storage type; ColumnMajor data for an m x n 
+	// matrix is exactly the RowMajor data for its n x m transpose
+	constexpr StorageType flipStorageType(const StorageType storage_type)
+	{
+		return (storage_type == StorageType::RowMajor) ?
+			StorageType::ColumnMajor : StorageType::RowMajor;
+	}
+
 	// Returns number of digits in val
 	template <typename DataType>
 	inline size_t numDigits(DataType val)
@@ -55,17 +94,7 @@ namespace LinAlg
 	{
 		// Vector to hold rearranged data
 		std::vector<DataType> new_data(data.size());
-
-		int row = -1;
-		for (size_t i = 0; i < data.size(); ++i)
-		{
-			size_t col = i % cols;
-			// Increment row every m times, where m is the number of columns
-			row += (i % cols == 0);
-			size_t new_index = col * rows + row;
-			// Put element in new column major position
-			new_data[new_index] = data[i];
-		}
+		transposeInto(data.data(), cols, new_data.data(), rows, rows, cols);
 		return new_data;
 	}
 
@@ -76,19 +105,10 @@ namespace LinAlg
 		const size_t rows,
 		const size_t cols)
 	{
-		// Vector to hold rearranged data
+		// Vector to hold rearranged data; column major data is the row
+		// major data of the transpose
 		std::vector<DataType> new_data(data.size());
-
-		int col = -1;
-		for (size_t i = 0; i < data.size(); ++i)
-		{
-			size_t row = i % rows;
-			// Increment col every n times, where n is the number of rows
-			col += (i % rows == 0);
-			size_t new_index = row * cols + col;
-			// Put element in new row major position
-			new_data[new_index] = data[i];
-		}
+		transposeInto(data.data(), rows, new_data.data(), cols, cols, rows);
 		return new_data;
 	}
 
@@ -0,0 +1,486 @@
+#ifndef MATRIX_VIEW_H
+#define MATRIX_VIEW_H
+
+#include <vector>
+#include <functional>
+#include <type_traits>
+
+#include "matrix_utils.h"
+#include "exceptions.h"
+#include "simd_kernels.h"
+
+// ------------------------------------------------------------------
+// Lightweight non-owning views into the data of a DenseMatrix or
+// MathVector; reads and writes go straight to the underlying storage,
+// so views are invalidated by anything that reallocates that storage,
+// such as addRow(), addCol(), removeRow(), removeCol(), or setData()
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Strided view of a one-dimensional sequence of elements; element i
+	// lives at data[i * stride]
+	// DataType may be const qualified for read-only views
+	template <typename DataType>
+	class VectorView
+	{
+	public:
+
+		using ValueType = typename std::remove_const<DataType>::type;
+
+		// Constructor
+		VectorView(DataType* data_in,
+			const size_t size_in,
+			const size_t stride_in = 1) :
+			_data(data_in),
+			_size(size_in),
+			_stride(stride_in)
+		{ }
+
+		// Default constructor; creates an empty view
+		VectorView() :
+			_data(nullptr),
+			_size(0),
+			_stride(1)
+		{ }
+
+		// Implicit conversion from a writable view to a read-only view
+		operator VectorView<const ValueType>() const
+		{
+			return VectorView<const ValueType>(_data, _size, _stride);
+		}
+
+		DataType* data() const
+		{
+			return _data;
+		}
+
+		size_t size() const
+		{
+			return _size;
+		}
+
+		size_t stride() const
+		{
+			return _stride;
+		}
+
+		// Returns true if elements are adjacent in memory
+		bool isContiguous() const
+		{
+			return _stride == 1 || _size <= 1;
+		}
+
+		// Subscript operator overload; no bounds checking
+		DataType& operator[](const size_t index) const
+		{
+			return _data[index * _stride];
+		}
+
+		// Returns element at given index with bounds checking
+		DataType& at(const size_t index) const
+		{
+			if (index >= _size)
+				throw OutOfBounds();
+
+			return _data[index * _stride];
+		}
+
+		// Returns a view of elements [first, last)
+		VectorView<DataType> subView(const size_t first,
+			const size_t last) const
+		{
+			if (first > last || last > _size)
+				throw OutOfBounds();
+
+			return VectorView<DataType>(
+				_data + first * _stride, last - first, _stride);
+		}
+
+		// Copies the elements of given view into this view, converting
+		// them to this view's data type; both views must be the same size
+		template <typename OtherDataType>
+		void assign(const VectorView<OtherDataType>& other) const
+		{
+			if (other.size() != _size)
+				throw InvalidDimensions();
+
+			for (size_t i = 0; i < _size; ++i)
+			{
+				_data[i * _stride] = static_cast<ValueType>(other[i]);
+			}
+		}
+
+		// Sets every element of the view to given value
+		void fill(const ValueType val) const
+		{
+			for (size_t i = 0; i < _size; ++i)
+			{
+				_data[i * _stride] = val;
+			}
+		}
+
+		// Scales every element of the view by the given value
+		void scale(const ValueType factor) const
+		{
+			for (size_t i = 0; i < _size; ++i)
+			{
+				_data[i * _stride] *= factor;
+			}
+		}
+
+		// Adds factor * other to this view element-wise; both views
+		// must be the same size
+		void addScaled(const VectorView<const ValueType>& other,
+			const ValueType factor) const
+		{
+			if (other.size() != _size)
+				throw InvalidDimensions();
+
+			if (isContiguous() && other.isContiguous())
+			{
+				axpyKernel(factor, other.data(), _data, _size);
+				return;
+			}
+
+			for (size_t i = 0; i < _size; ++i)
+			{
+				_data[i * _stride] += factor * other[i];
+			}
+		}
+
+		// Swaps the contents of this view with given view; both views
+		// must be the same size
+		void swapWith(const VectorView<DataType>& other) const
+		{
+			if (other.size() != _size)
+				throw InvalidDimensions();
+
+			for (size_t i = 0; i < _size; ++i)
+			{
+				std::swap(_data[i * _stride], other[i]);
+			}
+		}
+
+		// Returns copy of the viewed elements as a std::vector
+		std::vector<ValueType> toStdVector() const
+		{
+			std::vector<ValueType> result(_size);
+			for (size_t i = 0; i < _size; ++i)
+			{
+				result[i] = _data[i * _stride];
+			}
+			return result;
+		}
+
+	private:
+
+		// Pointer to first element, number of elements, and distance
+		// between consecutive elements
+		DataType* _data;
+		size_t _size;
+		size_t _stride;
+	};
+
+	// Two-dimensional view of a matrix stored in RowMajor or ColumnMajor
+	// order with a leading dimension; for RowMajor, element (i, j) lives
+	// at data[i * leading_dim + j], and for ColumnMajor at
+	// data[j * leading_dim + i]
+	// DataType may be const qualified for read-only views
+	template <typename DataType>
+	class MatrixView
+	{
+	public:
+
+		using ValueType = typename std::remove_const<DataType>::type;
+
+		// Constructor
+		MatrixView(DataType* data_in,
+			const size_t rows_in,
+			const size_t cols_in,
+			const size_t leading_dim_in,
+			const StorageType storage_type_in) :
+			_data(data_in),
+			_rows(rows_in),
+			_cols(cols_in),
+			_leading_dim(leading_dim_in),
+			_storage_type(storage_type_in)
+		{ }
+
+		// Constructor for a view of a contiguous, densely packed matrix
+		MatrixView(DataType* data_in,
+			const size_t rows_in,
+			const size_t cols_in,
+			const StorageType storage_type_in) :
+			MatrixView(data_in, rows_in, cols_in,
+				storage_type_in == StorageType::RowMajor ? cols_in : rows_in,
+				storage_type_in)
+		{ }
+
+		// Default constructor; creates an empty view
+		MatrixView() :
+			_data(nullptr),
+			_rows(0),
+			_cols(0),
+			_leading_dim(0),
+			_storage_type(StorageType::ColumnMajor)
+		{ }
+
+		// Implicit conversion from a writable view to a read-only view
+		operator MatrixView<const ValueType>() const
+		{
+			return MatrixView<const ValueType>(
+				_data, _rows, _cols, _leading_dim, _storage_type);
+		}
+
+		DataType* data() const
+		{
+			return _data;
+		}
+
+		size_t rows() const
+		{
+			return _rows;
+		}
+
+		size_t cols() const
+		{
+			return _cols;
+		}
+
+		size_t size() const
+		{
+			return _rows * _cols;
+		}
+
+		size_t leadingDim() const
+		{
+			return _leading_dim;
+		}
+
+		StorageType getStorageType() const
+		{
+			return _storage_type;
+		}
+
+		// Returns distance in memory between elements (i, j) and (i + 1, j)
+		size_t rowStride() const
+		{
+			return (_storage_type == StorageType::RowMajor) ? _leading_dim : 1;
+		}
+
+		// Returns distance in memory between elements (i, j) and (i, j + 1)
+		size_t colStride() const
+		{
+			return (_storage_type == StorageType::RowMajor) ? 1 : _leading_dim;
+		}
+
+		bool isEmpty() const
+		{
+			return _rows == 0 || _cols == 0;
+		}
+
+		bool isSquare() const
+		{
+			return _rows == _cols;
+		}
+
+		// Returns true if the viewed elements form one unbroken block
+		// of memory
+		bool isContiguous() const
+		{
+			if (_storage_type == StorageType::RowMajor)
+				return _leading_dim == _cols || _rows <= 1;
+			else
+				return _leading_dim == _rows || _cols <= 1;
+		}
+
+		// Returns element at location (row, col); no bounds checking
+		DataType& operator()(const size_t row, const size_t col) const
+		{
+			if (_storage_type == StorageType::RowMajor)
+				return _data[row * _leading_dim + col];
+			else
+				return _data[col * _leading_dim + row];
+		}
+
+		// Returns element at location (row, col) with bounds checking
+		DataType& at(const size_t row, const size_t col) const
+		{
+			if (row >= _rows || col >= _cols)
+				throw OutOfBounds();
+
+			return (*this)(row, col);
+		}
+
+		// Returns view of row pos
+		VectorView<DataType> row(const size_t pos) const
+		{
+			if (pos >= _rows)
+				throw OutOfBounds();
+
+			if (_storage_type == StorageType::RowMajor)
+				return VectorView<DataType>(
+					_data + pos * _leading_dim, _cols, 1);
+			else
+				return VectorView<DataType>(
+					_data + pos, _cols, _leading_dim);
+		}
+
+		// Returns view of col pos
+		VectorView<DataType> col(const size_t pos) const
+		{
+			if (pos >= _cols)
+				throw OutOfBounds();
+
+			if (_storage_type == StorageType::RowMajor)
+				return VectorView<DataType>(
+					_data + pos, _rows, _leading_dim);
+			else
+				return VectorView<DataType>(
+					_data + pos * _leading_dim, _rows, 1);
+		}
+
+		// Returns view of rows [first_row, last_row) and columns
+		// [first_col, last_col)
+		MatrixView<DataType> subView(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col) const
+		{
+			if (first_row > last_row || last_row > _rows ||
+				first_col > last_col || last_col > _cols)
+			{
+				throw OutOfBounds();
+			}
+
+			size_t offset = (_storage_type == StorageType::RowMajor) ?
+				first_row * _leading_dim + first_col :
+				first_col * _leading_dim + first_row;
+
+			return MatrixView<DataType>(_data + offset,
+				last_row - first_row,
+				last_col - first_col,
+				_leading_dim,
+				_storage_type);
+		}
+
+		// Returns view of the transpose; the same elements are read with
+		// the dimensions swapped and the storage type flipped, so no data
+		// is moved
+		MatrixView<DataType> transposed() const
+		{
+			return MatrixView<DataType>(_data, _cols, _rows, _leading_dim,
+				flipStorageType(_storage_type));
+		}
+
+		// Copies the elements of given view into this view, converting
+		// them to this view's data type; both views must have the same
+		// dimensions but may differ in storage type
+		template <typename OtherDataType>
+		void assign(const MatrixView<OtherDataType>& other) const
+		{
+			if (other.rows() != _rows || other.cols() != _cols)
+				throw InvalidDimensions();
+
+			if (_storage_type == StorageType::RowMajor)
+			{
+				for (size_t i = 0; i < _rows; ++i)
+				{
+					row(i).assign(other.row(i));
+				}
+			}
+			else
+			{
+				for (size_t j = 0; j < _cols; ++j)
+				{
+					col(j).assign(other.col(j));
+				}
+			}
+		}
+
+		// Sets every element of the view to given value
+		void fill(const ValueType val) const
+		{
+			for (size_t i = 0; i < numLines(); ++i)
+			{
+				line(i).fill(val);
+			}
+		}
+
+		// Returns number of rows if RowMajor, or columns if ColumnMajor
+		size_t numLines() const
+		{
+			return (_storage_type == StorageType::RowMajor) ? _rows : _cols;
+		}
+
+		// Returns view of row pos if RowMajor, or col pos if ColumnMajor;
+		// these are always contiguous in memory
+		VectorView<DataType> line(const size_t pos) const
+		{
+			return (_storage_type == StorageType::RowMajor) ?
+				row(pos) : col(pos);
+		}
+
+	private:
+
+		// Pointer to element (0, 0)
+		DataType* _data;
+
+		// Dimensions of the view
+		size_t _rows;
+		size_t _cols;
+
+		// Distance in memory between the starts of consecutive rows if
+		// RowMajor, or consecutive columns if ColumnMajor
+		size_t _leading_dim;
+
+		StorageType _storage_type;
+	};
+
+	// Returns true if the memory spanned by views a and b overlaps; the
+	// check is conservative, so two views that interleave without sharing
+	// elements, such as alternate columns, still count as overlapping
+	template <typename DataType1, typename DataType2>
+	inline bool viewsOverlap(const MatrixView<DataType1>& a,
+		const MatrixView<DataType2>& b)
+	{
+		if (a.isEmpty() || b.isEmpty())
+			return false;
+
+		const void* a_first = a.data();
+		const void* a_last = &a(a.rows() - 1, a.cols() - 1) + 1;
+		const void* b_first = b.data();
+		const void* b_last = &b(b.rows() - 1, b.cols() - 1) + 1;
+
+		std::less<const void*> less;
+		return less(a_first, b_last) && less(b_first, a_last);
+	}
+
+	// Returns given view, or a view of its transpose if op is Transpose
+	template <typename DataType>
+	inline MatrixView<DataType> applyTranspose(const MatrixView<DataType>& view,
+		const TransposeOp op)
+	{
+		return (op == TransposeOp::Transpose) ? view.transposed() : view;
+	}
+
+	// Helper that blocks template argument deduction for a parameter
+	template <typename Type>
+	struct NonDeduced
+	{
+		using type = Type;
+	};
+
+	// Read-only view parameter type for functions whose DataType is 
+	// deduced from another argument; lets writable views be passed where
+	// a read-only view is expected
+	template <typename DataType>
+	using ConstMatrixView = typename NonDeduced<MatrixView<const DataType> >::type;
+
+	// Vector version of ConstMatrixView
+	template <typename DataType>
+	using ConstVectorView = typename NonDeduced<VectorView<const DataType> >::type;
+}
+
+#endif
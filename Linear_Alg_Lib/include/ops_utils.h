@@ -3,6 +3,7 @@
 
 #include "math_vector.h"
 #include "dense_matrix.h"
+#include "simd_kernels.h"
 
 // ------------------------------------------------------------------
 // Helpers for matrix_ops.h and vector_ops.h
@@ -22,10 +23,7 @@ namespace LinAlg
 				"Can't add std::vectors, invalid dimensions");
 
 		std::vector<DataType> result(vec1.size());
-		for (size_t i = 0; i < vec1.size(); ++i)
-		{
-			result[i] = vec1[i] + vec2[i];
-		}
+		addKernel(vec1.data(), vec2.data(), result.data(), vec1.size());
 		return result;
 	}
 
@@ -41,11 +39,120 @@ namespace LinAlg
 				"Can't subtract std::vectors, invalid dimensions");
 
 		std::vector<DataType> result(vec1.size());
-		for (size_t i = 0; i < vec1.size(); ++i)
+		subtractKernel(vec1.data(), vec2.data(), result.data(), vec1.size());
+		return result;
+	}
+
+	// Element-wise addition for elementwiseViews; contiguous lines of 
+	// matching data types go through the SIMD kernels
+	struct AddOp
+	{
+		template <typename DataType1, typename DataType2>
+		auto operator()(const DataType1& a, const DataType2& b) const
+			-> decltype(a + b)
 		{
-			result[i] = vec1[i] - vec2[i];
+			return a + b;
+		}
+
+		template <typename OutDataType, typename DataType1, typename DataType2>
+		void applyContiguous(OutDataType* out,
+			const DataType1* a,
+			const DataType2* b,
+			const size_t n) const
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = static_cast<OutDataType>(a[i] + b[i]);
+			}
+		}
+
+		template <typename DataType>
+		void applyContiguous(DataType* out,
+			const DataType* a,
+			const DataType* b,
+			const size_t n) const
+		{
+			addKernel(a, b, out, n);
+		}
+	};
+
+	// Element-wise subtraction for elementwiseViews; see AddOp
+	struct SubtractOp
+	{
+		template <typename DataType1, typename DataType2>
+		auto operator()(const DataType1& a, const DataType2& b) const
+			-> decltype(a - b)
+		{
+			return a - b;
+		}
+
+		template <typename OutDataType, typename DataType1, typename DataType2>
+		void applyContiguous(OutDataType* out,
+			const DataType1* a,
+			const DataType2* b,
+			const size_t n) const
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = static_cast<OutDataType>(a[i] - b[i]);
+			}
+		}
+
+		template <typename DataType>
+		void applyContiguous(DataType* out,
+			const DataType* a,
+			const DataType* b,
+			const size_t n) const
+		{
+			subtractKernel(a, b, out, n);
+		}
+	};
+
+	// Applies op element-wise to views a and b and writes the results 
+	// into out; all three views must have the same dimensions, but may
+	// have any combination of storage types; traverses in the storage 
+	// order of out
+	// op must provide operator()(a, b) for single elements and 
+	// applyContiguous(out, a, b, n) for contiguous lines, as AddOp does
+	template <typename OutDataType, typename DataType1, typename DataType2,
+		typename Op>
+	inline void elementwiseViews(const MatrixView<OutDataType>& out,
+		const MatrixView<DataType1>& a,
+		const MatrixView<DataType2>& b,
+		const Op& op)
+	{
+		if (a.rows() != out.rows() || a.cols() != out.cols() ||
+			b.rows() != out.rows() || b.cols() != out.cols())
+		{
+			throw InvalidDimensions();
+		}
+
+		if (out.isEmpty())
+			return;
+
+		bool out_row_major = out.getStorageType() == StorageType::RowMajor;
+
+		for (size_t i = 0; i < out.numLines(); ++i)
+		{
+			VectorView<OutDataType> out_line = out.line(i);
+			VectorView<DataType1> a_line = out_row_major ? a.row(i) : a.col(i);
+			VectorView<DataType2> b_line = out_row_major ? b.row(i) : b.col(i);
+
+			// Contiguous fast path; runs the SIMD kernels when the data
+			// types match
+			if (a_line.isContiguous() && b_line.isContiguous())
+			{
+				op.applyContiguous(out_line.data(), a_line.data(),
+					b_line.data(), out_line.size());
+			}
+			else
+			{
+				for (size_t j = 0; j < out_line.size(); ++j)
+				{
+					out_line[j] = op(a_line[j], b_line[j]);
+				}
+			}
 		}
-		return result;
 	}
 
 	// Returns true if matrix dimensions match; false otherwise                 
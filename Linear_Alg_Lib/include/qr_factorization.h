@@ -0,0 +1,346 @@
+#ifndef QR_FACTORIZATION_H
+#define QR_FACTORIZATION_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <limits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemm_kernel.h"
+#include "trsm_kernel.h"
+#include "householder_kernel.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Householder QR factorization A = QR of an m x n matrix, where Q is
+// orthogonal and R upper triangular; works for any shape, and for
+// m >= n gives the least squares solution of an overdetermined system
+// Columns are factored in panels whose reflectors are combined into the
+// compact WY form I - V T V^T, so applying them to the rest of the
+// matrix, which is nearly all the work, runs as GEMMs
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Number of columns factored together as one panel
+	const size_t QR_BLOCK_SIZE = 32;
+
+	template <typename DataType>
+	class QRFactorization
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"QRFactorization requires a floating point data type");
+
+	public:
+
+		// Constructor; factors given matrix, converting its elements to
+		// DataType
+		template <typename MatrixDataType>
+		explicit QRFactorization(const DenseMatrix<MatrixDataType>& A) :
+			QRFactorization(A.view())
+		{ }
+
+		// View version of constructor
+		template <typename ViewDataType>
+		explicit QRFactorization(const MatrixView<ViewDataType>& A) :
+			_factors(A, StorageType::ColumnMajor),
+			_tau(std::min(A.rows(), A.cols())),
+			_block_factors(QR_BLOCK_SIZE, std::min(A.rows(), A.cols()))
+		{
+			factor();
+		}
+
+		// Constructor that factors given matrix in place of its own
+		// storage, without copying it if it is already ColumnMajor
+		explicit QRFactorization(DenseMatrix<DataType>&& A) :
+			_factors(std::move(A)),
+			_tau(std::min(_factors.rows(), _factors.cols())),
+			_block_factors(QR_BLOCK_SIZE, _tau.size())
+		{
+			_factors.convertToColMajor();
+			factor();
+		}
+
+		size_t rows() const
+		{
+			return _factors.rows();
+		}
+
+		size_t cols() const
+		{
+			return _factors.cols();
+		}
+
+		// Returns R and the Householder vectors packed into one ColumnMajor
+		// m x n matrix; R is the upper triangle, and below the diagonal,
+		// column k holds reflector k, whose leading 1 is implied
+		const DenseMatrix<DataType>& getFactors() const
+		{
+			return _factors;
+		}
+
+		// Returns the scaling factors of the reflectors; reflector k is
+		// H_k = I - tau_k v_k v_k^T, and Q = H_0 H_1 ... H_{k-1}
+		const std::vector<DataType>& getTau() const
+		{
+			return _tau;
+		}
+
+		// Returns true if the columns of A are linearly independent; a
+		// diagonal element of R counts as zero when it is below
+		// m * epsilon times the largest one, since rounding leaves
+		// dependent columns with tiny nonzero pivots instead of exact zeros
+		bool isFullRank() const
+		{
+			if (_tau.size() < cols())
+				return false;
+
+			DataType max_diag = 0;
+			for (size_t k = 0; k < _tau.size(); ++k)
+			{
+				max_diag = std::max(max_diag, std::abs(_factors.at(k, k)));
+			}
+
+			const DataType tolerance = max_diag * static_cast<DataType>(rows()) *
+				std::numeric_limits<DataType>::epsilon();
+			for (size_t k = 0; k < _tau.size(); ++k)
+			{
+				if (!(std::abs(_factors.at(k, k)) > tolerance))
+					return false;
+			}
+			return true;
+		}
+
+		// Returns the min(m, n) x n upper triangular factor R
+		DenseMatrix<DataType> upper() const
+		{
+			const size_t k = _tau.size();
+			DenseMatrix<DataType> R(k, cols());
+			for (size_t j = 0; j < cols(); ++j)
+			{
+				size_t last = std::min(j + 1, k);
+				R.colView(j).subView(0, last).assign(
+					_factors.colView(j).subView(0, last));
+			}
+			return R;
+		}
+
+		// Returns the m x min(m, n) factor Q with orthonormal columns,
+		// so that A = QR
+		DenseMatrix<DataType> orthogonal() const
+		{
+			const size_t k = _tau.size();
+			DenseMatrix<DataType> Q(rows(), k);
+			for (size_t i = 0; i < k; ++i)
+			{
+				Q.at(i, i) = 1;
+			}
+			applyQ(Q.view());
+			return Q;
+		}
+
+		// Overwrites B, which has m rows, with Q^T B
+		void applyQTranspose(const MatrixView<DataType>& B) const
+		{
+			if (B.rows() != rows())
+				throw InvalidDimensions();
+
+			for (size_t first = 0; first < _tau.size(); first += QR_BLOCK_SIZE)
+			{
+				applyBlockReflector(first, B, TransposeOp::Transpose);
+			}
+		}
+
+		// Overwrites B, which has m rows, with Q B
+		void applyQ(const MatrixView<DataType>& B) const
+		{
+			if (B.rows() != rows())
+				throw InvalidDimensions();
+
+			const size_t num_blocks = (_tau.size() + QR_BLOCK_SIZE - 1) / QR_BLOCK_SIZE;
+			for (size_t block = num_blocks; block-- > 0; )
+			{
+				applyBlockReflector(block * QR_BLOCK_SIZE, B, TransposeOp::NoTranspose);
+			}
+		}
+
+		// Overwrites b, which has m elements, with Q^T b; one reflector at
+		// a time, each a dot product and an axpy on contiguous memory
+		void applyQTranspose(const VectorView<DataType>& b) const
+		{
+			if (b.size() != rows())
+				throw InvalidDimensions();
+
+			std::vector<DataType> copy;
+			DataType* data = b.data();
+			if (!b.isContiguous())
+			{
+				copy = b.toStdVector();
+				data = copy.data();
+			}
+
+			for (size_t k = 0; k < _tau.size(); ++k)
+			{
+				applyReflector(k, data);
+			}
+
+			if (!b.isContiguous())
+				b.assign(VectorView<const DataType>(copy.data(), copy.size()));
+		}
+
+		// Returns the x that minimizes ||Ax - b||, which is the exact
+		// solution when one exists; needs m >= n, and throws
+		// InvalidDimensions otherwise, or SingularMatrix if A doesn't have
+		// full column rank
+		template <typename VectorDataType>
+		MathVector<DataType> solve(const MathVector<VectorDataType>& b) const
+		{
+			checkSolvable(b.size());
+
+			std::vector<DataType> y(b.size());
+			VectorView<DataType> y_view(y.data(), y.size());
+			y_view.assign(b.view());
+			applyQTranspose(y_view);
+
+			// R x = (Q^T b)[0, n)
+			y.resize(cols());
+			trsvBlocked(_factors.subMatrixView(0, cols(), 0, cols()),
+				TriangleType::Upper, DiagonalType::NonUnit, y.data());
+			return MathVector<DataType>(std::move(y));
+		}
+
+		// Least squares solution for every column of B at once; result is
+		// a ColumnMajor n x p matrix
+		template <typename MatrixDataType>
+		DenseMatrix<DataType> solve(const DenseMatrix<MatrixDataType>& B) const
+		{
+			checkSolvable(B.rows());
+
+			DenseMatrix<DataType> Y(B.view(), StorageType::ColumnMajor);
+			applyQTranspose(Y.view());
+
+			DenseMatrix<DataType> X = Y.getSubMatrix(0, cols(), 0, B.cols());
+			trsmParallel(_factors.subMatrixView(0, cols(), 0, cols()),
+				TriangleType::Upper, DiagonalType::NonUnit, X.view());
+			return X;
+		}
+
+	private:
+
+		// Factors _factors in place one panel at a time; each panel is
+		// reduced column by column, its reflectors are combined into the
+		// triangular factor T, and the block reflector is then applied to
+		// the columns to the right of the panel
+		void factor()
+		{
+			const size_t k = _tau.size();
+			MatrixView<DataType> A = _factors.view();
+
+			for (size_t first = 0; first < k; first += QR_BLOCK_SIZE)
+			{
+				const size_t last = std::min(first + QR_BLOCK_SIZE, k);
+				factorPanel(A, first, last);
+				formBlockFactor(first, last);
+
+				if (last < cols())
+				{
+					applyBlockReflector(first,
+						A.subView(0, rows(), last, cols()), TransposeOp::Transpose);
+				}
+			}
+		}
+
+		// Reduces columns [first, last) of A to upper triangular form with
+		// one reflector per column, applying each reflector to the rest
+		// of the panel as soon as it is formed
+		void factorPanel(const MatrixView<DataType>& A,
+			const size_t first,
+			const size_t last)
+		{
+			const size_t m = rows();
+
+			for (size_t k = first; k < last; ++k)
+			{
+				// Reflector that maps A[k, m) of column k onto a multiple
+				// of the first unit vector
+				_tau[k] = householderReflector(&A(k, k), m - k);
+
+				for (size_t j = k + 1; j < last; ++j)
+				{
+					applyReflector(k, &A(0, j));
+				}
+			}
+		}
+
+		// Applies reflector k to the contiguous vector c of length m;
+		// c -= tau_k (v_k^T c) v_k, where v_k is 1 at row k and the factors
+		// below the diagonal of column k after it
+		void applyReflector(const size_t k, DataType* c) const
+		{
+			applyHouseholder(&_factors.view()(k, k) + 1, _tau[k], c + k, rows() - k);
+		}
+
+		// Forms the T factor of the block reflector of panel [first, last)
+		void formBlockFactor(const size_t first, const size_t last)
+		{
+			householderBlockFactor(_factors.subMatrixView(first, rows(), first, last),
+				&_tau[first], blockFactor(first));
+		}
+
+		// Returns view of the T factor of the panel starting at column
+		// first; every panel's T is stored in its own columns of
+		// _block_factors
+		MatrixView<DataType> blockFactor(const size_t first)
+		{
+			size_t width = std::min(QR_BLOCK_SIZE, _tau.size() - first);
+			return _block_factors.subMatrixView(0, width, first, first + width);
+		}
+
+		MatrixView<const DataType> blockFactor(const size_t first) const
+		{
+			size_t width = std::min(QR_BLOCK_SIZE, _tau.size() - first);
+			return _block_factors.subMatrixView(0, width, first, first + width);
+		}
+
+		// Applies the block reflector of the panel starting at column
+		// first, or its transpose, to the rows [first, m) of C
+		void applyBlockReflector(const size_t first,
+			const MatrixView<DataType>& C,
+			const TransposeOp trans_T) const
+		{
+			MatrixView<const DataType> T = blockFactor(first);
+			applyHouseholderBlock(_factors.subMatrixView(first, rows(), first, first + T.cols()),
+				T, C.subView(first, rows(), 0, C.cols()), trans_T);
+		}
+
+		// Throws unless a right hand side with given number of rows can be
+		// solved for in the least squares sense
+		void checkSolvable(const size_t rhs_rows) const
+		{
+			if (rhs_rows != rows() || rows() < cols())
+				throw InvalidDimensions();
+
+			if (!isFullRank())
+				throw SingularMatrix();
+		}
+
+		// R and the Householder vectors, ColumnMajor so that reflectors
+		// and the columns they act on are contiguous
+		DenseMatrix<DataType> _factors;
+
+		// Scaling factor of every reflector
+		std::vector<DataType> _tau;
+
+		// T factors of the compact WY form of every panel, side by side
+		DenseMatrix<DataType> _block_factors;
+	};
+}
+
+#endif
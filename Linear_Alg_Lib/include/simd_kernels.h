@@ -0,0 +1,239 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------------------
+// Vectorized kernels for the element-wise primitives the rest of the
+// library is built on; the instruction set is chosen at runtime from
+// the features of the CPU, which are detected once on first use
+// Overloads exist for float, double, int32_t, and int64_t; any other
+// data type falls back to the scalar templates below
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Dimensions of the register tile computed by gemmTileKernel();
+	// GEMM_MR rows of A times GEMM_NR columns of B
+	const size_t GEMM_MR = 4;
+	const size_t GEMM_NR = 8;
+
+	// Instruction sets the kernels can dispatch to, from slowest to
+	// fastest
+	enum class SimdLevel {
+		Scalar,
+		SSE2,
+		AVX2,
+		AVX512
+	};
+
+	// Returns the fastest instruction set supported by the CPU and OS
+	SimdLevel detectedSimdLevel();
+
+	// Returns the instruction set the kernels currently dispatch to
+	SimdLevel activeSimdLevel();
+
+	// Sets the instruction set the kernels dispatch to; levels above
+	// detectedSimdLevel() are clamped to it
+	// Mostly useful for testing and benchmarking individual code paths
+	void setSimdLevel(const SimdLevel level);
+
+	// Returns name of given level, such as "AVX2"
+	const char* simdLevelName(const SimdLevel level);
+
+	// Returns the sum of a[i] * b[i] for i in [0, n)
+	template <typename DataType>
+	inline DataType dotKernel(const DataType* a,
+		const DataType* b,
+		const size_t n)
+	{
+		DataType result = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			result += a[i] * b[i];
+		}
+		return result;
+	}
+
+	// Sets out[i] = a[i] + b[i] for i in [0, n); out may alias a or b
+	template <typename DataType>
+	inline void addKernel(const DataType* a,
+		const DataType* b,
+		DataType* out,
+		const size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = a[i] + b[i];
+		}
+	}
+
+	// Sets out[i] = a[i] - b[i] for i in [0, n); out may alias a or b
+	template <typename DataType>
+	inline void subtractKernel(const DataType* a,
+		const DataType* b,
+		DataType* out,
+		const size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = a[i] - b[i];
+		}
+	}
+
+	// Sets y[i] += alpha * x[i] for i in [0, n)
+	template <typename DataType>
+	inline void axpyKernel(const DataType alpha,
+		const DataType* x,
+		DataType* y,
+		const size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			y[i] += alpha * x[i];
+		}
+	}
+
+	// Returns the sum of values[i] * x[indices[i]] for i in [0, n); the
+	// dot product of one row of a compressed sparse matrix with x
+	template <typename DataType>
+	inline DataType sparseDotKernel(const DataType* values,
+		const size_t* indices,
+		const DataType* x,
+		const size_t n)
+	{
+		DataType result = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			result += values[i] * x[indices[i]];
+		}
+		return result;
+	}
+
+	// Sets y[indices[i]] += alpha * values[i] for i in [0, n); indices
+	// must be distinct, as they are within one line of a compressed
+	// sparse matrix
+	template <typename DataType>
+	inline void sparseAxpyKernel(const DataType alpha,
+		const DataType* values,
+		const size_t* indices,
+		DataType* y,
+		const size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			y[indices[i]] += alpha * values[i];
+		}
+	}
+
+	// Transposes the rows x cols matrix at src, whose rows start src_ld
+	// elements apart, into dst, whose rows start dst_ld elements apart,
+	// so dst[j * dst_ld + i] = src[i * src_ld + j]; the same call also
+	// converts between column major and row major; src and dst must not
+	// overlap
+	template <typename DataType>
+	inline void transposeKernel(const DataType* src,
+		const size_t src_ld,
+		DataType* dst,
+		const size_t dst_ld,
+		const size_t rows,
+		const size_t cols)
+	{
+		for (size_t i = 0; i < rows; ++i)
+		{
+			for (size_t j = 0; j < cols; ++j)
+			{
+				dst[j * dst_ld + i] = src[i * src_ld + j];
+			}
+		}
+	}
+
+	// Computes the GEMM_MR x GEMM_NR product of a packed sliver of A,
+	// whose step p holds GEMM_MR adjacent elements of column p, and a
+	// packed sliver of B, whose step p holds GEMM_NR adjacent elements of
+	// row p, over kc steps, and stores it to tile in row major order
+	template <typename DataType>
+	inline void gemmTileKernel(const size_t kc,
+		const DataType* A_sliver,
+		const DataType* B_sliver,
+		DataType* tile)
+	{
+		DataType acc[GEMM_MR][GEMM_NR] = {};
+		for (size_t p = 0; p < kc; ++p)
+		{
+			for (size_t i = 0; i < GEMM_MR; ++i)
+			{
+				const DataType a = A_sliver[i];
+				for (size_t j = 0; j < GEMM_NR; ++j)
+				{
+					acc[i][j] += a * B_sliver[j];
+				}
+			}
+			A_sliver += GEMM_MR;
+			B_sliver += GEMM_NR;
+		}
+
+		for (size_t i = 0; i < GEMM_MR; ++i)
+		{
+			for (size_t j = 0; j < GEMM_NR; ++j)
+			{
+				tile[i * GEMM_NR + j] = acc[i][j];
+			}
+		}
+	}
+
+	// Vectorized overloads; implemented in simd_kernels.cpp
+
+	float dotKernel(const float* a, const float* b, const size_t n);
+	double dotKernel(const double* a, const double* b, const size_t n);
+	int32_t dotKernel(const int32_t* a, const int32_t* b, const size_t n);
+	int64_t dotKernel(const int64_t* a, const int64_t* b, const size_t n);
+
+	void addKernel(const float* a, const float* b, float* out, const size_t n);
+	void addKernel(const double* a, const double* b, double* out, const size_t n);
+	void addKernel(const int32_t* a, const int32_t* b, int32_t* out, const size_t n);
+	void addKernel(const int64_t* a, const int64_t* b, int64_t* out, const size_t n);
+
+	void subtractKernel(const float* a, const float* b, float* out, const size_t n);
+	void subtractKernel(const double* a, const double* b, double* out, const size_t n);
+	void subtractKernel(const int32_t* a, const int32_t* b, int32_t* out, const size_t n);
+	void subtractKernel(const int64_t* a, const int64_t* b, int64_t* out, const size_t n);
+
+	void axpyKernel(const float alpha, const float* x, float* y, const size_t n);
+	void axpyKernel(const double alpha, const double* x, double* y, const size_t n);
+	void axpyKernel(const int32_t alpha, const int32_t* x, int32_t* y, const size_t n);
+	void axpyKernel(const int64_t alpha, const int64_t* x, int64_t* y, const size_t n);
+
+	float sparseDotKernel(const float* values, const size_t* indices, const float* x, const size_t n);
+	double sparseDotKernel(const double* values, const size_t* indices, const double* x, const size_t n);
+	int32_t sparseDotKernel(const int32_t* values, const size_t* indices, const int32_t* x, const size_t n);
+	int64_t sparseDotKernel(const int64_t* values, const size_t* indices, const int64_t* x, const size_t n);
+
+	void sparseAxpyKernel(const float alpha, const float* values, const size_t* indices,
+		float* y, const size_t n);
+	void sparseAxpyKernel(const double alpha, const double* values, const size_t* indices,
+		double* y, const size_t n);
+	void sparseAxpyKernel(const int32_t alpha, const int32_t* values, const size_t* indices,
+		int32_t* y, const size_t n);
+	void sparseAxpyKernel(const int64_t alpha, const int64_t* values, const size_t* indices,
+		int64_t* y, const size_t n);
+
+	void transposeKernel(const float* src, const size_t src_ld, float* dst,
+		const size_t dst_ld, const size_t rows, const size_t cols);
+	void transposeKernel(const double* src, const size_t src_ld, double* dst,
+		const size_t dst_ld, const size_t rows, const size_t cols);
+	void transposeKernel(const int32_t* src, const size_t src_ld, int32_t* dst,
+		const size_t dst_ld, const size_t rows, const size_t cols);
+	void transposeKernel(const int64_t* src, const size_t src_ld, int64_t* dst,
+		const size_t dst_ld, const size_t rows, const size_t cols);
+
+	// Only floating point types have GEMM tiles; integer products use
+	// the template above
+	void gemmTileKernel(const size_t kc, const float* A_sliver,
+		const float* B_sliver, float* tile);
+	void gemmTileKernel(const size_t kc, const double* A_sliver,
+		const double* B_sliver, double* tile);
+}
+
+#endif
@@ -0,0 +1,497 @@
+#ifndef SINGULAR_VALUE_DECOMPOSITION_H
+#define SINGULAR_VALUE_DECOMPOSITION_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <utility>
+#include <memory>
+#include <type_traits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemm_kernel.h"
+#include "qr_factorization.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Singular value decomposition A = U diag(s) V^T of an m x n matrix,
+// with s descending and the columns of U and V orthonormal; the thin
+// form is computed, with min(m, n) singular values and vectors
+// JacobiSVD finds even the tiny singular values of a well-conditioned
+// matrix with badly scaled columns to high relative accuracy, which
+// methods that bidiagonalize first can't, and RandomizedSVD
+// approximates just the largest few of a large matrix with a handful of
+// GEMMs
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Most sweeps over all column pairs before giving up; Jacobi
+	// converges quadratically, and rarely needs more than ten
+	const size_t JACOBI_MAX_SWEEPS = 60;
+
+	// Rounds of rotations on matrices with fewer elements than this run
+	// on one thread
+	const size_t JACOBI_PARALLEL_MIN_SIZE = 1 << 15;
+
+	// Columns sampled beyond the rank asked of RandomizedSVD
+	const size_t RANDOMIZED_SVD_OVERSAMPLING = 10;
+
+	// Passes of subspace iteration of RandomizedSVD, each of which
+	// sharpens the decay of the singular values it sees
+	const size_t RANDOMIZED_SVD_POWER_ITERATIONS = 2;
+
+	template <typename DataType>
+	class JacobiSVD
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"JacobiSVD requires a floating point data type");
+
+	public:
+
+		// Constructor; computes the singular values of given matrix, and
+		// its singular vectors unless compute_vectors is false, converting
+		// its elements to DataType
+		// Throws NoConvergence in the rare case the sweeps don't converge
+		template <typename MatrixDataType>
+		explicit JacobiSVD(const DenseMatrix<MatrixDataType>& A,
+			const bool compute_vectors = true) :
+			JacobiSVD(A.view(), compute_vectors)
+		{ }
+
+		// View version of constructor; tall matrices are first reduced to
+		// their n x n R factor by QR, so the sweeps only ever work on a
+		// square matrix, and wide ones are decomposed through their
+		// transpose
+		template <typename ViewDataType>
+		explicit JacobiSVD(const MatrixView<ViewDataType>& A,
+			const bool compute_vectors = true) :
+			_rows(A.rows()),
+			_cols(A.cols()),
+			_left(0, 0),
+			_right(0, 0)
+		{
+			const bool wide = A.rows() < A.cols();
+			const MatrixView<ViewDataType> B = wide ? A.transposed() : A;
+			const size_t m = B.rows();
+			const size_t n = B.cols();
+			if (n == 0)
+				return;
+
+			// W B_V = B with V orthogonal; the sweeps make the columns of
+			// W orthogonal, which then are U diag(s)
+			std::unique_ptr<QRFactorization<DataType> > qr;
+			DenseMatrix<DataType> W(0, 0);
+			if (m > n)
+			{
+				qr.reset(new QRFactorization<DataType>(B));
+				W = qr->upper();
+			}
+			else
+			{
+				W = DenseMatrix<DataType>(B, StorageType::ColumnMajor);
+			}
+
+			DenseMatrix<DataType> V(0, 0);
+			if (compute_vectors)
+			{
+				V = DenseMatrix<DataType>(n, n);
+				for (size_t i = 0; i < n; ++i)
+				{
+					V.at(i, i) = 1;
+				}
+			}
+
+			orthogonalizeColumns(W.view(), V.view());
+
+			// Singular values are the column norms, sorted descending
+			std::vector<DataType> norms(n);
+			for (size_t j = 0; j < n; ++j)
+			{
+				norms[j] = std::sqrt(dotKernel(&W.at(0, j), &W.at(0, j), n));
+			}
+			std::vector<size_t> order(n);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(),
+				[&norms](const size_t a, const size_t b) { return norms[a] > norms[b]; });
+
+			std::vector<DataType> values(n);
+			for (size_t j = 0; j < n; ++j)
+			{
+				values[j] = norms[order[j]];
+			}
+			_singular_values = MathVector<DataType>(std::move(values));
+
+			if (!compute_vectors)
+				return;
+
+			DenseMatrix<DataType> U(m, n);
+			DenseMatrix<DataType> V_sorted(n, n);
+			for (size_t j = 0; j < n; ++j)
+			{
+				V_sorted.colView(j).assign(V.colView(order[j]));
+				if (norms[order[j]] != DataType(0))
+				{
+					VectorView<DataType> u = U.colView(j).subView(0, n);
+					u.assign(W.colView(order[j]));
+					u.scale(1 / norms[order[j]]);
+				}
+			}
+
+			completeColumns(U.view().subView(0, n, 0, n), n - static_cast<size_t>(
+				std::count(norms.begin(), norms.end(), DataType(0))));
+
+			// U = Q [U_R; 0] for tall matrices
+			if (qr)
+				qr->applyQ(U.view());
+
+			_left = wide ? std::move(V_sorted) : std::move(U);
+			_right = wide ? std::move(U) : std::move(V_sorted);
+		}
+
+		// Returns the min(m, n) singular values in descending order
+		MathVector<DataType> singularValues() const
+		{
+			return _singular_values;
+		}
+
+		// Returns true if singular vectors were computed
+		bool hasVectors() const
+		{
+			return !_left.isEmpty();
+		}
+
+		// Returns the m x min(m, n) ColumnMajor U, whose column j is the
+		// left singular vector of singular value j; empty if vectors
+		// weren't computed
+		const DenseMatrix<DataType>& leftVectors() const
+		{
+			return _left;
+		}
+
+		// Returns the n x min(m, n) ColumnMajor V, whose column j is the
+		// right singular vector of singular value j
+		const DenseMatrix<DataType>& rightVectors() const
+		{
+			return _right;
+		}
+
+		// Returns number of singular values above max(m, n) * epsilon
+		// times the largest one
+		size_t rank() const
+		{
+			if (_singular_values.size() == 0)
+				return 0;
+
+			const DataType tolerance = _singular_values[0] *
+				static_cast<DataType>(std::max(_rows, _cols)) *
+				std::numeric_limits<DataType>::epsilon();
+			size_t count = 0;
+			while (count < _singular_values.size() && _singular_values[count] > tolerance)
+			{
+				++count;
+			}
+			return count;
+		}
+
+	private:
+
+		// Makes the columns of W mutually orthogonal by plane rotations,
+		// applying every rotation to V too, unless V is empty
+		// Each sweep covers all n (n - 1) / 2 pairs of columns in n - 1
+		// rounds of the round robin ordering; the pairs of a round share
+		// no columns, so they are rotated in parallel
+		static void orthogonalizeColumns(const MatrixView<DataType>& W,
+			const MatrixView<DataType>& V)
+		{
+			const size_t n = W.cols();
+			const size_t players = n + n % 2;
+			const size_t num_pairs = players / 2;
+
+			ThreadPool& pool = defaultThreadPool();
+			const bool parallel = pool.numThreads() > 1 &&
+				W.rows() * n >= JACOBI_PARALLEL_MIN_SIZE;
+			std::vector<char> rotated(num_pairs);
+
+			for (size_t sweep = 0; sweep < JACOBI_MAX_SWEEPS; ++sweep)
+			{
+				bool any_rotated = false;
+				for (size_t round = 0; round + 1 < players; ++round)
+				{
+					// Player 0 stays put while the others circle around
+					// it, so every pair meets once per sweep
+					auto pair_in_round = [&](const size_t pair)
+					{
+						auto position = [&](const size_t i)
+						{
+							return 1 + (round + i) % (players - 1);
+						};
+						size_t p = (pair == 0) ? 0 : position(pair);
+						size_t q = (pair == 0) ? position(0) : position(players - 1 - pair);
+						rotated[pair] = (p < n && q < n) ? rotatePair(W, V, p, q) : 0;
+					};
+
+					if (parallel)
+						pool.parallelFor(num_pairs, pair_in_round);
+					else
+					{
+						for (size_t pair = 0; pair < num_pairs; ++pair)
+						{
+							pair_in_round(pair);
+						}
+					}
+
+					for (char flag : rotated)
+					{
+						any_rotated = any_rotated || flag;
+					}
+				}
+
+				if (!any_rotated)
+					return;
+			}
+
+			throw NoConvergence();
+		}
+
+		// Fills columns [first, n) of the n x n U, whose columns before
+		// first are orthonormal, so that all of them are; these belong to
+		// zero singular values, and are any orthonormal basis of the
+		// complement, built by Gram-Schmidt, twice, from the unit vector
+		// e_i whose residual 1 - sum_k U(i, k)^2 is largest; with j columns
+		// done those residuals sum to n - j, so the largest is at least
+		// (n - j) / n and the new column never cancels away
+		static void completeColumns(const MatrixView<DataType>& U, const size_t first)
+		{
+			const size_t n = U.rows();
+			for (size_t j = first; j < n; ++j)
+			{
+				size_t best = 0;
+				DataType best_residual = -1;
+				for (size_t i = 0; i < n; ++i)
+				{
+					DataType residual = 1;
+					for (size_t k = 0; k < j; ++k)
+					{
+						residual -= U(i, k) * U(i, k);
+					}
+					if (residual > best_residual)
+					{
+						best = i;
+						best_residual = residual;
+					}
+				}
+
+				VectorView<DataType> u = U.col(j);
+				u.fill(0);
+				u[best] = 1;
+				for (size_t pass = 0; pass < 2; ++pass)
+				{
+					for (size_t k = 0; k < j; ++k)
+					{
+						DataType projection = dotKernel(&U(0, k), &u[0], n);
+						axpyKernel(-projection, &U(0, k), &u[0], n);
+					}
+				}
+				u.scale(1 / std::sqrt(dotKernel(&u[0], &u[0], n)));
+			}
+		}
+
+		// Rotates columns p and q of W, and of V, to make them orthogonal;
+		// returns false, leaving them be, if they already are to working
+		// precision, which is sqrt(m) epsilon since the dot products carry
+		// that much rounding; a tighter test can keep rotating rounding
+		// noise back and forth between a column and a tiny one forever
+		static bool rotatePair(const MatrixView<DataType>& W,
+			const MatrixView<DataType>& V,
+			const size_t p,
+			const size_t q)
+		{
+			const size_t m = W.rows();
+			DataType* w_p = &W(0, p);
+			DataType* w_q = &W(0, q);
+			const DataType alpha = dotKernel(w_p, w_p, m);
+			const DataType beta = dotKernel(w_q, w_q, m);
+			const DataType gamma = dotKernel(w_p, w_q, m);
+
+			if (!(std::abs(gamma) > std::sqrt(static_cast<DataType>(m)) *
+				std::numeric_limits<DataType>::epsilon() * std::sqrt(alpha) * std::sqrt(beta)))
+			{
+				return false;
+			}
+
+			// Rotation that diagonalizes [alpha gamma; gamma beta], with
+			// the smaller of the two possible angles
+			const DataType zeta = (beta - alpha) / (2 * gamma);
+			const DataType t = std::copysign(DataType(1), zeta) /
+				(std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+			const DataType c = 1 / std::sqrt(1 + t * t);
+			const DataType s = c * t;
+
+			rotateColumns(w_p, w_q, m, c, s);
+			if (!V.isEmpty())
+				rotateColumns(&V(0, p), &V(0, q), V.rows(), c, s);
+			return true;
+		}
+
+		// Sets [x y] = [x y] [c s; -s c]
+		static void rotateColumns(DataType* x,
+			DataType* y,
+			const size_t length,
+			const DataType c,
+			const DataType s)
+		{
+			for (size_t i = 0; i < length; ++i)
+			{
+				DataType x_i = x[i];
+				x[i] = c * x_i - s * y[i];
+				y[i] = s * x_i + c * y[i];
+			}
+		}
+
+		// Shape of the decomposed matrix
+		size_t _rows;
+		size_t _cols;
+
+		MathVector<DataType> _singular_values;
+
+		DenseMatrix<DataType> _left;
+
+		DenseMatrix<DataType> _right;
+	};
+
+	// Randomized SVD of Halko, Martinsson and Tropp, which approximates the
+	// largest singular values and vectors of A from the range of A Omega
+	// for a Gaussian random Omega with a few more columns than the rank
+	// asked for; the range is sharpened by subspace iteration, and the
+	// small projection of A onto it is decomposed by JacobiSVD
+	// Every product with A is a GEMM with O(rank) columns, which is nearly
+	// all the work, so for a low rank of a large matrix it is orders of
+	// magnitude cheaper than the full decomposition
+	template <typename DataType>
+	class RandomizedSVD
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"RandomizedSVD requires a floating point data type");
+
+	public:
+
+		// Constructor; approximates the given number of largest singular
+		// values and vectors of A, using rank + oversampling random
+		// columns and given number of subspace iterations
+		// Throws InvalidDimensions unless 0 < rank <= min(m, n)
+		explicit RandomizedSVD(const DenseMatrix<DataType>& A,
+			const size_t rank,
+			const size_t oversampling = RANDOMIZED_SVD_OVERSAMPLING,
+			const size_t power_iterations = RANDOMIZED_SVD_POWER_ITERATIONS) :
+			RandomizedSVD(A.view(), rank, oversampling, power_iterations)
+		{ }
+
+		// View version of constructor
+		explicit RandomizedSVD(const ConstMatrixView<DataType>& A,
+			const size_t rank,
+			const size_t oversampling = RANDOMIZED_SVD_OVERSAMPLING,
+			const size_t power_iterations = RANDOMIZED_SVD_POWER_ITERATIONS) :
+			_left(0, 0),
+			_right(0, 0)
+		{
+			const size_t m = A.rows();
+			const size_t n = A.cols();
+			if (rank == 0 || rank > std::min(m, n))
+				throw InvalidDimensions();
+
+			const size_t samples = std::min(rank + oversampling, std::min(m, n));
+
+			// Q = orth(A Omega)
+			DenseMatrix<DataType> omega(n, samples);
+			std::mt19937 generator(std::mt19937::default_seed);
+			std::normal_distribution<DataType> distribution(0, 1);
+			for (size_t j = 0; j < samples; ++j)
+			{
+				VectorView<DataType> column = omega.colView(j);
+				for (size_t i = 0; i < n; ++i)
+				{
+					column[i] = distribution(generator);
+				}
+			}
+			DenseMatrix<DataType> Q = orthonormalize(multiply(A, omega));
+
+			// Q = orth(A orth(A^T Q)), which sees the singular values raised
+			// to the power 2 * power_iterations + 1; orthonormalizing
+			// between products keeps the small ones from being lost to
+			// rounding
+			for (size_t iteration = 0; iteration < power_iterations; ++iteration)
+			{
+				DenseMatrix<DataType> Z = orthonormalize(multiply(A.transposed(), Q));
+				Q = orthonormalize(multiply(A, Z));
+			}
+
+			// A ~ Q B with B = Q^T A, decomposed through its tall transpose:
+			// B^T = U_B diag(s) V_B^T makes A ~ (Q V_B) diag(s) U_B^T
+			JacobiSVD<DataType> small(multiply(A.transposed(), Q).view());
+			std::vector<DataType> values = small.singularValues().getData();
+			values.resize(rank);
+			_singular_values = MathVector<DataType>(std::move(values));
+
+			_right = small.leftVectors().getSubMatrix(0, n, 0, rank);
+			_left = multiply(Q.view(), small.rightVectors().subMatrixView(0, samples, 0, rank));
+		}
+
+		// Returns the rank largest singular values in descending order
+		MathVector<DataType> singularValues() const
+		{
+			return _singular_values;
+		}
+
+		// Returns the m x rank ColumnMajor U of the left singular vectors
+		const DenseMatrix<DataType>& leftVectors() const
+		{
+			return _left;
+		}
+
+		// Returns the n x rank ColumnMajor V of the right singular vectors
+		const DenseMatrix<DataType>& rightVectors() const
+		{
+			return _right;
+		}
+
+	private:
+
+		// Returns A B as a ColumnMajor matrix
+		static DenseMatrix<DataType> multiply(const ConstMatrixView<DataType>& A,
+			const ConstMatrixView<DataType>& B)
+		{
+			DenseMatrix<DataType> C(A.rows(), B.cols());
+			gemmParallel(A, B, C.view(), defaultThreadPool(), GemmBlockSizes(), 1, 0);
+			return C;
+		}
+
+		static DenseMatrix<DataType> multiply(const ConstMatrixView<DataType>& A,
+			const DenseMatrix<DataType>& B)
+		{
+			return multiply(A, B.view());
+		}
+
+		// Returns an orthonormal basis of the columns of Y, the Q factor
+		// of its QR factorization
+		static DenseMatrix<DataType> orthonormalize(DenseMatrix<DataType>&& Y)
+		{
+			return QRFactorization<DataType>(std::move(Y)).orthogonal();
+		}
+
+		MathVector<DataType> _singular_values;
+
+		DenseMatrix<DataType> _left;
+
+		DenseMatrix<DataType> _right;
+	};
+}
+
+#endif
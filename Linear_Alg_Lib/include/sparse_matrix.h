@@ -2,12 +2,21 @@
 #define SPARSE_MATRIX_H
 
 #include <vector>
+#include <utility>
+
 #include "matrix.h"
 #include "matrix_utils.h"
+#include "math_vector.h"
+#include "exceptions.h"
 
 // ------------------------------------------------------------------
 // Matrix class for sparse matrices; stores data in three vectors; one 
 // for the actual data, one for row indices, and one for column indices
+// This is the coordinate (COO) format; entries are kept in no
+// particular order and a position may appear more than once, in which
+// case its value is the sum of its entries, so the format is cheap to
+// build but slow to compute with; convert it to a CSRMatrix or
+// CSCMatrix, see compressed_sparse_matrix.h, for fast kernels
 // ------------------------------------------------------------------
 
 namespace LinAlg
@@ -29,7 +38,19 @@ namespace LinAlg
 			_row_indices(row_indices_in),
 			_col_indices(col_indices_in),
 			_num_nonzero(data_in.size())
-		{ }
+		{
+			if (row_indices_in.size() != _num_nonzero ||
+				col_indices_in.size() != _num_nonzero)
+			{
+				throw InvalidDimensions();
+			}
+
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (_row_indices[k] >= rows_in || _col_indices[k] >= cols_in)
+					throw OutOfBounds();
+			}
+		}
 
 		// Constructor with only one input vector; this vector contains every element
 		// in the matrix, including zero values
@@ -40,17 +61,25 @@ namespace LinAlg
 			const size_t cols_in) :
 			Matrix<DataType, SparseMatrix<DataType> >(rows_in, cols_in)
 		{
+			if (data_in.size() != rows_in * cols_in)
+				throw InvalidDimensions();
+
 			// If data_in is not row major, convert it to row major
+			std::vector<DataType> converted;
+			const std::vector<DataType>* elements = &data_in;
 			if (storage_type_in == StorageType::ColumnMajor)
-				data_in = convertToRowMajorHelper(data_in, rows_in, cols_in);
+			{
+				converted = convertToRowMajorHelper(data_in, rows_in, cols_in);
+				elements = &converted;
+			}
 
 			// Iterates through data_in and puts all non-zero elements into the data vector; 
 			// stores the row and column indices of each non-zero element in _row_indices and
 			// _col_indices respectively
 			_num_nonzero = 0;
-			for (size_t i = 0; i < data_in.size(); ++i)
+			for (size_t i = 0; i < elements->size(); ++i)
 			{
-				DataType elt = data_in[i];
+				DataType elt = (*elements)[i];
 				if (elt != 0)
 				{
 					size_t row = rowIndex(i, cols_in);
@@ -69,19 +98,19 @@ namespace LinAlg
 		}
 
 		// Returns _data vector
-		std::vector<DataType> getData() const
+		const std::vector<DataType>& getData() const
 		{
 			return _data;
 		}
 
 		// Returns _row_indices vector
-		std::vector<size_t> getRowIndices() const
+		const std::vector<size_t>& getRowIndices() const
 		{
 			return _row_indices;
 		}
 
 		// Returns _col_indices vector
-		std::vector<size_t> getColIndices() const
+		const std::vector<size_t>& getColIndices() const
 		{
 			return _col_indices;
 		}
@@ -92,6 +121,195 @@ namespace LinAlg
 			return _num_nonzero;
 		}
 
+		// Appends the entry (row, col, value); an existing entry at the
+		// same position is not replaced, the two are summed instead, which
+		// is how finite element and graph codes assemble their matrices
+		void addEntry(const size_t row, const size_t col, const DataType value)
+		{
+			checkIndex(row, col);
+			_data.push_back(value);
+			_row_indices.push_back(row);
+			_col_indices.push_back(col);
+			++_num_nonzero;
+		}
+
+		// Returns element at location (row, col), const version; the sum
+		// of every entry at that position, found by a linear search
+		DataType at(const size_t row, const size_t col) const override
+		{
+			checkIndex(row, col);
+
+			DataType sum = 0;
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (_row_indices[k] == row && _col_indices[k] == col)
+					sum += _data[k];
+			}
+			return sum;
+		}
+
+		// Returns element at location (row, col), non-const version; any
+		// duplicate entries at that position are first merged into one,
+		// and a zero entry is appended if there is none
+		DataType& at(const size_t row, const size_t col) override
+		{
+			checkIndex(row, col);
+
+			size_t found = _num_nonzero;
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (_row_indices[k] == row && _col_indices[k] == col)
+				{
+					if (found == _num_nonzero)
+						found = k;
+					else
+						_data[found] += _data[k];
+				}
+			}
+
+			if (found == _num_nonzero)
+			{
+				addEntry(row, col, 0);
+				return _data.back();
+			}
+
+			// Keeps the first entry, which holds the sum, and drops the rest
+			eraseEntries([&](const size_t k)
+				{
+					return k > found && _row_indices[k] == row && _col_indices[k] == col;
+				});
+			return _data[found];
+		}
+
+		// Returns row pos as a MathVector
+		MathVector<DataType> row(const size_t pos) const override
+		{
+			return lineHelper(pos, _row_indices, _col_indices, this->_rows, this->_cols);
+		}
+
+		// Returns col pos as a MathVector
+		MathVector<DataType> col(const size_t pos) const override
+		{
+			return lineHelper(pos, _col_indices, _row_indices, this->_cols, this->_rows);
+		}
+
+		// Sets row pos to given MathVector; only its nonzero elements are
+		// stored
+		void setRow(const size_t pos,
+			const MathVector<DataType>& new_row) override
+		{
+			setHelper(pos, new_row, _row_indices, _col_indices, this->_rows, this->_cols);
+		}
+
+		// Sets col pos to given MathVector
+		void setCol(const size_t pos,
+			const MathVector<DataType>& new_col) override
+		{
+			setHelper(pos, new_col, _col_indices, _row_indices, this->_cols, this->_rows);
+		}
+
+		// Adds given row to the matrix above row pos
+		void addRow(const size_t pos,
+			const MathVector<DataType>& new_row) override
+		{
+			addHelper(pos, new_row, _row_indices, _col_indices, this->_rows, this->_cols);
+		}
+
+		// Adds given col to the matrix to the left of col pos
+		void addCol(const size_t pos,
+			const MathVector<DataType>& new_col) override
+		{
+			addHelper(pos, new_col, _col_indices, _row_indices, this->_cols, this->_rows);
+		}
+
+		// Removes row pos from the matrix entirely
+		void removeRow(const size_t pos) override
+		{
+			removeHelper(pos, _row_indices, this->_rows, this->_cols);
+		}
+
+		// Removes col pos from the matrix entirely
+		void removeCol(const size_t pos) override
+		{
+			removeHelper(pos, _col_indices, this->_cols, this->_rows);
+		}
+
+		// Swaps the two rows at given positions; only the row indices of
+		// their entries change
+		void swapRows(const size_t pos1, const size_t pos2) override
+		{
+			swapHelper(pos1, pos2, _row_indices, this->_rows);
+		}
+
+		// Swaps the two columns at given positions
+		void swapCols(const size_t pos1, const size_t pos2) override
+		{
+			swapHelper(pos1, pos2, _col_indices, this->_cols);
+		}
+
+		// Scales row pos by the given factor
+		void scaleRow(const size_t pos, const DataType factor) override
+		{
+			scaleHelper(pos, factor, _row_indices, this->_rows);
+		}
+
+		// Scales col pos by the given factor
+		void scaleCol(const size_t pos, const DataType factor) override
+		{
+			scaleHelper(pos, factor, _col_indices, this->_cols);
+		}
+
+		// Returns matrix containing rows [first_row, last_row) and 
+		// columns [first_col, last_col)
+		SparseMatrix<DataType> getSubMatrix(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col) const override
+		{
+			checkSubMatrix(first_row, last_row, first_col, last_col);
+
+			SparseMatrix<DataType> sub_matrix(std::vector<DataType>(),
+				std::vector<size_t>(), std::vector<size_t>(),
+				last_row - first_row, last_col - first_col);
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (inSubMatrix(k, first_row, last_row, first_col, last_col))
+				{
+					sub_matrix.addEntry(_row_indices[k] - first_row,
+						_col_indices[k] - first_col, _data[k]);
+				}
+			}
+			return sub_matrix;
+		}
+
+		// Sets section of matrix including rows [first_row, last_row)
+		// and columns [first_col, last_col) to given matrix
+		void setSubMatrix(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col,
+			const SparseMatrix<DataType>& new_sub_matrix) override
+		{
+			checkSubMatrix(first_row, last_row, first_col, last_col);
+
+			if (new_sub_matrix.rows() != last_row - first_row ||
+				new_sub_matrix.cols() != last_col - first_col)
+			{
+				throw InvalidDimensions();
+			}
+
+			eraseEntries([&](const size_t k)
+				{
+					return inSubMatrix(k, first_row, last_row, first_col, last_col);
+				});
+
+			for (size_t k = 0; k < new_sub_matrix._num_nonzero; ++k)
+			{
+				addEntry(new_sub_matrix._row_indices[k] + first_row,
+					new_sub_matrix._col_indices[k] + first_col, new_sub_matrix._data[k]);
+			}
+		}
+
 
 
 		// Prints matrix to cout:
@@ -110,6 +328,208 @@ namespace LinAlg
 
 	private:
 
+		// Throws OutOfBounds unless (row, col) is in the matrix
+		void checkIndex(const size_t row, const size_t col) const
+		{
+			if (row >= this->_rows || col >= this->_cols)
+				throw OutOfBounds();
+		}
+
+		// Throws OutOfBounds unless the given rows and columns are in the
+		// matrix
+		void checkSubMatrix(const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col) const
+		{
+			if (first_row > this->_rows ||
+				last_row > this->_rows ||
+				first_col > this->_cols ||
+				last_col > this->_cols)
+			{
+				throw OutOfBounds();
+			}
+		}
+
+		// Returns true if entry k is in rows [first_row, last_row) and
+		// columns [first_col, last_col)
+		bool inSubMatrix(const size_t k,
+			const size_t first_row,
+			const size_t last_row,
+			const size_t first_col,
+			const size_t last_col) const
+		{
+			return _row_indices[k] >= first_row && _row_indices[k] < last_row &&
+				_col_indices[k] >= first_col && _col_indices[k] < last_col;
+		}
+
+		// Removes every entry k for which erase(k) is true, keeping the
+		// order of the others
+		template <typename Predicate>
+		void eraseEntries(const Predicate& erase)
+		{
+			size_t kept = 0;
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (erase(k))
+					continue;
+
+				_data[kept] = _data[k];
+				_row_indices[kept] = _row_indices[k];
+				_col_indices[kept] = _col_indices[k];
+				++kept;
+			}
+
+			_num_nonzero = kept;
+			_data.resize(kept);
+			_row_indices.resize(kept);
+			_col_indices.resize(kept);
+		}
+
+		// Helpers for the row and column versions of the methods below;
+		// major_indices are the indices along which pos counts, the row
+		// indices for rows, minor_indices the others, num_of the number
+		// of rows or columns and size_of their size
+
+		// Helper for row() and col()
+		MathVector<DataType> lineHelper(const size_t pos,
+			const std::vector<size_t>& major_indices,
+			const std::vector<size_t>& minor_indices,
+			const size_t num_of,
+			const size_t size_of) const
+		{
+			if (pos >= num_of)
+				throw OutOfBounds();
+
+			std::vector<DataType> line(size_of, 0);
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (major_indices[k] == pos)
+					line[minor_indices[k]] += _data[k];
+			}
+			return MathVector<DataType>(std::move(line));
+		}
+
+		// Appends the nonzero elements of given row or column as entries
+		// of line pos
+		void appendLine(const size_t pos,
+			const MathVector<DataType>& new_line,
+			std::vector<size_t>& major_indices,
+			std::vector<size_t>& minor_indices)
+		{
+			for (size_t i = 0; i < new_line.size(); ++i)
+			{
+				DataType elt = new_line[i];
+				if (elt != 0)
+				{
+					_data.push_back(elt);
+					major_indices.push_back(pos);
+					minor_indices.push_back(i);
+					++_num_nonzero;
+				}
+			}
+		}
+
+		// Helper for setRow() and setCol()
+		void setHelper(const size_t pos,
+			const MathVector<DataType>& new_line,
+			std::vector<size_t>& major_indices,
+			std::vector<size_t>& minor_indices,
+			const size_t num_of,
+			const size_t size_of)
+		{
+			if (pos >= num_of)
+				throw OutOfBounds();
+
+			if (new_line.size() != size_of)
+				throw InvalidDimensions();
+
+			eraseEntries([&](const size_t k) { return major_indices[k] == pos; });
+			appendLine(pos, new_line, major_indices, minor_indices);
+		}
+
+		// Helper for addRow() and addCol(); a matrix without rows takes
+		// its number of columns from the first row added, and vice versa
+		void addHelper(const size_t pos,
+			const MathVector<DataType>& new_line,
+			std::vector<size_t>& major_indices,
+			std::vector<size_t>& minor_indices,
+			size_t& num_of,
+			size_t& size_of)
+		{
+			if (pos > num_of)
+				throw OutOfBounds();
+
+			if (num_of == 0)
+				size_of = new_line.size();
+			else if (new_line.size() != size_of)
+				throw InvalidDimensions();
+
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (major_indices[k] >= pos)
+					++major_indices[k];
+			}
+			appendLine(pos, new_line, major_indices, minor_indices);
+
+			++num_of;
+			this->_size = this->_rows * this->_cols;
+		}
+
+		// Helper for removeRow() and removeCol()
+		void removeHelper(const size_t pos,
+			std::vector<size_t>& major_indices,
+			size_t& num_of,
+			const size_t size_of)
+		{
+			if (pos >= num_of)
+				throw OutOfBounds();
+
+			eraseEntries([&](const size_t k) { return major_indices[k] == pos; });
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (major_indices[k] > pos)
+					--major_indices[k];
+			}
+
+			--num_of;
+			this->_size = num_of * size_of;
+		}
+
+		// Helper for swapRows() and swapCols()
+		void swapHelper(const size_t pos1,
+			const size_t pos2,
+			std::vector<size_t>& major_indices,
+			const size_t num_of)
+		{
+			if (pos1 >= num_of || pos2 >= num_of)
+				throw OutOfBounds();
+
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (major_indices[k] == pos1)
+					major_indices[k] = pos2;
+				else if (major_indices[k] == pos2)
+					major_indices[k] = pos1;
+			}
+		}
+
+		// Helper for scaleRow() and scaleCol()
+		void scaleHelper(const size_t pos,
+			const DataType factor,
+			const std::vector<size_t>& major_indices,
+			const size_t num_of)
+		{
+			if (pos >= num_of)
+				throw OutOfBounds();
+
+			for (size_t k = 0; k < _num_nonzero; ++k)
+			{
+				if (major_indices[k] == pos)
+					_data[k] *= factor;
+			}
+		}
+
 		// Vector to store non-zero data
 		std::vector<DataType> _data;
 
@@ -0,0 +1,377 @@
+#ifndef SPMV_KERNEL_H
+#define SPMV_KERNEL_H
+
+#include <vector>
+#include <algorithm>
+
+#include "sparse_matrix.h"
+#include "compressed_sparse_matrix.h"
+#include "matrix_view.h"
+#include "matrix_utils.h"
+#include "gemv_kernel.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Sparse matrix-vector multiplication engine; a compressed matrix is
+// streamed once, line by line, with each line either reduced against x,
+// gathering the elements of x it needs, or accumulated into y,
+// scattering; long lines go through sparseDotKernel() and
+// sparseAxpyKernel()
+// Work is split across threads by merge path: walking the lines and
+// the entries together is a path of num_lines + nnz steps, and every
+// thread takes an equal share of it, so a thread gets the same amount
+// of work whether its lines are long or short, and a line longer than
+// a share is simply split between threads
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Products with fewer entries than this run on one thread
+	const size_t SPMV_PARALLEL_MIN_NONZERO = 1 << 14;
+
+	// Lines shorter than this are summed inline rather than by a call to
+	// the SIMD kernels, which would spend more time dispatching and
+	// reducing across lanes than gathering
+	const size_t SPMV_SIMD_MIN_LENGTH = 16;
+
+	// Returns the dot product of n entries of a compressed line with x
+	template <typename DataType>
+	inline DataType spmvLineDot(const DataType* values,
+		const size_t* indices,
+		const DataType* x,
+		const size_t n)
+	{
+		if (n >= SPMV_SIMD_MIN_LENGTH)
+			return sparseDotKernel(values, indices, x, n);
+
+		DataType sum = 0;
+		for (size_t k = 0; k < n; ++k)
+			sum += values[k] * x[indices[k]];
+		return sum;
+	}
+
+	// Adds alpha times n entries of a compressed line into y
+	template <typename DataType>
+	inline void spmvLineAxpy(const DataType alpha,
+		const DataType* values,
+		const size_t* indices,
+		DataType* y,
+		const size_t n)
+	{
+		if (n >= SPMV_SIMD_MIN_LENGTH)
+		{
+			sparseAxpyKernel(alpha, values, indices, y, n);
+			return;
+		}
+
+		for (size_t k = 0; k < n; ++k)
+			y[indices[k]] += alpha * values[k];
+	}
+
+	// Point on the merge path of a compressed matrix, after given number
+	// of whole lines and of entries
+	struct MergePathCoordinate
+	{
+		size_t line;
+		size_t entry;
+	};
+
+	// Returns the point where the merge path of a compressed matrix with
+	// given pointer array crosses diagonal line + entry = diagonal; a
+	// binary search for the first line that ends after the entries the
+	// diagonal leaves for it
+	inline MergePathCoordinate mergePathSearch(const std::vector<size_t>& pointers,
+		const size_t diagonal)
+	{
+		const size_t num_lines = pointers.size() - 1;
+		const size_t num_entries = pointers.back();
+
+		size_t low = (diagonal > num_entries) ? diagonal - num_entries : 0;
+		size_t high = std::min(diagonal, num_lines);
+		while (low < high)
+		{
+			size_t mid = low + (high - low) / 2;
+			if (pointers[mid + 1] <= diagonal - mid - 1)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		return { low, diagonal - low };
+	}
+
+	// Returns the num_parts + 1 points that split the merge path of a
+	// compressed matrix with given pointer array into equal parts
+	inline std::vector<MergePathCoordinate> mergePathPartition(
+		const std::vector<size_t>& pointers,
+		const size_t num_parts)
+	{
+		const size_t length = pointers.size() - 1 + pointers.back();
+		std::vector<MergePathCoordinate> bounds(num_parts + 1);
+		for (size_t part = 0; part <= num_parts; ++part)
+		{
+			bounds[part] = mergePathSearch(pointers, std::min(
+				(length + num_parts - 1) / num_parts * part, length));
+		}
+		return bounds;
+	}
+
+	// Sums given partial results, each of n elements and num_partials of
+	// them one after another, into y, which must not overlap them; in
+	// parallel across bands of y
+	template <typename DataType>
+	inline void sumPartials(const std::vector<DataType>& partials,
+		const size_t num_partials,
+		DataType* y,
+		const size_t n,
+		ThreadPool& pool)
+	{
+		const size_t num_bands = std::min(pool.numThreads(),
+			(n + GEMV_MIN_BAND - 1) / GEMV_MIN_BAND);
+		if (num_bands == 0)
+			return;
+
+		const size_t band_size = (n + num_bands - 1) / num_bands;
+		pool.parallelFor(num_bands, [&](const size_t band)
+		{
+			size_t first = std::min(band * band_size, n);
+			size_t last = std::min(first + band_size, n);
+			for (size_t partial = 0; partial < num_partials; ++partial)
+			{
+				addKernel(y + first, partials.data() + partial * n + first,
+					y + first, last - first);
+			}
+		});
+	}
+
+	// Computes y = alpha * A * x + beta * y, where line i of the
+	// compressed arrays is row i of A, so every element of y is the dot
+	// product of one line with x
+	// A part of the merge path that ends inside a line leaves the sum of
+	// that line's entries it covered as a carry, which is added to y once
+	// every part has finished and the line's owner has written it
+	template <typename DataType>
+	inline void spmvGather(const std::vector<size_t>& pointers,
+		const std::vector<size_t>& indices,
+		const std::vector<DataType>& data,
+		const DataType* x,
+		DataType* y,
+		const size_t num_parts,
+		ThreadPool& pool,
+		const DataType alpha,
+		const DataType beta)
+	{
+		const std::vector<MergePathCoordinate> bounds =
+			mergePathPartition(pointers, num_parts);
+		std::vector<DataType> carries(num_parts, 0);
+
+		auto run_part = [&](const size_t part)
+		{
+			size_t p = bounds[part].entry;
+			for (size_t line = bounds[part].line; line < bounds[part + 1].line; ++line)
+			{
+				size_t end = pointers[line + 1];
+				DataType sum = spmvLineDot(data.data() + p, indices.data() + p, x, end - p);
+				y[line] = (beta == DataType(0)) ? alpha * sum : alpha * sum + beta * y[line];
+				p = end;
+			}
+
+			size_t end = bounds[part + 1].entry;
+			carries[part] = spmvLineDot(data.data() + p, indices.data() + p, x, end - p);
+		};
+
+		if (num_parts == 1)
+			run_part(0);
+		else
+			pool.parallelFor(num_parts, run_part);
+
+		for (size_t part = 0; part < num_parts; ++part)
+		{
+			size_t line = bounds[part + 1].line;
+			if (line < pointers.size() - 1 && carries[part] != DataType(0))
+				y[line] += alpha * carries[part];
+		}
+	}
+
+	// Computes y = alpha * A * x + beta * y, where line j of the
+	// compressed arrays is column j of A, so every line is scaled by an
+	// element of x and added into y
+	// Lines may add into any element of y, so every part of the merge
+	// path but the first sums into its own copy of y, and the copies are
+	// added together at the end
+	template <typename DataType>
+	inline void spmvScatter(const std::vector<size_t>& pointers,
+		const std::vector<size_t>& indices,
+		const std::vector<DataType>& data,
+		const DataType* x,
+		DataType* y,
+		const size_t y_size,
+		const size_t num_parts,
+		ThreadPool& pool,
+		const DataType alpha,
+		const DataType beta)
+	{
+		gemvScale(VectorView<DataType>(y, y_size), beta);
+
+		const std::vector<MergePathCoordinate> bounds =
+			mergePathPartition(pointers, num_parts);
+		std::vector<DataType> partials((num_parts - 1) * y_size);
+
+		auto run_part = [&](const size_t part)
+		{
+			DataType* out = (part == 0) ? y : partials.data() + (part - 1) * y_size;
+			size_t p = bounds[part].entry;
+			size_t last_entry = bounds[part + 1].entry;
+			for (size_t line = bounds[part].line; p < last_entry; ++line)
+			{
+				size_t end = std::min(pointers[line + 1], last_entry);
+				DataType factor = alpha * x[line];
+				if (factor != DataType(0))
+					spmvLineAxpy(factor, data.data() + p, indices.data() + p, out, end - p);
+				p = end;
+			}
+		};
+
+		if (num_parts == 1)
+		{
+			run_part(0);
+			return;
+		}
+
+		pool.parallelFor(num_parts, run_part);
+		sumPartials(partials, num_parts - 1, y, y_size, pool);
+	}
+
+	// Computes y = alpha * op(A) * x + beta * y for a CSR or CSC matrix A,
+	// where op(A) is A or its transpose; x and y may have any stride, but
+	// y must not overlap x
+	// A CSR product, or a CSC product with the transpose, reduces every
+	// line against x; the other two scatter every line into y
+	// Following BLAS, if beta is 0 the old contents of y are never read
+	template <typename DataType, StorageType Storage>
+	inline void spmvParallel(const CompressedSparseMatrix<DataType, Storage>& A,
+		const TransposeOp trans,
+		const ConstVectorView<DataType>& x,
+		const VectorView<DataType>& y,
+		ThreadPool& pool = defaultThreadPool(),
+		const typename NonDeduced<DataType>::type alpha = 1,
+		const typename NonDeduced<DataType>::type beta = 1)
+	{
+		const bool transposed = (trans == TransposeOp::Transpose);
+		const size_t m = transposed ? A.cols() : A.rows();
+		const size_t n = transposed ? A.rows() : A.cols();
+		if (x.size() != n || y.size() != m)
+			throw InvalidDimensions();
+
+		// Kernels need contiguous vectors; strided ones go through copies
+		std::vector<DataType> x_copy, y_copy;
+		const DataType* x_data = x.data();
+		if (!x.isContiguous())
+		{
+			x_copy = x.toStdVector();
+			x_data = x_copy.data();
+		}
+
+		DataType* y_data = y.data();
+		if (!y.isContiguous())
+		{
+			y_copy = y.toStdVector();
+			y_data = y_copy.data();
+		}
+
+		const size_t num_parts = (pool.numThreads() > 1 &&
+			A.getNumNonzero() >= SPMV_PARALLEL_MIN_NONZERO) ? pool.numThreads() : 1;
+
+		// Lines of A are rows of op(A) for CSR without transpose and for
+		// CSC with it
+		if ((Storage == StorageType::RowMajor) != transposed)
+		{
+			spmvGather(A.getPointers(), A.getIndices(), A.getData(),
+				x_data, y_data, num_parts, pool, alpha, beta);
+		}
+		else
+		{
+			spmvScatter(A.getPointers(), A.getIndices(), A.getData(),
+				x_data, y_data, m, num_parts, pool, alpha, beta);
+		}
+
+		if (!y.isContiguous())
+			y.assign(VectorView<const DataType>(y_copy.data(), m));
+	}
+
+	// COO version of spmvParallel(); the entries are in no particular
+	// order, so each thread takes an equal chunk of them and sums into
+	// its own copy of y, with every entry both gathered from x and
+	// scattered into y one element at a time
+	// For more than one or two products with the same matrix, converting
+	// it to a CSRMatrix first is faster
+	template <typename DataType>
+	inline void spmvParallel(const SparseMatrix<DataType>& A,
+		const TransposeOp trans,
+		const ConstVectorView<DataType>& x,
+		const VectorView<DataType>& y,
+		ThreadPool& pool = defaultThreadPool(),
+		const typename NonDeduced<DataType>::type alpha = 1,
+		const typename NonDeduced<DataType>::type beta = 1)
+	{
+		const bool transposed = (trans == TransposeOp::Transpose);
+		const size_t m = transposed ? A.cols() : A.rows();
+		const size_t n = transposed ? A.rows() : A.cols();
+		if (x.size() != n || y.size() != m)
+			throw InvalidDimensions();
+
+		std::vector<DataType> x_copy, y_copy;
+		const DataType* x_data = x.data();
+		if (!x.isContiguous())
+		{
+			x_copy = x.toStdVector();
+			x_data = x_copy.data();
+		}
+
+		DataType* y_data = y.data();
+		if (!y.isContiguous())
+		{
+			y_copy = y.toStdVector();
+			y_data = y_copy.data();
+		}
+
+		const std::vector<DataType>& data = A.getData();
+		const size_t* out_indices = transposed ?
+			A.getColIndices().data() : A.getRowIndices().data();
+		const size_t* in_indices = transposed ?
+			A.getRowIndices().data() : A.getColIndices().data();
+		const size_t num_entries = data.size();
+
+		gemvScale(VectorView<DataType>(y_data, m), beta);
+
+		const size_t num_parts = (pool.numThreads() > 1 &&
+			num_entries >= SPMV_PARALLEL_MIN_NONZERO) ? pool.numThreads() : 1;
+		const size_t part_size = (num_entries + num_parts - 1) / num_parts;
+		std::vector<DataType> partials((num_parts - 1) * m);
+
+		auto run_part = [&](const size_t part)
+		{
+			DataType* out = (part == 0) ? y_data : partials.data() + (part - 1) * m;
+			size_t first = std::min(part * part_size, num_entries);
+			size_t last = std::min(first + part_size, num_entries);
+			for (size_t k = first; k < last; ++k)
+			{
+				out[out_indices[k]] += alpha * data[k] * x_data[in_indices[k]];
+			}
+		};
+
+		if (num_parts == 1)
+			run_part(0);
+		else
+		{
+			pool.parallelFor(num_parts, run_part);
+			sumPartials(partials, num_parts - 1, y_data, m, pool);
+		}
+
+		if (!y.isContiguous())
+			y.assign(VectorView<const DataType>(y_copy.data(), m));
+	}
+}
+
+#endif
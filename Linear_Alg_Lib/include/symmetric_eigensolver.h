@@ -0,0 +1,460 @@
+#ifndef SYMMETRIC_EIGENSOLVER_H
+#define SYMMETRIC_EIGENSOLVER_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <type_traits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "gemv_kernel.h"
+#include "gemm_kernel.h"
+#include "householder_kernel.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Eigenvalues and eigenvectors of a symmetric matrix, A = V diag(w) V^T
+// with V orthogonal; A is reduced to a tridiagonal matrix by Householder
+// reflectors, the tridiagonal eigenproblem is solved by the implicit QL
+// algorithm, and the eigenvectors are transformed back with the
+// reflectors in compact WY form
+// Without eigenvectors, the QL iteration costs O(n^2) and nothing but
+// the reduction touches the n x n matrix
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Number of columns reduced together as one panel
+	const size_t EIGEN_BLOCK_SIZE = 32;
+
+	// Most QL iterations spent on one eigenvalue before giving up
+	const size_t EIGEN_MAX_ITERATIONS = 30;
+
+	// Sequences of rotations that touch fewer elements of the eigenvector
+	// matrix than this are applied on one thread
+	const size_t EIGEN_PARALLEL_MIN_SIZE = 1 << 15;
+
+	template <typename DataType>
+	class SymmetricEigensolver
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"SymmetricEigensolver requires a floating point data type");
+
+	public:
+
+		// Constructor; computes the eigenvalues of given square matrix,
+		// and its eigenvectors unless compute_eigenvectors is false,
+		// converting its elements to DataType; only the lower triangle is
+		// read, and A is assumed to be symmetric
+		// Throws InvalidDimensions if the matrix isn't square, and
+		// NoConvergence in the rare case the QL iteration doesn't converge
+		template <typename MatrixDataType>
+		explicit SymmetricEigensolver(const DenseMatrix<MatrixDataType>& A,
+			const bool compute_eigenvectors = true) :
+			SymmetricEigensolver(A.view(), compute_eigenvectors)
+		{ }
+
+		// View version of constructor
+		template <typename ViewDataType>
+		explicit SymmetricEigensolver(const MatrixView<ViewDataType>& A,
+			const bool compute_eigenvectors = true) :
+			_eigenvalues(A.rows()),
+			_eigenvectors(0, 0)
+		{
+			if (!A.isSquare())
+				throw InvalidDimensions();
+
+			const size_t n = A.rows();
+			if (n == 0)
+				return;
+
+			// Only the lower triangle is copied
+			DenseMatrix<DataType> reduced(n, n);
+			MatrixView<DataType> work = reduced.view();
+			for (size_t j = 0; j < n; ++j)
+			{
+				work.col(j).subView(j, n).assign(A.col(j).subView(j, n));
+			}
+
+			std::vector<DataType> off_diagonal(n);
+			std::vector<DataType> tau(n - 1);
+			tridiagonalize(work, off_diagonal, tau);
+
+			if (compute_eigenvectors)
+			{
+				_eigenvectors = DenseMatrix<DataType>(n, n);
+				for (size_t i = 0; i < n; ++i)
+				{
+					_eigenvectors.at(i, i) = 1;
+				}
+			}
+
+			solveTridiagonal(off_diagonal, compute_eigenvectors);
+
+			if (compute_eigenvectors)
+				transformBack(reduced.view(), tau);
+
+			sortEigenpairs();
+		}
+
+		// Returns number of rows and columns of the matrix
+		size_t size() const
+		{
+			return _eigenvalues.size();
+		}
+
+		// Returns true if eigenvectors were computed
+		bool hasEigenvectors() const
+		{
+			return _eigenvectors.rows() == size() && size() > 0;
+		}
+
+		// Returns the eigenvalues in ascending order
+		MathVector<DataType> eigenvalues() const
+		{
+			return MathVector<DataType>(_eigenvalues);
+		}
+
+		// Returns the orthonormal eigenvectors as the columns of a
+		// ColumnMajor matrix, column i belonging to eigenvalue i; empty
+		// if they weren't computed
+		const DenseMatrix<DataType>& eigenvectors() const
+		{
+			return _eigenvectors;
+		}
+
+	private:
+
+		// Reduces the lower triangle of A to a symmetric tridiagonal
+		// matrix, Q^T A Q = T, with the blocked algorithm of LAPACK's
+		// dsytrd: within a panel, each reflector is formed from its
+		// column brought up to date with the panel's earlier reflectors,
+		// which are kept as the rank-2k update V W^T + W V^T, and that
+		// update is then applied to the rest of the lower triangle by
+		// GEMMs
+		// The diagonal of T goes to _eigenvalues and the subdiagonal to
+		// off_diagonal; reflector i is left below the subdiagonal of
+		// column i of A, with its leading 1 on the subdiagonal
+		void tridiagonalize(const MatrixView<DataType>& A,
+			std::vector<DataType>& off_diagonal,
+			std::vector<DataType>& tau)
+		{
+			const size_t n = A.rows();
+
+			for (size_t first = 0; first + 1 < n; first += EIGEN_BLOCK_SIZE)
+			{
+				const size_t last = std::min(first + EIGEN_BLOCK_SIZE, n - 1);
+				const size_t nb = last - first;
+
+				// Row r of W holds row first + r of the update
+				DenseMatrix<DataType> W_storage(n - first, nb);
+				MatrixView<DataType> W = W_storage.view();
+				std::vector<DataType> t(nb);
+
+				for (size_t i = first; i < last; ++i)
+				{
+					const size_t j = i - first;
+					DataType* a_i = &A(i, i);
+
+					// A[i, n)(i) -= V W(i)^T + W V(i)^T over the panel's
+					// earlier columns
+					if (j > 0)
+					{
+						gemvCols<DataType>(A.subView(i, n, first, i), W.row(j).subView(0, j),
+							a_i, DataType(-1));
+						gemvCols<DataType>(W.subView(j, n - first, 0, j), A.row(i).subView(first, i),
+							a_i, DataType(-1));
+					}
+
+					_eigenvalues[i] = a_i[0];
+					tau[i] = householderReflector(a_i + 1, n - i - 1);
+					off_diagonal[i] = a_i[1];
+					a_i[1] = 1;
+
+					// w = tau (A22 - V W^T - W V^T) v, then
+					// w -= (tau / 2) (w^T v) v
+					const size_t length = n - i - 1;
+					const DataType* v = a_i + 1;
+					DataType* w = &W(j + 1, j);
+					symmetricProduct(A.subView(i + 1, n, i + 1, n), v, w);
+
+					if (j > 0)
+					{
+						MatrixView<const DataType> V_rest = A.subView(i + 1, n, first, i);
+						MatrixView<const DataType> W_rest = W.subView(j + 1, n - first, 0, j);
+						VectorView<DataType> t_view(t.data(), j);
+
+						gemvRows(W_rest.transposed(), v, t_view, DataType(1), DataType(0));
+						gemvCols<DataType>(V_rest, VectorView<const DataType>(t.data(), j), w, DataType(-1));
+						gemvRows(V_rest.transposed(), v, t_view, DataType(1), DataType(0));
+						gemvCols<DataType>(W_rest, VectorView<const DataType>(t.data(), j), w, DataType(-1));
+					}
+
+					VectorView<DataType>(w, length).scale(tau[i]);
+					DataType alpha = DataType(-0.5) * tau[i] * dotKernel(w, v, length);
+					axpyKernel(alpha, v, w, length);
+				}
+
+				updateTrailing(A.subView(last, n, first, last),
+					W.subView(last - first, n - first, 0, nb),
+					A.subView(last, n, last, n));
+			}
+
+			_eigenvalues[n - 1] = A(n - 1, n - 1);
+			off_diagonal[n - 1] = 0;
+		}
+
+		// Computes y = A x for the symmetric A whose lower triangle is
+		// stored ColumnMajor, in one pass over that triangle; each column
+		// gives a dot product for its diagonal element and an axpy into
+		// the elements below it
+		static void symmetricProduct(const MatrixView<const DataType>& A,
+			const DataType* x,
+			DataType* y)
+		{
+			const size_t m = A.rows();
+			const size_t ld = A.leadingDim();
+			std::fill(y, y + m, DataType(0));
+
+			for (size_t c = 0; c < m; ++c)
+			{
+				const DataType* col = A.data() + c * ld;
+				const size_t below = m - c - 1;
+				y[c] += col[c] * x[c] + dotKernel(col + c + 1, x + c + 1, below);
+				axpyKernel(x[c], col + c + 1, y + c + 1, below);
+			}
+		}
+
+		// Sets the lower triangle of A22 to A22 - V W^T - W V^T; as in
+		// Cholesky's update, each block of columns only updates the rows
+		// from its diagonal block down, and blocks run as parallel tasks
+		static void updateTrailing(const MatrixView<const DataType>& V,
+			const MatrixView<const DataType>& W,
+			const MatrixView<DataType>& A22)
+		{
+			const size_t m = A22.rows();
+			const size_t nb = V.cols();
+			const size_t num_blocks = (m + EIGEN_BLOCK_SIZE - 1) / EIGEN_BLOCK_SIZE;
+
+			auto updateBlock = [&](const size_t block)
+			{
+				size_t first = block * EIGEN_BLOCK_SIZE;
+				size_t last = std::min(first + EIGEN_BLOCK_SIZE, m);
+				MatrixView<DataType> C = A22.subView(first, m, first, last);
+				gemmBlocked(V.subView(first, m, 0, nb),
+					W.subView(first, last, 0, nb).transposed(), C, GemmBlockSizes(), -1, 1);
+				gemmBlocked(W.subView(first, m, 0, nb),
+					V.subView(first, last, 0, nb).transposed(), C, GemmBlockSizes(), -1, 1);
+			};
+
+			if (m * m * nb < 2 * GEMM_PARALLEL_MIN_WORK)
+			{
+				for (size_t block = 0; block < num_blocks; ++block)
+				{
+					updateBlock(block);
+				}
+				return;
+			}
+
+			defaultThreadPool().parallelFor(num_blocks, updateBlock);
+		}
+
+		// Finds the eigenvalues of the tridiagonal matrix with diagonal
+		// _eigenvalues and given subdiagonal by the implicit QL algorithm
+		// with Wilkinson shifts; each QL sweep is a chain of plane
+		// rotations, recorded and, if eigenvectors are wanted, applied to
+		// the columns of _eigenvectors together
+		void solveTridiagonal(std::vector<DataType>& e, const bool compute_eigenvectors)
+		{
+			std::vector<DataType>& d = _eigenvalues;
+			const size_t n = d.size();
+			const DataType eps = std::numeric_limits<DataType>::epsilon();
+			std::vector<DataType> cosines(n), sines(n);
+
+			for (size_t l = 0; l < n; ++l)
+			{
+				size_t iterations = 0;
+				while (true)
+				{
+					// Splits off the first block, ending at m, whose
+					// subdiagonal is negligible
+					size_t m = l;
+					for (; m + 1 < n; ++m)
+					{
+						DataType dd = std::abs(d[m]) + std::abs(d[m + 1]);
+						if (std::abs(e[m]) <= eps * dd)
+							break;
+					}
+					if (m == l)
+						break;
+
+					if (++iterations > EIGEN_MAX_ITERATIONS)
+						throw NoConvergence();
+
+					// Shift is the eigenvalue of the leading 2 x 2 block
+					// closer to d[l]
+					DataType g = (d[l + 1] - d[l]) / (2 * e[l]);
+					DataType r = std::hypot(g, DataType(1));
+					g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+
+					DataType s = 1, c = 1, p = 0;
+					size_t i = m;
+					bool underflow = false;
+					while (i-- > l)
+					{
+						DataType f = s * e[i];
+						DataType b = c * e[i];
+						r = std::hypot(f, g);
+						e[i + 1] = r;
+						if (r == DataType(0))
+						{
+							// Rotation underflowed; the matrix has split
+							d[i + 1] -= p;
+							e[m] = 0;
+							underflow = true;
+							break;
+						}
+
+						s = f / r;
+						c = g / r;
+						g = d[i + 1] - p;
+						r = (d[i] - g) * s + 2 * c * b;
+						p = s * r;
+						d[i + 1] = g + p;
+						g = c * r - b;
+						cosines[i] = c;
+						sines[i] = s;
+					}
+
+					if (compute_eigenvectors)
+						applyRotations(cosines, sines, underflow ? i + 1 : l, m);
+
+					if (underflow)
+						continue;
+
+					d[l] -= p;
+					e[l] = g;
+					e[m] = 0;
+				}
+			}
+		}
+
+		// Applies the rotations of a QL sweep, for i from last - 1 down
+		// to first, to columns i and i + 1 of _eigenvectors; the rows are
+		// independent, so large matrices are split into bands of rows
+		// that each thread takes through the whole sweep
+		void applyRotations(const std::vector<DataType>& cosines,
+			const std::vector<DataType>& sines,
+			const size_t first,
+			const size_t last)
+		{
+			const size_t n = _eigenvectors.rows();
+			MatrixView<DataType> Z = _eigenvectors.view();
+
+			auto rotateBand = [&](const size_t row_first, const size_t row_last)
+			{
+				for (size_t i = last; i-- > first; )
+				{
+					const DataType c = cosines[i];
+					const DataType s = sines[i];
+					DataType* z_i = &Z(0, i) + row_first;
+					DataType* z_next = &Z(0, i + 1) + row_first;
+					for (size_t k = 0; k < row_last - row_first; ++k)
+					{
+						DataType f = z_next[k];
+						z_next[k] = s * z_i[k] + c * f;
+						z_i[k] = c * z_i[k] - s * f;
+					}
+				}
+			};
+
+			ThreadPool& pool = defaultThreadPool();
+			const size_t num_threads = pool.numThreads();
+			if (num_threads == 1 || n * (last - first) < EIGEN_PARALLEL_MIN_SIZE)
+			{
+				rotateBand(0, n);
+				return;
+			}
+
+			const size_t band_rows = (n + num_threads - 1) / num_threads;
+			const size_t num_bands = (n + band_rows - 1) / band_rows;
+			pool.parallelFor(num_bands, [&](const size_t band)
+			{
+				size_t row_first = band * band_rows;
+				rotateBand(row_first, std::min(row_first + band_rows, n));
+			});
+		}
+
+		// Turns the eigenvectors of T into those of A, V = Q Z, by
+		// applying the reflectors left in reduced as one block reflector
+		// per panel, last panel first; each is three GEMMs across
+		// defaultThreadPool()
+		void transformBack(const MatrixView<const DataType>& reduced,
+			const std::vector<DataType>& tau)
+		{
+			const size_t n = reduced.rows();
+			const size_t num_reflectors = n - 1;
+			const size_t num_blocks = (num_reflectors + EIGEN_BLOCK_SIZE - 1) / EIGEN_BLOCK_SIZE;
+			MatrixView<DataType> Z = _eigenvectors.view();
+
+			for (size_t block = num_blocks; block-- > 0; )
+			{
+				const size_t first = block * EIGEN_BLOCK_SIZE;
+				const size_t last = std::min(first + EIGEN_BLOCK_SIZE, num_reflectors);
+				MatrixView<const DataType> V = reduced.subView(first + 1, n, first, last);
+
+				DenseMatrix<DataType> T(last - first, last - first);
+				householderBlockFactor(V, &tau[first], T.view());
+				applyHouseholderBlock(V, T.view(), Z.subView(first + 1, n, 0, n),
+					TransposeOp::NoTranspose);
+			}
+		}
+
+		// Sorts the eigenvalues in ascending order, moving the
+		// eigenvectors with them
+		void sortEigenpairs()
+		{
+			const size_t n = size();
+			std::vector<size_t> order(n);
+			std::iota(order.begin(), order.end(), size_t(0));
+			std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
+			{
+				return _eigenvalues[a] < _eigenvalues[b];
+			});
+
+			std::vector<DataType> sorted(n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				sorted[i] = _eigenvalues[order[i]];
+			}
+			_eigenvalues = std::move(sorted);
+
+			if (!hasEigenvectors())
+				return;
+
+			DenseMatrix<DataType> vectors(n, n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				vectors.colView(i).assign(
+					static_cast<const DenseMatrix<DataType>&>(_eigenvectors).colView(order[i]));
+			}
+			_eigenvectors = std::move(vectors);
+		}
+
+		// Diagonal of the tridiagonal matrix while it is reduced, then
+		// the eigenvalues
+		std::vector<DataType> _eigenvalues;
+
+		// Eigenvectors as columns, ColumnMajor so that every rotation
+		// runs down two contiguous columns
+		DenseMatrix<DataType> _eigenvectors;
+	};
+}
+
+#endif
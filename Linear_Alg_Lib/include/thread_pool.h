@@ -0,0 +1,158 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------
+// Persistent pool of worker threads shared by the parallel algorithms
+// in the library; threads are created once and sleep between jobs, so
+// parallel regions don't pay for thread creation
+// Scheduling is work-stealing: each worker pushes the tasks it spawns
+// onto its own deque and runs them newest first, which keeps recursive
+// algorithms depth-first and cache-friendly, while idle workers steal
+// the oldest, and therefore largest, tasks from the others
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	class ThreadPool
+	{
+	public:
+
+		// Creates a pool that runs jobs on num_threads threads in total;
+		// the thread that calls parallelFor() counts as one of them, so
+		// num_threads - 1 workers are started; 0 is treated as 1
+		explicit ThreadPool(const size_t num_threads);
+
+		// Waits for the workers to finish any queued work and joins them
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Returns number of threads that take part in a parallelFor(),
+		// including the calling thread
+		size_t numThreads() const
+		{
+			return _workers.size() + 1;
+		}
+
+		// Calls task(i) for every i in [0, num_tasks) across the pool and
+		// returns once all calls have finished; tasks are handed out one
+		// at a time, so uneven tasks still balance
+		// If a task throws, the remaining tasks still run and the first
+		// exception is rethrown on the calling thread
+		// Calls made from inside a task run serially on that thread
+		void parallelFor(const size_t num_tasks,
+			const std::function<void(size_t)>& task);
+
+		// Queues task to run on the pool; from a worker of this pool it
+		// goes on that worker's own deque, otherwise on a shared queue
+		// Most code should use TaskGroup instead, which tracks completion
+		void submit(std::function<void()> task);
+
+		// Runs one queued task on the calling thread, stealing from the
+		// workers if needed; returns false if no task was found
+		bool runPendingTask();
+
+		// Returns true if the calling thread is a worker of any pool
+		static bool onWorkerThread();
+
+	private:
+
+		// Deque of tasks owned by one worker; the owner pushes and pops at
+		// the back, and thieves take from the front
+		struct WorkerQueue
+		{
+			std::deque<std::function<void()> > tasks;
+			std::mutex mutex;
+		};
+
+		// Main loop of every worker thread
+		void workerLoop(const size_t index);
+
+		// Takes the next task for the thread with given worker index, or
+		// for a thread outside the pool if index is numThreads(); looks
+		// at the thread's own deque, then the shared queue, then steals
+		bool popTask(const size_t index, std::function<void()>& task);
+
+		std::vector<std::thread> _workers;
+		std::vector<std::unique_ptr<WorkerQueue> > _local_queues;
+
+		// Tasks submitted from threads outside the pool
+		std::deque<std::function<void()> > _shared_queue;
+		std::mutex _shared_mutex;
+
+		// Number of tasks in all queues; sleeping workers wait on
+		// _sleep_cv until it becomes nonzero
+		std::atomic<size_t> _queued_tasks;
+		std::mutex _sleep_mutex;
+		std::condition_variable _sleep_cv;
+		bool _stopping;
+	};
+
+	// Group of tasks run on a ThreadPool whose completion can be waited
+	// on together; tasks may spawn further groups of their own, as in
+	// recursive divide-and-conquer algorithms
+	class TaskGroup
+	{
+	public:
+
+		// Creates an empty group that runs its tasks on given pool
+		explicit TaskGroup(ThreadPool& pool);
+
+		// Waits for any tasks still running; exceptions they threw are
+		// discarded, so call wait() to see them
+		~TaskGroup();
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		// Starts task on the pool; on a single-threaded pool it runs
+		// immediately on the calling thread
+		void run(std::function<void()> task);
+
+		// Returns once every task started by run() has finished; the
+		// calling thread runs queued tasks, possibly from other groups,
+		// while it waits, and only blocks once none are left
+		// Rethrows the first exception thrown by a task of the group
+		void wait();
+
+	private:
+
+		// Completion state shared with the queued tasks
+		struct State
+		{
+			std::atomic<size_t> pending;
+			std::mutex mutex;
+			std::condition_variable finished_cv;
+			std::exception_ptr error;
+		};
+
+		ThreadPool& _pool;
+		std::shared_ptr<State> _state;
+	};
+
+	// Returns the pool used by the library's parallel algorithms; created
+	// on first use with one thread per hardware thread
+	ThreadPool& defaultThreadPool();
+
+	// Sets number of threads used by the library's parallel algorithms;
+	// 1 makes every algorithm serial, and 0 restores the default of one
+	// thread per hardware thread
+	// Must not be called while a parallel algorithm is running
+	void setNumThreads(const size_t num_threads);
+
+	// Returns number of threads used by the library's parallel algorithms
+	size_t getNumThreads();
+}
+
+#endif
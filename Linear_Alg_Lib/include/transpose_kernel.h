@@ -0,0 +1,179 @@
+#ifndef TRANSPOSE_KERNEL_H
+#define TRANSPOSE_KERNEL_H
+
+#include <vector>
+#include <algorithm>
+
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+// ------------------------------------------------------------------
+// Cache-blocked matrix transposes, used to convert dense data between
+// row major and column major order; the matrix is walked in square
+// tiles small enough that the source and destination of a tile both
+// stay in L1, and each tile is transposed in registers by
+// transposeKernel() in simd_kernels.h
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Side of the square tiles the transposes work on
+	const size_t TRANSPOSE_TILE = 32;
+
+	// Transposes with fewer elements than this run on one thread
+	const size_t TRANSPOSE_PARALLEL_MIN_SIZE = 1 << 18;
+
+	// Non-square matrices with at least this many elements are converted
+	// in place by DenseMatrix, trading speed for not allocating a second
+	// copy of the data; see transposeInPlace()
+	const size_t TRANSPOSE_IN_PLACE_MIN_SIZE = 1 << 24;
+
+	// Transposes the rows x cols matrix at src, whose rows start src_ld
+	// elements apart, into dst, whose rows start dst_ld elements apart;
+	// src and dst must not overlap
+	// Large matrices are split into bands of tile rows across
+	// defaultThreadPool()
+	template <typename DataType>
+	inline void transposeInto(const DataType* src,
+		const size_t src_ld,
+		DataType* dst,
+		const size_t dst_ld,
+		const size_t rows,
+		const size_t cols)
+	{
+		const size_t num_bands = (rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+
+		auto transposeBand = [&](const size_t band)
+		{
+			size_t first_row = band * TRANSPOSE_TILE;
+			size_t band_rows = std::min(TRANSPOSE_TILE, rows - first_row);
+
+			for (size_t first_col = 0; first_col < cols; first_col += TRANSPOSE_TILE)
+			{
+				size_t tile_cols = std::min(TRANSPOSE_TILE, cols - first_col);
+				transposeKernel(src + first_row * src_ld + first_col, src_ld,
+					dst + first_col * dst_ld + first_row, dst_ld,
+					band_rows, tile_cols);
+			}
+		};
+
+		if (rows * cols < TRANSPOSE_PARALLEL_MIN_SIZE)
+		{
+			for (size_t band = 0; band < num_bands; ++band)
+			{
+				transposeBand(band);
+			}
+			return;
+		}
+
+		defaultThreadPool().parallelFor(num_bands, transposeBand);
+	}
+
+	// Transposes the n x n matrix at data, whose rows start ld elements
+	// apart, in place; tiles above the diagonal are swapped with their
+	// mirror images below it through a small buffer on the stack, and
+	// rows of tiles run in parallel for large matrices
+	template <typename DataType>
+	inline void transposeSquareInPlace(DataType* data,
+		const size_t ld,
+		const size_t n)
+	{
+		const size_t num_tiles = (n + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+
+		auto transposeTileRow = [&](const size_t tile_row)
+		{
+			DataType buffer[TRANSPOSE_TILE * TRANSPOSE_TILE];
+
+			size_t first_row = tile_row * TRANSPOSE_TILE;
+			size_t tile_rows = std::min(TRANSPOSE_TILE, n - first_row);
+			DataType* diagonal = data + first_row * ld + first_row;
+
+			// Tile on the diagonal is transposed into the buffer and
+			// copied back
+			transposeKernel(diagonal, ld, buffer, TRANSPOSE_TILE,
+				tile_rows, tile_rows);
+			for (size_t i = 0; i < tile_rows; ++i)
+			{
+				std::copy(buffer + i * TRANSPOSE_TILE,
+					buffer + i * TRANSPOSE_TILE + tile_rows, diagonal + i * ld);
+			}
+
+			for (size_t first_col = first_row + TRANSPOSE_TILE; first_col < n;
+				first_col += TRANSPOSE_TILE)
+			{
+				size_t tile_cols = std::min(TRANSPOSE_TILE, n - first_col);
+				DataType* upper = data + first_row * ld + first_col;
+				DataType* lower = data + first_col * ld + first_row;
+
+				transposeKernel(upper, ld, buffer, TRANSPOSE_TILE,
+					tile_rows, tile_cols);
+				transposeKernel(lower, ld, upper, ld,
+					tile_cols, tile_rows);
+
+				for (size_t i = 0; i < tile_cols; ++i)
+				{
+					std::copy(buffer + i * TRANSPOSE_TILE,
+						buffer + i * TRANSPOSE_TILE + tile_rows, lower + i * ld);
+				}
+			}
+		};
+
+		if (n * n < TRANSPOSE_PARALLEL_MIN_SIZE)
+		{
+			for (size_t tile_row = 0; tile_row < num_tiles; ++tile_row)
+			{
+				transposeTileRow(tile_row);
+			}
+			return;
+		}
+
+		defaultThreadPool().parallelFor(num_tiles, transposeTileRow);
+	}
+
+	// Transposes the rows x cols matrix stored contiguously in row major
+	// order at data in place, so it then holds the cols x rows transpose
+	// in row major order; equivalently, converts a row major matrix to
+	// column major or the reverse
+	// Square matrices are transposed tile by tile; other shapes follow
+	// the cycles of the permutation that maps index i to
+	// i * rows mod (size - 1), which needs one bit of extra memory per
+	// element instead of a second copy of the data, but runs on one
+	// thread and reads memory in a scattered order
+	template <typename DataType>
+	inline void transposeInPlace(DataType* data,
+		const size_t rows,
+		const size_t cols)
+	{
+		if (rows == cols)
+		{
+			transposeSquareInPlace(data, cols, rows);
+			return;
+		}
+
+		const size_t size = rows * cols;
+		if (rows <= 1 || cols <= 1)
+			return;
+
+		// The first and last elements never move
+		std::vector<bool> visited(size, false);
+		for (size_t start = 1; start < size - 1; ++start)
+		{
+			if (visited[start])
+				continue;
+
+			// Moves each element of the cycle to its destination, carrying
+			// the element it displaces to the next step
+			DataType carried = data[start];
+			size_t i = start;
+			do
+			{
+				i = static_cast<size_t>(
+					(static_cast<unsigned long long>(i) * rows) % (size - 1));
+				std::swap(carried, data[i]);
+				visited[i] = true;
+			} while (i != start);
+		}
+	}
+}
+
+#endif
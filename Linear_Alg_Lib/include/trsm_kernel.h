@@ -0,0 +1,261 @@
+#ifndef TRSM_KERNEL_H
+#define TRSM_KERNEL_H
+
+#include <algorithm>
+
+#include "matrix_view.h"
+#include "matrix_utils.h"
+#include "exceptions.h"
+#include "simd_kernels.h"
+#include "gemv_kernel.h"
+#include "gemm_kernel.h"
+#include "thread_pool.h"
+
+// ------------------------------------------------------------------
+// Triangular solve engine, for one right hand side (TRSV) or a matrix
+// of them (TRSM); the triangle is split into diagonal blocks, solved by
+// substitution, and the rectangles between them are applied as GEMV or
+// GEMM updates, so nearly all the work streams through memory in
+// storage order with the vectorized kernels, and nothing is allocated
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Rows and columns of the diagonal blocks solved by substitution
+	const size_t TRIANGULAR_BLOCK_SIZE = 64;
+
+	// Solves with a matrix of right hand sides with fewer multiply-adds
+	// than this run on one thread
+	const size_t TRSM_PARALLEL_MIN_WORK = 1 << 18;
+
+	// Computes y -= A * x, reading A in storage order; x and y are
+	// contiguous and must not overlap
+	template <typename DataType>
+	inline void trsvUpdate(const ConstMatrixView<DataType>& A,
+		const DataType* x,
+		DataType* y)
+	{
+		if (A.getStorageType() == StorageType::RowMajor)
+			gemvRows(A, x, VectorView<DataType>(y, A.rows()), DataType(-1), DataType(1));
+		else
+			gemvCols(A, VectorView<const DataType>(x, A.cols()), y, DataType(-1));
+	}
+
+	// Overwrites the contiguous x with the solution of Ax = x by plain
+	// substitution; RowMajor triangles take a dot product with each row,
+	// and ColumnMajor triangles subtract each solved column from the rest
+	// of x, so both read A one contiguous line at a time
+	template <typename DataType>
+	inline void trsvUnblocked(const ConstMatrixView<DataType>& A,
+		const TriangleType uplo,
+		const DiagonalType diag,
+		DataType* x)
+	{
+		const size_t n = A.rows();
+		const size_t ld = A.leadingDim();
+		const DataType* a = A.data();
+		const bool unit = (diag == DiagonalType::Unit);
+
+		if (A.getStorageType() == StorageType::RowMajor)
+		{
+			if (uplo == TriangleType::Lower)
+			{
+				for (size_t i = 0; i < n; ++i)
+				{
+					x[i] -= dotKernel(a + i * ld, x, i);
+					if (!unit)
+						x[i] /= a[i * ld + i];
+				}
+			}
+			else
+			{
+				for (size_t i = n; i-- > 0; )
+				{
+					x[i] -= dotKernel(a + i * ld + i + 1, x + i + 1, n - i - 1);
+					if (!unit)
+						x[i] /= a[i * ld + i];
+				}
+			}
+			return;
+		}
+
+		if (uplo == TriangleType::Lower)
+		{
+			for (size_t k = 0; k < n; ++k)
+			{
+				if (!unit)
+					x[k] /= a[k * ld + k];
+				if (x[k] != DataType(0))
+					axpyKernel(-x[k], a + k * ld + k + 1, x + k + 1, n - k - 1);
+			}
+		}
+		else
+		{
+			for (size_t k = n; k-- > 0; )
+			{
+				if (!unit)
+					x[k] /= a[k * ld + k];
+				if (x[k] != DataType(0))
+					axpyKernel(-x[k], a + k * ld, x, k);
+			}
+		}
+	}
+
+	// Overwrites the contiguous x with the solution of Ax = x, where A is
+	// the given triangle of a square view; diagonal blocks are solved in
+	// order by trsvUnblocked()
+	// RowMajor triangles first subtract the already solved part of x
+	// from each block, a row-wise GEMV, and ColumnMajor triangles subtract
+	// each solved block from the part of x still to come, a column-wise
+	// GEMV, so every update runs along the lines A is stored in
+	template <typename DataType>
+	inline void trsvBlocked(const ConstMatrixView<DataType>& A,
+		const TriangleType uplo,
+		const DiagonalType diag,
+		DataType* x)
+	{
+		const size_t n = A.rows();
+		const size_t nb = TRIANGULAR_BLOCK_SIZE;
+		const size_t num_blocks = (n + nb - 1) / nb;
+		const bool lower = (uplo == TriangleType::Lower);
+		const bool row_major = (A.getStorageType() == StorageType::RowMajor);
+
+		for (size_t b = 0; b < num_blocks; ++b)
+		{
+			const size_t block = lower ? b : num_blocks - 1 - b;
+			const size_t first = block * nb;
+			const size_t last = std::min(first + nb, n);
+
+			if (row_major)
+			{
+				if (lower && first > 0)
+					trsvUpdate(A.subView(first, last, 0, first), x, x + first);
+				else if (!lower && last < n)
+					trsvUpdate(A.subView(first, last, last, n), x + last, x + first);
+			}
+
+			trsvUnblocked(A.subView(first, last, first, last), uplo, diag, x + first);
+
+			if (!row_major)
+			{
+				if (lower && last < n)
+					trsvUpdate(A.subView(last, n, first, last), x + first, x + last);
+				else if (!lower && first > 0)
+					trsvUpdate(A.subView(0, first, first, last), x + first, x);
+			}
+		}
+	}
+
+	// Overwrites B with the solution of AX = B, where A is a triangle
+	// that fits in cache; ColumnMajor columns of B are solved one at a
+	// time, and RowMajor B is solved a whole row at a time, with each
+	// solved row subtracted from the rows still to come
+	template <typename DataType>
+	inline void trsmUnblocked(const ConstMatrixView<DataType>& A,
+		const TriangleType uplo,
+		const DiagonalType diag,
+		const MatrixView<DataType>& B)
+	{
+		if (B.getStorageType() == StorageType::ColumnMajor)
+		{
+			for (size_t j = 0; j < B.cols(); ++j)
+			{
+				trsvUnblocked(A, uplo, diag, B.col(j).data());
+			}
+			return;
+		}
+
+		const size_t n = A.rows();
+		const size_t p = B.cols();
+		const bool lower = (uplo == TriangleType::Lower);
+
+		for (size_t step = 0; step < n; ++step)
+		{
+			const size_t i = lower ? step : n - 1 - step;
+			DataType* row_i = B.row(i).data();
+			if (diag == DiagonalType::NonUnit)
+				B.row(i).scale(1 / A(i, i));
+
+			const size_t first = lower ? i + 1 : 0;
+			const size_t last = lower ? n : i;
+			for (size_t k = first; k < last; ++k)
+			{
+				DataType factor = A(k, i);
+				if (factor != DataType(0))
+					axpyKernel(-factor, row_i, B.row(k).data(), p);
+			}
+		}
+	}
+
+	// Overwrites B with the solution of AX = B on the calling thread;
+	// after each diagonal block of rows is solved, the rows below it, or
+	// above it for an upper triangle, are updated by one GEMM
+	template <typename DataType>
+	inline void trsmBlocked(const ConstMatrixView<DataType>& A,
+		const TriangleType uplo,
+		const DiagonalType diag,
+		const MatrixView<DataType>& B)
+	{
+		const size_t n = A.rows();
+		const size_t p = B.cols();
+		const size_t nb = TRIANGULAR_BLOCK_SIZE;
+		const size_t num_blocks = (n + nb - 1) / nb;
+		const bool lower = (uplo == TriangleType::Lower);
+
+		for (size_t b = 0; b < num_blocks; ++b)
+		{
+			const size_t block = lower ? b : num_blocks - 1 - b;
+			const size_t first = block * nb;
+			const size_t last = std::min(first + nb, n);
+			MatrixView<DataType> B_block = B.subView(first, last, 0, p);
+
+			trsmUnblocked(A.subView(first, last, first, last), uplo, diag, B_block);
+
+			if (lower && last < n)
+			{
+				gemmBlocked(A.subView(last, n, first, last), B_block,
+					B.subView(last, n, 0, p), GemmBlockSizes(), -1, 1);
+			}
+			else if (!lower && first > 0)
+			{
+				gemmBlocked(A.subView(0, first, first, last), B_block,
+					B.subView(0, first, 0, p), GemmBlockSizes(), -1, 1);
+			}
+		}
+	}
+
+	// Overwrites B with the solution of AX = B; columns of B are
+	// independent, so large solves split them into one group per thread
+	// of given pool, each solved by trsmBlocked()
+	template <typename DataType>
+	inline void trsmParallel(const ConstMatrixView<DataType>& A,
+		const TriangleType uplo,
+		const DiagonalType diag,
+		const MatrixView<DataType>& B,
+		ThreadPool& pool = defaultThreadPool())
+	{
+		if (!A.isSquare() || A.rows() != B.rows())
+			throw InvalidDimensions();
+
+		const size_t n = A.rows();
+		const size_t p = B.cols();
+		const size_t num_threads = pool.numThreads();
+
+		if (num_threads == 1 || p < 2 || n * n * p < TRSM_PARALLEL_MIN_WORK)
+		{
+			trsmBlocked(A, uplo, diag, B);
+			return;
+		}
+
+		const size_t group_cols = (p + num_threads - 1) / num_threads;
+		const size_t num_groups = (p + group_cols - 1) / group_cols;
+		pool.parallelFor(num_groups, [&](const size_t group)
+		{
+			size_t first = group * group_cols;
+			size_t last = std::min(first + group_cols, p);
+			trsmBlocked(A, uplo, diag, B.subView(0, n, first, last));
+		});
+	}
+}
+
+#endif
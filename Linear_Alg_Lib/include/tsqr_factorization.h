@@ -0,0 +1,315 @@
+#ifndef TSQR_FACTORIZATION_H
+#define TSQR_FACTORIZATION_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <limits>
+
+#include "dense_matrix.h"
+#include "math_vector.h"
+#include "matrix_view.h"
+#include "simd_kernels.h"
+#include "qr_factorization.h"
+#include "trsm_kernel.h"
+#include "thread_pool.h"
+#include "exceptions.h"
+
+// ------------------------------------------------------------------
+// Tall-skinny QR (TSQR) of a matrix with many more rows than columns,
+// fed in as batches of rows; every batch is reduced to a small R
+// factor, and the Rs are merged pairwise up a tree, so only the current
+// batch and O(log(batches)) R factors are ever held in memory
+// Right hand sides can be streamed alongside the rows, which turns the
+// final R into the least squares solution and its residual norms
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	// Fewest rows of a batch reduced by one thread; smaller blocks spend
+	// more time merging than they save
+	const size_t TSQR_MIN_BLOCK_ROWS = 1024;
+
+	template <typename DataType>
+	class TSQRFactorization
+	{
+		static_assert(std::is_floating_point<DataType>::value,
+			"TSQRFactorization requires a floating point data type");
+
+	public:
+
+		// Constructor; creates an empty factorization of a matrix with
+		// given number of columns, and of rhs_cols right hand side
+		// columns that are fed in with every batch
+		explicit TSQRFactorization(const size_t cols_in,
+			const size_t rhs_cols_in = 0) :
+			_rows(0),
+			_cols(cols_in),
+			_rhs_cols(rhs_cols_in)
+		{ }
+
+		// Returns number of rows fed in so far
+		size_t rows() const
+		{
+			return _rows;
+		}
+
+		size_t cols() const
+		{
+			return _cols;
+		}
+
+		size_t rhsCols() const
+		{
+			return _rhs_cols;
+		}
+
+		// Appends given rows of A; throws InvalidDimensions if the number
+		// of columns is wrong, or if right hand sides are expected
+		template <typename MatrixDataType>
+		void addBatch(const DenseMatrix<MatrixDataType>& A_batch)
+		{
+			addBatch(A_batch.view());
+		}
+
+		// View version of addBatch
+		template <typename ViewDataType>
+		void addBatch(const MatrixView<ViewDataType>& A_batch)
+		{
+			if (_rhs_cols != 0)
+				throw InvalidDimensions();
+
+			addBatch(A_batch, MatrixView<const DataType>(nullptr, A_batch.rows(), 0,
+				StorageType::ColumnMajor));
+		}
+
+		// Appends given rows of A together with the matching rows of the
+		// right hand sides B
+		template <typename MatrixDataType, typename RhsDataType>
+		void addBatch(const DenseMatrix<MatrixDataType>& A_batch,
+			const DenseMatrix<RhsDataType>& B_batch)
+		{
+			addBatch(A_batch.view(), B_batch.view());
+		}
+
+		// Appends given rows of A together with the matching elements of
+		// the single right hand side b
+		template <typename MatrixDataType, typename VectorDataType>
+		void addBatch(const DenseMatrix<MatrixDataType>& A_batch,
+			const MathVector<VectorDataType>& b_batch)
+		{
+			VectorView<const VectorDataType> b = b_batch.view();
+			addBatch(A_batch.view(), MatrixView<const VectorDataType>(
+				b.data(), b.size(), 1, StorageType::ColumnMajor));
+		}
+
+		// View version of addBatch with right hand sides; the rows of the
+		// batch are split into blocks that are reduced on separate
+		// threads, and the blocks' R factors are merged pairwise in
+		// parallel into one R for the whole batch, which then joins the
+		// tree of earlier batches
+		template <typename ViewDataType, typename RhsDataType>
+		void addBatch(const MatrixView<ViewDataType>& A_batch,
+			const MatrixView<RhsDataType>& B_batch)
+		{
+			if (A_batch.cols() != _cols || B_batch.cols() != _rhs_cols ||
+				A_batch.rows() != B_batch.rows())
+			{
+				throw InvalidDimensions();
+			}
+
+			const size_t m = A_batch.rows();
+			if (m == 0)
+				return;
+
+			ThreadPool& pool = defaultThreadPool();
+			const size_t block_rows = std::max(std::max(TSQR_MIN_BLOCK_ROWS, width()),
+				(m + pool.numThreads() - 1) / pool.numThreads());
+			const size_t num_blocks = (m + block_rows - 1) / block_rows;
+
+			std::vector<DenseMatrix<DataType> > factors(num_blocks,
+				DenseMatrix<DataType>(0, width()));
+			pool.parallelFor(num_blocks, [&](const size_t block)
+			{
+				size_t first = block * block_rows;
+				size_t last = std::min(first + block_rows, m);
+
+				// [A B] for the rows of this block, in the ColumnMajor
+				// layout that QRFactorization works in
+				DenseMatrix<DataType> stacked(last - first, width());
+				stacked.subMatrixView(0, last - first, 0, _cols).assign(
+					A_batch.subView(first, last, 0, _cols));
+				if (_rhs_cols != 0)
+				{
+					stacked.subMatrixView(0, last - first, _cols, width()).assign(
+						B_batch.subView(first, last, 0, _rhs_cols));
+				}
+				factors[block] = reduce(std::move(stacked));
+			});
+
+			push(mergeAll(std::move(factors)));
+			_rows += m;
+		}
+
+		// Returns the min(m, n) x n upper triangular factor R of all rows
+		// fed in so far; A = QR, with Q never formed
+		DenseMatrix<DataType> upper() const
+		{
+			DenseMatrix<DataType> R = combined();
+			return R.getSubMatrix(0, std::min(R.rows(), _cols), 0, _cols);
+		}
+
+		// Returns the n x rhsCols() matrix X that minimizes ||AX - B|| for
+		// all rows fed in so far; throws InvalidDimensions if there are no
+		// right hand sides or fewer rows than columns, and SingularMatrix if
+		// the columns of A aren't linearly independent
+		DenseMatrix<DataType> solve() const
+		{
+			if (_rhs_cols == 0 || _rows < _cols)
+				throw InvalidDimensions();
+
+			DenseMatrix<DataType> R = combined();
+			checkFullRank(R);
+
+			// R = [R11 R12; 0 R22], and R11 X = R12
+			DenseMatrix<DataType> X(R.subMatrixView(0, _cols, _cols, width()),
+				StorageType::ColumnMajor);
+			trsmParallel(R.subMatrixView(0, _cols, 0, _cols),
+				TriangleType::Upper, DiagonalType::NonUnit, X.view());
+			return X;
+		}
+
+		// Returns ||Ax - b|| of the least squares solution for every right
+		// hand side, read from the part of R below the rows of A's factor
+		std::vector<DataType> residualNorms() const
+		{
+			if (_rows < _cols)
+				throw InvalidDimensions();
+
+			DenseMatrix<DataType> R = combined();
+			std::vector<DataType> norms(_rhs_cols);
+			for (size_t j = 0; j < _rhs_cols; ++j)
+			{
+				size_t last = std::min(R.rows(), _cols + j + 1);
+				const DataType* tail = R.colView(_cols + j).data() + _cols;
+				norms[j] = std::sqrt(dotKernel(tail, tail, last - _cols));
+			}
+			return norms;
+		}
+
+	private:
+
+		// Returns number of columns of A and B together
+		size_t width() const
+		{
+			return _cols + _rhs_cols;
+		}
+
+		// Returns R factor of given rows
+		static DenseMatrix<DataType> reduce(DenseMatrix<DataType>&& stacked)
+		{
+			return QRFactorization<DataType>(std::move(stacked)).upper();
+		}
+
+		// Returns R factor of the rows of two R factors stacked on top of
+		// each other, which is the R factor of all rows they came from
+		static DenseMatrix<DataType> merge(const DenseMatrix<DataType>& R1,
+			const DenseMatrix<DataType>& R2)
+		{
+			DenseMatrix<DataType> stacked(R1.rows() + R2.rows(), R1.cols());
+			stacked.subMatrixView(0, R1.rows(), 0, R1.cols()).assign(R1.view());
+			stacked.subMatrixView(R1.rows(), stacked.rows(), 0, R1.cols()).assign(R2.view());
+			return reduce(std::move(stacked));
+		}
+
+		// Merges given R factors pairwise, one tree level at a time, with
+		// the pairs of a level merged in parallel
+		static DenseMatrix<DataType> mergeAll(std::vector<DenseMatrix<DataType> >&& factors)
+		{
+			while (factors.size() > 1)
+			{
+				const size_t num_pairs = factors.size() / 2;
+				std::vector<DenseMatrix<DataType> > merged((factors.size() + 1) / 2,
+					DenseMatrix<DataType>(0, factors.front().cols()));
+				defaultThreadPool().parallelFor(num_pairs, [&](const size_t pair)
+				{
+					merged[pair] = merge(factors[2 * pair], factors[2 * pair + 1]);
+				});
+
+				if (factors.size() % 2 != 0)
+					merged.back() = std::move(factors.back());
+				factors = std::move(merged);
+			}
+			return std::move(factors.front());
+		}
+
+		// Adds the R factor of a batch to the tree of earlier batches;
+		// _levels works like a binary counter, where level i holds the R
+		// of 2^i batches, and adding a batch merges up through every
+		// occupied level, so the tree is never more than log2(batches)
+		// factors wide
+		void push(DenseMatrix<DataType>&& R)
+		{
+			size_t level = 0;
+			for (; level < _levels.size() && _levels[level].rows() != 0; ++level)
+			{
+				R = merge(_levels[level], R);
+				_levels[level] = DenseMatrix<DataType>(0, width());
+			}
+
+			if (level == _levels.size())
+				_levels.push_back(std::move(R));
+			else
+				_levels[level] = std::move(R);
+		}
+
+		// Returns R factor of [A B] for all rows fed in so far, merging
+		// every level of the tree without changing it
+		DenseMatrix<DataType> combined() const
+		{
+			DenseMatrix<DataType> R(0, width());
+			for (const DenseMatrix<DataType>& factor : _levels)
+			{
+				if (factor.rows() == 0)
+					continue;
+				R = (R.rows() == 0) ? factor : merge(factor, R);
+			}
+			return R;
+		}
+
+		// Throws SingularMatrix unless the diagonal of the leading n x n
+		// block of R is nonzero, judged with the same relative tolerance
+		// as QRFactorization::isFullRank()
+		void checkFullRank(const DenseMatrix<DataType>& R) const
+		{
+			DataType max_diag = 0;
+			for (size_t k = 0; k < _cols; ++k)
+			{
+				max_diag = std::max(max_diag, std::abs(R.at(k, k)));
+			}
+
+			const DataType tolerance = max_diag * static_cast<DataType>(_rows) *
+				std::numeric_limits<DataType>::epsilon();
+			for (size_t k = 0; k < _cols; ++k)
+			{
+				if (!(std::abs(R.at(k, k)) > tolerance))
+					throw SingularMatrix();
+			}
+		}
+
+		// Number of rows fed in so far
+		size_t _rows;
+
+		size_t _cols;
+
+		size_t _rhs_cols;
+
+		// R factors of groups of batches; level i is either empty, with
+		// no rows, or the R of 2^i batches
+		std::vector<DenseMatrix<DataType> > _levels;
+	};
+}
+
+#endif
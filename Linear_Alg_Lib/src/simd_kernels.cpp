@@ -0,0 +1,1158 @@
+#include "../include/simd_kernels.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LINALG_X86
+#if defined(__x86_64__) || defined(_M_X64)
+#define LINALG_X64
+#endif
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit instructions for sets enabled on the command
+// line unless a function opts in with a target attribute; MSVC always
+// allows intrinsics, so the attribute expands to nothing there
+#if defined(__GNUC__) || defined(__clang__)
+#define LINALG_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LINALG_TARGET(isa)
+#endif
+
+// ------------------------------------------------------------------
+// Implementation of simd_kernels.h
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	namespace
+	{
+		// Queries the CPU and OS for supported instruction sets
+		SimdLevel detectSimdLevel()
+		{
+#if !defined(LINALG_X86)
+			return SimdLevel::Scalar;
+#elif defined(__GNUC__) || defined(__clang__)
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") &&
+				__builtin_cpu_supports("avx512dq"))
+			{
+				return SimdLevel::AVX512;
+			}
+			if (__builtin_cpu_supports("avx2") &&
+				__builtin_cpu_supports("fma"))
+			{
+				return SimdLevel::AVX2;
+			}
+			if (__builtin_cpu_supports("sse2"))
+				return SimdLevel::SSE2;
+			return SimdLevel::Scalar;
+#else
+			int info[4];
+			__cpuid(info, 0);
+			int max_leaf = info[0];
+
+			__cpuid(info, 1);
+			bool sse2 = (info[3] & (1 << 26)) != 0;
+			bool fma = (info[2] & (1 << 12)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+
+			// The OS must save the YMM and ZMM registers on context
+			// switches for AVX and AVX-512 to be usable
+			unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+			bool os_avx = (xcr0 & 0x6) == 0x6;
+			bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+			bool avx2 = false, avx512f = false, avx512dq = false;
+			if (max_leaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+				avx512f = (info[1] & (1 << 16)) != 0;
+				avx512dq = (info[1] & (1 << 17)) != 0;
+			}
+
+			if (os_avx512 && avx512f && avx512dq)
+				return SimdLevel::AVX512;
+			if (os_avx && avx && avx2 && fma)
+				return SimdLevel::AVX2;
+			if (sse2)
+				return SimdLevel::SSE2;
+			return SimdLevel::Scalar;
+#endif
+		}
+
+		// Level the kernels dispatch to; starts at the detected level
+		std::atomic<int>& activeLevelStorage()
+		{
+			static std::atomic<int> level(static_cast<int>(detectedSimdLevel()));
+			return level;
+		}
+	}
+
+	// Returns the fastest instruction set supported by the CPU and OS
+	SimdLevel detectedSimdLevel()
+	{
+		static const SimdLevel detected = detectSimdLevel();
+		return detected;
+	}
+
+	// Returns the instruction set the kernels currently dispatch to
+	SimdLevel activeSimdLevel()
+	{
+		return static_cast<SimdLevel>(
+			activeLevelStorage().load(std::memory_order_relaxed));
+	}
+
+	// Sets the instruction set the kernels dispatch to; levels above
+	// detectedSimdLevel() are clamped to it
+	void setSimdLevel(const SimdLevel level)
+	{
+		int clamped = static_cast<int>(level);
+		int detected = static_cast<int>(detectedSimdLevel());
+		if (clamped > detected)
+			clamped = detected;
+
+		activeLevelStorage().store(clamped, std::memory_order_relaxed);
+	}
+
+	// Returns name of given level, such as "AVX2"
+	const char* simdLevelName(const SimdLevel level)
+	{
+		switch (level)
+		{
+		case SimdLevel::SSE2:
+			return "SSE2";
+		case SimdLevel::AVX2:
+			return "AVX2";
+		case SimdLevel::AVX512:
+			return "AVX-512";
+		default:
+			return "Scalar";
+		}
+	}
+
+#if defined(LINALG_X86)
+	namespace
+	{
+		// --------------------------------------------------------------
+		// Register operations for each instruction set and data type;
+		// every struct provides the same interface so the loops below
+		// can be written once per instruction set
+		// gather() loads p[indices[0]], p[indices[1]], ... into a
+		// register and scatter() stores one to the same places; AVX2 and
+		// AVX-512 gather in hardware, which takes 64-bit indices, so only
+		// when size_t is 64 bits, and only AVX-512 scatters in hardware
+		// --------------------------------------------------------------
+
+		// Element by element versions of gather() and scatter(), for
+		// structs whose instruction set has no such instructions
+#define LINALG_LANEWISE_GATHER(isa)                                               \
+		LINALG_TARGET(isa) static Reg gather(const Type* p, const size_t* indices) \
+		{                                                                         \
+			Type lanes[width];                                                    \
+			for (size_t i = 0; i < width; ++i)                                    \
+				lanes[i] = p[indices[i]];                                         \
+			return load(lanes);                                                   \
+		}
+
+#define LINALG_LANEWISE_SCATTER(isa)                                              \
+		LINALG_TARGET(isa) static void scatter(Type* p, const size_t* indices, Reg r) \
+		{                                                                         \
+			Type lanes[width];                                                    \
+			store(lanes, r);                                                      \
+			for (size_t i = 0; i < width; ++i)                                    \
+				p[indices[i]] = lanes[i];                                         \
+		}
+
+		struct Sse2Float
+		{
+			using Type = float;
+			using Reg = __m128;
+			static const size_t width = 4;
+			LINALG_TARGET("sse2") static Reg load(const Type* p) { return _mm_loadu_ps(p); }
+			LINALG_TARGET("sse2") static void store(Type* p, Reg r) { _mm_storeu_ps(p, r); }
+			LINALG_TARGET("sse2") static Reg zero() { return _mm_setzero_ps(); }
+			LINALG_TARGET("sse2") static Reg set1(Type v) { return _mm_set1_ps(v); }
+			LINALG_TARGET("sse2") static Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+			LINALG_TARGET("sse2") static Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+			LINALG_TARGET("sse2") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			LINALG_LANEWISE_GATHER("sse2")
+			LINALG_LANEWISE_SCATTER("sse2")
+		};
+
+		struct Sse2Double
+		{
+			using Type = double;
+			using Reg = __m128d;
+			static const size_t width = 2;
+			LINALG_TARGET("sse2") static Reg load(const Type* p) { return _mm_loadu_pd(p); }
+			LINALG_TARGET("sse2") static void store(Type* p, Reg r) { _mm_storeu_pd(p, r); }
+			LINALG_TARGET("sse2") static Reg zero() { return _mm_setzero_pd(); }
+			LINALG_TARGET("sse2") static Reg set1(Type v) { return _mm_set1_pd(v); }
+			LINALG_TARGET("sse2") static Reg add(Reg a, Reg b) { return _mm_add_pd(a, b); }
+			LINALG_TARGET("sse2") static Reg sub(Reg a, Reg b) { return _mm_sub_pd(a, b); }
+			LINALG_TARGET("sse2") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+			LINALG_LANEWISE_GATHER("sse2")
+			LINALG_LANEWISE_SCATTER("sse2")
+		};
+
+		struct Sse2Int32
+		{
+			using Type = int32_t;
+			using Reg = __m128i;
+			static const size_t width = 4;
+			LINALG_TARGET("sse2") static Reg load(const Type* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+			LINALG_TARGET("sse2") static void store(Type* p, Reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+			LINALG_TARGET("sse2") static Reg zero() { return _mm_setzero_si128(); }
+			LINALG_TARGET("sse2") static Reg set1(Type v) { return _mm_set1_epi32(v); }
+			LINALG_TARGET("sse2") static Reg add(Reg a, Reg b) { return _mm_add_epi32(a, b); }
+			LINALG_TARGET("sse2") static Reg sub(Reg a, Reg b) { return _mm_sub_epi32(a, b); }
+
+			// SSE2 has no 32-bit low multiply; multiply even and odd lanes
+			// as 64-bit products and interleave the low halves back together
+			LINALG_TARGET("sse2") static Reg mul(Reg a, Reg b)
+			{
+				__m128i even = _mm_mul_epu32(a, b);
+				__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+				return _mm_unpacklo_epi32(
+					_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+					_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+			}
+
+			LINALG_TARGET("sse2") static Reg mulAdd(Reg a, Reg b, Reg c) { return add(mul(a, b), c); }
+			LINALG_LANEWISE_GATHER("sse2")
+			LINALG_LANEWISE_SCATTER("sse2")
+		};
+
+		struct Sse2Int64
+		{
+			using Type = int64_t;
+			using Reg = __m128i;
+			static const size_t width = 2;
+			LINALG_TARGET("sse2") static Reg load(const Type* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+			LINALG_TARGET("sse2") static void store(Type* p, Reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+			LINALG_TARGET("sse2") static Reg zero() { return _mm_setzero_si128(); }
+			LINALG_TARGET("sse2") static Reg set1(Type v) { return _mm_set1_epi64x(v); }
+			LINALG_TARGET("sse2") static Reg add(Reg a, Reg b) { return _mm_add_epi64(a, b); }
+			LINALG_TARGET("sse2") static Reg sub(Reg a, Reg b) { return _mm_sub_epi64(a, b); }
+
+			// Low 64 bits of a 64-bit product built from 32-bit products:
+			// lo(a) * lo(b) + ((hi(a) * lo(b) + lo(a) * hi(b)) << 32)
+			LINALG_TARGET("sse2") static Reg mul(Reg a, Reg b)
+			{
+				__m128i lo_lo = _mm_mul_epu32(a, b);
+				__m128i hi_lo = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+				__m128i lo_hi = _mm_mul_epu32(a, _mm_srli_epi64(b, 32));
+				__m128i cross = _mm_slli_epi64(_mm_add_epi64(hi_lo, lo_hi), 32);
+				return _mm_add_epi64(lo_lo, cross);
+			}
+
+			LINALG_TARGET("sse2") static Reg mulAdd(Reg a, Reg b, Reg c) { return add(mul(a, b), c); }
+			LINALG_LANEWISE_GATHER("sse2")
+			LINALG_LANEWISE_SCATTER("sse2")
+		};
+
+		struct Avx2Float
+		{
+			using Type = float;
+			using Reg = __m256;
+			static const size_t width = 8;
+			LINALG_TARGET("avx2,fma") static Reg load(const Type* p) { return _mm256_loadu_ps(p); }
+			LINALG_TARGET("avx2,fma") static void store(Type* p, Reg r) { _mm256_storeu_ps(p, r); }
+			LINALG_TARGET("avx2,fma") static Reg zero() { return _mm256_setzero_ps(); }
+			LINALG_TARGET("avx2,fma") static Reg set1(Type v) { return _mm256_set1_ps(v); }
+			LINALG_TARGET("avx2,fma") static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm256_fmadd_ps(a, b, c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx2,fma") static Reg gather(const Type* p, const size_t* indices)
+			{
+				__m128 low = _mm256_i64gather_ps(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 4);
+				__m128 high = _mm256_i64gather_ps(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + 4)), 4);
+				return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx2,fma")
+#endif
+			LINALG_LANEWISE_SCATTER("avx2,fma")
+		};
+
+		struct Avx2Double
+		{
+			using Type = double;
+			using Reg = __m256d;
+			static const size_t width = 4;
+			LINALG_TARGET("avx2,fma") static Reg load(const Type* p) { return _mm256_loadu_pd(p); }
+			LINALG_TARGET("avx2,fma") static void store(Type* p, Reg r) { _mm256_storeu_pd(p, r); }
+			LINALG_TARGET("avx2,fma") static Reg zero() { return _mm256_setzero_pd(); }
+			LINALG_TARGET("avx2,fma") static Reg set1(Type v) { return _mm256_set1_pd(v); }
+			LINALG_TARGET("avx2,fma") static Reg add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm256_fmadd_pd(a, b, c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx2,fma") static Reg gather(const Type* p, const size_t* indices)
+			{
+				return _mm256_i64gather_pd(p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 8);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx2,fma")
+#endif
+			LINALG_LANEWISE_SCATTER("avx2,fma")
+		};
+
+		struct Avx2Int32
+		{
+			using Type = int32_t;
+			using Reg = __m256i;
+			static const size_t width = 8;
+			LINALG_TARGET("avx2,fma") static Reg load(const Type* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			LINALG_TARGET("avx2,fma") static void store(Type* p, Reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+			LINALG_TARGET("avx2,fma") static Reg zero() { return _mm256_setzero_si256(); }
+			LINALG_TARGET("avx2,fma") static Reg set1(Type v) { return _mm256_set1_epi32(v); }
+			LINALG_TARGET("avx2,fma") static Reg add(Reg a, Reg b) { return _mm256_add_epi32(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg sub(Reg a, Reg b) { return _mm256_sub_epi32(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx2,fma") static Reg gather(const Type* p, const size_t* indices)
+			{
+				const int* base = reinterpret_cast<const int*>(p);
+				__m128i low = _mm256_i64gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 4);
+				__m128i high = _mm256_i64gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + 4)), 4);
+				return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx2,fma")
+#endif
+			LINALG_LANEWISE_SCATTER("avx2,fma")
+		};
+
+		struct Avx2Int64
+		{
+			using Type = int64_t;
+			using Reg = __m256i;
+			static const size_t width = 4;
+			LINALG_TARGET("avx2,fma") static Reg load(const Type* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+			LINALG_TARGET("avx2,fma") static void store(Type* p, Reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+			LINALG_TARGET("avx2,fma") static Reg zero() { return _mm256_setzero_si256(); }
+			LINALG_TARGET("avx2,fma") static Reg set1(Type v) { return _mm256_set1_epi64x(v); }
+			LINALG_TARGET("avx2,fma") static Reg add(Reg a, Reg b) { return _mm256_add_epi64(a, b); }
+			LINALG_TARGET("avx2,fma") static Reg sub(Reg a, Reg b) { return _mm256_sub_epi64(a, b); }
+
+			// AVX2 has no 64-bit low multiply; see Sse2Int64::mul
+			LINALG_TARGET("avx2,fma") static Reg mul(Reg a, Reg b)
+			{
+				__m256i lo_lo = _mm256_mul_epu32(a, b);
+				__m256i hi_lo = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+				__m256i lo_hi = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+				__m256i cross = _mm256_slli_epi64(_mm256_add_epi64(hi_lo, lo_hi), 32);
+				return _mm256_add_epi64(lo_lo, cross);
+			}
+
+			LINALG_TARGET("avx2,fma") static Reg mulAdd(Reg a, Reg b, Reg c) { return add(mul(a, b), c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx2,fma") static Reg gather(const Type* p, const size_t* indices)
+			{
+				return _mm256_i64gather_epi64(reinterpret_cast<const long long*>(p),
+					_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 8);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx2,fma")
+#endif
+			LINALG_LANEWISE_SCATTER("avx2,fma")
+		};
+
+		struct Avx512Float
+		{
+			using Type = float;
+			using Reg = __m512;
+			static const size_t width = 16;
+			LINALG_TARGET("avx512f,avx512dq") static Reg load(const Type* p) { return _mm512_loadu_ps(p); }
+			LINALG_TARGET("avx512f,avx512dq") static void store(Type* p, Reg r) { _mm512_storeu_ps(p, r); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg zero() { return _mm512_setzero_ps(); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg set1(Type v) { return _mm512_set1_ps(v); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm512_fmadd_ps(a, b, c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx512f,avx512dq") static Reg gather(const Type* p, const size_t* indices)
+			{
+				__m256 low = _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xff, _mm512_loadu_si512(indices), p, 4);
+				__m256 high = _mm512_mask_i64gather_ps(_mm256_setzero_ps(), 0xff, _mm512_loadu_si512(indices + 8), p, 4);
+				return _mm512_insertf32x8(_mm512_insertf32x8(_mm512_setzero_ps(), low, 0), high, 1);
+			}
+			LINALG_TARGET("avx512f,avx512dq") static void scatter(Type* p, const size_t* indices, Reg r)
+			{
+				_mm512_i64scatter_ps(p, _mm512_loadu_si512(indices), _mm512_maskz_extractf32x8_ps(0xff, r, 0), 4);
+				_mm512_i64scatter_ps(p, _mm512_loadu_si512(indices + 8), _mm512_maskz_extractf32x8_ps(0xff, r, 1), 4);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx512f,avx512dq")
+			LINALG_LANEWISE_SCATTER("avx512f,avx512dq")
+#endif
+		};
+
+		struct Avx512Double
+		{
+			using Type = double;
+			using Reg = __m512d;
+			static const size_t width = 8;
+			LINALG_TARGET("avx512f,avx512dq") static Reg load(const Type* p) { return _mm512_loadu_pd(p); }
+			LINALG_TARGET("avx512f,avx512dq") static void store(Type* p, Reg r) { _mm512_storeu_pd(p, r); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg zero() { return _mm512_setzero_pd(); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg set1(Type v) { return _mm512_set1_pd(v); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm512_fmadd_pd(a, b, c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx512f,avx512dq") static Reg gather(const Type* p, const size_t* indices)
+			{
+				return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xff, _mm512_loadu_si512(indices), p, 8);
+			}
+			LINALG_TARGET("avx512f,avx512dq") static void scatter(Type* p, const size_t* indices, Reg r)
+			{
+				_mm512_i64scatter_pd(p, _mm512_loadu_si512(indices), r, 8);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx512f,avx512dq")
+			LINALG_LANEWISE_SCATTER("avx512f,avx512dq")
+#endif
+		};
+
+		struct Avx512Int32
+		{
+			using Type = int32_t;
+			using Reg = __m512i;
+			static const size_t width = 16;
+			LINALG_TARGET("avx512f,avx512dq") static Reg load(const Type* p) { return _mm512_loadu_si512(p); }
+			LINALG_TARGET("avx512f,avx512dq") static void store(Type* p, Reg r) { _mm512_storeu_si512(p, r); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg zero() { return _mm512_setzero_si512(); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg set1(Type v) { return _mm512_set1_epi32(v); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg add(Reg a, Reg b) { return _mm512_add_epi32(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg sub(Reg a, Reg b) { return _mm512_sub_epi32(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx512f,avx512dq") static Reg gather(const Type* p, const size_t* indices)
+			{
+				__m256i low = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xff, _mm512_loadu_si512(indices), p, 4);
+				__m256i high = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xff, _mm512_loadu_si512(indices + 8), p, 4);
+				__m512i zero = _mm512_setzero_si512();
+				return _mm512_mask_inserti64x4(zero, 0xff,
+					_mm512_mask_inserti64x4(zero, 0xff, zero, low, 0), high, 1);
+			}
+			LINALG_TARGET("avx512f,avx512dq") static void scatter(Type* p, const size_t* indices, Reg r)
+			{
+				_mm512_i64scatter_epi32(p, _mm512_loadu_si512(indices), _mm512_maskz_extracti64x4_epi64(0xf, r, 0), 4);
+				_mm512_i64scatter_epi32(p, _mm512_loadu_si512(indices + 8), _mm512_maskz_extracti64x4_epi64(0xf, r, 1), 4);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx512f,avx512dq")
+			LINALG_LANEWISE_SCATTER("avx512f,avx512dq")
+#endif
+		};
+
+		struct Avx512Int64
+		{
+			using Type = int64_t;
+			using Reg = __m512i;
+			static const size_t width = 8;
+			LINALG_TARGET("avx512f,avx512dq") static Reg load(const Type* p) { return _mm512_loadu_si512(p); }
+			LINALG_TARGET("avx512f,avx512dq") static void store(Type* p, Reg r) { _mm512_storeu_si512(p, r); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg zero() { return _mm512_setzero_si512(); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg set1(Type v) { return _mm512_set1_epi64(v); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg add(Reg a, Reg b) { return _mm512_add_epi64(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg sub(Reg a, Reg b) { return _mm512_sub_epi64(a, b); }
+			LINALG_TARGET("avx512f,avx512dq") static Reg mulAdd(Reg a, Reg b, Reg c) { return _mm512_add_epi64(_mm512_mullo_epi64(a, b), c); }
+#if defined(LINALG_X64)
+			LINALG_TARGET("avx512f,avx512dq") static Reg gather(const Type* p, const size_t* indices)
+			{
+				return _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xff, _mm512_loadu_si512(indices), p, 8);
+			}
+			LINALG_TARGET("avx512f,avx512dq") static void scatter(Type* p, const size_t* indices, Reg r)
+			{
+				_mm512_i64scatter_epi64(p, _mm512_loadu_si512(indices), r, 8);
+			}
+#else
+			LINALG_LANEWISE_GATHER("avx512f,avx512dq")
+			LINALG_LANEWISE_SCATTER("avx512f,avx512dq")
+#endif
+		};
+
+#undef LINALG_LANEWISE_GATHER
+#undef LINALG_LANEWISE_SCATTER
+
+		// --------------------------------------------------------------
+		// In-register transposes of one square block of elements of a
+		// given size; transposes only move data, so integer types share
+		// the floating point shuffles of the same width
+		// --------------------------------------------------------------
+
+		// 4 x 4 block of 32-bit elements
+		struct Sse2Transpose32
+		{
+			static const size_t size = 4;
+
+			template <typename Type>
+			LINALG_TARGET("sse2") static void transposeBlock(const Type* src,
+				const size_t src_ld, Type* dst, const size_t dst_ld)
+			{
+				__m128 r0 = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+				__m128 r1 = _mm_loadu_ps(reinterpret_cast<const float*>(src + src_ld));
+				__m128 r2 = _mm_loadu_ps(reinterpret_cast<const float*>(src + 2 * src_ld));
+				__m128 r3 = _mm_loadu_ps(reinterpret_cast<const float*>(src + 3 * src_ld));
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				_mm_storeu_ps(reinterpret_cast<float*>(dst), r0);
+				_mm_storeu_ps(reinterpret_cast<float*>(dst + dst_ld), r1);
+				_mm_storeu_ps(reinterpret_cast<float*>(dst + 2 * dst_ld), r2);
+				_mm_storeu_ps(reinterpret_cast<float*>(dst + 3 * dst_ld), r3);
+			}
+		};
+
+		// 2 x 2 block of 64-bit elements
+		struct Sse2Transpose64
+		{
+			static const size_t size = 2;
+
+			template <typename Type>
+			LINALG_TARGET("sse2") static void transposeBlock(const Type* src,
+				const size_t src_ld, Type* dst, const size_t dst_ld)
+			{
+				__m128d r0 = _mm_loadu_pd(reinterpret_cast<const double*>(src));
+				__m128d r1 = _mm_loadu_pd(reinterpret_cast<const double*>(src + src_ld));
+				_mm_storeu_pd(reinterpret_cast<double*>(dst), _mm_unpacklo_pd(r0, r1));
+				_mm_storeu_pd(reinterpret_cast<double*>(dst + dst_ld), _mm_unpackhi_pd(r0, r1));
+			}
+		};
+
+		// 8 x 8 block of 32-bit elements; interleaves pairs of rows, then
+		// pairs of pairs, then swaps 128-bit halves across registers
+		struct Avx2Transpose32
+		{
+			static const size_t size = 8;
+
+			template <typename Type>
+			LINALG_TARGET("avx2,fma") static void transposeBlock(const Type* src,
+				const size_t src_ld, Type* dst, const size_t dst_ld)
+			{
+				__m256 r[8], t[8];
+				for (size_t i = 0; i < 8; ++i)
+				{
+					r[i] = _mm256_loadu_ps(reinterpret_cast<const float*>(src + i * src_ld));
+				}
+
+				for (size_t i = 0; i < 8; i += 2)
+				{
+					t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+					t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+				}
+
+				for (size_t i = 0; i < 8; i += 4)
+				{
+					r[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+					r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+					r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+					r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+				}
+
+				for (size_t i = 0; i < 4; ++i)
+				{
+					_mm256_storeu_ps(reinterpret_cast<float*>(dst + i * dst_ld),
+						_mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+					_mm256_storeu_ps(reinterpret_cast<float*>(dst + (i + 4) * dst_ld),
+						_mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+				}
+			}
+		};
+
+		// 4 x 4 block of 64-bit elements
+		struct Avx2Transpose64
+		{
+			static const size_t size = 4;
+
+			template <typename Type>
+			LINALG_TARGET("avx2,fma") static void transposeBlock(const Type* src,
+				const size_t src_ld, Type* dst, const size_t dst_ld)
+			{
+				__m256d r0 = _mm256_loadu_pd(reinterpret_cast<const double*>(src));
+				__m256d r1 = _mm256_loadu_pd(reinterpret_cast<const double*>(src + src_ld));
+				__m256d r2 = _mm256_loadu_pd(reinterpret_cast<const double*>(src + 2 * src_ld));
+				__m256d r3 = _mm256_loadu_pd(reinterpret_cast<const double*>(src + 3 * src_ld));
+
+				__m256d t0 = _mm256_unpacklo_pd(r0, r1);
+				__m256d t1 = _mm256_unpackhi_pd(r0, r1);
+				__m256d t2 = _mm256_unpacklo_pd(r2, r3);
+				__m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+				_mm256_storeu_pd(reinterpret_cast<double*>(dst),
+					_mm256_permute2f128_pd(t0, t2, 0x20));
+				_mm256_storeu_pd(reinterpret_cast<double*>(dst + dst_ld),
+					_mm256_permute2f128_pd(t1, t3, 0x20));
+				_mm256_storeu_pd(reinterpret_cast<double*>(dst + 2 * dst_ld),
+					_mm256_permute2f128_pd(t0, t2, 0x31));
+				_mm256_storeu_pd(reinterpret_cast<double*>(dst + 3 * dst_ld),
+					_mm256_permute2f128_pd(t1, t3, 0x31));
+			}
+		};
+
+		// --------------------------------------------------------------
+		// Loops shared by every data type of one instruction set; each
+		// set needs its own copy so the target attribute matches the
+		// register operations it inlines
+		// --------------------------------------------------------------
+
+#define LINALG_DEFINE_SIMD_LOOPS(isa_namespace, isa)                              \
+		namespace isa_namespace                                                   \
+		{                                                                         \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) typename Ops::Type dot(const typename Ops::Type* a,\
+				const typename Ops::Type* b, const size_t n)                      \
+			{                                                                     \
+				using Type = typename Ops::Type;                                  \
+				const size_t w = Ops::width;                                      \
+				typename Ops::Reg acc0 = Ops::zero(), acc1 = Ops::zero();         \
+				typename Ops::Reg acc2 = Ops::zero(), acc3 = Ops::zero();         \
+				size_t i = 0;                                                     \
+				for (; i + 4 * w <= n; i += 4 * w)                                \
+				{                                                                 \
+					acc0 = Ops::mulAdd(Ops::load(a + i), Ops::load(b + i), acc0); \
+					acc1 = Ops::mulAdd(Ops::load(a + i + w),                      \
+						Ops::load(b + i + w), acc1);                              \
+					acc2 = Ops::mulAdd(Ops::load(a + i + 2 * w),                  \
+						Ops::load(b + i + 2 * w), acc2);                          \
+					acc3 = Ops::mulAdd(Ops::load(a + i + 3 * w),                  \
+						Ops::load(b + i + 3 * w), acc3);                          \
+				}                                                                 \
+				for (; i + w <= n; i += w)                                        \
+				{                                                                 \
+					acc0 = Ops::mulAdd(Ops::load(a + i), Ops::load(b + i), acc0); \
+				}                                                                 \
+				acc0 = Ops::add(Ops::add(acc0, acc1), Ops::add(acc2, acc3));      \
+				Type lanes[Ops::width];                                           \
+				Ops::store(lanes, acc0);                                          \
+				Type result = 0;                                                  \
+				for (size_t j = 0; j < w; ++j)                                    \
+					result += lanes[j];                                           \
+				for (; i < n; ++i)                                                \
+					result += a[i] * b[i];                                        \
+				return result;                                                    \
+			}                                                                     \
+                                                                                  \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) void add(const typename Ops::Type* a,              \
+				const typename Ops::Type* b, typename Ops::Type* out,             \
+				const size_t n)                                                   \
+			{                                                                     \
+				size_t i = 0;                                                     \
+				for (; i + Ops::width <= n; i += Ops::width)                      \
+					Ops::store(out + i, Ops::add(Ops::load(a + i), Ops::load(b + i))); \
+				for (; i < n; ++i)                                                \
+					out[i] = a[i] + b[i];                                         \
+			}                                                                     \
+                                                                                  \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) void subtract(const typename Ops::Type* a,         \
+				const typename Ops::Type* b, typename Ops::Type* out,             \
+				const size_t n)                                                   \
+			{                                                                     \
+				size_t i = 0;                                                     \
+				for (; i + Ops::width <= n; i += Ops::width)                      \
+					Ops::store(out + i, Ops::sub(Ops::load(a + i), Ops::load(b + i))); \
+				for (; i < n; ++i)                                                \
+					out[i] = a[i] - b[i];                                         \
+			}                                                                     \
+                                                                                  \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) void axpy(const typename Ops::Type alpha,          \
+				const typename Ops::Type* x, typename Ops::Type* y,               \
+				const size_t n)                                                   \
+			{                                                                     \
+				typename Ops::Reg alpha_reg = Ops::set1(alpha);                   \
+				size_t i = 0;                                                     \
+				for (; i + Ops::width <= n; i += Ops::width)                      \
+					Ops::store(y + i, Ops::mulAdd(alpha_reg, Ops::load(x + i),    \
+						Ops::load(y + i)));                                       \
+				for (; i < n; ++i)                                                \
+					y[i] += alpha * x[i];                                         \
+			}                                                                     \
+                                                                                  \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) typename Ops::Type sparseDot(                      \
+				const typename Ops::Type* values, const size_t* indices,          \
+				const typename Ops::Type* x, const size_t n)                      \
+			{                                                                     \
+				using Type = typename Ops::Type;                                  \
+				const size_t w = Ops::width;                                      \
+				typename Ops::Reg acc0 = Ops::zero(), acc1 = Ops::zero();         \
+				size_t i = 0;                                                     \
+				for (; i + 2 * w <= n; i += 2 * w)                                \
+				{                                                                 \
+					acc0 = Ops::mulAdd(Ops::load(values + i),                     \
+						Ops::gather(x, indices + i), acc0);                       \
+					acc1 = Ops::mulAdd(Ops::load(values + i + w),                 \
+						Ops::gather(x, indices + i + w), acc1);                   \
+				}                                                                 \
+				for (; i + w <= n; i += w)                                        \
+				{                                                                 \
+					acc0 = Ops::mulAdd(Ops::load(values + i),                     \
+						Ops::gather(x, indices + i), acc0);                       \
+				}                                                                 \
+				acc0 = Ops::add(acc0, acc1);                                      \
+				Type lanes[Ops::width];                                           \
+				Ops::store(lanes, acc0);                                          \
+				Type result = 0;                                                  \
+				for (size_t j = 0; j < w; ++j)                                    \
+					result += lanes[j];                                           \
+				for (; i < n; ++i)                                                \
+					result += values[i] * x[indices[i]];                          \
+				return result;                                                    \
+			}                                                                     \
+                                                                                  \
+			template <typename Ops>                                               \
+			LINALG_TARGET(isa) void sparseAxpy(const typename Ops::Type alpha,    \
+				const typename Ops::Type* values, const size_t* indices,          \
+				typename Ops::Type* y, const size_t n)                            \
+			{                                                                     \
+				typename Ops::Reg alpha_reg = Ops::set1(alpha);                   \
+				size_t i = 0;                                                     \
+				for (; i + Ops::width <= n; i += Ops::width)                      \
+					Ops::scatter(y, indices + i, Ops::mulAdd(alpha_reg,           \
+						Ops::load(values + i), Ops::gather(y, indices + i)));     \
+				for (; i < n; ++i)                                                \
+					y[indices[i]] += alpha * values[i];                           \
+			}                                                                     \
+                                                                                  \
+			template <typename Block, typename Type>                              \
+			LINALG_TARGET(isa) void transpose(const Type* src,                    \
+				const size_t src_ld, Type* dst, const size_t dst_ld,              \
+				const size_t rows, const size_t cols)                             \
+			{                                                                     \
+				const size_t b = Block::size;                                     \
+				size_t i = 0;                                                     \
+				for (; i + b <= rows; i += b)                                     \
+				{                                                                 \
+					size_t j = 0;                                                 \
+					for (; j + b <= cols; j += b)                                 \
+						Block::transposeBlock(src + i * src_ld + j, src_ld,       \
+							dst + j * dst_ld + i, dst_ld);                        \
+					for (; j < cols; ++j)                                         \
+						for (size_t k = i; k < i + b; ++k)                        \
+							dst[j * dst_ld + k] = src[k * src_ld + j];            \
+				}                                                                 \
+				for (; i < rows; ++i)                                             \
+					for (size_t j = 0; j < cols; ++j)                             \
+						dst[j * dst_ld + i] = src[i * src_ld + j];                \
+			}                                                                     \
+		}
+
+		LINALG_DEFINE_SIMD_LOOPS(sse2, "sse2")
+		LINALG_DEFINE_SIMD_LOOPS(avx2, "avx2,fma")
+		LINALG_DEFINE_SIMD_LOOPS(avx512, "avx512f,avx512dq")
+
+#undef LINALG_DEFINE_SIMD_LOOPS
+
+		// --------------------------------------------------------------
+		// GEMM register tiles; the GEMM_MR x GEMM_NR tile stays in
+		// registers for the whole kc loop, and every step broadcasts the
+		// GEMM_MR elements of A against one row of B
+		// Kernels with few accumulators run two steps at a time into two
+		// sets of them, so consecutive FMAs don't wait on each other
+		// --------------------------------------------------------------
+
+		namespace sse2
+		{
+			LINALG_TARGET("sse2") void gemmTile(const size_t kc, const float* A,
+				const float* B, float* tile)
+			{
+				__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+				__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+				__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+				__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+				for (size_t p = 0; p < kc; ++p)
+				{
+					__m128 b0 = _mm_loadu_ps(B);
+					__m128 b1 = _mm_loadu_ps(B + 4);
+					__m128 a = _mm_set1_ps(A[0]);
+					c00 = _mm_add_ps(c00, _mm_mul_ps(a, b0));
+					c01 = _mm_add_ps(c01, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(A[1]);
+					c10 = _mm_add_ps(c10, _mm_mul_ps(a, b0));
+					c11 = _mm_add_ps(c11, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(A[2]);
+					c20 = _mm_add_ps(c20, _mm_mul_ps(a, b0));
+					c21 = _mm_add_ps(c21, _mm_mul_ps(a, b1));
+					a = _mm_set1_ps(A[3]);
+					c30 = _mm_add_ps(c30, _mm_mul_ps(a, b0));
+					c31 = _mm_add_ps(c31, _mm_mul_ps(a, b1));
+					A += GEMM_MR;
+					B += GEMM_NR;
+				}
+				_mm_storeu_ps(tile, c00);
+				_mm_storeu_ps(tile + 4, c01);
+				_mm_storeu_ps(tile + 8, c10);
+				_mm_storeu_ps(tile + 12, c11);
+				_mm_storeu_ps(tile + 16, c20);
+				_mm_storeu_ps(tile + 20, c21);
+				_mm_storeu_ps(tile + 24, c30);
+				_mm_storeu_ps(tile + 28, c31);
+			}
+
+			// A row of the tile takes four registers, so the tile is
+			// computed two rows at a time to stay within the sixteen
+			// registers SSE2 has
+			LINALG_TARGET("sse2") void gemmTile(const size_t kc, const double* A,
+				const double* B, double* tile)
+			{
+				for (size_t i = 0; i < GEMM_MR; i += 2)
+				{
+					__m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+					__m128d c02 = _mm_setzero_pd(), c03 = _mm_setzero_pd();
+					__m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+					__m128d c12 = _mm_setzero_pd(), c13 = _mm_setzero_pd();
+					const double* A_step = A + i;
+					const double* B_step = B;
+					for (size_t p = 0; p < kc; ++p)
+					{
+						__m128d b0 = _mm_loadu_pd(B_step);
+						__m128d b1 = _mm_loadu_pd(B_step + 2);
+						__m128d b2 = _mm_loadu_pd(B_step + 4);
+						__m128d b3 = _mm_loadu_pd(B_step + 6);
+						__m128d a = _mm_set1_pd(A_step[0]);
+						c00 = _mm_add_pd(c00, _mm_mul_pd(a, b0));
+						c01 = _mm_add_pd(c01, _mm_mul_pd(a, b1));
+						c02 = _mm_add_pd(c02, _mm_mul_pd(a, b2));
+						c03 = _mm_add_pd(c03, _mm_mul_pd(a, b3));
+						a = _mm_set1_pd(A_step[1]);
+						c10 = _mm_add_pd(c10, _mm_mul_pd(a, b0));
+						c11 = _mm_add_pd(c11, _mm_mul_pd(a, b1));
+						c12 = _mm_add_pd(c12, _mm_mul_pd(a, b2));
+						c13 = _mm_add_pd(c13, _mm_mul_pd(a, b3));
+						A_step += GEMM_MR;
+						B_step += GEMM_NR;
+					}
+					double* row = tile + i * GEMM_NR;
+					_mm_storeu_pd(row, c00);
+					_mm_storeu_pd(row + 2, c01);
+					_mm_storeu_pd(row + 4, c02);
+					_mm_storeu_pd(row + 6, c03);
+					_mm_storeu_pd(row + 8, c10);
+					_mm_storeu_pd(row + 10, c11);
+					_mm_storeu_pd(row + 12, c12);
+					_mm_storeu_pd(row + 14, c13);
+				}
+			}
+		}
+
+		namespace avx2
+		{
+			LINALG_TARGET("avx2,fma") void gemmTile(const size_t kc, const float* A,
+				const float* B, float* tile)
+			{
+				__m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+				__m256 c2 = _mm256_setzero_ps(), c3 = _mm256_setzero_ps();
+				__m256 d0 = _mm256_setzero_ps(), d1 = _mm256_setzero_ps();
+				__m256 d2 = _mm256_setzero_ps(), d3 = _mm256_setzero_ps();
+				size_t p = 0;
+				for (; p + 2 <= kc; p += 2)
+				{
+					__m256 b = _mm256_loadu_ps(B);
+					c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(A), b, c0);
+					c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 1), b, c1);
+					c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 2), b, c2);
+					c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 3), b, c3);
+					b = _mm256_loadu_ps(B + GEMM_NR);
+					d0 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 4), b, d0);
+					d1 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 5), b, d1);
+					d2 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 6), b, d2);
+					d3 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 7), b, d3);
+					A += 2 * GEMM_MR;
+					B += 2 * GEMM_NR;
+				}
+				if (p < kc)
+				{
+					__m256 b = _mm256_loadu_ps(B);
+					c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(A), b, c0);
+					c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 1), b, c1);
+					c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 2), b, c2);
+					c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(A + 3), b, c3);
+				}
+				_mm256_storeu_ps(tile, _mm256_add_ps(c0, d0));
+				_mm256_storeu_ps(tile + 8, _mm256_add_ps(c1, d1));
+				_mm256_storeu_ps(tile + 16, _mm256_add_ps(c2, d2));
+				_mm256_storeu_ps(tile + 24, _mm256_add_ps(c3, d3));
+			}
+
+			LINALG_TARGET("avx2,fma") void gemmTile(const size_t kc, const double* A,
+				const double* B, double* tile)
+			{
+				__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+				__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+				__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+				__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+				for (size_t p = 0; p < kc; ++p)
+				{
+					__m256d b0 = _mm256_loadu_pd(B);
+					__m256d b1 = _mm256_loadu_pd(B + 4);
+					__m256d a = _mm256_broadcast_sd(A);
+					c00 = _mm256_fmadd_pd(a, b0, c00);
+					c01 = _mm256_fmadd_pd(a, b1, c01);
+					a = _mm256_broadcast_sd(A + 1);
+					c10 = _mm256_fmadd_pd(a, b0, c10);
+					c11 = _mm256_fmadd_pd(a, b1, c11);
+					a = _mm256_broadcast_sd(A + 2);
+					c20 = _mm256_fmadd_pd(a, b0, c20);
+					c21 = _mm256_fmadd_pd(a, b1, c21);
+					a = _mm256_broadcast_sd(A + 3);
+					c30 = _mm256_fmadd_pd(a, b0, c30);
+					c31 = _mm256_fmadd_pd(a, b1, c31);
+					A += GEMM_MR;
+					B += GEMM_NR;
+				}
+				_mm256_storeu_pd(tile, c00);
+				_mm256_storeu_pd(tile + 4, c01);
+				_mm256_storeu_pd(tile + 8, c10);
+				_mm256_storeu_pd(tile + 12, c11);
+				_mm256_storeu_pd(tile + 16, c20);
+				_mm256_storeu_pd(tile + 20, c21);
+				_mm256_storeu_pd(tile + 24, c30);
+				_mm256_storeu_pd(tile + 28, c31);
+			}
+		}
+
+		// A row of float tile is only half a register wide, so AVX-512
+		// uses the AVX2 float tile
+		namespace avx512
+		{
+			LINALG_TARGET("avx512f,avx512dq") void gemmTile(const size_t kc, const double* A,
+				const double* B, double* tile)
+			{
+				__m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+				__m512d c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+				__m512d d0 = _mm512_setzero_pd(), d1 = _mm512_setzero_pd();
+				__m512d d2 = _mm512_setzero_pd(), d3 = _mm512_setzero_pd();
+				size_t p = 0;
+				for (; p + 2 <= kc; p += 2)
+				{
+					__m512d b = _mm512_loadu_pd(B);
+					c0 = _mm512_fmadd_pd(_mm512_set1_pd(A[0]), b, c0);
+					c1 = _mm512_fmadd_pd(_mm512_set1_pd(A[1]), b, c1);
+					c2 = _mm512_fmadd_pd(_mm512_set1_pd(A[2]), b, c2);
+					c3 = _mm512_fmadd_pd(_mm512_set1_pd(A[3]), b, c3);
+					b = _mm512_loadu_pd(B + GEMM_NR);
+					d0 = _mm512_fmadd_pd(_mm512_set1_pd(A[4]), b, d0);
+					d1 = _mm512_fmadd_pd(_mm512_set1_pd(A[5]), b, d1);
+					d2 = _mm512_fmadd_pd(_mm512_set1_pd(A[6]), b, d2);
+					d3 = _mm512_fmadd_pd(_mm512_set1_pd(A[7]), b, d3);
+					A += 2 * GEMM_MR;
+					B += 2 * GEMM_NR;
+				}
+				if (p < kc)
+				{
+					__m512d b = _mm512_loadu_pd(B);
+					c0 = _mm512_fmadd_pd(_mm512_set1_pd(A[0]), b, c0);
+					c1 = _mm512_fmadd_pd(_mm512_set1_pd(A[1]), b, c1);
+					c2 = _mm512_fmadd_pd(_mm512_set1_pd(A[2]), b, c2);
+					c3 = _mm512_fmadd_pd(_mm512_set1_pd(A[3]), b, c3);
+				}
+				_mm512_storeu_pd(tile, _mm512_add_pd(c0, d0));
+				_mm512_storeu_pd(tile + 8, _mm512_add_pd(c1, d1));
+				_mm512_storeu_pd(tile + 16, _mm512_add_pd(c2, d2));
+				_mm512_storeu_pd(tile + 24, _mm512_add_pd(c3, d3));
+			}
+		}
+	}
+
+	// Defines the dispatching overloads of the kernels for one data
+	// type; prefix is the part of the Ops struct names after the
+	// instruction set, such as Double for Avx2Double
+#define LINALG_DEFINE_KERNELS(Type, prefix)                                       \
+	Type dotKernel(const Type* a, const Type* b, const size_t n)                  \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: return avx512::dot<Avx512##prefix>(a, b, n);      \
+		case SimdLevel::AVX2: return avx2::dot<Avx2##prefix>(a, b, n);            \
+		case SimdLevel::SSE2: return sse2::dot<Sse2##prefix>(a, b, n);            \
+		default: return dotKernel<Type>(a, b, n);                                 \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	void addKernel(const Type* a, const Type* b, Type* out, const size_t n)       \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: avx512::add<Avx512##prefix>(a, b, out, n); break; \
+		case SimdLevel::AVX2: avx2::add<Avx2##prefix>(a, b, out, n); break;       \
+		case SimdLevel::SSE2: sse2::add<Sse2##prefix>(a, b, out, n); break;       \
+		default: addKernel<Type>(a, b, out, n); break;                            \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	void subtractKernel(const Type* a, const Type* b, Type* out, const size_t n)  \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: avx512::subtract<Avx512##prefix>(a, b, out, n); break; \
+		case SimdLevel::AVX2: avx2::subtract<Avx2##prefix>(a, b, out, n); break;  \
+		case SimdLevel::SSE2: sse2::subtract<Sse2##prefix>(a, b, out, n); break;  \
+		default: subtractKernel<Type>(a, b, out, n); break;                       \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	void axpyKernel(const Type alpha, const Type* x, Type* y, const size_t n)     \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: avx512::axpy<Avx512##prefix>(alpha, x, y, n); break; \
+		case SimdLevel::AVX2: avx2::axpy<Avx2##prefix>(alpha, x, y, n); break;    \
+		case SimdLevel::SSE2: sse2::axpy<Sse2##prefix>(alpha, x, y, n); break;    \
+		default: axpyKernel<Type>(alpha, x, y, n); break;                         \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	Type sparseDotKernel(const Type* values, const size_t* indices,               \
+		const Type* x, const size_t n)                                            \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: return avx512::sparseDot<Avx512##prefix>(values, indices, x, n); \
+		case SimdLevel::AVX2: return avx2::sparseDot<Avx2##prefix>(values, indices, x, n); \
+		case SimdLevel::SSE2: return sse2::sparseDot<Sse2##prefix>(values, indices, x, n); \
+		default: return sparseDotKernel<Type>(values, indices, x, n);             \
+		}                                                                         \
+	}                                                                             \
+                                                                                  \
+	void sparseAxpyKernel(const Type alpha, const Type* values,                   \
+		const size_t* indices, Type* y, const size_t n)                           \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512: avx512::sparseAxpy<Avx512##prefix>(alpha, values, indices, y, n); break; \
+		case SimdLevel::AVX2: avx2::sparseAxpy<Avx2##prefix>(alpha, values, indices, y, n); break; \
+		case SimdLevel::SSE2: sse2::sparseAxpy<Sse2##prefix>(alpha, values, indices, y, n); break; \
+		default: sparseAxpyKernel<Type>(alpha, values, indices, y, n); break;     \
+		}                                                                         \
+	}
+
+	LINALG_DEFINE_KERNELS(float, Float)
+	LINALG_DEFINE_KERNELS(double, Double)
+	LINALG_DEFINE_KERNELS(int32_t, Int32)
+	LINALG_DEFINE_KERNELS(int64_t, Int64)
+
+#undef LINALG_DEFINE_KERNELS
+
+	// Defines the dispatching transposeKernel() for one data type; bits
+	// is the size of the type; AVX-512 reuses the AVX2 blocks, as wider
+	// blocks don't help a transpose bound by memory traffic
+#define LINALG_DEFINE_TRANSPOSE_KERNEL(Type, bits)                                \
+	void transposeKernel(const Type* src, const size_t src_ld, Type* dst,         \
+		const size_t dst_ld, const size_t rows, const size_t cols)                \
+	{                                                                             \
+		switch (activeSimdLevel())                                                \
+		{                                                                         \
+		case SimdLevel::AVX512:                                                   \
+			avx512::transpose<Avx2Transpose##bits>(src, src_ld, dst, dst_ld, rows, cols); \
+			break;                                                                \
+		case SimdLevel::AVX2:                                                     \
+			avx2::transpose<Avx2Transpose##bits>(src, src_ld, dst, dst_ld, rows, cols); \
+			break;                                                                \
+		case SimdLevel::SSE2:                                                     \
+			sse2::transpose<Sse2Transpose##bits>(src, src_ld, dst, dst_ld, rows, cols); \
+			break;                                                                \
+		default:                                                                  \
+			transposeKernel<Type>(src, src_ld, dst, dst_ld, rows, cols);          \
+			break;                                                                \
+		}                                                                         \
+	}
+
+	LINALG_DEFINE_TRANSPOSE_KERNEL(float, 32)
+	LINALG_DEFINE_TRANSPOSE_KERNEL(double, 64)
+	LINALG_DEFINE_TRANSPOSE_KERNEL(int32_t, 32)
+	LINALG_DEFINE_TRANSPOSE_KERNEL(int64_t, 64)
+
+#undef LINALG_DEFINE_TRANSPOSE_KERNEL
+
+	void gemmTileKernel(const size_t kc, const float* A_sliver,
+		const float* B_sliver, float* tile)
+	{
+		switch (activeSimdLevel())
+		{
+		case SimdLevel::AVX512:
+		case SimdLevel::AVX2: avx2::gemmTile(kc, A_sliver, B_sliver, tile); break;
+		case SimdLevel::SSE2: sse2::gemmTile(kc, A_sliver, B_sliver, tile); break;
+		default: gemmTileKernel<float>(kc, A_sliver, B_sliver, tile); break;
+		}
+	}
+
+	void gemmTileKernel(const size_t kc, const double* A_sliver,
+		const double* B_sliver, double* tile)
+	{
+		switch (activeSimdLevel())
+		{
+		case SimdLevel::AVX512: avx512::gemmTile(kc, A_sliver, B_sliver, tile); break;
+		case SimdLevel::AVX2: avx2::gemmTile(kc, A_sliver, B_sliver, tile); break;
+		case SimdLevel::SSE2: sse2::gemmTile(kc, A_sliver, B_sliver, tile); break;
+		default: gemmTileKernel<double>(kc, A_sliver, B_sliver, tile); break;
+		}
+	}
+
+#else
+
+	// Without x86 intrinsics every overload runs the scalar template
+#define LINALG_DEFINE_KERNELS(Type)                                               \
+	Type dotKernel(const Type* a, const Type* b, const size_t n)                  \
+	{                                                                             \
+		return dotKernel<Type>(a, b, n);                                          \
+	}                                                                             \
+	void addKernel(const Type* a, const Type* b, Type* out, const size_t n)       \
+	{                                                                             \
+		addKernel<Type>(a, b, out, n);                                            \
+	}                                                                             \
+	void subtractKernel(const Type* a, const Type* b, Type* out, const size_t n)  \
+	{                                                                             \
+		subtractKernel<Type>(a, b, out, n);                                       \
+	}                                                                             \
+	void axpyKernel(const Type alpha, const Type* x, Type* y, const size_t n)     \
+	{                                                                             \
+		axpyKernel<Type>(alpha, x, y, n);                                         \
+	}                                                                             \
+	Type sparseDotKernel(const Type* values, const size_t* indices,               \
+		const Type* x, const size_t n)                                            \
+	{                                                                             \
+		return sparseDotKernel<Type>(values, indices, x, n);                      \
+	}                                                                             \
+	void sparseAxpyKernel(const Type alpha, const Type* values,                   \
+		const size_t* indices, Type* y, const size_t n)                           \
+	{                                                                             \
+		sparseAxpyKernel<Type>(alpha, values, indices, y, n);                     \
+	}                                                                             \
+	void transposeKernel(const Type* src, const size_t src_ld, Type* dst,         \
+		const size_t dst_ld, const size_t rows, const size_t cols)                \
+	{                                                                             \
+		transposeKernel<Type>(src, src_ld, dst, dst_ld, rows, cols);              \
+	}
+
+	LINALG_DEFINE_KERNELS(float)
+	LINALG_DEFINE_KERNELS(double)
+	LINALG_DEFINE_KERNELS(int32_t)
+	LINALG_DEFINE_KERNELS(int64_t)
+
+#undef LINALG_DEFINE_KERNELS
+
+	void gemmTileKernel(const size_t kc, const float* A_sliver,
+		const float* B_sliver, float* tile)
+	{
+		gemmTileKernel<float>(kc, A_sliver, B_sliver, tile);
+	}
+
+	void gemmTileKernel(const size_t kc, const double* A_sliver,
+		const double* B_sliver, double* tile)
+	{
+		gemmTileKernel<double>(kc, A_sliver, B_sliver, tile);
+	}
+
+#endif
+}
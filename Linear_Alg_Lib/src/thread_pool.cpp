@@ -0,0 +1,421 @@
+#include "../include/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+// ------------------------------------------------------------------
+// Implementation of thread_pool.h
+// ------------------------------------------------------------------
+
+namespace LinAlg
+{
+	namespace
+	{
+		// Pool that owns the calling thread, or nullptr for threads
+		// outside every pool, and the thread's index within that pool
+		thread_local ThreadPool* current_pool = nullptr;
+		thread_local size_t worker_index = 0;
+
+		// State of one parallelFor() call, shared between the calling
+		// thread and every worker that picks it up
+		struct ParallelForJob
+		{
+			ParallelForJob(const std::function<void(size_t)>& task_in,
+				const size_t num_tasks_in) :
+				task(task_in),
+				num_tasks(num_tasks_in),
+				next_task(0),
+				finished_tasks(0)
+			{ }
+
+			// Claims and runs tasks until none are left
+			void run()
+			{
+				size_t i;
+				while ((i = next_task.fetch_add(1)) < num_tasks)
+				{
+					try
+					{
+						task(i);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (!error)
+							error = std::current_exception();
+					}
+
+					if (finished_tasks.fetch_add(1) + 1 == num_tasks)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						done_cv.notify_all();
+					}
+				}
+			}
+
+			// Blocks until every task has finished
+			void wait()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				done_cv.wait(lock, [this]() {
+					return finished_tasks.load() == num_tasks;
+				});
+			}
+
+			const std::function<void(size_t)>& task;
+			const size_t num_tasks;
+			std::atomic<size_t> next_task;
+			std::atomic<size_t> finished_tasks;
+
+			std::mutex mutex;
+			std::condition_variable done_cv;
+			std::exception_ptr error;
+		};
+
+		// Returns number of hardware threads, or 1 if unknown
+		size_t hardwareThreads()
+		{
+			size_t num_threads = std::thread::hardware_concurrency();
+			return num_threads == 0 ? 1 : num_threads;
+		}
+
+		std::unique_ptr<ThreadPool>& defaultThreadPoolStorage()
+		{
+			static std::unique_ptr<ThreadPool> pool;
+			return pool;
+		}
+
+		// Guards creation and replacement of the default pool
+		std::mutex& defaultThreadPoolMutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		// Default pool, read without the mutex; only set while holding it
+		std::atomic<ThreadPool*>& defaultThreadPoolPointer()
+		{
+			static std::atomic<ThreadPool*> pointer(nullptr);
+			return pointer;
+		}
+	}
+
+	// Creates a pool that runs jobs on num_threads threads in total
+	ThreadPool::ThreadPool(const size_t num_threads) :
+		_queued_tasks(0),
+		_stopping(false)
+	{
+		for (size_t i = 1; i < num_threads; ++i)
+		{
+			_local_queues.emplace_back(new WorkerQueue());
+		}
+
+		// Queues must all exist before any worker starts stealing
+		for (size_t i = 0; i < _local_queues.size(); ++i)
+		{
+			_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+		}
+	}
+
+	// Waits for the workers to finish any queued work and joins them
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+			_stopping = true;
+		}
+		_sleep_cv.notify_all();
+
+		for (std::thread& worker : _workers)
+		{
+			worker.join();
+		}
+	}
+
+	// Calls task(i) for every i in [0, num_tasks) across the pool
+	void ThreadPool::parallelFor(const size_t num_tasks,
+		const std::function<void(size_t)>& task)
+	{
+		if (num_tasks == 0)
+			return;
+
+		// Nested calls run serially; the enclosing tasks already keep
+		// the pool busy
+		if (_workers.empty() || num_tasks == 1 || onWorkerThread())
+		{
+			for (size_t i = 0; i < num_tasks; ++i)
+			{
+				task(i);
+			}
+			return;
+		}
+
+		// Workers may still hold the job after the last task finishes,
+		// so its lifetime is shared
+		std::shared_ptr<ParallelForJob> job =
+			std::make_shared<ParallelForJob>(task, num_tasks);
+
+		size_t helpers = std::min(_workers.size(), num_tasks - 1);
+		for (size_t i = 0; i < helpers; ++i)
+		{
+			submit([job]() { job->run(); });
+		}
+
+		job->run();
+		job->wait();
+
+		if (job->error)
+			std::rethrow_exception(job->error);
+	}
+
+	// Queues task to run on the pool
+	void ThreadPool::submit(std::function<void()> task)
+	{
+		if (current_pool == this)
+		{
+			WorkerQueue& queue = *_local_queues[worker_index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(_shared_mutex);
+			_shared_queue.push_back(std::move(task));
+		}
+
+		// Incremented after the push, and the sleep mutex is taken before
+		// notifying, so a worker can't miss the wake-up
+		_queued_tasks.fetch_add(1);
+		{
+			std::lock_guard<std::mutex> lock(_sleep_mutex);
+		}
+		_sleep_cv.notify_one();
+	}
+
+	// Runs one queued task on the calling thread
+	bool ThreadPool::runPendingTask()
+	{
+		size_t index = (current_pool == this) ?
+			worker_index : _local_queues.size();
+
+		std::function<void()> task;
+		if (!popTask(index, task))
+			return false;
+
+		task();
+		return true;
+	}
+
+	// Returns true if the calling thread is a worker of any pool
+	bool ThreadPool::onWorkerThread()
+	{
+		return current_pool != nullptr;
+	}
+
+	// Main loop of every worker thread
+	void ThreadPool::workerLoop(const size_t index)
+	{
+		current_pool = this;
+		worker_index = index;
+
+		while (true)
+		{
+			std::function<void()> task;
+			if (popTask(index, task))
+			{
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(_sleep_mutex);
+			_sleep_cv.wait(lock, [this]() {
+				return _stopping || _queued_tasks.load() > 0;
+			});
+
+			if (_stopping && _queued_tasks.load() == 0)
+				return;
+		}
+	}
+
+	// Takes the next task for the thread with given worker index
+	bool ThreadPool::popTask(const size_t index, std::function<void()>& task)
+	{
+		const size_t num_queues = _local_queues.size();
+
+		// Own deque first, newest task first
+		if (index < num_queues)
+		{
+			WorkerQueue& queue = *_local_queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				_queued_tasks.fetch_sub(1);
+				return true;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_shared_mutex);
+			if (!_shared_queue.empty())
+			{
+				task = std::move(_shared_queue.front());
+				_shared_queue.pop_front();
+				_queued_tasks.fetch_sub(1);
+				return true;
+			}
+		}
+
+		// Steals the oldest task of another worker, starting with the
+		// next one along so thieves spread out over the victims
+		for (size_t i = 1; i <= num_queues; ++i)
+		{
+			size_t victim = (index + i) % num_queues;
+			if (victim == index)
+				continue;
+
+			WorkerQueue& queue = *_local_queues[victim];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				_queued_tasks.fetch_sub(1);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Creates an empty group that runs its tasks on given pool
+	TaskGroup::TaskGroup(ThreadPool& pool) :
+		_pool(pool),
+		_state(std::make_shared<State>())
+	{
+		_state->pending = 0;
+	}
+
+	// Waits for any tasks still running
+	TaskGroup::~TaskGroup()
+	{
+		try
+		{
+			wait();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	// Starts task on the pool
+	void TaskGroup::run(std::function<void()> task)
+	{
+		std::shared_ptr<State> state = _state;
+		auto guarded_task = [state, task]()
+		{
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+
+			// Decremented under the mutex, so a waiter that has just
+			// checked pending can't miss the notification
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->pending.fetch_sub(1);
+			}
+			state->finished_cv.notify_all();
+		};
+
+		_state->pending.fetch_add(1);
+
+		if (_pool.numThreads() == 1)
+			guarded_task();
+		else
+			_pool.submit(guarded_task);
+	}
+
+	// Returns once every task started by run() has finished
+	void TaskGroup::wait()
+	{
+		// Helping instead of blocking keeps every thread busy, and lets
+		// a worker wait on tasks that are still in its own deque
+		while (_state->pending.load() > 0)
+		{
+			if (_pool.runPendingTask())
+				continue;
+
+			// Nothing is left to help with, so the group's remaining
+			// tasks are running on other threads; sleep until one of
+			// them finishes, as it may have queued more work
+			std::unique_lock<std::mutex> lock(_state->mutex);
+			const size_t pending = _state->pending.load();
+			_state->finished_cv.wait(lock, [&]() {
+				size_t now = _state->pending.load();
+				return now == 0 || now != pending;
+			});
+		}
+
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> lock(_state->mutex);
+			std::swap(error, _state->error);
+		}
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	// Returns the pool used by the library's parallel algorithms
+	// Every kernel calls this once per operation, so after the pool is
+	// created it is only an atomic load
+	ThreadPool& defaultThreadPool()
+	{
+		ThreadPool* cached = defaultThreadPoolPointer().load(std::memory_order_acquire);
+		if (cached)
+			return *cached;
+
+		std::lock_guard<std::mutex> lock(defaultThreadPoolMutex());
+		std::unique_ptr<ThreadPool>& pool = defaultThreadPoolStorage();
+		if (!pool)
+		{
+			pool.reset(new ThreadPool(hardwareThreads()));
+			defaultThreadPoolPointer().store(pool.get(), std::memory_order_release);
+		}
+		return *pool;
+	}
+
+	// Sets number of threads used by the library's parallel algorithms
+	void setNumThreads(const size_t num_threads)
+	{
+		size_t threads = (num_threads == 0) ? hardwareThreads() : num_threads;
+
+		std::lock_guard<std::mutex> lock(defaultThreadPoolMutex());
+		std::unique_ptr<ThreadPool>& pool = defaultThreadPoolStorage();
+		if (pool && pool->numThreads() == threads)
+			return;
+
+		// Old workers are joined before new ones start, so the machine
+		// is never oversubscribed
+		defaultThreadPoolPointer().store(nullptr, std::memory_order_release);
+		pool.reset();
+		pool.reset(new ThreadPool(threads));
+		defaultThreadPoolPointer().store(pool.get(), std::memory_order_release);
+	}
+
+	// Returns number of threads used by the library's parallel algorithms
+	size_t getNumThreads()
+	{
+		return defaultThreadPool().numThreads();
+	}
+}
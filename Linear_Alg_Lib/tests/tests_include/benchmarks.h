@@ -12,6 +12,50 @@ void benchmarkDenseMatrixBasicMult();
 
 void benchmarkDenseMatrixStrassen();
 
+void benchmarkDenseMatrixBlockedMult();
+
+void benchmarkDenseMatrixParallelMult();
+
+void benchmarkDenseMatrixParallelStrassen();
+
+void benchmarkDenseMatrixStrassenWinograd();
+
+void benchmarkDenseMatrixExpressions();
+
+void benchmarkDenseMatrixInPlace();
+
+void benchmarkDenseMatrixConversion();
+
+void benchmarkDenseMatrixGemm();
+
+void benchmarkDenseMatrixGemv();
+
+void benchmarkDenseMatrixLUSolve();
+
+void benchmarkDenseMatrixBlockedLU();
+
+void benchmarkDenseMatrixCholesky();
+
+void benchmarkDenseMatrixLeastSquares();
+
+void benchmarkDenseMatrixTSQR();
+
+void benchmarkDenseMatrixTriangularSolve();
+
+void benchmarkDenseMatrixTrsm();
+
+void benchmarkDenseMatrixMixedPrecision();
+
+void benchmarkDenseMatrixEigensolver();
+
+void benchmarkDenseMatrixLanczos();
+
+void benchmarkDenseMatrixSVD();
+
+void benchmarkSparseMatrixConversion();
+
+void benchmarkSparseMatrixSpMV();
+
 
 
 #endif 
\ No newline at end of file
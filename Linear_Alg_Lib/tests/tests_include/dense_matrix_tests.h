@@ -17,10 +17,18 @@ void testDenseMatrixConvertColMajor();
 
 void testDenseMatrixConvertRowMajor();
 
+void testDenseTranspose();
+
+void testDenseLazyTranspose();
+
 void testDenseAdd();
 
 void testDenseSub();
 
+void testDenseExpressions();
+
+void testDenseInPlaceOps();
+
 void testDenseAtRowCol();
 
 void testDenseAddRowCol();
@@ -29,10 +37,44 @@ void testDenseRemoveRowCol();
 
 void testDenseSubMatrix();
 
+void testDenseViews();
+
 void testDenseEquals();
 
 void testDenseMult();
 
+void testDenseBlockedMult();
+
+void testDenseParallelMult();
+
+void testDenseGemm();
+
+void testDenseGemv();
+
+void testDenseParallelStrassen();
+
+void testDenseStrassenWorkspace();
+
+void testDenseStrassenWinograd();
+
 void testDenseLinearSolver();
 
+void testDenseTriangularSolve();
+
+void testDenseMixedPrecision();
+
+void testDenseLUFactorization();
+
+void testDenseCholesky();
+
+void testDenseQR();
+
+void testDenseTSQR();
+
+void testDenseSymmetricEigen();
+
+void testDenseKrylovEigen();
+
+void testDenseSVD();
+
 #endif
\ No newline at end of file
@@ -19,6 +19,8 @@ void testMathVectorAdd();
 
 void testMathVectorSubtract();
 
+void testMathVectorExpressions();
+
 void testMathVectorDotProduct();
 
 void testMathVectorCrossProduct();
@@ -27,4 +29,6 @@ void testMathVectorMagnitude();
 
 void testMathVectorNormalize();
 
+void testMathVectorSimdKernels();
+
 #endif
\ No newline at end of file
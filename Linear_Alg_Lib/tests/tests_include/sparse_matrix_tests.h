@@ -5,8 +5,22 @@
 // Unit tests for SparseMatrix class
 // ------------------------------------------------------------------
 
-//void testSparseMatrix();
-//
-//void testSparseCtor();
+void testSparseMatrix();
 
-#endif
\ No newline at end of file
+void testSparseCtor();
+
+void testSparseAtRowCol();
+
+void testSparseAddRemoveRowCol();
+
+void testSparseSubMatrix();
+
+void testSparseCompressed();
+
+void testSparseCompressedParallel();
+
+void testSparseSpMV();
+
+void testSparseSpMVParallel();
+
+#endif
@@ -57,19 +57,27 @@ inline void checkSparseMatrix(const SparseMatrix<DataType>& mat,
 	assert(mat.cols() == cols);
 }
 
-// Returns a randomly generated vector of size n
-inline std::vector<int> generateRandomVector(const size_t n)
+// Returns a randomly generated vector of size n, with values in
+// [0, bound); a small bound keeps products of int matrices from
+// overflowing
+inline std::vector<int> generateRandomVector(const size_t n, const size_t bound)
 {
 	std::vector<int> values(n);
 
-	auto generateRandomValues = [n]() -> int 
+	auto generateRandomValues = [bound]() -> int 
 		{ 
-			return rand() % n; 
+			return rand() % bound; 
 		};
 
 	generate(values.begin(), values.end(), generateRandomValues);
 	return values;
 }
 
+// Returns a randomly generated vector of size n, with values in [0, n)
+inline std::vector<int> generateRandomVector(const size_t n)
+{
+	return generateRandomVector(n, n);
+}
+
 
 #endif
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "../tests_include/benchmarks.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <functional>
+#include <iostream>
+#include <numeric>
+#include <thread>
 
 #include "../tests_include/benchmark_utils.h"
 #include "../tests_include/tests_utils.h"
@@ -17,6 +21,28 @@ void runBenchmarks()
 {
 	//benchmarkDenseMatrixBasicMult();
 	benchmarkDenseMatrixStrassen();
+	benchmarkDenseMatrixBlockedMult();
+	benchmarkDenseMatrixParallelMult();
+	benchmarkDenseMatrixParallelStrassen();
+	benchmarkDenseMatrixStrassenWinograd();
+	benchmarkDenseMatrixExpressions();
+	benchmarkDenseMatrixInPlace();
+	benchmarkDenseMatrixConversion();
+	benchmarkDenseMatrixGemm();
+	benchmarkDenseMatrixGemv();
+	benchmarkDenseMatrixLUSolve();
+	benchmarkDenseMatrixBlockedLU();
+	benchmarkDenseMatrixCholesky();
+	benchmarkDenseMatrixLeastSquares();
+	benchmarkDenseMatrixTSQR();
+	benchmarkDenseMatrixTriangularSolve();
+	benchmarkDenseMatrixTrsm();
+	benchmarkDenseMatrixMixedPrecision();
+	benchmarkDenseMatrixEigensolver();
+	benchmarkDenseMatrixLanczos();
+	benchmarkDenseMatrixSVD();
+	benchmarkSparseMatrixConversion();
+	benchmarkSparseMatrixSpMV();
 }
 
 // Used to determine that converting mat1 to RowMajor and mat2 to 
@@ -84,3 +110,826 @@ void benchmarkDenseMatrixStrassen()
 		strassen1, strassen2, 1, "strassen1_rowcol", "strassen2_rowcol", mat1_rowmaj, mat2_colmaj);
 }
 
+// Compares the packed, cache-blocked GEMM engine behind operator* 
+// against basicMultWithConversion
+void benchmarkDenseMatrixBlockedMult()
+{
+	const size_t n = 300;
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+
+	DenseMatrix<int> mat1_colmaj(data1, n, n);
+	DenseMatrix<int> mat1_rowmaj(data1, n, n, StorageType::RowMajor);
+	DenseMatrix<int> mat2_colmaj(data2, n, n);
+	DenseMatrix<int> mat2_rowmaj(data2, n, n, StorageType::RowMajor);
+
+	auto basic = [](const DenseMatrix<int>& mat1, const DenseMatrix<int>& mat2)
+		{
+			DenseMatrix<int> mat3 = basicMultWithConversion(mat1, mat2);
+		};
+
+	auto blocked = [](const DenseMatrix<int>& mat1, const DenseMatrix<int>& mat2)
+		{
+			DenseMatrix<int> mat3 = blockedMult(mat1, mat2);
+		};
+
+	compareExecutionTimes(
+		basic, blocked, 5, "basic_colcol", "blocked_colcol", mat1_colmaj, mat2_colmaj);
+	compareExecutionTimes(
+		basic, blocked, 5, "basic_colrow", "blocked_colrow", mat1_colmaj, mat2_rowmaj);
+	compareExecutionTimes(
+		basic, blocked, 5, "basic_rowrow", "blocked_rowrow", mat1_rowmaj, mat2_rowmaj);
+	compareExecutionTimes(
+		basic, blocked, 5, "basic_rowcol", "blocked_rowcol", mat1_rowmaj, mat2_colmaj);
+}
+
+// Prints the speedup curve of the parallel blocked GEMM engine as the
+// number of threads in the library's pool doubles up to the number of
+// hardware threads
+void benchmarkDenseMatrixParallelMult()
+{
+	const size_t n = 1024;
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+	DenseMatrix<double> mat1(DenseMatrix<int>(data1, n, n).view());
+	DenseMatrix<double> mat2(DenseMatrix<int>(data2, n, n).view());
+
+	auto mult = [](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = blockedMult(mat1, mat2);
+		};
+
+	size_t max_threads = std::thread::hardware_concurrency();
+	if (max_threads == 0)
+		max_threads = 1;
+
+	size_t original_threads = getNumThreads();
+	long long serial_time = 0;
+
+	for (size_t threads = 1; ; threads *= 2)
+	{
+		threads = std::min(threads, max_threads);
+		setNumThreads(threads);
+
+		long long time = measureAverageExecutionTime(mult, 3, mat1, mat2).count();
+		if (threads == 1)
+			serial_time = time;
+
+		std::cout << "parallel_mult_" << threads << "_threads: " << time
+			<< " (" << (double)serial_time / (double)time << "x)\n";
+
+		if (threads == max_threads)
+			break;
+	}
+	std::cout << "\n";
+
+	setNumThreads(original_threads);
+}
+
+// Compares task-parallel Strassen against the parallel blocked GEMM
+// engine on all hardware threads
+void benchmarkDenseMatrixParallelStrassen()
+{
+	const size_t n = 2048;
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+	DenseMatrix<double> mat1(DenseMatrix<int>(data1, n, n).view());
+	DenseMatrix<double> mat2(DenseMatrix<int>(data2, n, n).view());
+
+	auto blocked = [](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = blockedMult(mat1, mat2);
+		};
+
+	auto strassen_parallel = [](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = strassen(mat1, mat2, 256);
+		};
+
+	compareExecutionTimes(
+		blocked, strassen_parallel, 1, "blocked_parallel", "strassen_parallel", mat1, mat2);
+}
+
+// Tunes the Strassen-Winograd crossover for doubles, then compares 
+// Strassen-Winograd against classic Strassen and the blocked GEMM engine
+// using the tuned threshold
+void benchmarkDenseMatrixStrassenWinograd()
+{
+	const size_t n = 2048;
+
+	size_t crossover = tuneStrassenCrossover<double>(n);
+	if (crossover == STRASSEN_NO_CROSSOVER)
+	{
+		std::cout << "strassen_winograd crossover: none up to " << n << "\n\n";
+		crossover = n / 2;
+	}
+	else
+	{
+		std::cout << "strassen_winograd crossover: " << crossover << "\n\n";
+	}
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+	DenseMatrix<double> mat1(DenseMatrix<int>(data1, n, n).view());
+	DenseMatrix<double> mat2(DenseMatrix<int>(data2, n, n).view());
+
+	auto blocked = [](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = blockedMult(mat1, mat2);
+		};
+
+	auto classic = [crossover](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = strassen(mat1, mat2, crossover - 1);
+		};
+
+	auto winograd = [crossover](const DenseMatrix<double>& mat1, const DenseMatrix<double>& mat2)
+		{
+			DenseMatrix<double> mat3 = strassenWinograd(mat1, mat2, crossover - 1);
+		};
+
+	compareExecutionTimes(
+		blocked, winograd, 1, "blocked", "strassen_winograd", mat1, mat2);
+	compareExecutionTimes(
+		classic, winograd, 1, "strassen", "strassen_winograd", mat1, mat2);
+}
+
+// Compares a chain of element-wise operations evaluated one operator at
+// a time, with a temporary matrix per step, against the fused
+// expression templates, which make one pass and one allocation
+void benchmarkDenseMatrixExpressions()
+{
+	const size_t n = 1024;
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+
+	DenseMatrix<int> mat1_colmaj(data1, n, n);
+	DenseMatrix<int> mat2_colmaj(data2, n, n);
+	DenseMatrix<int> mat2_rowmaj(data2, n, n, StorageType::RowMajor);
+
+	auto stepwise = [](const DenseMatrix<int>& mat1, const DenseMatrix<int>& mat2)
+		{
+			DenseMatrix<int> sum = mat1 + mat2;
+			DenseMatrix<int> scaled = 2 * mat2;
+			DenseMatrix<int> difference = sum - scaled;
+			DenseMatrix<int> mat3 = difference + mat1;
+		};
+
+	auto fused = [](const DenseMatrix<int>& mat1, const DenseMatrix<int>& mat2)
+		{
+			DenseMatrix<int> mat3 = mat1 + mat2 - 2 * mat2 + mat1;
+		};
+
+	compareExecutionTimes(
+		stepwise, fused, 10, "stepwise_colcol", "fused_colcol", mat1_colmaj, mat2_colmaj);
+	compareExecutionTimes(
+		stepwise, fused, 10, "stepwise_colrow", "fused_colrow", mat1_colmaj, mat2_rowmaj);
+}
+
+// Compares accumulating many small products through temporaries, as
+// C = C + A * B, against accumulating them in place with C += A * B
+void benchmarkDenseMatrixInPlace()
+{
+	const size_t n = 16;
+	const size_t iterations = 20000;
+
+	std::vector<int> data1 = generateRandomVector(n * n);
+	std::vector<int> data2 = generateRandomVector(n * n);
+
+	DenseMatrix<int> mat1(data1, n, n);
+	DenseMatrix<int> mat2(data2, n, n);
+	DenseMatrix<int> mat3(n, n);
+
+	auto temporaries = [&](const DenseMatrix<int>& A, const DenseMatrix<int>& B)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				DenseMatrix<int> product = A * B;
+				mat3 = mat3 + product;
+			}
+		};
+
+	auto in_place = [&](const DenseMatrix<int>& A, const DenseMatrix<int>& B)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				mat3 += A * B;
+			}
+		};
+
+	compareExecutionTimes(
+		temporaries, in_place, 5, "temporaries", "in_place", mat1, mat2);
+}
+
+// Compares converting a matrix to column major with a plain element by
+// element loop against the tiled SIMD transpose, and against converting
+// in place
+void benchmarkDenseMatrixConversion()
+{
+	const size_t n = 2048;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(i % 1000);
+	}
+	DenseMatrix<double> mat(data, n, n, StorageType::RowMajor);
+
+	auto naive = [](const DenseMatrix<double>& mat)
+		{
+			std::vector<double> old_data = mat.getData();
+			std::vector<double> new_data(old_data.size());
+			for (size_t i = 0; i < old_data.size(); ++i)
+			{
+				new_data[(i % n) * n + i / n] = old_data[i];
+			}
+		};
+
+	auto tiled = [](const DenseMatrix<double>& mat)
+		{
+			DenseMatrix<double> converted = mat.convertToColMajor();
+		};
+
+	auto in_place = [](const DenseMatrix<double>& mat)
+		{
+			DenseMatrix<double> converted = mat;
+			converted.convertToColMajor();
+		};
+
+	compareExecutionTimes(naive, tiled, 5, "naive", "tiled", mat);
+	compareExecutionTimes(naive, in_place, 5, "naive", "in_place", mat);
+}
+
+// Compares computing C = 0.5 * A^T * B + 2 * C by transposing A, 
+// multiplying into a new matrix, and combining the results, against 
+// one gemm() call that reads A^T in place and scales C as it goes
+void benchmarkDenseMatrixGemm()
+{
+	const size_t n = 64;
+	const size_t iterations = 500;
+
+	std::vector<double> data1(n * n), data2(n * n);
+	for (size_t i = 0; i < data1.size(); ++i)
+	{
+		data1[i] = static_cast<double>(i % 17) - 8;
+		data2[i] = static_cast<double>(i % 13) - 6;
+	}
+
+	DenseMatrix<double> mat1(data1, n, n);
+	DenseMatrix<double> mat2(data2, n, n);
+	DenseMatrix<double> mat3(n, n);
+
+	auto temporaries = [&](const DenseMatrix<double>& A, const DenseMatrix<double>& B)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				DenseMatrix<double> A_t = A.transposed();
+				A_t.convertToColMajor();
+				DenseMatrix<double> product = blockedMult(A_t, B);
+				mat3 = 0.5 * product + 2.0 * mat3;
+			}
+		};
+
+	auto fused = [&](const DenseMatrix<double>& A, const DenseMatrix<double>& B)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				gemm(TransposeOp::Transpose, TransposeOp::NoTranspose,
+					0.5, A, B, 2.0, mat3);
+			}
+		};
+
+	compareExecutionTimes(
+		temporaries, fused, 5, "temporaries", "fused", mat1, mat2);
+}
+
+// Compares multiplying a matrix by a vector stored as an n x 1 matrix 
+// with basicMultWithConversion against the streaming GEMV kernels
+void benchmarkDenseMatrixGemv()
+{
+	const size_t n = 2000;
+	const size_t iterations = 20;
+
+	std::vector<double> data(n * n), vec_data(n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(i % 17) - 8;
+	}
+	for (size_t i = 0; i < n; ++i)
+	{
+		vec_data[i] = static_cast<double>(i % 13) - 6;
+	}
+
+	DenseMatrix<double> mat(data, n, n);
+	MathVector<double> vec(vec_data);
+
+	auto as_matrix = [&](const DenseMatrix<double>& A, const MathVector<double>& x)
+		{
+			DenseMatrix<double> x_mat(x.getData(), n, 1);
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				DenseMatrix<double> product = basicMultWithConversion(A, x_mat);
+			}
+		};
+
+	auto gemv = [&](const DenseMatrix<double>& A, const MathVector<double>& x)
+		{
+			for (size_t i = 0; i < iterations; ++i)
+			{
+				MathVector<double> product = A * x;
+			}
+		};
+
+	compareExecutionTimes(as_matrix, gemv, 5, "as_matrix", "gemv", mat, vec);
+}
+
+// Compares solving one system against many right hand sides by running
+// Gaussian elimination for every one of them, against factoring the 
+// matrix once with LUFactorization and reusing the factors
+void benchmarkDenseMatrixLUSolve()
+{
+	const size_t n = 200;
+	const size_t num_rhs = 50;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) - 50;
+	}
+	DenseMatrix<double> mat(data, n, n);
+
+	std::vector<MathVector<double> > rhs;
+	for (size_t i = 0; i < num_rhs; ++i)
+	{
+		std::vector<int> values = generateRandomVector(n);
+		rhs.push_back(MathVector<double>(std::vector<double>(values.begin(), values.end())));
+	}
+
+	auto eliminate = [&](const DenseMatrix<double>& A)
+		{
+			MathVector<double> x;
+			for (const MathVector<double>& b : rhs)
+			{
+				solveLinearEquation(A, b, x);
+			}
+		};
+
+	auto factored = [&](const DenseMatrix<double>& A)
+		{
+			LUFactorization<double> lu(A);
+			for (const MathVector<double>& b : rhs)
+			{
+				MathVector<double> x = lu.solve(b);
+			}
+		};
+
+	compareExecutionTimes(eliminate, factored, 3, "eliminate", "factored", mat);
+}
+
+// Compares row by row Gaussian elimination against the blocked LU
+// factorization, whose trailing updates run as parallel GEMMs, on one
+// large system
+void benchmarkDenseMatrixBlockedLU()
+{
+	const size_t n = 1000;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) - 50;
+	}
+	DenseMatrix<double> mat(data, n, n);
+
+	std::vector<int> values = generateRandomVector(n);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto elimination = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			gaussianElimination(A, b, x);
+		};
+
+	auto blocked_lu = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveLinearEquation(A, b, x);
+		};
+
+	compareExecutionTimes(elimination, blocked_lu, 3, "elimination", "blocked_lu", mat, vec);
+}
+
+// Compares solving a symmetric positive definite system with LU against
+// the Cholesky path of solveSymmetricLinearEquation
+void benchmarkDenseMatrixCholesky()
+{
+	const size_t n = 1000;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) / 10 - 5;
+	}
+	DenseMatrix<double> M(data, n, n);
+	DenseMatrix<double> mat = product(M, TransposeOp::Transpose, M, TransposeOp::NoTranspose);
+	for (size_t i = 0; i < n; ++i)
+	{
+		mat.at(i, i) += n;
+	}
+
+	std::vector<int> values = generateRandomVector(n);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto lu = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveLinearEquation(A, b, x);
+		};
+
+	auto cholesky = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveSymmetricLinearEquation(A, b, x);
+		};
+
+	compareExecutionTimes(lu, cholesky, 3, "lu", "cholesky", mat, vec);
+}
+
+// Compares least squares through the normal equations A^T A x = A^T b,
+// solved by Cholesky, against the blocked Householder QR of
+// solveLeastSquares, which squares neither A nor its condition number
+void benchmarkDenseMatrixLeastSquares()
+{
+	const size_t m = 2000;
+	const size_t n = 400;
+
+	std::vector<double> data(m * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) / 10 - 5;
+	}
+	DenseMatrix<double> mat(data, m, n);
+
+	std::vector<int> values = generateRandomVector(m);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto normal_equations = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			DenseMatrix<double> AtA = product(A, TransposeOp::Transpose, A, TransposeOp::NoTranspose);
+			MathVector<double> Atb(std::vector<double>(A.cols()));
+			gemv(TransposeOp::Transpose, 1.0, A, b, 0.0, Atb);
+			MathVector<double> x;
+			solveSymmetricLinearEquation(AtA, Atb, x);
+		};
+
+	auto qr = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveLeastSquares(A, b, x);
+		};
+
+	compareExecutionTimes(normal_equations, qr, 3, "normal_equations", "qr", mat, vec);
+}
+
+// Compares least squares on a tall, skinny matrix held in memory as a
+// whole against streaming it through TSQRFactorization in row batches
+void benchmarkDenseMatrixTSQR()
+{
+	const size_t m = 200000;
+	const size_t n = 20;
+	const size_t batch_rows = 10000;
+
+	std::vector<double> data(m * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) / 10 - 5;
+	}
+	DenseMatrix<double> mat(data, m, n, StorageType::RowMajor);
+
+	std::vector<int> values = generateRandomVector(m);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto whole = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveLeastSquares(A, b, x);
+		};
+
+	auto streamed = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			TSQRFactorization<double> tsqr(A.cols(), 1);
+			for (size_t first = 0; first < A.rows(); first += batch_rows)
+			{
+				size_t last = std::min(first + batch_rows, A.rows());
+				tsqr.addBatch(A.subMatrixView(first, last, 0, A.cols()),
+					DenseMatrix<double>(b.view().subView(first, last).toStdVector(),
+						last - first, 1).view());
+			}
+			DenseMatrix<double> x = tsqr.solve();
+		};
+
+	compareExecutionTimes(whole, streamed, 3, "whole", "streamed", mat, vec);
+}
+
+// Compares back substitution that reads a RowMajor triangle down its
+// columns with at() against the blocked trsv kernel
+void benchmarkDenseMatrixTriangularSolve()
+{
+	const size_t n = 2000;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = (i % (n + 1) == 0) ? 10 : static_cast<double>(rand() % 100) / 100;
+	}
+	DenseMatrix<double> mat(data, n, n, StorageType::RowMajor);
+
+	std::vector<int> values = generateRandomVector(n);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto element_access = [](const DenseMatrix<double>& U, const MathVector<double>& y)
+		{
+			MathVector<double> x = y;
+			for (int i = U.rows() - 1; i >= 0; --i)
+			{
+				x[i] /= U.at(i, i);
+				for (int j = 0; j < i; ++j)
+				{
+					x[j] -= U.at(j, i) * x[i];
+				}
+			}
+		};
+
+	auto blocked = [](const DenseMatrix<double>& U, const MathVector<double>& y)
+		{
+			MathVector<double> x = solveUpperTriangularSystem(U, y);
+		};
+
+	compareExecutionTimes(element_access, blocked, 3, "element_access", "blocked", mat, vec);
+}
+
+// Compares solving a triangular system for a matrix of right hand sides
+// one column at a time against one blocked trsm call
+void benchmarkDenseMatrixTrsm()
+{
+	const size_t n = 1000;
+	const size_t num_rhs = 200;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = (i % (n + 1) == 0) ? 10 : static_cast<double>(rand() % 100) / 100;
+	}
+	DenseMatrix<double> mat(data, n, n);
+	DenseMatrix<double> rhs(DenseMatrix<int>(generateRandomVector(n * num_rhs), n, num_rhs).view());
+
+	auto by_column = [](const DenseMatrix<double>& L, const DenseMatrix<double>& B)
+		{
+			DenseMatrix<double> X = B;
+			for (size_t j = 0; j < X.cols(); ++j)
+			{
+				trsv<double>(TriangleType::Lower, TransposeOp::NoTranspose, DiagonalType::NonUnit,
+					L.view(), X.colView(j));
+			}
+		};
+
+	auto blocked = [](const DenseMatrix<double>& L, const DenseMatrix<double>& B)
+		{
+			DenseMatrix<double> X = B;
+			trsm(TriangleType::Lower, TransposeOp::NoTranspose, DiagonalType::NonUnit, L, X);
+		};
+
+	compareExecutionTimes(by_column, blocked, 3, "by_column", "blocked", mat, rhs);
+}
+
+// Compares a double precision LU solve against factoring in single
+// precision and refining the solution back to double precision accuracy
+void benchmarkDenseMatrixMixedPrecision()
+{
+	const size_t n = 1000;
+
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = (i % (n + 1) == 0) ? 100 : static_cast<double>(rand() % 100) / 50 - 1;
+	}
+	DenseMatrix<double> mat(data, n, n);
+
+	std::vector<int> values = generateRandomVector(n);
+	MathVector<double> vec(std::vector<double>(values.begin(), values.end()));
+
+	auto double_lu = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveLinearEquation(A, b, x);
+		};
+
+	auto mixed = [](const DenseMatrix<double>& A, const MathVector<double>& b)
+		{
+			MathVector<double> x;
+			solveMixedPrecision(A, b, x);
+		};
+
+	compareExecutionTimes(double_lu, mixed, 3, "double_lu", "mixed", mat, vec);
+}
+
+// Measures what eigenvectors add to the symmetric eigensolver; both
+// paths share the blocked tridiagonalization, and the vectors add the
+// rotations of the QL sweeps and the back-transformation as GEMMs
+void benchmarkDenseMatrixEigensolver()
+{
+	const size_t n = 500;
+
+	DenseMatrix<double> mat(n, n);
+	for (size_t j = 0; j < n; ++j)
+	{
+		for (size_t i = j; i < n; ++i)
+		{
+			mat.at(i, j) = static_cast<double>(rand() % 100) / 50 - 1;
+			mat.at(j, i) = mat.at(i, j);
+		}
+	}
+
+	auto values_only = [](const DenseMatrix<double>& A)
+		{
+			SymmetricEigensolver<double> eigen(A, false);
+		};
+
+	auto with_vectors = [](const DenseMatrix<double>& A)
+		{
+			SymmetricEigensolver<double> eigen(A);
+		};
+
+	compareExecutionTimes(values_only, with_vectors, 3, "values_only", "with_vectors", mat);
+}
+
+// Compares the dense eigensolver against Lanczos for the few largest
+// eigenvalues, which only multiplies the matrix with vectors
+void benchmarkDenseMatrixLanczos()
+{
+	const size_t n = 1500;
+
+	DenseMatrix<double> mat(n, n);
+	for (size_t j = 0; j < n; ++j)
+	{
+		for (size_t i = j; i < n; ++i)
+		{
+			mat.at(i, j) = static_cast<double>(rand() % 100) / 50 - 1;
+			mat.at(j, i) = mat.at(i, j);
+		}
+	}
+
+	auto dense = [](const DenseMatrix<double>& A)
+		{
+			SymmetricEigensolver<double> eigen(A, false);
+		};
+
+	auto lanczos = [](const DenseMatrix<double>& A)
+		{
+			LanczosEigensolver<double> eigen([&A](const MathVector<double>& x)
+				{
+					return MathVector<double>(A * x);
+				}, A.rows(), 6);
+		};
+
+	compareExecutionTimes(dense, lanczos, 3, "dense", "lanczos", mat);
+}
+
+// Compares the full Jacobi SVD against the randomized SVD for the 20
+// largest singular values and vectors
+void benchmarkDenseMatrixSVD()
+{
+	const size_t m = 2000;
+	const size_t n = 400;
+
+	std::vector<double> data(m * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<double>(rand() % 100) / 50 - 1;
+	}
+	DenseMatrix<double> mat(data, m, n);
+
+	auto jacobi = [](const DenseMatrix<double>& A)
+		{
+			JacobiSVD<double> svd(A);
+		};
+
+	auto randomized = [](const DenseMatrix<double>& A)
+		{
+			RandomizedSVD<double> svd(A, 20);
+		};
+
+	compareExecutionTimes(jacobi, randomized, 3, "jacobi", "randomized", mat);
+}
+
+// Counting sort conversion from COO to CSR against sorting the
+// triplets by (row, col) with std::sort and merging duplicates
+void benchmarkSparseMatrixConversion()
+{
+	const size_t n = 200000;
+	const size_t num_entries = 2000000;
+
+	std::vector<double> data(num_entries);
+	std::vector<size_t> rows(num_entries);
+	std::vector<size_t> cols(num_entries);
+	for (size_t k = 0; k < num_entries; ++k)
+	{
+		rows[k] = rand() % n;
+		cols[k] = rand() % n;
+		data[k] = static_cast<double>(rand() % 100) / 50 - 1;
+	}
+	SparseMatrix<double> coo(data, rows, cols, n, n);
+
+	auto comparison_sort = [](const SparseMatrix<double>& A)
+		{
+			std::vector<size_t> row_indices = A.getRowIndices();
+			std::vector<size_t> col_indices = A.getColIndices();
+			std::vector<double> values = A.getData();
+			std::vector<size_t> order(values.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
+				{
+					return row_indices[a] < row_indices[b] ||
+						(row_indices[a] == row_indices[b] && col_indices[a] < col_indices[b]);
+				});
+
+			std::vector<size_t> pointers(A.rows() + 1, 0);
+			std::vector<size_t> indices;
+			std::vector<double> sorted_values;
+			for (size_t p = 0; p < order.size(); ++p)
+			{
+				size_t k = order[p];
+				if (p > 0 && row_indices[k] == row_indices[order[p - 1]] &&
+					col_indices[k] == col_indices[order[p - 1]])
+				{
+					sorted_values.back() += values[k];
+					continue;
+				}
+				++pointers[row_indices[k] + 1];
+				indices.push_back(col_indices[k]);
+				sorted_values.push_back(values[k]);
+			}
+			std::partial_sum(pointers.begin(), pointers.end(), pointers.begin());
+			CSRMatrix<double> csr(std::move(pointers), std::move(indices),
+				std::move(sorted_values), A.rows(), A.cols());
+		};
+
+	auto counting_sort = [](const SparseMatrix<double>& A)
+		{
+			CSRMatrix<double> csr(A);
+		};
+
+	compareExecutionTimes(comparison_sort, counting_sort, 3,
+		"comparison sort", "counting sort", coo);
+}
+
+// Merge path SpMV with the SIMD sparse dot kernel against a plain
+// row by row loop over the CSR arrays, on a matrix whose row lengths
+// follow a power law
+void benchmarkSparseMatrixSpMV()
+{
+	const size_t n = 200000;
+	const size_t num_entries = 2000000;
+
+	std::vector<double> data(num_entries);
+	std::vector<size_t> rows(num_entries);
+	std::vector<size_t> cols(num_entries);
+	for (size_t k = 0; k < num_entries; ++k)
+	{
+		double u = static_cast<double>(rand() % 10000) / 10000;
+		rows[k] = static_cast<size_t>(n * u * u * u);
+		cols[k] = (static_cast<size_t>(rand()) * RAND_MAX + rand()) % n;
+		data[k] = static_cast<double>(rand() % 100) / 50 - 1;
+	}
+	CSRMatrix<double> csr(SparseMatrix<double>(data, rows, cols, n, n));
+
+	std::vector<double> x_data(n);
+	for (size_t j = 0; j < n; ++j)
+		x_data[j] = static_cast<double>(rand() % 100) / 50 - 1;
+	MathVector<double> x(x_data);
+
+	auto row_loop = [](const CSRMatrix<double>& A, const MathVector<double>& x)
+		{
+			const std::vector<size_t>& pointers = A.getPointers();
+			const std::vector<size_t>& indices = A.getIndices();
+			const std::vector<double>& values = A.getData();
+			std::vector<double> y(A.rows());
+			for (size_t i = 0; i < A.rows(); ++i)
+			{
+				double sum = 0;
+				for (size_t p = pointers[i]; p < pointers[i + 1]; ++p)
+					sum += values[p] * x[indices[p]];
+				y[i] = sum;
+			}
+		};
+
+	auto merge_path = [](const CSRMatrix<double>& A, const MathVector<double>& x)
+		{
+			MathVector<double> y = A * x;
+		};
+
+	compareExecutionTimes(row_loop, merge_path, 20, "row loop", "merge path", csr, x);
+}
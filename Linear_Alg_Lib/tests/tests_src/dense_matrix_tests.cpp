@@ -1,6 +1,7 @@
 #include "../tests_include/dense_matrix_tests.h"
 
 #include <cassert>
+#include <chrono>
 #include <numeric>
 #include "../tests_include/tests_utils.h"
 #include "../../include/linalg.h"
@@ -18,16 +19,37 @@ void testDenseMatrix()
 	testDenseMatrixSetData();
 	testDenseMatrixConvertColMajor();
 	testDenseMatrixConvertRowMajor();
+	testDenseTranspose();
+	testDenseLazyTranspose();
 	//testDenseMatrixInsertion();
 	testDenseAdd();
 	testDenseSub();
+	testDenseExpressions();
+	testDenseInPlaceOps();
 	testDenseAtRowCol();
 	testDenseAddRowCol();
 	testDenseRemoveRowCol();
 	testDenseSubMatrix();
+	testDenseViews();
 	testDenseEquals();
 	testDenseMult();
+	testDenseBlockedMult();
+	testDenseParallelMult();
+	testDenseGemm();
+	testDenseGemv();
+	testDenseParallelStrassen();
+	testDenseStrassenWorkspace();
+	testDenseStrassenWinograd();
 	testDenseLinearSolver();
+	testDenseTriangularSolve();
+	testDenseMixedPrecision();
+	testDenseLUFactorization();
+	testDenseCholesky();
+	testDenseQR();
+	testDenseTSQR();
+	testDenseSymmetricEigen();
+	testDenseKrylovEigen();
+	testDenseSVD();
 
 	std::cout << "DenseMatrix tests complete\n";
 }
@@ -187,6 +209,183 @@ void testDenseMatrixConvertRowMajor()
 	assert(mat5.getData() == data4);
 }
 
+// Checks transposeKernel(), transposeInto(), and transposeInPlace() for
+// one data type against a plain loop
+template <typename DataType>
+void checkTranspose()
+{
+	// Shapes cover partial register blocks, partial tiles, and vectors
+	std::vector<std::pair<size_t, size_t> > shapes{ { 1, 1 }, { 1, 7 },
+		{ 9, 1 }, { 3, 5 }, { 8, 8 }, { 13, 29 }, { 33, 33 }, { 64, 40 },
+		{ 70, 70 } };
+
+	for (const std::pair<size_t, size_t>& shape : shapes)
+	{
+		size_t rows = shape.first;
+		size_t cols = shape.second;
+
+		// Source rows are padded, as in a sub-matrix view
+		size_t src_ld = cols + 3;
+		std::vector<DataType> src(rows * src_ld);
+		for (size_t i = 0; i < src.size(); ++i)
+		{
+			src[i] = static_cast<DataType>(i % 251);
+		}
+
+		std::vector<DataType> expected(rows * cols);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			for (size_t j = 0; j < cols; ++j)
+			{
+				expected[j * rows + i] = src[i * src_ld + j];
+			}
+		}
+
+		std::vector<DataType> dst(rows * cols);
+		transposeKernel(src.data(), src_ld, dst.data(), rows, rows, cols);
+		assert(dst == expected);
+
+		std::fill(dst.begin(), dst.end(), static_cast<DataType>(0));
+		transposeInto(src.data(), src_ld, dst.data(), rows, rows, cols);
+		assert(dst == expected);
+
+		// In place works on contiguous data only
+		std::vector<DataType> data(rows * cols);
+		for (size_t i = 0; i < rows; ++i)
+		{
+			std::copy(src.begin() + i * src_ld, src.begin() + i * src_ld + cols,
+				data.begin() + i * cols);
+		}
+		transposeInPlace(data.data(), rows, cols);
+		assert(data == expected);
+	}
+}
+
+// Tests the transposes behind storage type conversions
+void testDenseTranspose()
+{
+	SimdLevel original_level = activeSimdLevel();
+	std::vector<SimdLevel> levels{ SimdLevel::Scalar, SimdLevel::SSE2,
+		SimdLevel::AVX2, SimdLevel::AVX512 };
+
+	// Every instruction set up to the detected one
+	for (SimdLevel level : levels)
+	{
+		if (level > detectedSimdLevel())
+			break;
+
+		setSimdLevel(level);
+		checkTranspose<float>();
+		checkTranspose<double>();
+		checkTranspose<int32_t>();
+		checkTranspose<int64_t>();
+		checkTranspose<short>();
+	}
+	setSimdLevel(original_level);
+
+	// Large enough to run in parallel, for both the tiled and the 
+	// cycle-following in-place transposes
+	std::vector<std::pair<size_t, size_t> > shapes{ { 700, 700 }, { 900, 500 } };
+	for (const std::pair<size_t, size_t>& shape : shapes)
+	{
+		size_t rows = shape.first;
+		size_t cols = shape.second;
+		std::vector<double> data(rows * cols);
+		std::iota(data.begin(), data.end(), 0.0);
+
+		DenseMatrix<double> mat(data, rows, cols, StorageType::RowMajor);
+		mat.convertToColMajor();
+		assert(mat.getStorageType() == StorageType::ColumnMajor);
+		assert(mat.getData() == convertToColMajorHelper(data, rows, cols));
+		for (size_t i = 0; i < rows; i += 37)
+		{
+			for (size_t j = 0; j < cols; j += 41)
+			{
+				assert(mat.at(i, j) == data[i * cols + j]);
+			}
+		}
+
+		mat.convertToRowMajor();
+		assert(mat.getData() == data);
+
+		std::vector<double> in_place = data;
+		transposeInPlace(in_place.data(), rows, cols);
+		const DenseMatrix<double>& const_mat = mat;
+		assert(in_place == const_mat.convertToColMajor().getData());
+	}
+}
+
+// Tests transposes that flip the storage type instead of moving data
+void testDenseLazyTranspose()
+{
+	DenseMatrix<int> mat({ 1, 2, 3, 4, 5, 6 }, 2, 3, StorageType::RowMajor);
+	DenseMatrix<int> expected({ 1, 4, 2, 5, 3, 6 }, 3, 2, StorageType::RowMajor);
+
+	MatrixView<int> view = mat.transposeView();
+	assert(view.rows() == 3 && view.cols() == 2);
+	assert(view.data() == mat.view().data());
+	assert(DenseMatrix<int>(view, StorageType::RowMajor) == expected);
+	assert(view.transposed()(1, 2) == 6);
+
+	// Writes through the view land in the original matrix
+	view(2, 0) = 9;
+	assert(mat.at(0, 2) == 9);
+	view(2, 0) = 3;
+
+	// Transposing a sub-matrix view keeps its leading dimension
+	MatrixView<const int> sub = mat.subMatrixView(0, 2, 1, 3).transposed();
+	assert(sub.rows() == 2 && sub.cols() == 2);
+	assert(sub(0, 1) == 5 && sub(1, 0) == 3);
+
+	// Same data, read in the opposite order
+	DenseMatrix<int> copy = mat.transposed();
+	checkDenseMatrix(copy, mat.getData(), 3, 2, StorageType::ColumnMajor);
+	assert(DenseMatrix<int>(copy.view(), StorageType::RowMajor) == expected);
+
+	mat.transpose();
+	assert(mat == copy);
+	mat.transpose();
+	assert(mat.rows() == 2 && mat.getStorageType() == StorageType::RowMajor);
+
+	// Products with transposed operands match products of transposed copies
+	DenseMatrix<double> A(37, 23), B(37, 29);
+	for (size_t i = 0; i < A.size(); ++i)
+	{
+		A.at(i % 37, i / 37) = static_cast<double>((i * 7) % 11) - 5;
+	}
+	for (size_t i = 0; i < B.size(); ++i)
+	{
+		B.at(i % 37, i / 37) = static_cast<double>((i * 5) % 13) - 6;
+	}
+	// Reference transpose, built by moving data
+	const DenseMatrix<double>& const_A = A;
+	DenseMatrix<double> A_t = const_A.convertToRowMajor();
+	A_t.transpose();
+	A_t.convertToColMajor();
+
+	DenseMatrix<double> gram = product(A, TransposeOp::Transpose, A, TransposeOp::NoTranspose);
+	assert(gram == A_t * A);
+	assert(gram.getStorageType() == StorageType::ColumnMajor);
+	DenseMatrix<double> AtB = A.transposeView() * B.view();
+	assert(AtB.getStorageType() == StorageType::RowMajor);
+	assert(DenseMatrix<double>(AtB.view(), StorageType::ColumnMajor) == A_t * B);
+
+	// (A^T B)^T = B^T A
+	DenseMatrix<double> BtA = product(B, TransposeOp::Transpose, A_t, TransposeOp::Transpose);
+	assert(DenseMatrix<double>(BtA.transposeView(), StorageType::RowMajor) == AtB);
+
+	bool caught = false;
+	try
+	{
+		product(A, TransposeOp::NoTranspose, B, TransposeOp::NoTranspose);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
 void testDenseAdd()
 {
 	// colmaj + colmaj
@@ -291,6 +490,217 @@ void testDenseSub()
 	checkDenseMatrix(mat17, data17, 2, 5, StorageType::ColumnMajor);
 }
 
+// Tests expression templates for chained element-wise operations
+void testDenseExpressions()
+{
+	// Chains of +, -, and scaling are evaluated in one pass
+	std::vector<int> data1{ 1, 2, 3, 4, 5, 6 };
+	std::vector<int> data2{ 6, 5, 4, 3, 2, 1 };
+	std::vector<int> data3{ 1, 0, 1, 0, 1, 0 };
+	DenseMatrix<int> mat1(data1, 2, 3);
+	DenseMatrix<int> mat2(data2, 2, 3);
+	DenseMatrix<int> mat3(data3, 2, 3);
+	DenseMatrix<int> mat4 = mat1 + 2 * mat2 - mat3 * 3;
+	std::vector<int> data4{ 10, 12, 8, 10, 6, 8 };
+	checkDenseMatrix(mat4, data4, 2, 3, StorageType::ColumnMajor);
+
+	DenseMatrix<int> mat5 = 2 * (mat1 - mat2) + mat3;
+	std::vector<int> data5{ -9, -6, -1, 2, 7, 10 };
+	checkDenseMatrix(mat5, data5, 2, 3, StorageType::ColumnMajor);
+
+	// Mixed storage types are converted inside the pass; the result 
+	// takes the storage type of the leftmost operand
+	std::vector<int> data6{ 1, 4, 2, 5, 3, 6 };
+	DenseMatrix<int> mat6(data6, 2, 3, StorageType::RowMajor);
+	DenseMatrix<int> mat7 = mat6 + mat1 - mat3;
+	std::vector<int> data7{ 1, 6, 6, 7, 7, 12 };
+	checkDenseMatrix(mat7, data7, 2, 3, StorageType::RowMajor);
+
+	// Views and expressions mix freely
+	DenseMatrix<int> mat8 = mat1.subMatrixView(0, 2, 1, 3) +
+		mat6.subMatrixView(0, 2, 0, 2) * 2;
+	std::vector<int> data8{ 5, 14, 13, 12 };
+	checkDenseMatrix(mat8, data8, 2, 2, StorageType::ColumnMajor);
+
+	// Assignment overwrites in place, even if the matrix is an operand
+	mat4 = mat4 - mat1 - mat1;
+	std::vector<int> data9{ 8, 8, 2, 2, -4, -4 };
+	checkDenseMatrix(mat4, data9, 2, 3, StorageType::ColumnMajor);
+
+	// Assigning an expression of another storage type takes its type
+	mat4 = mat6 + mat6;
+	std::vector<int> data10{ 2, 8, 4, 10, 6, 12 };
+	checkDenseMatrix(mat4, data10, 2, 3, StorageType::RowMajor);
+
+	assert(mat4 == mat6 + mat6);
+	assert(mat6 + mat6 == mat4);
+	assert(mat4 != mat6 + mat1);
+
+	bool caught = false;
+	try
+	{
+		DenseMatrix<int> mat11 = mat1 + mat8;
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	// Large expressions are evaluated in parallel bands
+	size_t n = 300;
+	DenseMatrix<int> big1(n, n, StorageType::ColumnMajor);
+	DenseMatrix<int> big2(n, n, StorageType::RowMajor);
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			big1.at(i, j) = static_cast<int>(i + 2 * j);
+			big2.at(i, j) = static_cast<int>(i * j % 7);
+		}
+	}
+
+	DenseMatrix<int> big3 = 3 * big1 - big2 + big1;
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			assert(big3.at(i, j) == 4 * big1.at(i, j) - big2.at(i, j));
+		}
+	}
+}
+
+// Tests compound assignment and destination-passing functions, which
+// write into existing storage
+void testDenseInPlaceOps()
+{
+	std::vector<int> data1{ 1, 2, 3, 4, 5, 6 };
+	std::vector<int> data2{ 6, 5, 4, 3, 2, 1 };
+	DenseMatrix<int> mat1(data1, 2, 3);
+	DenseMatrix<int> mat2(data2, 2, 3, StorageType::RowMajor);
+	const int* mat1_data = mat1.view().data();
+
+	// mat2 in column major order is { 6, 3, 5, 2, 4, 1 }
+	mat1 += mat2;
+	std::vector<int> data3{ 7, 5, 8, 6, 9, 7 };
+	checkDenseMatrix(mat1, data3, 2, 3, StorageType::ColumnMajor);
+
+	mat1 -= 2 * mat2;
+	std::vector<int> data4{ -5, -1, -2, 2, 1, 5 };
+	checkDenseMatrix(mat1, data4, 2, 3, StorageType::ColumnMajor);
+
+	mat1 *= 3;
+	std::vector<int> data5{ -15, -3, -6, 6, 3, 15 };
+	checkDenseMatrix(mat1, data5, 2, 3, StorageType::ColumnMajor);
+
+	mat1 += mat1.view();
+	std::vector<int> data6{ -30, -6, -12, 12, 6, 30 };
+	checkDenseMatrix(mat1, data6, 2, 3, StorageType::ColumnMajor);
+	assert(mat1.view().data() == mat1_data);
+
+	// Operands that overlap the destination in another order, such as its
+	// transpose, are evaluated through a temporary
+	std::vector<int> square_data{ 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	std::vector<int> symmetric{ 2, 6, 10, 6, 10, 14, 10, 14, 18 };
+	std::vector<int> skew{ 0, -2, -4, 2, 0, -2, 4, 2, 0 };
+	DenseMatrix<int> square(square_data, 3, 3, StorageType::RowMajor);
+	square = square + square.transposeView();
+	checkDenseMatrix(square, symmetric, 3, 3, StorageType::RowMajor);
+
+	square = DenseMatrix<int>(square_data, 3, 3, StorageType::RowMajor);
+	square += square.transposeView();
+	checkDenseMatrix(square, symmetric, 3, 3, StorageType::RowMajor);
+
+	square = DenseMatrix<int>(square_data, 3, 3, StorageType::RowMajor);
+	square -= square.transposeView();
+	checkDenseMatrix(square, skew, 3, 3, StorageType::RowMajor);
+
+	square = DenseMatrix<int>(square_data, 3, 3, StorageType::RowMajor);
+	add(square.view(), square.transposeView(), square.view());
+	checkDenseMatrix(square, symmetric, 3, 3, StorageType::RowMajor);
+
+	// C += A * B and C -= A * B accumulate without a temporary
+	std::vector<int> data7{ 1, 2, 3, 4 };
+	std::vector<int> data8{ 1, 0, 2, 1 };
+	DenseMatrix<int> A(data7, 2, 2);
+	DenseMatrix<int> B(data8, 2, 2, StorageType::RowMajor);
+	DenseMatrix<int> C(2, 2);
+	const int* C_data = C.view().data();
+
+	C += A * B;
+	DenseMatrix<int> product = A * B;
+	assert(C == product);
+	C += A * B;
+	assert(C == product + product);
+	C -= A * B;
+	assert(C == product);
+	assert(C.view().data() == C_data);
+
+	// Products that read the destination go through a temporary
+	DenseMatrix<int> D = C;
+	D += D * B;
+	assert(D == C + product * B);
+
+	// Mixed products and expressions
+	assert(A * B + C == product + product);
+	assert(C - A * B == DenseMatrix<int>(2, 2));
+	assert(2 * (A * B) == product + product);
+	assert(A * B * B == product * B);
+	assert(A * B - A * B == DenseMatrix<int>(2, 2));
+
+	// Destination-passing functions keep the storage type of out
+	DenseMatrix<int> out(2, 3, StorageType::RowMajor);
+	add(mat1, mat2, out);
+	assert(out.getStorageType() == StorageType::RowMajor);
+	assert(DenseMatrix<int>(out.view(), StorageType::ColumnMajor) == mat1 + mat2);
+	subtract(mat1, 3 * mat2, out);
+	assert(DenseMatrix<int>(out.view(), StorageType::ColumnMajor) == mat1 - 3 * mat2);
+
+	DenseMatrix<int> out2(2, 2, StorageType::RowMajor);
+	multiply(A, B, out2);
+	assert(out2 == DenseMatrix<int>(product.view(), StorageType::RowMajor));
+	multiplyAdd(A, B, out2, -2);
+	assert(DenseMatrix<int>(out2.view(), StorageType::ColumnMajor) == DenseMatrix<int>(2, 2) - product);
+
+	bool caught = false;
+	try
+	{
+		multiply(A, B, out);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		add(A, B, out);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	// Large in-place products split across the thread pool
+	size_t n = 150;
+	DenseMatrix<double> big1(n, n), big2(n, n, StorageType::RowMajor);
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			big1.at(i, j) = static_cast<double>((i + j) % 5);
+			big2.at(i, j) = static_cast<double>((i * j) % 3);
+		}
+	}
+	DenseMatrix<double> big3 = big1;
+	big3 += big1 * big2;
+	DenseMatrix<double> expected = big1 + basicMultWithConversion(big1, big2);
+	assert(big3 == expected);
+}
+
 void testDenseAtRowCol()
 {
 	// rowmaj
@@ -595,6 +1005,93 @@ void testDenseSubMatrix()
 	mat1.setSubMatrix(0, 4, 0, 2, sub_mat);
 }
 
+void testDenseViews()
+{
+	std::vector<int> data1{ 1, 4, 2, 3, 4, 5, 1, 2, 5, 1, 7, 2, 1, 6, 3, 4 };
+	DenseMatrix<int> mat1(data1, 4, 4);
+
+	/*
+	1 4 5 1
+	4 5 1 6
+	2 1 7 3
+	3 2 2 4
+	*/
+
+	// Row and column views of a column major matrix
+	VectorView<int> row1 = mat1.rowView(1);
+	assert(row1.size() == 4 && row1.stride() == 4);
+	assert(row1.toStdVector() == std::vector<int>({ 4, 5, 1, 6 }));
+	assert(mat1.colView(2).toStdVector() == std::vector<int>({ 5, 1, 7, 2 }));
+
+	// Writes through a view go straight into the matrix
+	row1[2] = 9;
+	assert(mat1.at(1, 2) == 9);
+	mat1.colView(0).scale(2);
+	assert(mat1.col(0) == MathVector<int>({ 2, 8, 4, 6 }));
+
+	// Sub-matrix views share the matrix's data and leading dimension
+	MatrixView<int> sub_view = mat1.subMatrixView(1, 4, 1, 3);
+	assert(sub_view.rows() == 3 && sub_view.cols() == 2);
+	assert(sub_view.leadingDim() == 4);
+	assert(sub_view.at(0, 1) == 9);
+	sub_view(2, 0) = 0;
+	assert(mat1.at(3, 1) == 0);
+	assert(DenseMatrix<int>(sub_view).getData() == 
+		std::vector<int>({ 5, 1, 0, 9, 7, 2 }));
+
+	// Views of views
+	MatrixView<int> sub_sub_view = sub_view.subView(1, 3, 1, 2);
+	assert(sub_sub_view.at(0, 0) == 7 && sub_sub_view.at(1, 0) == 2);
+
+	// Row major views and assignment between storage types
+	DenseMatrix<int> mat2(mat1.view(), StorageType::RowMajor);
+	const DenseMatrix<int>& const_mat2 = mat2;
+	assert(mat2.getStorageType() == StorageType::RowMajor);
+	assert(mat2.rowView(1).isContiguous());
+	assert(const_mat2.convertToColMajor() == mat1);
+	mat2.subMatrixView(0, 2, 0, 2).assign(mat1.subMatrixView(2, 4, 2, 4));
+	DenseMatrix<int> mat1_corner = mat1.getSubMatrix(2, 4, 2, 4);
+	mat1_corner.convertToRowMajor();
+	assert(mat2.getSubMatrix(0, 2, 0, 2) == mat1_corner);
+
+	// Arithmetic on views of mixed storage types
+	DenseMatrix<int> sum = mat1.subMatrixView(0, 2, 0, 2) + 
+		mat2.subMatrixView(2, 4, 2, 4);
+	DenseMatrix<int> mat2_corner = mat2.getSubMatrix(2, 4, 2, 4);
+	mat2_corner.convertToColMajor();
+	DenseMatrix<int> expected_sum = mat1.getSubMatrix(0, 2, 0, 2) + mat2_corner;
+	assert(sum == expected_sum);
+
+	// Dot products of strided views
+	assert(dotProduct(mat1.rowView(0), mat2.colView(0)) ==
+		dotProduct(mat1.row(0), mat2.col(0)));
+
+	// Out of bounds views
+	bool thrown = false;
+	try
+	{
+		mat1.subMatrixView(0, 5, 0, 1);
+	}
+	catch (OutOfBounds&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	// Strassen and the solver on sub-matrix views
+	DenseMatrix<int> mat3(generateRandomVector(35 * 35), 35, 35);
+	DenseMatrix<int> mat4(generateRandomVector(35 * 35), 35, 35, StorageType::RowMajor);
+	MatrixView<const int> mat3_view = mat3.subMatrixView(0, 33, 1, 30);
+	MatrixView<const int> mat4_view = mat4.subMatrixView(2, 31, 0, 27);
+	assert(strassen(mat3_view, mat4_view, 4, StorageType::ColumnMajor) ==
+		basicMultWithConversion(DenseMatrix<int>(mat3_view), DenseMatrix<int>(mat4_view)));
+
+	DenseMatrix<int> A({ 7, 7, 7, 1, 0, 3, 7, 4, 5, 2, 7, 5, 7, 0 }, 2, 7, StorageType::RowMajor);
+	MathVector<double> x;
+	assert(solveLinearEquation(A.subMatrixView(0, 2, 3, 5), MathVector<int>({ 1, 4 }), x));
+	checkVectors(x.getData(), { 1.0, -0.6 });
+}
+
 void testDenseEquals()
 {
 	std::vector<int> data1{ 1, 4, 2, 3, 4, 6 };
@@ -679,6 +1176,528 @@ void testDenseMult()
 	assert(basicMultWithConversion(mat20, mat21) == strassen(mat20, mat21, 1));
 }
 
+void testDenseBlockedMult()
+{
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+
+	// Small blocks exercise every edge case of the packing and tiling
+	GemmBlockSizes small_blocks;
+	small_blocks.MC = 6;
+	small_blocks.KC = 5;
+	small_blocks.NC = 11;
+
+	for (StorageType type1 : types)
+	{
+		for (StorageType type2 : types)
+		{
+			DenseMatrix<int> mat1(generateRandomVector(23 * 17), 23, 17, type1);
+			DenseMatrix<int> mat2(generateRandomVector(17 * 29), 17, 29, type2);
+			DenseMatrix<int> expected = basicMultWithConversion(mat1, mat2);
+
+			assert(blockedMult(mat1, mat2) == expected);
+			assert(mat1 * mat2 == expected);
+
+			DenseMatrix<int> product(23, 29, type1);
+			gemmBlocked(mat1.view(), mat2.view(), product.view(), small_blocks);
+			assert(product == expected);
+
+			// Accumulates into C
+			gemmBlocked(mat1.view(), mat2.view(), product.view(), small_blocks);
+			assert(product == expected + expected);
+		}
+	}
+
+	// Sub-matrix views with leading dimensions larger than their widths
+	std::vector<double> data3(40 * 40), data4(40 * 40);
+	for (size_t i = 0; i < data3.size(); ++i)
+	{
+		data3[i] = 0.5 * (double)(rand() % 100) - 25.0;
+		data4[i] = 0.25 * (double)(rand() % 100) - 12.5;
+	}
+	DenseMatrix<double> mat4(data3, 40, 40);
+	DenseMatrix<double> mat5(data4, 40, 40, StorageType::RowMajor);
+	MatrixView<const double> view4 = mat4.subMatrixView(3, 34, 1, 38);
+	MatrixView<const double> view5 = mat5.subMatrixView(2, 39, 5, 12);
+	DenseMatrix<double> product2 = view4 * view5;
+	DenseMatrix<double> expected2 = basicMultWithConversion(
+		DenseMatrix<double>(view4), DenseMatrix<double>(view5));
+	checkVectors(product2.getData(), expected2.getData());
+
+	// Empty inner dimension gives a zero matrix
+	DenseMatrix<int> empty1(3, 0);
+	DenseMatrix<int> empty2(0, 4);
+	assert(empty1 * empty2 == DenseMatrix<int>(3, 4));
+}
+
+void testDenseParallelMult()
+{
+	// Every task runs exactly once, even with more tasks than threads
+	ThreadPool pool(4);
+	assert(pool.numThreads() == 4);
+
+	std::vector<int> counts(1000, 0);
+	pool.parallelFor(counts.size(), [&](const size_t i) { ++counts[i]; });
+	assert(counts == std::vector<int>(1000, 1));
+
+	// Exceptions thrown by tasks reach the caller
+	bool caught = false;
+	try
+	{
+		pool.parallelFor(100, [](const size_t i)
+		{
+			if (i == 37)
+				throw OutOfBounds();
+		});
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	// Nested calls run serially instead of deadlocking
+	std::vector<int> nested(64, 0);
+	pool.parallelFor(8, [&](const size_t i)
+	{
+		pool.parallelFor(8, [&](const size_t j) { ++nested[i * 8 + j]; });
+	});
+	assert(nested == std::vector<int>(64, 1));
+
+	// Dimensions that don't divide evenly into tiles, for every
+	// combination of storage types
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+	for (StorageType type1 : types)
+	{
+		for (StorageType type2 : types)
+		{
+			DenseMatrix<int> mat1(generateRandomVector(150 * 97, 100), 150, 97, type1);
+			DenseMatrix<int> mat2(generateRandomVector(97 * 203, 100), 97, 203, type2);
+			DenseMatrix<int> expected = basicMultWithConversion(mat1, mat2);
+
+			DenseMatrix<int> product(150, 203, type1);
+			gemmParallel(mat1.view(), mat2.view(), product.view(), pool);
+			assert(product == expected);
+		}
+	}
+
+	// Default pool follows setNumThreads()
+	size_t original_threads = getNumThreads();
+	setNumThreads(3);
+	assert(getNumThreads() == 3);
+
+	DenseMatrix<int> mat3(generateRandomVector(130 * 70, 100), 130, 70);
+	DenseMatrix<int> mat4(generateRandomVector(70 * 90, 100), 70, 90);
+	assert(mat3 * mat4 == basicMultWithConversion(mat3, mat4));
+
+	setNumThreads(original_threads);
+}
+
+// Checks C = 2 * A * B - C for one floating point type against an int
+// reference; small integer values keep every sum exact, and odd
+// dimensions leave partial register tiles and an odd number of steps
+template <typename DataType>
+static void checkGemmTiles()
+{
+	const size_t m = 37, k = 301, n = 29;
+	DenseMatrix<int> A(generateRandomVector(m * k, 9), m, k);
+	DenseMatrix<int> B(generateRandomVector(k * n, 9), k, n, StorageType::RowMajor);
+	DenseMatrix<int> C(generateRandomVector(m * n, 9), m, n);
+	DenseMatrix<int> expected = 2 * basicMultWithConversion(A, B) - C;
+
+	DenseMatrix<DataType> A_real(A.view()), B_real(B.view()), C_real(C.view());
+	gemm(TransposeOp::NoTranspose, TransposeOp::NoTranspose, 2, A_real, B_real, -1, C_real);
+	assert(C_real == DenseMatrix<DataType>(expected.view()));
+}
+
+void testDenseGemm()
+{
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+	const TransposeOp ops[] = { TransposeOp::NoTranspose, TransposeOp::Transpose };
+
+	// Large enough to run in parallel and span several panels of k
+	const size_t m = 70, k = 300, n = 45;
+	for (TransposeOp trans_A : ops)
+	{
+		for (TransposeOp trans_B : ops)
+		{
+			for (StorageType type : types)
+			{
+				// Operands are stored transposed when their flag is set
+				bool t_A = trans_A == TransposeOp::Transpose;
+				bool t_B = trans_B == TransposeOp::Transpose;
+				DenseMatrix<int> A(generateRandomVector(m * k, 100),
+					t_A ? k : m, t_A ? m : k, type);
+				DenseMatrix<int> B(generateRandomVector(k * n, 100),
+					t_B ? n : k, t_B ? k : n);
+				DenseMatrix<int> C0(generateRandomVector(m * n, 100), m, n, type);
+
+				DenseMatrix<int> AB = basicMultWithConversion<int>(
+					applyTranspose(A.view(), trans_A),
+					applyTranspose(B.view(), trans_B), type);
+
+				DenseMatrix<int> C = C0;
+				gemm(trans_A, trans_B, 1, A, B, 1, C);
+				assert(C == AB + C0);
+
+				C = C0;
+				gemm(trans_A, trans_B, -2, A, B, 3, C);
+				assert(C == -2 * AB + 3 * C0);
+
+				gemm(trans_A, trans_B, 1, A, B, 0, C);
+				assert(C == AB);
+			}
+		}
+	}
+
+	// Floating point register tiles on every instruction set up to the
+	// detected one
+	SimdLevel original_level = activeSimdLevel();
+	std::vector<SimdLevel> levels{ SimdLevel::Scalar, SimdLevel::SSE2,
+		SimdLevel::AVX2, SimdLevel::AVX512 };
+	for (SimdLevel level : levels)
+	{
+		if (level > detectedSimdLevel())
+			break;
+
+		setSimdLevel(level);
+		checkGemmTiles<float>();
+		checkGemmTiles<double>();
+	}
+	setSimdLevel(original_level);
+
+	// With beta 0, C is never read, so garbage in C doesn't leak through
+	DenseMatrix<double> A({ 1, 2, 3, 4, 5, 6 }, 2, 3, StorageType::RowMajor);
+	DenseMatrix<double> B({ 1, 0, 2, 1, 0, 3 }, 3, 2, StorageType::RowMajor);
+	DenseMatrix<double> C(std::vector<double>(4, std::nan("")), 2, 2);
+	gemm(TransposeOp::NoTranspose, TransposeOp::NoTranspose, 1.0, A, B, 0.0, C);
+	assert(C == DenseMatrix<double>({ 5, 14, 11, 23 }, 2, 2));
+
+	// With alpha 0, A and B are never read, so only C is scaled
+	DenseMatrix<double> A_nan(std::vector<double>(6, std::nan("")), 2, 3);
+	DenseMatrix<double> B_inf(std::vector<double>(6, INFINITY), 3, 2);
+	gemm(TransposeOp::NoTranspose, TransposeOp::NoTranspose, 0.0, A_nan, B_inf, 2.0, C);
+	assert(C == DenseMatrix<double>({ 10, 28, 22, 46 }, 2, 2));
+
+	// A^T * A on sub-matrix views, written into a sub-matrix of C
+	DenseMatrix<double> D(4, 4);
+	gemm(TransposeOp::Transpose, TransposeOp::NoTranspose, 0.5, B.view(),
+		B.view(), 0.0, D.subMatrixView(1, 3, 1, 3));
+	checkVectors(D.getData(), { 0, 0, 0, 0, 0, 2.5, 1, 0, 0, 1, 5, 0, 0, 0, 0, 0 });
+
+	// Empty inner dimension only scales C
+	DenseMatrix<int> empty1(3, 0);
+	DenseMatrix<int> empty2(0, 2);
+	DenseMatrix<int> E({ 1, 2, 3, 4, 5, 6 }, 3, 2);
+	gemm(TransposeOp::NoTranspose, TransposeOp::NoTranspose, 1, empty1, empty2, 2, E);
+	assert(E == DenseMatrix<int>({ 2, 4, 6, 8, 10, 12 }, 3, 2));
+
+	bool caught = false;
+	try
+	{
+		gemm(TransposeOp::Transpose, TransposeOp::NoTranspose, 1, E, E, 0, E);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+// Returns alpha * A * x + beta * y computed element by element
+static std::vector<int> referenceGemv(const MatrixView<const int>& A,
+	const std::vector<int>& x,
+	const std::vector<int>& y,
+	const int alpha,
+	const int beta)
+{
+	std::vector<int> result(A.rows());
+	for (size_t i = 0; i < A.rows(); ++i)
+	{
+		int sum = 0;
+		for (size_t j = 0; j < A.cols(); ++j)
+		{
+			sum += A(i, j) * x[j];
+		}
+		result[i] = alpha * sum + beta * y[i];
+	}
+	return result;
+}
+
+void testDenseGemv()
+{
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+	const TransposeOp ops[] = { TransposeOp::NoTranspose, TransposeOp::Transpose };
+
+	// Small, tall, and short and wide shapes cover the serial path, bands
+	// of rows, and panels of columns
+	std::vector<std::pair<size_t, size_t> > shapes{
+		{ 7, 5 }, { 1000, 300 }, { 6, 20000 } };
+	for (const std::pair<size_t, size_t>& shape : shapes)
+	{
+		for (StorageType type : types)
+		{
+			for (TransposeOp trans_A : ops)
+			{
+				DenseMatrix<int> A(generateRandomVector(shape.first * shape.second, 100),
+					shape.first, shape.second, type);
+				MatrixView<const int> op_A = applyTranspose(A.view(), trans_A);
+
+				MathVector<int> x(generateRandomVector(op_A.cols(), 100));
+				MathVector<int> y(generateRandomVector(op_A.rows(), 100));
+				std::vector<int> expected = referenceGemv(
+					op_A, x.getData(), y.getData(), 3, -2);
+
+				gemv(trans_A, 3, A, x, -2, y);
+				assert(y.getData() == expected);
+
+				// Strided vectors
+				std::vector<int> x_strided(2 * x.size()), y_strided(3 * y.size());
+				for (size_t i = 0; i < x.size(); ++i)
+				{
+					x_strided[2 * i] = x[i];
+				}
+				VectorView<int> y_view(y_strided.data(), y.size(), 3);
+				gemv<int>(trans_A, 1, A.view(),
+					VectorView<const int>(x_strided.data(), x.size(), 2), 0, y_view);
+				assert(y_view.toStdVector() == referenceGemv(op_A, x.getData(),
+					y.getData(), 1, 0));
+				assert(y_strided[1] == 0 && y_strided[2] == 0);
+			}
+		}
+	}
+
+	// operator* on matrices, transposed views, and sub-matrix views
+	DenseMatrix<int> A({ 1, 2, 3, 4, 5, 6 }, 2, 3, StorageType::RowMajor);
+	MathVector<int> x({ 1, 0, -1 });
+	MathVector<int> z({ 2, 1 });
+	assert((A * x).getData() == std::vector<int>({ -2, -2 }));
+	assert((A.transposeView() * z.view()).getData() == std::vector<int>({ 6, 9, 12 }));
+	assert((A.subMatrixView(0, 2, 1, 3) * z.view()).getData() ==
+		std::vector<int>({ 7, 16 }));
+
+	// With beta 0, y is never read
+	DenseMatrix<double> B({ 1, 2, 3, 4 }, 2, 2);
+	MathVector<double> w({ 1, 1 });
+	MathVector<double> v(std::vector<double>(2, std::nan("")));
+	gemv(TransposeOp::NoTranspose, 1.0, B, w, 0.0, v);
+	checkVectors(v.getData(), { 4, 6 });
+
+	bool caught = false;
+	try
+	{
+		MathVector<int> result = A * z;
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	setNumThreads(original_threads);
+}
+
+// Recursive sum of [first, last) that spawns both halves as tasks
+static long long parallelSum(ThreadPool& pool, const long long first,
+	const long long last)
+{
+	if (last - first <= 8)
+	{
+		long long sum = 0;
+		for (long long i = first; i < last; ++i)
+		{
+			sum += i;
+		}
+		return sum;
+	}
+
+	long long middle = first + (last - first) / 2;
+	long long left_sum = 0;
+	long long right_sum = 0;
+
+	TaskGroup group(pool);
+	group.run([&]() { left_sum = parallelSum(pool, first, middle); });
+	group.run([&]() { right_sum = parallelSum(pool, middle, last); });
+	group.wait();
+
+	return left_sum + right_sum;
+}
+
+void testDenseParallelStrassen()
+{
+	// Nested task groups, on pools with and without workers
+	ThreadPool pool(4);
+	ThreadPool serial_pool(1);
+	assert(parallelSum(pool, 0, 10000) == 49995000);
+	assert(parallelSum(serial_pool, 0, 10000) == 49995000);
+
+	// A waiter with nothing left to help with sleeps until a task of the
+	// group finishes, then helps with any work that task queued
+	{
+		std::atomic<int> finished(0);
+		TaskGroup group(pool);
+		for (size_t i = 0; i < 4; ++i)
+		{
+			group.run([&]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+				group.run([&]() { ++finished; });
+				++finished;
+			});
+		}
+		group.wait();
+		assert(finished.load() == 8);
+	}
+
+	// Exceptions thrown by tasks are rethrown by wait()
+	bool caught = false;
+	try
+	{
+		TaskGroup group(pool);
+		for (size_t i = 0; i < 20; ++i)
+		{
+			group.run([i]()
+			{
+				if (i == 13)
+					throw InvalidDimensions();
+			});
+		}
+		group.wait();
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	assert(strassenParallelDepth(1) == 0);
+	assert(strassenParallelDepth(3) == 1);
+	assert(strassenParallelDepth(64) == 3);
+
+	// Several levels of parallel recursion, including odd dimensions
+	DenseMatrix<int> mat1(generateRandomVector(75 * 66, 100), 75, 66);
+	DenseMatrix<int> mat2(generateRandomVector(66 * 81, 100), 66, 81, StorageType::RowMajor);
+	DenseMatrix<int> expected = basicMultWithConversion(mat1, mat2);
+
+	for (size_t depth = 0; depth <= 3; ++depth)
+	{
+		DenseMatrix<int> product(75, 81);
+		std::vector<int> workspace(strassenWorkspaceSize(75, 66, 81, 8, depth));
+		strassenInto(mat1.view(), mat2.view(), product.view(), 8,
+			workspace.data(), pool, depth);
+		assert(product == expected);
+	}
+
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+	assert(strassen(mat1, mat2, 8) == expected);
+	setNumThreads(original_threads);
+}
+
+void testDenseStrassenWorkspace()
+{
+	ThreadPool serial_pool(1);
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+
+	// Every combination of odd and even dimensions gets peeled at some
+	// level of the recursion
+	const size_t dims[][3] = { { 40, 40, 40 }, { 41, 40, 40 }, { 40, 41, 40 },
+		{ 40, 40, 41 }, { 37, 43, 39 }, { 64, 35, 50 } };
+
+	for (const size_t* dim : dims)
+	{
+		for (StorageType type1 : types)
+		{
+			for (StorageType type2 : types)
+			{
+				DenseMatrix<int> mat1(generateRandomVector(dim[0] * dim[1], 100),
+					dim[0], dim[1], type1);
+				DenseMatrix<int> mat2(generateRandomVector(dim[1] * dim[2], 100),
+					dim[1], dim[2], type2);
+				DenseMatrix<int> expected = basicMultWithConversion(mat1, mat2);
+
+				// Writes into a sub-view, so C has a leading dimension
+				// larger than its width and must not be touched outside it
+				DenseMatrix<int> big(dim[0] + 3, dim[2] + 2, type2);
+				big.view().fill(-1);
+				MatrixView<int> C = big.subMatrixView(1, dim[0] + 1, 2, dim[2] + 2);
+
+				std::vector<int> workspace(
+					strassenWorkspaceSize(dim[0], dim[1], dim[2], 4, 0));
+				strassenInto(mat1.view(), mat2.view(), C, 4,
+					workspace.data(), serial_pool, 0);
+
+				assert(DenseMatrix<int>(C, type1) == expected);
+				assert(big.at(0, 0) == -1 && big.at(dim[0] + 2, 1) == -1);
+			}
+		}
+	}
+
+	// Serial recursion needs about n^2 workspace elements in total
+	assert(strassenWorkspaceSize(512, 512, 512, 64, 0) <= 512 * 512);
+	assert(strassenWorkspaceSize(512, 512, 512, 512, 0) == 0);
+	assert(strassenWorkspaceSize(513, 513, 513, 64, 0) ==
+		strassenWorkspaceSize(512, 512, 512, 64, 0));
+}
+
+void testDenseStrassenWinograd()
+{
+	ThreadPool pool(4);
+	ThreadPool serial_pool(1);
+	const StorageType types[] = { StorageType::ColumnMajor, StorageType::RowMajor };
+	const size_t dims[][3] = { { 40, 40, 40 }, { 41, 40, 40 }, { 40, 41, 40 },
+		{ 40, 40, 41 }, { 37, 43, 39 }, { 64, 35, 50 } };
+
+	for (const size_t* dim : dims)
+	{
+		for (StorageType type1 : types)
+		{
+			for (StorageType type2 : types)
+			{
+				DenseMatrix<int> mat1(generateRandomVector(dim[0] * dim[1], 100),
+					dim[0], dim[1], type1);
+				DenseMatrix<int> mat2(generateRandomVector(dim[1] * dim[2], 100),
+					dim[1], dim[2], type2);
+				DenseMatrix<int> expected = basicMultWithConversion(mat1, mat2);
+
+				// Serial schedule, then every level in parallel
+				for (size_t depth = 0; depth <= 3; depth += 3)
+				{
+					DenseMatrix<int> product(dim[0], dim[2], type2);
+					std::vector<int> workspace(
+						strassenWorkspaceSize(dim[0], dim[1], dim[2], 4, depth));
+					strassenWinogradInto(mat1.view(), mat2.view(), product.view(),
+						4, workspace.data(), depth == 0 ? serial_pool : pool, depth);
+					assert(DenseMatrix<int>(product.view(), type1) == expected);
+				}
+
+				assert(strassenWinograd(mat1, mat2, 8) == expected);
+			}
+		}
+	}
+
+	// operator* switches to Strassen-Winograd at the crossover, which is
+	// fixed until set or tuned explicitly
+	size_t original_crossover = strassenCrossover<int>();
+	assert(original_crossover == STRASSEN_DEFAULT_CROSSOVER);
+
+	DenseMatrix<int> mat3(generateRandomVector(300 * 280, 100), 300, 280);
+	DenseMatrix<int> mat4(generateRandomVector(280 * 270, 100), 280, 270,
+		StorageType::RowMajor);
+	DenseMatrix<int> expected = basicMultWithConversion(mat3, mat4);
+
+	setStrassenCrossover<int>(STRASSEN_MIN_CROSSOVER);
+	assert(strassenCrossover<int>() == STRASSEN_MIN_CROSSOVER);
+	assert(mat3 * mat4 == expected);
+
+	setStrassenCrossover<int>(STRASSEN_NO_CROSSOVER);
+	assert(mat3 * mat4 == expected);
+
+	setStrassenCrossover<int>(original_crossover);
+}
+
 void testDenseLinearSolver()
 {
 	DenseMatrix<int> A1({ 1, 0, 3, 4, 5, 2, 5, 7, 0 }, 3, 3, StorageType::ColumnMajor);
@@ -701,10 +1720,1148 @@ void testDenseLinearSolver()
 	MathVector<int> b4({ 1, 1 });
 	assert(!solveLinearEquation(A4, b4, x));
 
+	// Singular, though rounding leaves the last pivot a few epsilon
+	// away from zero rather than exactly zero
+	DenseMatrix<int> A7({ 1, 2, 3, 4, 5, 6, 7, 8, 9 }, 3, 3, StorageType::RowMajor);
+	assert(!solveLinearEquation(A7, MathVector<int>({ 1, 2, 3 }), x));
+	DenseMatrix<double> A8({ 0.1, 0.2, 0.3, 0.6 }, 2, 2, StorageType::RowMajor);
+	assert(!solveLinearEquation(A8, MathVector<double>({ 1, 1 }), x));
+	assert(!solveMixedPrecision(A8, MathVector<double>({ 1, 1 }), x));
+
+	// Pivots are chosen by magnitude
+	DenseMatrix<int> A6({ 1, 2, 3, -5, 4, 0, 1, 1, 1 }, 3, 3, StorageType::RowMajor);
+	MathVector<int> b6({ 1, 2, 3 });
+	maximizePivot(A6, b6, 0);
+	assert(A6.at(0, 0) == -5 && b6[0] == 2);
+
+	// Transposed systems are solved without forming the transpose
+	DenseMatrix<int> A5({ 1, 0, 3, 4, 5, 2, 5, 7, 0 }, 3, 3, StorageType::RowMajor);
+	assert(A5.transposed() == A1);
+	assert(solveLinearEquation(A5, b1, x, TransposeOp::Transpose));
+	checkVectors(x.getData(), { -6.4, 10.6, -7 });
+	assert(solveLinearEquation(A1.view(), b1, x, TransposeOp::NoTranspose));
+	checkVectors(x.getData(), { -6.4, 10.6, -7 });
+
+	// Gaussian elimination without a factorization object
+	assert(gaussianElimination(A5, b1, x, TransposeOp::Transpose));
+	checkVectors(x.getData(), { -6.4, 10.6, -7 });
+	assert(!gaussianElimination(A4, b4, x));
+
 	DenseMatrix<double> A({0, 9, 2, 1, 8, 5, 3, 1, 0, 0, 2, 5, 0, 0, 2, 1}, 4, 4, StorageType::RowMajor);
 	MathVector<double> b({1, 2, 6, 9});
 	solveLinearEquation(A, b, x);
 	std::cout << "A:\n" << A << "\n";
 	std::cout << "b:\n" << b << "\n";
 	std::cout << "Solution:\n" << x << "\n";
-}
\ No newline at end of file
+}
+
+void testDenseLUFactorization()
+{
+	// Same systems as testDenseLinearSolver, with integer input
+	DenseMatrix<int> A1({ 1, 0, 3, 4, 5, 2, 5, 7, 0 }, 3, 3, StorageType::ColumnMajor);
+	MathVector<int> b1({ 1, 4, 2 });
+	LUFactorization<double> lu1(A1);
+	assert(lu1.size() == 3 && !lu1.isSingular());
+	checkVectors(lu1.solve(b1).getData(), { -6.4, 10.6, -7 });
+	assert(areEqual(lu1.determinant(), -5));
+
+	DenseMatrix<int> A1_t({ 1, 0, 3, 4, 5, 2, 5, 7, 0 }, 3, 3, StorageType::RowMajor);
+	LUFactorization<double> lu1_t(A1_t);
+	checkVectors(lu1_t.solve(b1, TransposeOp::Transpose).getData(), { -6.4, 10.6, -7 });
+
+	// PA = LU on a random matrix, then many right hand sides at once
+	const size_t n = 60;
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = 0.5 * (double)(rand() % 100) - 25.0;
+	}
+	DenseMatrix<double> A(data, n, n, StorageType::RowMajor);
+	LUFactorization<double> lu(A);
+
+	DenseMatrix<double> L = lu.lower();
+	DenseMatrix<double> U = lu.upper();
+	DenseMatrix<double> LU = L * U;
+	std::vector<size_t> perm = lu.permutation();
+	for (size_t i = 0; i < n; ++i)
+	{
+		assert(areEqual(L.at(i, i), 1));
+		for (size_t j = 0; j < n; ++j)
+		{
+			assert(areEqual(LU.at(i, j), A.at(perm[i], j)));
+
+			// Partial pivoting keeps every multiplier at most 1
+			if (i > j)
+				assert(std::abs(L.at(i, j)) <= 1);
+		}
+	}
+
+	DenseMatrix<int> B(generateRandomVector(n * 7), n, 7, StorageType::RowMajor);
+	DenseMatrix<double> X = lu.solve(B);
+	DenseMatrix<double> AX = A * X;
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < 7; ++j)
+		{
+			assert(areEqual(AX.at(i, j), B.at(i, j)));
+		}
+	}
+
+	DenseMatrix<double> Xt = lu.solve(B, TransposeOp::Transpose);
+	DenseMatrix<double> AtX = A.transposeView() * Xt.view();
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < 7; ++j)
+		{
+			assert(areEqual(AtX.at(i, j), B.at(i, j)));
+		}
+	}
+
+	// Strided right hand sides are solved in place
+	std::vector<double> strided(2 * n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		strided[2 * i] = B.at(i, 0);
+	}
+	lu.solveInPlace(VectorView<double>(strided.data(), n, 2));
+	for (size_t i = 0; i < n; ++i)
+	{
+		assert(areEqual(strided[2 * i], X.at(i, 0)));
+		assert(strided[2 * i + 1] == 0);
+	}
+
+	// Several panels, with the trailing updates and triangular solves
+	// split across threads
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const size_t big_n = 300;
+	std::vector<double> big_data(big_n * big_n);
+	for (size_t i = 0; i < big_data.size(); ++i)
+	{
+		big_data[i] = 0.25 * (double)(rand() % 200) - 25.0;
+	}
+	DenseMatrix<double> big_A(big_data, big_n, big_n);
+	LUFactorization<double> big_lu(big_A);
+
+	DenseMatrix<double> big_LU = big_lu.lower() * big_lu.upper();
+	std::vector<size_t> big_perm = big_lu.permutation();
+	for (size_t i = 0; i < big_n; ++i)
+	{
+		for (size_t j = 0; j < big_n; ++j)
+		{
+			assert(std::abs(big_LU.at(i, j) - big_A.at(big_perm[i], j)) < 1e-9);
+		}
+	}
+
+	std::vector<int> big_b_data = generateRandomVector(big_n);
+	MathVector<double> big_b(std::vector<double>(big_b_data.begin(), big_b_data.end()));
+	MathVector<double> big_x;
+	assert(solveLinearEquation(big_A, big_b, big_x));
+	MathVector<double> big_Ax = big_A * big_x;
+	for (size_t i = 0; i < big_n; ++i)
+	{
+		assert(std::abs(big_Ax[i] - big_b[i]) < 1e-8);
+	}
+
+	setNumThreads(original_threads);
+
+	// Singular matrices factor, but can't be solved
+	DenseMatrix<int> A2({ 5, 0, 1, 0 }, 2, 2);
+	LUFactorization<double> lu2(A2);
+	assert(lu2.isSingular());
+	assert(lu2.determinant() == 0);
+	assert(lu2.isNumericallySingular());
+
+	// A pivot that is only rounding error isn't exactly zero, but is
+	// negligible next to the elements of the matrix
+	DenseMatrix<int> A_rounded({ 1, 2, 3, 4, 5, 6, 7, 8, 9 }, 3, 3, StorageType::RowMajor);
+	LUFactorization<double> lu_rounded(A_rounded);
+	assert(!lu_rounded.isSingular() && lu_rounded.isNumericallySingular());
+	assert(!lu1.isNumericallySingular());
+
+	bool caught = false;
+	try
+	{
+		lu2.solve(MathVector<int>({ 1, 1 }));
+	}
+	catch (const SingularMatrix&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		LUFactorization<double> lu3(DenseMatrix<double>(2, 3));
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		lu1.solve(MathVector<int>({ 1, 1 }));
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testDenseCholesky()
+{
+	// A = LL^T with L = [2 0; 1 sqrt(2)]; upper triangle isn't read
+	DenseMatrix<int> A1({ 4, 2, 99, 3 }, 2, 2);
+	CholeskyFactorization<double> cholesky1(A1);
+	assert(cholesky1.isPositiveDefinite());
+	checkVectors(cholesky1.lower().getData(), { 2, 1, 0, std::sqrt(2.0) });
+	assert(areEqual(cholesky1.determinant(), 8));
+	checkVectors(cholesky1.solve(MathVector<int>({ 2, 4 })).getData(), { -0.25, 1.5 });
+
+	// Several panels, with the trailing updates split across threads
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const size_t n = 200;
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = 0.1 * (double)(rand() % 100) - 5.0;
+	}
+	DenseMatrix<double> M(data, n, n);
+	DenseMatrix<double> A = product(M, TransposeOp::Transpose, M, TransposeOp::NoTranspose);
+	for (size_t i = 0; i < n; ++i)
+	{
+		A.at(i, i) += n;
+	}
+
+	CholeskyFactorization<double> cholesky(A);
+	assert(cholesky.isPositiveDefinite() && cholesky.size() == n);
+	const DenseMatrix<double>& L = cholesky.lower();
+	DenseMatrix<double> LLt = product(L, TransposeOp::NoTranspose, L, TransposeOp::Transpose);
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			assert(std::abs(LLt.at(i, j) - A.at(i, j)) < 1e-9);
+			if (j > i)
+				assert(L.at(i, j) == 0);
+		}
+	}
+
+	DenseMatrix<int> B(generateRandomVector(n * 5), n, 5);
+	DenseMatrix<double> X = cholesky.solve(B);
+	DenseMatrix<double> AX = A * X;
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < 5; ++j)
+		{
+			assert(std::abs(AX.at(i, j) - B.at(i, j)) < 1e-9);
+		}
+	}
+
+	MathVector<double> b(std::vector<double>(n, 1.0));
+	MathVector<double> x;
+	assert(solveSymmetricLinearEquation(A, b, x));
+	checkVectors(x.getData(), cholesky.solve(b).getData());
+
+	setNumThreads(original_threads);
+
+	// Symmetric but indefinite, so the solver falls back to LU
+	DenseMatrix<double> A2({ 1, 2, 2, 1 }, 2, 2);
+	CholeskyFactorization<double> cholesky2(A2);
+	assert(!cholesky2.isPositiveDefinite());
+	bool caught = false;
+	try
+	{
+		cholesky2.solve(MathVector<double>({ 1, 1 }));
+	}
+	catch (const SingularMatrix&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	MathVector<double> b2({ 3, 3 });
+	assert(solveSymmetricLinearEquation(A2, b2, x));
+	checkVectors(x.getData(), { 1, 1 });
+
+	// Only the lower triangle is used on the LU path too
+	DenseMatrix<double> A3({ -2, 1, 50, 3 }, 2, 2);
+	MathVector<double> b3({ -1, 4 });
+	assert(solveSymmetricLinearEquation(A3, b3, x));
+	checkVectors(x.getData(), { 1, 1 });
+
+	DenseMatrix<double> A4({ 1, 1, 1, 1 }, 2, 2);
+	assert(!solveSymmetricLinearEquation(A4, b3, x));
+	assert(!solveSymmetricLinearEquation(A4, MathVector<double>({ 1 }), x));
+
+	// Indefinite, so it takes the LU path, and singular up to rounding
+	DenseMatrix<double> A5({ -0.1, 0.3, 0.3, -0.9 }, 2, 2);
+	assert(!solveSymmetricLinearEquation(A5, b3, x));
+}
+
+// Checks that Q has orthonormal columns, R is upper triangular, and QR = A
+static void checkQRFactors(const QRFactorization<double>& qr, const DenseMatrix<double>& A)
+{
+	DenseMatrix<double> Q = qr.orthogonal();
+	DenseMatrix<double> R = qr.upper();
+	const size_t k = std::min(A.rows(), A.cols());
+	assert(Q.rows() == A.rows() && Q.cols() == k);
+	assert(R.rows() == k && R.cols() == A.cols());
+
+	DenseMatrix<double> QtQ = product(Q, TransposeOp::Transpose, Q, TransposeOp::NoTranspose);
+	for (size_t i = 0; i < k; ++i)
+	{
+		for (size_t j = 0; j < k; ++j)
+		{
+			assert(std::abs(QtQ.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-9);
+		}
+	}
+
+	DenseMatrix<double> QR = Q * R;
+	for (size_t i = 0; i < A.rows(); ++i)
+	{
+		for (size_t j = 0; j < A.cols(); ++j)
+		{
+			assert(std::abs(QR.at(i, j) - A.at(i, j)) < 1e-9);
+			if (i > j && i < k)
+				assert(R.at(i, j) == 0);
+		}
+	}
+}
+
+void testDenseQR()
+{
+	// Line through (1, 1), (2, 2), (3, 2); the normal equations give
+	// intercept 2/3 and slope 1/2
+	DenseMatrix<int> A1({ 1, 1, 1, 1, 2, 3 }, 3, 2);
+	MathVector<int> b1({ 1, 2, 2 });
+	QRFactorization<double> qr1(A1);
+	assert(qr1.isFullRank());
+	checkQRFactors(qr1, DenseMatrix<double>(A1.view()));
+	checkVectors(qr1.solve(b1).getData(), { 2.0 / 3, 0.5 });
+
+	MathVector<double> x;
+	assert(solveLeastSquares(A1, b1, x));
+	checkVectors(x.getData(), { 2.0 / 3, 0.5 });
+
+	// Square systems are solved exactly
+	DenseMatrix<double> A2({ 2, 1, 1, 3 }, 2, 2);
+	assert(solveLeastSquares(A2, MathVector<double>({ 3, 4 }), x));
+	checkVectors(x.getData(), { 1, 1 });
+
+	// Several panels, with the block reflectors applied across threads
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const size_t m = 300, n = 100;
+	std::vector<double> data(m * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = 0.1 * (double)(rand() % 100) - 5.0;
+	}
+	DenseMatrix<double> A(data, m, n);
+	QRFactorization<double> qr(A);
+	assert(qr.isFullRank() && qr.rows() == m && qr.cols() == n);
+	checkQRFactors(qr, A);
+
+	// Residual of the least squares solution is orthogonal to the
+	// columns of A
+	DenseMatrix<double> B(DenseMatrix<int>(generateRandomVector(m * 3), m, 3).view());
+	DenseMatrix<double> X = qr.solve(B);
+	assert(X.rows() == n && X.cols() == 3);
+	DenseMatrix<double> residual = A * X - B;
+	DenseMatrix<double> normal = product(A, TransposeOp::Transpose,
+		residual, TransposeOp::NoTranspose);
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < 3; ++j)
+		{
+			assert(std::abs(normal.at(i, j)) < 1e-6);
+		}
+	}
+
+	MathVector<double> b(B.colView(1));
+	assert(solveLeastSquares(A, b, x));
+	for (size_t i = 0; i < n; ++i)
+	{
+		assert(std::abs(x[i] - X.at(i, 1)) < 1e-9);
+	}
+
+	// Q^T applied to a vector matches the blocked version
+	DenseMatrix<double> Qtb(B.colView(1).toStdVector(), m, 1);
+	qr.applyQTranspose(Qtb.view());
+	std::vector<double> qtb = b.getData();
+	qr.applyQTranspose(VectorView<double>(qtb.data(), qtb.size()));
+	for (size_t i = 0; i < m; ++i)
+	{
+		assert(std::abs(qtb[i] - Qtb.at(i, 0)) < 1e-9);
+	}
+
+	// Wide matrices factor too, but have no unique least squares solution
+	DenseMatrix<double> wide(A.transposeView(), StorageType::RowMajor);
+	QRFactorization<double> qr_wide(wide);
+	checkQRFactors(qr_wide, wide);
+	assert(!qr_wide.isFullRank());
+	assert(!solveLeastSquares(wide, MathVector<double>(std::vector<double>(n, 1.0)), x));
+
+	setNumThreads(original_threads);
+
+	// Dependent columns
+	DenseMatrix<double> A3({ 1, 2, 3, 2, 4, 6 }, 3, 2);
+	QRFactorization<double> qr3(A3);
+	assert(!qr3.isFullRank());
+	assert(!solveLeastSquares(A3, MathVector<double>({ 1, 1, 1 }), x));
+	bool caught = false;
+	try
+	{
+		qr3.solve(MathVector<double>({ 1, 1, 1 }));
+	}
+	catch (const SingularMatrix&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	assert(!solveLeastSquares(A1, MathVector<int>({ 1, 2 }), x));
+}
+
+void testDenseTSQR()
+{
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	// Batches of different sizes, some split into blocks across threads
+	const size_t m = 9000, n = 6;
+	std::vector<double> data(m * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = 0.1 * (double)(rand() % 100) - 5.0;
+	}
+	DenseMatrix<double> A(data, m, n, StorageType::RowMajor);
+	std::vector<int> values = generateRandomVector(m);
+	MathVector<double> b(std::vector<double>(values.begin(), values.end()));
+
+	TSQRFactorization<double> tsqr(n, 1);
+	const size_t batch_sizes[] = { 700, 3, 3000, 1297, 4000 };
+	size_t first = 0;
+	for (size_t batch_rows : batch_sizes)
+	{
+		DenseMatrix<double> A_batch = A.getSubMatrix(first, first + batch_rows, 0, n);
+		MathVector<double> b_batch(b.view().subView(first, first + batch_rows));
+		tsqr.addBatch(A_batch, b_batch);
+		first += batch_rows;
+	}
+	assert(tsqr.rows() == m && tsqr.cols() == n && tsqr.rhsCols() == 1);
+
+	// R matches the R of the whole matrix up to the signs of its rows
+	QRFactorization<double> qr(A);
+	DenseMatrix<double> R_full = qr.upper();
+	DenseMatrix<double> R = tsqr.upper();
+	assert(R.rows() == n && R.cols() == n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		double sign = (R.at(i, i) * R_full.at(i, i) < 0) ? -1 : 1;
+		for (size_t j = 0; j < n; ++j)
+		{
+			assert(std::abs(sign * R.at(i, j) - R_full.at(i, j)) < 1e-8);
+		}
+	}
+
+	DenseMatrix<double> X = tsqr.solve();
+	MathVector<double> x = qr.solve(b);
+	assert(X.rows() == n && X.cols() == 1);
+	for (size_t i = 0; i < n; ++i)
+	{
+		assert(std::abs(X.at(i, 0) - x[i]) < 1e-9);
+	}
+
+	MathVector<double> residual = A * x - b;
+	double norm = std::sqrt(dotKernel(residual.view().data(), residual.view().data(), m));
+	assert(std::abs(tsqr.residualNorms()[0] - norm) < 1e-6 * norm);
+
+	setNumThreads(original_threads);
+
+	// Exact fit through a few small batches, with fewer rows than
+	// columns at first
+	TSQRFactorization<double> small(2, 1);
+	small.addBatch(DenseMatrix<int>({ 1, 0 }, 1, 2), MathVector<int>({ 1 }));
+	bool caught = false;
+	try
+	{
+		small.solve();
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+	small.addBatch(DenseMatrix<int>({ 0, 1, 1, 1 }, 2, 2, StorageType::RowMajor),
+		MathVector<int>({ 2, 3 }));
+	checkVectors(small.solve().getData(), { 1, 2 });
+	assert(small.residualNorms()[0] < 1e-12);
+
+	// Without right hand sides only R is available
+	TSQRFactorization<double> no_rhs(2);
+	no_rhs.addBatch(DenseMatrix<double>({ 3, 0, 4, 0, 0, 5 }, 3, 2));
+	DenseMatrix<double> R2 = no_rhs.upper();
+	assert(areEqual(std::abs(R2.at(0, 0)), 5) && areEqual(std::abs(R2.at(0, 1)), 4));
+	assert(areEqual(std::abs(R2.at(1, 1)), 3) && R2.at(1, 0) == 0);
+	caught = false;
+	try
+	{
+		no_rhs.addBatch(DenseMatrix<double>(1, 3));
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	// Dependent columns
+	TSQRFactorization<double> dependent(2, 1);
+	dependent.addBatch(DenseMatrix<double>({ 1, 2, 3, 2, 4, 6 }, 3, 2),
+		MathVector<double>({ 1, 1, 1 }));
+	caught = false;
+	try
+	{
+		dependent.solve();
+	}
+	catch (const SingularMatrix&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testDenseTriangularSolve()
+{
+	// Lower triangle holds values that must never be read
+	DenseMatrix<double> U({ 2, 1, -1, 99, 3, 2, 99, 99, 4 }, 3, 3, StorageType::RowMajor);
+	MathVector<double> y({ 4, 15, 12 });
+	checkVectors(solveUpperTriangularSystem(U, y).getData(), { 2, 3, 3 });
+
+	DenseMatrix<double> L({ 2, 99, 99, 1, 3, 99, -1, 2, 4 }, 3, 3, StorageType::RowMajor);
+	checkVectors(solveLowerTriangularSystem(L, MathVector<double>({ 4, 11, 16 })).getData(),
+		{ 2, 3, 3 });
+
+	// Every combination of storage, triangle, transpose and diagonal, on
+	// sizes that leave partial blocks
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const size_t n = 150, p = 70;
+	const StorageType storage_types[] = { StorageType::RowMajor, StorageType::ColumnMajor };
+	const TriangleType triangles[] = { TriangleType::Lower, TriangleType::Upper };
+	const TransposeOp transposes[] = { TransposeOp::NoTranspose, TransposeOp::Transpose };
+	const DiagonalType diagonals[] = { DiagonalType::NonUnit, DiagonalType::Unit };
+
+	std::vector<int> x_values = generateRandomVector(n);
+	MathVector<double> x_true(std::vector<double>(x_values.begin(), x_values.end()));
+	DenseMatrix<double> X_true(DenseMatrix<int>(generateRandomVector(n * p), n, p).view());
+
+	for (StorageType storage : storage_types)
+	{
+		for (TriangleType uplo : triangles)
+		{
+			for (TransposeOp trans : transposes)
+			{
+				for (DiagonalType diag : diagonals)
+				{
+					// The triangle with an exact diagonal of ones for Unit,
+					// and the full matrix with junk in the other triangle
+					DenseMatrix<double> T(n, n, storage);
+					DenseMatrix<double> A(n, n, storage);
+					for (size_t i = 0; i < n; ++i)
+					{
+						for (size_t j = 0; j < n; ++j)
+						{
+							bool inside = (uplo == TriangleType::Lower) ? j <= i : j >= i;
+							double val = (i == j) ? 4.0 + (double)(rand() % 4) :
+								0.01 * (double)(rand() % 100) - 0.5;
+							A.at(i, j) = inside ? val : 1e300;
+							if (inside)
+								T.at(i, j) = (i == j && diag == DiagonalType::Unit) ? 1 : val;
+						}
+					}
+
+					MathVector<double> x(std::vector<double>(n, 0.0));
+					gemv(trans, 1.0, T, x_true, 0.0, x);
+					trsv(uplo, trans, diag, A, x);
+					for (size_t i = 0; i < n; ++i)
+					{
+						assert(std::abs(x[i] - x_true[i]) < 1e-8);
+					}
+
+					DenseMatrix<double> B = product(T, trans, X_true, TransposeOp::NoTranspose);
+					DenseMatrix<double> B_row(B.view(), StorageType::RowMajor);
+					trsm(uplo, trans, diag, A, B);
+					trsm(uplo, trans, diag, A, B_row);
+					for (size_t i = 0; i < n; ++i)
+					{
+						for (size_t j = 0; j < p; ++j)
+						{
+							assert(std::abs(B.at(i, j) - X_true.at(i, j)) < 1e-8);
+							assert(std::abs(B_row.at(i, j) - X_true.at(i, j)) < 1e-8);
+						}
+					}
+
+					// Strided right hand side, a column of a RowMajor matrix
+					B_row = product(T, trans, X_true, TransposeOp::NoTranspose);
+					B_row.convertToRowMajor();
+					trsv<double>(uplo, trans, diag, A.view(), B_row.colView(3));
+					for (size_t i = 0; i < n; ++i)
+					{
+						assert(std::abs(B_row.at(i, 3) - X_true.at(i, 3)) < 1e-8);
+					}
+				}
+			}
+		}
+	}
+
+	setNumThreads(original_threads);
+
+	bool caught = false;
+	try
+	{
+		MathVector<double> short_x({ 1, 2 });
+		trsv(TriangleType::Upper, TransposeOp::NoTranspose, DiagonalType::NonUnit, U, short_x);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testDenseMixedPrecision()
+{
+	// Well conditioned; refinement reaches double precision accuracy,
+	// far beyond what the float factors alone give
+	const size_t n = 300;
+	std::vector<double> data(n * n);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = 0.01 * (double)(rand() % 100) - 0.5;
+	}
+	DenseMatrix<double> A(data, n, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		A.at(i, i) += 20;
+	}
+	MathVector<double> x_true(std::vector<double>(n, 0.0));
+	for (size_t i = 0; i < n; ++i)
+	{
+		x_true[i] = 1.0 / (double)(i + 1);
+	}
+	MathVector<double> b = A * x_true;
+
+	MathVector<double> x;
+	assert(solveMixedPrecision(A, b, x));
+	MathVector<float> x_float = LUFactorization<float>(A).solve(b);
+	double error = 0, float_error = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		error = std::max(error, std::abs(x[i] - x_true[i]));
+		float_error = std::max(float_error, std::abs((double)x_float[i] - x_true[i]));
+	}
+	assert(error < 1e-13);
+	assert(float_error > 1e-10);
+
+	// Integer and RowMajor input
+	DenseMatrix<int> A1({ 4, 1, 2, 3 }, 2, 2, StorageType::RowMajor);
+	assert(solveMixedPrecision(A1, MathVector<int>({ 5, 5 }), x));
+	checkVectors(x.getData(), { 1, 1 });
+
+	// Hilbert matrix; condition number near 1e13 is out of reach of float
+	// factors, so the solve falls back to double precision and gives the
+	// same answer as solveLinearEquation
+	const size_t h = 10;
+	DenseMatrix<double> hilbert(h, h);
+	for (size_t i = 0; i < h; ++i)
+	{
+		for (size_t j = 0; j < h; ++j)
+		{
+			hilbert.at(i, j) = 1.0 / (double)(i + j + 1);
+		}
+	}
+	MathVector<double> b_h(std::vector<double>(h, 1.0));
+	MathVector<double> x_double;
+	assert(solveMixedPrecision(hilbert, b_h, x));
+	assert(solveLinearEquation(hilbert, b_h, x_double));
+	checkVectors(x.getData(), x_double.getData());
+
+	DenseMatrix<double> singular({ 1, 2, 2, 4 }, 2, 2);
+	assert(!solveMixedPrecision(singular, MathVector<double>({ 1, 1 }), x));
+	assert(!solveMixedPrecision(DenseMatrix<double>(2, 3), MathVector<double>({ 1, 1 }), x));
+}
+
+void testDenseSymmetricEigen()
+{
+	// Eigenvalues come out in ascending order; upper triangle isn't read
+	DenseMatrix<int> A1({ 2, 1, 99, 2 }, 2, 2);
+	SymmetricEigensolver<double> eigen1(A1);
+	checkVectors(eigen1.eigenvalues().getData(), { 1, 3 });
+	const DenseMatrix<double>& V1 = eigen1.eigenvectors();
+	assert(areEqual(std::abs(V1.at(0, 0)), 1 / std::sqrt(2.0)));
+	assert(areEqual(V1.at(0, 0), -V1.at(1, 0)) && areEqual(V1.at(0, 1), V1.at(1, 1)));
+
+	// Second difference matrix, whose eigenvalues are known exactly
+	const size_t h = 50;
+	DenseMatrix<double> D(h, h, StorageType::RowMajor);
+	for (size_t i = 0; i < h; ++i)
+	{
+		D.at(i, i) = 2;
+		if (i > 0)
+			D.at(i, i - 1) = -1;
+	}
+	SymmetricEigensolver<double> eigen_d(D, false);
+	assert(!eigen_d.hasEigenvectors() && eigen_d.eigenvectors().rows() == 0);
+	MathVector<double> w_d = eigen_d.eigenvalues();
+	const double pi = std::acos(-1.0);
+	for (size_t k = 0; k < h; ++k)
+	{
+		assert(std::abs(w_d[k] - (2 - 2 * std::cos((k + 1) * pi / (h + 1)))) < 1e-12);
+	}
+
+	// Several panels, with the updates and back-transformation split
+	// across threads; AV = V diag(w) and V^T V = I
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	const size_t n = 150;
+	DenseMatrix<double> A(n, n, StorageType::RowMajor);
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j <= i; ++j)
+		{
+			A.at(i, j) = 0.1 * (double)(rand() % 100) - 5.0;
+			A.at(j, i) = A.at(i, j);
+		}
+	}
+
+	SymmetricEigensolver<double> eigen(A);
+	assert(eigen.size() == n && eigen.hasEigenvectors());
+	MathVector<double> w = eigen.eigenvalues();
+	const DenseMatrix<double>& V = eigen.eigenvectors();
+	DenseMatrix<double> AV = A * V;
+	DenseMatrix<double> VtV = product(V, TransposeOp::Transpose, V, TransposeOp::NoTranspose);
+	double trace = 0, sum = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		trace += A.at(i, i);
+		sum += w[i];
+		if (i > 0)
+			assert(w[i - 1] <= w[i]);
+		for (size_t j = 0; j < n; ++j)
+		{
+			assert(std::abs(AV.at(i, j) - w[j] * V.at(i, j)) < 1e-10);
+			assert(std::abs(VtV.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-12);
+		}
+	}
+	assert(std::abs(trace - sum) < 1e-10);
+
+	SymmetricEigensolver<double> values_only(A.view(), false);
+	MathVector<double> w2 = values_only.eigenvalues();
+	for (size_t i = 0; i < n; ++i)
+	{
+		assert(std::abs(w[i] - w2[i]) < 1e-10);
+	}
+
+	setNumThreads(original_threads);
+
+	// Single precision, and a matrix that is already diagonal
+	DenseMatrix<float> F({ 3, 0, 0, 0, -1, 0, 0, 0, 2 }, 3, 3);
+	SymmetricEigensolver<float> eigen_f(F);
+	checkVectors(eigen_f.eigenvalues().getData(), { -1.0f, 2.0f, 3.0f });
+	assert(eigen_f.eigenvectors().at(1, 0) == 1 && eigen_f.eigenvectors().at(0, 2) == 1);
+
+	bool caught = false;
+	try
+	{
+		SymmetricEigensolver<double> not_square(DenseMatrix<double>(2, 3));
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testDenseKrylovEigen()
+{
+	// Hessenberg companion matrix of (x - 1)(x - 2)(x^2 + 4); an implicit
+	// double shift step keeps the eigenvalues and gives H = Q^T H_0 Q
+	DenseMatrix<double> C({ 0, 0, 0, -8,
+		1, 0, 0, 12,
+		0, 1, 0, -6,
+		0, 0, 1, 3 }, 4, 4, StorageType::RowMajor);
+	std::vector<std::complex<double> > roots = hessenbergEigenvalues<double>(C.view());
+	std::sort(roots.begin(), roots.end(), [](const std::complex<double>& a,
+		const std::complex<double>& b) { return a.real() != b.real() ?
+			a.real() < b.real() : a.imag() < b.imag(); });
+	assert(std::abs(roots[0] - std::complex<double>(0, -2)) < 1e-12);
+	assert(std::abs(roots[1] - std::complex<double>(0, 2)) < 1e-12);
+	assert(std::abs(roots[2] - 1.0) < 1e-12 && std::abs(roots[3] - 2.0) < 1e-12);
+
+	DenseMatrix<double> H(C.view(), StorageType::ColumnMajor);
+	DenseMatrix<double> Q({ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 }, 4, 4);
+	hessenbergDoubleShiftStep(H.view(), std::complex<double>(0.5, 1), Q.view());
+	DenseMatrix<double> QHQ = product(Q, TransposeOp::Transpose,
+		DenseMatrix<double>(C * Q), TransposeOp::NoTranspose);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (size_t j = 0; j < 4; ++j)
+		{
+			assert(std::abs(QHQ.at(i, j) - H.at(i, j)) < 1e-12);
+			if (i > j + 1)
+				assert(H.at(i, j) == 0);
+		}
+	}
+
+	std::vector<std::complex<double> > y = hessenbergEigenvector<double>(C.view(), roots[1]);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		std::complex<double> Cy = 0;
+		for (size_t j = 0; j < 4; ++j)
+		{
+			Cy += C.at(i, j) * y[j];
+		}
+		assert(std::abs(Cy - roots[1] * y[i]) < 1e-12);
+	}
+
+	// Diagonal operator with eigenvalues 1, ..., n; eigenvectors are
+	// unit vectors
+	const size_t n = 400;
+	auto diagonal = [n](const MathVector<double>& x)
+		{
+			std::vector<double> product(n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				product[i] = (i + 1) * x[i];
+			}
+			return MathVector<double>(std::move(product));
+		};
+
+	LanczosEigensolver<double> largest(diagonal, n, 4);
+	checkVectors(largest.eigenvalues().getData(), { 400, 399, 398, 397 });
+	for (size_t i = 0; i < 4; ++i)
+	{
+		assert(std::abs(std::abs(largest.eigenvectors().at(n - 1 - i, i)) - 1) < 1e-10);
+	}
+
+	LanczosEigensolver<double> smallest(diagonal, n, 3, EigenTarget::Smallest);
+	MathVector<double> w_small = smallest.eigenvalues();
+	for (size_t i = 0; i < 3; ++i)
+	{
+		assert(std::abs(w_small[i] - (i + 1)) < 1e-9);
+	}
+
+	// Random symmetric matrix, checked against the dense eigensolver
+	const size_t m = 300;
+	DenseMatrix<double> S(m, m);
+	for (size_t j = 0; j < m; ++j)
+	{
+		for (size_t i = j; i < m; ++i)
+		{
+			S.at(i, j) = 0.01 * (double)(rand() % 200) - 1.0;
+			S.at(j, i) = S.at(i, j);
+		}
+	}
+	auto symmetric = [&S](const MathVector<double>& x) { return MathVector<double>(S * x); };
+
+	MathVector<double> dense = SymmetricEigensolver<double>(S, false).eigenvalues();
+	LanczosEigensolver<double> lanczos(symmetric, m, 5, EigenTarget::Smallest);
+	MathVector<double> w = lanczos.eigenvalues();
+	const DenseMatrix<double>& V = lanczos.eigenvectors();
+	DenseMatrix<double> SV = S * V;
+	DenseMatrix<double> VtV = product(V, TransposeOp::Transpose, V, TransposeOp::NoTranspose);
+	for (size_t j = 0; j < 5; ++j)
+	{
+		assert(std::abs(w[j] - dense[j]) < 1e-10);
+		for (size_t i = 0; i < m; ++i)
+		{
+			assert(std::abs(SV.at(i, j) - w[j] * V.at(i, j)) < 1e-10);
+		}
+		for (size_t i = 0; i < 5; ++i)
+		{
+			assert(std::abs(VtV.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-12);
+		}
+	}
+
+	// Rotation blocks with eigenvalues a +- bi, followed by a diagonal;
+	// the pair on the boundary is returned whole
+	auto blocks = [n](const MathVector<double>& x)
+		{
+			std::vector<double> product(n);
+			for (size_t i = 0; i < 4; i += 2)
+			{
+				double a = 10.0 * (i + 1), b = 5;
+				product[i] = a * x[i] + b * x[i + 1];
+				product[i + 1] = -b * x[i] + a * x[i + 1];
+			}
+			for (size_t i = 4; i < n; ++i)
+			{
+				product[i] = 0.01 * i * x[i];
+			}
+			return MathVector<double>(std::move(product));
+		};
+
+	ArnoldiEigensolver<double> arnoldi(blocks, n, 3);
+	const std::vector<std::complex<double> >& z = arnoldi.eigenvalues();
+	assert(z.size() == 4);
+	assert(std::abs(z[0] - std::complex<double>(30, 5)) < 1e-10);
+	assert(std::abs(z[1] - std::complex<double>(30, -5)) < 1e-10);
+	assert(std::abs(z[2] - std::complex<double>(10, 5)) < 1e-10);
+	assert(std::abs(z[3] - std::complex<double>(10, -5)) < 1e-10);
+
+	// A (re + i im) = z (re + i im), for real and imaginary parts in
+	// neighbouring columns
+	const DenseMatrix<double>& Z = arnoldi.eigenvectors();
+	for (size_t j = 0; j < 4; j += 2)
+	{
+		MathVector<double> re(Z.colView(j)), im(Z.colView(j + 1));
+		MathVector<double> A_re = blocks(re), A_im = blocks(im);
+		for (size_t i = 0; i < n; ++i)
+		{
+			std::complex<double> v(re[i], im[i]), Av(A_re[i], A_im[i]);
+			assert(std::abs(Av - z[j] * v) < 1e-10);
+		}
+	}
+
+	// General matrix; Smallest finds the eigenvalues of least magnitude,
+	// here the diagonal ones near zero, and real eigenvalues have real
+	// eigenvectors
+	ArnoldiEigensolver<double> near_zero(blocks, n, 2, EigenTarget::Smallest);
+	assert(near_zero.eigenvalues().size() == 2);
+	assert(std::abs(near_zero.eigenvalues()[0].real() - 0.04) < 1e-10);
+	assert(std::abs(near_zero.eigenvalues()[1].real() - 0.05) < 1e-10);
+	assert(std::abs(std::abs(near_zero.eigenvectors().at(4, 0)) - 1) < 1e-8);
+
+	// Bases as large as the whole space give exact results, and single
+	// precision works through the same paths
+	DenseMatrix<float> F({ 2, 1, 0, 1, 2, 1, 0, 1, 2 }, 3, 3);
+	auto small = [&F](const MathVector<float>& x) { return MathVector<float>(F * x); };
+	LanczosEigensolver<float> lanczos_f(small, 3, 3);
+	assert(lanczos_f.restarts() == 0);
+	assert(std::abs(lanczos_f.eigenvalues()[0] - (2 + std::sqrt(2.0f))) < 1e-5f);
+	assert(std::abs(lanczos_f.eigenvalues()[2] - (2 - std::sqrt(2.0f))) < 1e-5f);
+	ArnoldiEigensolver<float> arnoldi_f(small, 3, 1);
+	assert(std::abs(arnoldi_f.eigenvalues()[0].real() - (2 + std::sqrt(2.0f))) < 1e-5f);
+
+	bool caught = false;
+	try
+	{
+		LanczosEigensolver<double> too_many(diagonal, n, n + 1);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+// Checks that A = U diag(s) V^T, with orthonormal U and V and s
+// descending
+template <typename SVD>
+static void checkSVD(const DenseMatrix<double>& A,
+	const SVD& svd,
+	const double tolerance)
+{
+	MathVector<double> s = svd.singularValues();
+	const DenseMatrix<double>& U = svd.leftVectors();
+	const DenseMatrix<double>& V = svd.rightVectors();
+	assert(U.rows() == A.rows() && V.rows() == A.cols());
+	assert(U.cols() == s.size() && V.cols() == s.size());
+
+	DenseMatrix<double> US = U;
+	for (size_t j = 0; j < s.size(); ++j)
+	{
+		US.colView(j).scale(s[j]);
+		if (j > 0)
+			assert(s[j - 1] >= s[j]);
+	}
+	DenseMatrix<double> USVt = product(US, TransposeOp::NoTranspose, V, TransposeOp::Transpose);
+	for (size_t i = 0; i < A.rows(); ++i)
+	{
+		for (size_t j = 0; j < A.cols(); ++j)
+		{
+			assert(std::abs(USVt.at(i, j) - A.at(i, j)) < tolerance);
+		}
+	}
+
+	DenseMatrix<double> UtU = product(U, TransposeOp::Transpose, U, TransposeOp::NoTranspose);
+	DenseMatrix<double> VtV = product(V, TransposeOp::Transpose, V, TransposeOp::NoTranspose);
+	for (size_t i = 0; i < s.size(); ++i)
+	{
+		for (size_t j = 0; j < s.size(); ++j)
+		{
+			assert(std::abs(UtU.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-12);
+			assert(std::abs(VtV.at(i, j) - (i == j ? 1.0 : 0.0)) < 1e-12);
+		}
+	}
+}
+
+void testDenseSVD()
+{
+	// A^T A = [25 20; 20 25], whose eigenvalues are 45 and 5
+	DenseMatrix<int> A1({ 3, 0, 4, 5 }, 2, 2, StorageType::RowMajor);
+	JacobiSVD<double> svd1(A1);
+	checkVectors(svd1.singularValues().getData(), { 3 * std::sqrt(5.0), std::sqrt(5.0) });
+	checkSVD(DenseMatrix<double>(A1.view()), svd1, 1e-12);
+
+	// Tall, reduced by QR first, and wide, decomposed through the
+	// transpose, with enough columns for rounds to run in parallel
+	size_t original_threads = getNumThreads();
+	setNumThreads(4);
+
+	auto random_matrix = [](const size_t rows, const size_t cols, const StorageType storage)
+		{
+			DenseMatrix<double> M(rows, cols, storage);
+			for (size_t i = 0; i < rows; ++i)
+			{
+				for (size_t j = 0; j < cols; ++j)
+				{
+					M.at(i, j) = 0.01 * (double)(rand() % 200) - 1.0;
+				}
+			}
+			return M;
+		};
+
+	DenseMatrix<double> tall = random_matrix(300, 120, StorageType::RowMajor);
+	JacobiSVD<double> svd_tall(tall);
+	checkSVD(tall, svd_tall, 1e-12);
+	assert(svd_tall.rank() == 120);
+
+	// Singular values are the square roots of the eigenvalues of A^T A
+	DenseMatrix<double> gram = product(tall, TransposeOp::Transpose, tall, TransposeOp::NoTranspose);
+	MathVector<double> eigen = SymmetricEigensolver<double>(gram, false).eigenvalues();
+	MathVector<double> s_tall = svd_tall.singularValues();
+	for (size_t j = 0; j < 120; ++j)
+	{
+		assert(std::abs(s_tall[j] * s_tall[j] - eigen[119 - j]) < 1e-10 * eigen[119]);
+	}
+
+	DenseMatrix<double> wide = random_matrix(40, 90, StorageType::ColumnMajor);
+	JacobiSVD<double> svd_wide(wide);
+	checkSVD(wide, svd_wide, 1e-12);
+
+	JacobiSVD<double> values_only(wide, false);
+	assert(!values_only.hasVectors() && svd_wide.hasVectors());
+	for (size_t j = 0; j < 40; ++j)
+	{
+		assert(std::abs(values_only.singularValues()[j] - svd_wide.singularValues()[j]) < 1e-12);
+	}
+
+	setNumThreads(original_threads);
+
+	// Rank one, x y^T, has the single singular value |x||y|
+	DenseMatrix<double> outer({ 1, 2, 3, 2, 4, 6, -1, -2, -3, 0, 0, 0 }, 4, 3, StorageType::RowMajor);
+	JacobiSVD<double> svd_outer(outer);
+	assert(svd_outer.rank() == 1);
+	assert(std::abs(svd_outer.singularValues()[0] - std::sqrt(6.0 * 14.0)) < 1e-12);
+	checkSVD(outer, svd_outer, 1e-12);
+
+	// An exactly zero singular value still gets a unit singular vector,
+	// orthogonal to the others
+	DenseMatrix<double> zero_col({ 1, 0, 2, 3, 0, 4, 5, 0, 6 }, 3, 3, StorageType::RowMajor);
+	JacobiSVD<double> svd_zero_col(zero_col);
+	assert(svd_zero_col.rank() == 2 && svd_zero_col.singularValues()[2] == 0);
+	checkSVD(zero_col, svd_zero_col, 1e-12);
+
+	// The centering matrix I - 11^T / 4 leaves its null vector (1, 1, 1, 1)
+	// spread over every coordinate, so no unit vector is mostly outside the
+	// range of U and completing it has to pick the best of them
+	DenseMatrix<double> centering(4, 4, StorageType::ColumnMajor);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (size_t j = 0; j < 4; ++j)
+		{
+			centering.at(i, j) = (i == j ? 1.0 : 0.0) - 0.25;
+		}
+	}
+	JacobiSVD<double> svd_centering(centering);
+	assert(svd_centering.rank() == 3);
+	checkSVD(centering, svd_centering, 1e-12);
+
+	// Columns scaled from 1 down to 1e-15; the product of the singular
+	// values matches |det A| closely only if the smallest of them is
+	// accurate to many digits
+	DenseMatrix<double> B = random_matrix(4, 4, StorageType::ColumnMajor);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		B.at(i, i) += 3;
+	}
+	double det = std::abs(LUFactorization<double>(B).determinant());
+	DenseMatrix<double> graded = B;
+	for (size_t j = 0; j < 4; ++j)
+	{
+		graded.colView(j).scale(std::pow(1e-5, (double)j));
+		det *= std::pow(1e-5, (double)j);
+	}
+	MathVector<double> s_graded = JacobiSVD<double>(graded).singularValues();
+	double product_of_values = s_graded[0] * s_graded[1] * s_graded[2] * s_graded[3];
+	assert(std::abs(product_of_values / det - 1) < 1e-10);
+
+	JacobiSVD<float> svd_float(DenseMatrix<float>({ 3, 0, 4, 5 }, 2, 2, StorageType::RowMajor));
+	assert(std::abs(svd_float.singularValues()[1] - std::sqrt(5.0f)) < 1e-5f);
+
+	// Exactly rank 10, so ten samples plus oversampling capture the whole
+	// range and the randomized decomposition is exact
+	DenseMatrix<double> X = random_matrix(500, 10, StorageType::ColumnMajor);
+	DenseMatrix<double> Y = random_matrix(10, 150, StorageType::ColumnMajor);
+	DenseMatrix<double> low_rank = X * Y;
+	RandomizedSVD<double> randomized(low_rank, 10);
+	checkSVD(low_rank, randomized, 1e-10);
+
+	MathVector<double> s_exact = JacobiSVD<double>(low_rank, false).singularValues();
+	for (size_t j = 0; j < 10; ++j)
+	{
+		assert(std::abs(randomized.singularValues()[j] - s_exact[j]) < 1e-10 * s_exact[0]);
+	}
+
+	// Singular values 2^-j, j < 30; a rank 5 approximation is accurate
+	// with subspace iteration, and much less so without
+	DenseMatrix<double> U_known = QRFactorization<double>(
+		random_matrix(400, 30, StorageType::ColumnMajor)).orthogonal();
+	DenseMatrix<double> V_known = QRFactorization<double>(
+		random_matrix(150, 30, StorageType::ColumnMajor)).orthogonal();
+	for (size_t j = 0; j < 30; ++j)
+	{
+		U_known.colView(j).scale(std::pow(0.5, (double)j));
+	}
+	DenseMatrix<double> decaying = product(U_known, TransposeOp::NoTranspose,
+		V_known, TransposeOp::Transpose);
+
+	RandomizedSVD<double> truncated(decaying, 5);
+	RandomizedSVD<double> no_iterations(decaying, 5, RANDOMIZED_SVD_OVERSAMPLING, 0);
+	assert(truncated.singularValues().size() == 5);
+	assert(truncated.leftVectors().cols() == 5 && truncated.rightVectors().rows() == 150);
+	double error = 0, error_no_iterations = 0;
+	for (size_t j = 0; j < 5; ++j)
+	{
+		double s_j = std::pow(0.5, (double)j);
+		error = std::max(error, std::abs(truncated.singularValues()[j] - s_j) / s_j);
+		error_no_iterations = std::max(error_no_iterations,
+			std::abs(no_iterations.singularValues()[j] - s_j) / s_j);
+	}
+	assert(error < 1e-12 && error < error_no_iterations);
+
+	bool caught = false;
+	try
+	{
+		RandomizedSVD<double> too_large(low_rank, 151);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
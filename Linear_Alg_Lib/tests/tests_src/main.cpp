@@ -2,6 +2,7 @@
 
 #include "../tests_include/math_vector_tests.h"
 #include "../tests_include/dense_matrix_tests.h"
+#include "../tests_include/sparse_matrix_tests.h"
 #include "../tests_include/benchmarks.h"
 
 // ------------------------------------------------------------------
@@ -26,6 +27,7 @@ int	main(int argc, char* argv[])
 	{
 		testMathVector();
 		testDenseMatrix();
+		testSparseMatrix();
 
 		std::cout << "All tests complete\n";
 	}
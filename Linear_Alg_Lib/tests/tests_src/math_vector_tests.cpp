@@ -19,10 +19,12 @@ void testMathVector()
 	testMathVectorEquals();
 	testMathVectorAdd();
 	testMathVectorSubtract();
+	testMathVectorExpressions();
 	testMathVectorDotProduct();
 	testMathVectorCrossProduct();
 	testMathVectorMagnitude();
 	testMathVectorNormalize();
+	testMathVectorSimdKernels();
 
 	std::cout << "MathVector tests complete\n";
 }
@@ -122,6 +124,48 @@ void testMathVectorSubtract()
 	assert(vec6.getData() == data6);
 }
 
+void testMathVectorExpressions()
+{
+	std::vector<int> data1{ 1, 2, 3, 4 };
+	std::vector<int> data2{ 4, 3, 2, 1 };
+	MathVector<int> vec1(data1);
+	MathVector<int> vec2(data2);
+	MathVector<int> vec3 = vec1 + 2 * vec2 - vec1 * 3;
+	std::vector<int> data3{ 6, 2, -2, -6 };
+	assert(vec3.getData() == data3);
+
+	// Strided views are read in place
+	std::vector<int> data4{ 1, 0, 2, 0, 3, 0, 4, 0 };
+	MathVector<int> vec4(data4);
+	VectorView<const int> strided(vec4.view().data(), 4, 2);
+	MathVector<int> vec5 = strided - vec1 + vec2;
+	assert(vec5.getData() == data2);
+
+	// Assignment and += overwrite in place
+	vec3 = vec3 + vec1;
+	std::vector<int> data6{ 7, 4, 1, -2 };
+	assert(vec3.getData() == data6);
+	vec3 += vec2;
+	vec3 -= 2 * vec1;
+	std::vector<int> data7{ 9, 3, -3, -9 };
+	assert(vec3.getData() == data7);
+
+	assert(vec3 == vec3 + vec1 - vec1);
+	assert(MathVector<int>(vec1 + vec2) == 5 * vec1 - 4 * vec1 + vec2);
+	assert(vec3 != vec3 + vec1);
+
+	bool caught = false;
+	try
+	{
+		MathVector<int> vec8 = vec1 + vec4;
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
 void testMathVectorDotProduct()
 {
 	std::vector<int> data1{ 0, 1, 0, 2, 2, 0 };
@@ -197,4 +241,104 @@ void testMathVectorNormalize()
 	std::vector<double> result3{ 0, 0, 0 };
 	MathVector<double> unit_vec3 = vec3.normalized();
 	checkVectors(result3, unit_vec3.getData());
-}
\ No newline at end of file
+}
+
+// Checks the vectorized kernels for one data type against the scalar
+// templates; values are small integers so floating point results are
+// exact regardless of summation order
+template <typename DataType>
+void checkSimdKernels()
+{
+	// Sizes cover empty input, partial registers, and every remainder
+	// after the unrolled loop for the widest registers
+	for (size_t n = 0; n <= 67; ++n)
+	{
+		std::vector<DataType> a(n), b(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			a[i] = static_cast<DataType>((i * 7) % 11) - 5;
+			b[i] = static_cast<DataType>((i * 3) % 13) - 6;
+		}
+
+		assert(dotKernel(a.data(), b.data(), n) ==
+			dotKernel<DataType>(a.data(), b.data(), n));
+
+		std::vector<DataType> out(n), expected(n);
+		addKernel(a.data(), b.data(), out.data(), n);
+		addKernel<DataType>(a.data(), b.data(), expected.data(), n);
+		assert(out == expected);
+
+		subtractKernel(a.data(), b.data(), out.data(), n);
+		subtractKernel<DataType>(a.data(), b.data(), expected.data(), n);
+		assert(out == expected);
+
+		out = b;
+		expected = b;
+		axpyKernel(static_cast<DataType>(3), a.data(), out.data(), n);
+		axpyKernel<DataType>(static_cast<DataType>(3), a.data(), expected.data(), n);
+		assert(out == expected);
+
+		// Output may alias an input
+		out = a;
+		addKernel(out.data(), b.data(), out.data(), n);
+		addKernel<DataType>(a.data(), b.data(), expected.data(), n);
+		assert(out == expected);
+
+		// Distinct indices into a vector twice as long, out of order
+		std::vector<size_t> indices(n);
+		std::vector<DataType> x(2 * n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			indices[i] = 2 * (n - 1 - i) + i % 2;
+		}
+		for (size_t i = 0; i < 2 * n; ++i)
+		{
+			x[i] = static_cast<DataType>((i * 5) % 9) - 4;
+		}
+
+		assert(sparseDotKernel(a.data(), indices.data(), x.data(), n) ==
+			sparseDotKernel<DataType>(a.data(), indices.data(), x.data(), n));
+
+		out = x;
+		expected = x;
+		sparseAxpyKernel(static_cast<DataType>(-2), a.data(), indices.data(), out.data(), n);
+		sparseAxpyKernel<DataType>(static_cast<DataType>(-2), a.data(), indices.data(),
+			expected.data(), n);
+		assert(out == expected);
+	}
+}
+
+void testMathVectorSimdKernels()
+{
+	SimdLevel original_level = activeSimdLevel();
+	int detected = static_cast<int>(detectedSimdLevel());
+
+	// Runs every instruction set the machine supports
+	for (int level = 0; level <= detected; ++level)
+	{
+		setSimdLevel(static_cast<SimdLevel>(level));
+		assert(activeSimdLevel() == static_cast<SimdLevel>(level));
+
+		checkSimdKernels<float>();
+		checkSimdKernels<double>();
+		checkSimdKernels<int32_t>();
+		checkSimdKernels<int64_t>();
+
+		// 64-bit products need all 64 bits, which the emulated multiplies
+		// on SSE2 and AVX2 build from 32-bit pieces
+		std::vector<int64_t> a{ 3000000000LL, -5, 1LL << 40, -7000000001LL, 9 };
+		std::vector<int64_t> b{ 3, 4000000000LL, -(1LL << 20), 2, -11 };
+		assert(dotKernel(a.data(), b.data(), a.size()) ==
+			dotKernel<int64_t>(a.data(), b.data(), a.size()));
+
+		MathVector<double> vec1(std::vector<double>{ 1.5, -2, 0, 4, 8, 1, 2, 3, 4 });
+		MathVector<double> vec2(std::vector<double>{ 2, 0.5, 7, -1, 1, 1, 1, 1, 1 });
+		assert(areEqual(dotProduct(vec1, vec2), 16.0));
+	}
+
+	// Requests above the detected level are clamped
+	setSimdLevel(SimdLevel::AVX512);
+	assert(activeSimdLevel() == detectedSimdLevel());
+
+	setSimdLevel(original_level);
+}
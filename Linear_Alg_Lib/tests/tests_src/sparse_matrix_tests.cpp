@@ -1,6 +1,7 @@
 #include "../tests_include/sparse_matrix_tests.h"
 
 #include <cassert>
+#include <cmath>
 #include "../tests_include/tests_utils.h"
 #include "../../include/linalg.h"
 
@@ -11,21 +12,569 @@ using namespace LinAlg;
 // ------------------------------------------------------------------
 
 // Runs all SparseMatrix tests
-// TODO, leaving SparseMatrix for now
-//void testSparseMatrix()
-//{
-//	std::cout << "Sparse matrix tests complete\n";
-//}
-//
-//void testSparseCtor()
-//{
-//	// Test ctor with three input vectors
-//	std::vector<int> data1{ 1, 1, 1 };
-//	std::vector<size_t> rows1{ 0, 1, 2 };
-//	std::vector<size_t> cols1{ 0, 1, 2 };
-//	SparseMatrix<int> mat1(data1, rows1, cols1, 3, 3);
-//	checkSparseMatrix(mat1, data1, rows1, cols1, 3, 3, 3);
-//
-//	std::vector<int> data2{ 1, 1, 1, 1 };
-//	std::vector<size_t> rows2{ 0, 0, 0, 0 };
-//}
\ No newline at end of file
+void testSparseMatrix()
+{
+	testSparseCtor();
+	testSparseAtRowCol();
+	testSparseAddRemoveRowCol();
+	testSparseSubMatrix();
+	testSparseCompressed();
+	testSparseCompressedParallel();
+	testSparseSpMV();
+	testSparseSpMVParallel();
+
+	std::cout << "SparseMatrix tests complete\n";
+}
+
+void testSparseCtor()
+{
+	// Test ctor with three input vectors
+	std::vector<int> data1{ 1, 1, 1 };
+	std::vector<size_t> rows1{ 0, 1, 2 };
+	std::vector<size_t> cols1{ 0, 1, 2 };
+	SparseMatrix<int> mat1(data1, rows1, cols1, 3, 3);
+	checkSparseMatrix(mat1, data1, rows1, cols1, 3, 3, 3);
+
+	// Duplicate positions are allowed
+	std::vector<int> data2{ 1, 1, 1, 1 };
+	std::vector<size_t> rows2{ 0, 0, 0, 0 };
+	std::vector<size_t> cols2{ 1, 1, 0, 1 };
+	SparseMatrix<int> mat2(data2, rows2, cols2, 1, 2);
+	checkSparseMatrix(mat2, data2, rows2, cols2, 4, 1, 2);
+
+	// Test ctor with a dense data vector; zeros are dropped, and the
+	// entries are stored in row major order either way
+	std::vector<int> dense_row{ 0, 2, 0,
+								3, 0, 4 };
+	SparseMatrix<int> mat3(dense_row, StorageType::RowMajor, 2, 3);
+	checkSparseMatrix(mat3, { 2, 3, 4 }, { 0, 1, 1 }, { 1, 0, 2 }, 3, 2, 3);
+
+	std::vector<int> dense_col{ 0, 3,
+								2, 0,
+								0, 4 };
+	SparseMatrix<int> mat4(dense_col, StorageType::ColumnMajor, 2, 3);
+	checkSparseMatrix(mat4, { 2, 3, 4 }, { 0, 1, 1 }, { 1, 0, 2 }, 3, 2, 3);
+
+	bool caught = false;
+	try
+	{
+		SparseMatrix<int> mat5(data1, rows1, { 0, 1 }, 3, 3);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		SparseMatrix<int> mat6(data1, rows1, { 0, 1, 3 }, 3, 3);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testSparseAtRowCol()
+{
+	// [ 0  5  0 ]
+	// [ 1  0  2 ], with the 5 split into two entries
+	SparseMatrix<int> mat({ 2, 1, 3, 2 }, { 0, 1, 0, 1 }, { 1, 0, 1, 2 }, 2, 3);
+	const SparseMatrix<int>& const_mat = mat;
+	assert(const_mat.at(0, 1) == 5);
+	assert(const_mat.at(0, 0) == 0);
+	assert(const_mat.at(1, 2) == 2);
+	assert(mat.getNumNonzero() == 4);
+
+	// The non-const version merges the duplicates into one entry
+	mat.at(0, 1) += 1;
+	assert(mat.at(0, 1) == 6);
+	assert(mat.getNumNonzero() == 3);
+
+	mat.at(1, 1) = 7;
+	assert(mat.getNumNonzero() == 4);
+	assert(const_mat.at(1, 1) == 7);
+
+	assert(mat.row(1) == MathVector<int>({ 1, 7, 2 }));
+	assert(mat.col(1) == MathVector<int>({ 6, 7 }));
+
+	mat.setRow(0, MathVector<int>({ 8, 0, 9 }));
+	assert(mat.row(0) == MathVector<int>({ 8, 0, 9 }));
+	assert(mat.getNumNonzero() == 5);
+
+	mat.setCol(2, MathVector<int>({ 0, 0 }));
+	assert(mat.col(2) == MathVector<int>({ 0, 0 }));
+	assert(mat.getNumNonzero() == 3);
+
+	mat.swapRows(0, 1);
+	assert(mat.row(0) == MathVector<int>({ 1, 7, 0 }));
+	assert(mat.row(1) == MathVector<int>({ 8, 0, 0 }));
+
+	mat.swapCols(0, 2);
+	assert(mat.row(0) == MathVector<int>({ 0, 7, 1 }));
+
+	mat.scaleRow(0, 2);
+	mat.scaleCol(2, 3);
+	assert(mat.row(0) == MathVector<int>({ 0, 14, 6 }));
+	assert(mat.row(1) == MathVector<int>({ 0, 0, 24 }));
+
+	bool caught = false;
+	try
+	{
+		const_mat.at(2, 0);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		mat.setRow(0, MathVector<int>({ 1, 2 }));
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testSparseAddRemoveRowCol()
+{
+	// [ 1  0 ]
+	// [ 0  2 ]
+	SparseMatrix<int> mat({ 1, 2 }, { 0, 1 }, { 0, 1 }, 2, 2);
+
+	mat.addRow(1, MathVector<int>({ 0, 3 }));
+	assert(mat.rows() == 3);
+	assert(mat.size() == 6);
+	assert(mat.row(1) == MathVector<int>({ 0, 3 }));
+	assert(mat.row(2) == MathVector<int>({ 0, 2 }));
+	assert(mat.getNumNonzero() == 3);
+
+	mat.addCol(0, MathVector<int>({ 4, 0, 5 }));
+	assert(mat.cols() == 3);
+	assert(mat.row(0) == MathVector<int>({ 4, 1, 0 }));
+	assert(mat.row(2) == MathVector<int>({ 5, 0, 2 }));
+
+	mat.removeRow(0);
+	assert(mat.rows() == 2);
+	assert(mat.row(0) == MathVector<int>({ 0, 0, 3 }));
+	assert(mat.row(1) == MathVector<int>({ 5, 0, 2 }));
+
+	mat.removeCol(2);
+	assert(mat.cols() == 2);
+	assert(mat.size() == 4);
+	assert(mat.row(1) == MathVector<int>({ 5, 0 }));
+	assert(mat.getNumNonzero() == 1);
+
+	// A matrix without rows takes its columns from the first row added
+	SparseMatrix<int> empty({}, {}, {}, 0, 0);
+	empty.addRow(0, MathVector<int>({ 0, 6, 0 }));
+	assert(empty.rows() == 1 && empty.cols() == 3);
+	assert(empty.at(0, 1) == 6);
+
+	bool caught = false;
+	try
+	{
+		mat.addRow(3, MathVector<int>({ 1, 1 }));
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		mat.removeCol(2);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testSparseSubMatrix()
+{
+	// [ 1  0  2  0 ]
+	// [ 0  3  0  4 ]
+	// [ 5  0  6  0 ]
+	std::vector<int> dense{ 1, 0, 2, 0,
+							0, 3, 0, 4,
+							5, 0, 6, 0 };
+	SparseMatrix<int> mat(dense, StorageType::RowMajor, 3, 4);
+
+	SparseMatrix<int> sub = mat.getSubMatrix(1, 3, 1, 3);
+	assert(sub.rows() == 2 && sub.cols() == 2);
+	assert(sub.row(0) == MathVector<int>({ 3, 0 }));
+	assert(sub.row(1) == MathVector<int>({ 0, 6 }));
+
+	mat.setSubMatrix(0, 2, 2, 4, SparseMatrix<int>({ 7 }, { 1 }, { 0 }, 2, 2));
+	assert(mat.row(0) == MathVector<int>({ 1, 0, 0, 0 }));
+	assert(mat.row(1) == MathVector<int>({ 0, 3, 7, 0 }));
+	assert(mat.row(2) == MathVector<int>({ 5, 0, 6, 0 }));
+
+	bool caught = false;
+	try
+	{
+		mat.getSubMatrix(0, 4, 0, 1);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		mat.setSubMatrix(0, 1, 0, 1, sub);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testSparseCompressed()
+{
+	// [ 1  0  2 ]
+	// [ 0  0  0 ]
+	// [ 3  4  0 ]
+	// [ 0  5  6 ], given out of order, with the 4 and 6 split into
+	// duplicates
+	std::vector<double> data{ 7, 1.5, -1, 3, 1, 5, 2.5, 2 };
+	std::vector<size_t> rows{ 3, 2, 3, 2, 0, 3, 2, 0 };
+	std::vector<size_t> cols{ 2, 1, 2, 0, 0, 1, 1, 2 };
+	SparseMatrix<double> coo(data, rows, cols, 4, 3);
+
+	CSRMatrix<double> csr(coo);
+	assert(csr.rows() == 4 && csr.cols() == 3);
+	assert(csr.getStorageType() == StorageType::RowMajor);
+	assert(csr.getNumNonzero() == 6);
+	assert(csr.getPointers() == std::vector<size_t>({ 0, 2, 2, 4, 6 }));
+	assert(csr.getIndices() == std::vector<size_t>({ 0, 2, 0, 1, 1, 2 }));
+	assert(csr.getData() == std::vector<double>({ 1, 2, 3, 4, 5, 6 }));
+	assert(csr.at(2, 1) == 4);
+	assert(csr.at(1, 1) == 0);
+	assert(csr.at(3, 0) == 0);
+
+	CSCMatrix<double> csc(coo);
+	assert(csc.numLines() == 3);
+	assert(csc.getPointers() == std::vector<size_t>({ 0, 2, 4, 6 }));
+	assert(csc.getIndices() == std::vector<size_t>({ 0, 2, 2, 3, 0, 3 }));
+	assert(csc.getData() == std::vector<double>({ 1, 3, 4, 5, 2, 6 }));
+
+	// Conversions between the two formats
+	CSCMatrix<double> csc_from_csr(csr);
+	assert(csc_from_csr.getPointers() == csc.getPointers());
+	assert(csc_from_csr.getIndices() == csc.getIndices());
+	assert(csc_from_csr.getData() == csc.getData());
+
+	CSRMatrix<double> csr_from_csc(csc);
+	assert(csr_from_csc.getIndices() == csr.getIndices());
+	assert(csr_from_csc.getData() == csr.getData());
+
+	// CSR arrays of a matrix are the CSC arrays of its transpose
+	CSCMatrix<double> csr_transposed = csr.transposed();
+	assert(csr_transposed.rows() == 3 && csr_transposed.cols() == 4);
+	assert(csr_transposed.at(1, 2) == 4);
+	assert(csr_transposed.at(2, 3) == 6);
+
+	const DenseMatrix<double> expected(
+		{ 1, 0, 2,
+		  0, 0, 0,
+		  3, 4, 0,
+		  0, 5, 6 }, 4, 3, StorageType::RowMajor);
+	assert(csr.toDenseMatrix() == expected);
+	assert(csc.toDenseMatrix() == expected.convertToColMajor());
+	assert(csc.toDenseMatrix().getStorageType() == StorageType::ColumnMajor);
+
+	SparseMatrix<double> coo_again = csr.toSparseMatrix();
+	assert(coo_again.getNumNonzero() == 6);
+	assert(coo_again.getRowIndices() == std::vector<size_t>({ 0, 0, 2, 2, 3, 3 }));
+	assert(CSRMatrix<double>(coo_again).getData() == csr.getData());
+
+	// Empty matrices and matrices without entries
+	CSRMatrix<double> no_entries(SparseMatrix<double>({}, {}, {}, 3, 2));
+	assert(no_entries.getPointers() == std::vector<size_t>({ 0, 0, 0, 0 }));
+	assert(no_entries.at(2, 1) == 0);
+	CSCMatrix<double> empty(SparseMatrix<double>({}, {}, {}, 0, 0));
+	assert(empty.getPointers() == std::vector<size_t>({ 0 }));
+
+	// Constructor from the arrays checks them
+	CSRMatrix<int> from_arrays({ 0, 1, 3 }, { 2, 0, 1 }, { 7, 8, 9 }, 2, 3);
+	assert(from_arrays.at(0, 2) == 7);
+	assert(from_arrays.at(1, 1) == 9);
+
+	bool caught = false;
+	try
+	{
+		CSRMatrix<int> unsorted({ 0, 2 }, { 1, 0 }, { 1, 1 }, 1, 2);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		CSRMatrix<int> out_of_bounds({ 0, 1 }, { 2 }, { 1 }, 1, 2);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		csr.at(0, 3);
+	}
+	catch (const OutOfBounds&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+// Large enough for the conversions to run on several threads; rows have
+// very different lengths, and every position appears about twice
+void testSparseCompressedParallel()
+{
+	const size_t m = 3000;
+	const size_t n = 500;
+	const size_t num_entries = 100000;
+
+	std::vector<int> data(num_entries);
+	std::vector<size_t> rows(num_entries);
+	std::vector<size_t> cols(num_entries);
+	std::vector<int> dense(m * n, 0);
+	for (size_t k = 0; k < num_entries; ++k)
+	{
+		// Row i gets about i / m of the entries of the last one
+		rows[k] = static_cast<size_t>(std::sqrt(static_cast<double>(rand() % (m * m))));
+		cols[k] = rand() % (n / 4) * 4;
+		data[k] = rand() % 9 - 4;
+		dense[rows[k] * n + cols[k]] += data[k];
+	}
+	SparseMatrix<int> coo(data, rows, cols, m, n);
+
+	ThreadPool pool(4);
+	CSRMatrix<int> csr(coo, pool);
+	CSCMatrix<int> csc(coo, pool);
+	ThreadPool serial_pool(1);
+	CSRMatrix<int> serial(coo, serial_pool);
+
+	assert(csr.getPointers() == serial.getPointers());
+	assert(csr.getIndices() == serial.getIndices());
+	assert(csr.getData() == serial.getData());
+	assert(csr.toDenseMatrix() == DenseMatrix<int>(dense, m, n, StorageType::RowMajor));
+	assert(csr.getNumNonzero() < num_entries);
+
+	for (size_t i = 0; i < m; ++i)
+	{
+		const std::vector<size_t>& pointers = csr.getPointers();
+		for (size_t p = pointers[i] + 1; p < pointers[i + 1]; ++p)
+		{
+			assert(csr.getIndices()[p - 1] < csr.getIndices()[p]);
+		}
+	}
+
+	CSCMatrix<int> csc_from_csr(csr, pool);
+	assert(csc_from_csr.getPointers() == csc.getPointers());
+	assert(csc_from_csr.getIndices() == csc.getIndices());
+	assert(csc_from_csr.getData() == csc.getData());
+
+	CSRMatrix<int> csr_from_csc(csc, pool);
+	assert(csr_from_csc.getIndices() == csr.getIndices());
+	assert(csr_from_csc.getData() == csr.getData());
+}
+
+void testSparseSpMV()
+{
+	// [ 1  0  2  0 ]
+	// [ 0  0  0  0 ]
+	// [ 0  3  0  4 ]
+	std::vector<double> data{ 4, 1, 3, 2 };
+	std::vector<size_t> rows{ 2, 0, 2, 0 };
+	std::vector<size_t> cols{ 3, 0, 1, 2 };
+	SparseMatrix<double> coo(data, rows, cols, 3, 4);
+	CSRMatrix<double> csr(coo);
+	CSCMatrix<double> csc(coo);
+
+	MathVector<double> x({ 1, 2, 3, 4 });
+	MathVector<double> x_t({ 1, 2, 3 });
+	const std::vector<double> expected{ 7, 0, 22 };
+	const std::vector<double> expected_t{ 1, 9, 2, 12 };
+
+	assert((csr * x).getData() == expected);
+	assert((csc * x).getData() == expected);
+	assert((coo * x).getData() == expected);
+	assert(product(csr, TransposeOp::Transpose, x_t).getData() == expected_t);
+	assert(product(csc, TransposeOp::Transpose, x_t).getData() == expected_t);
+	assert(product(coo, TransposeOp::Transpose, x_t).getData() == expected_t);
+
+	// y = 2 * A * x - y
+	std::vector<double> y{ 1, 1, 1 };
+	spmvParallel(csr, TransposeOp::NoTranspose, x.view(),
+		VectorView<double>(y.data(), 3), defaultThreadPool(), 2, -1);
+	assert(y == std::vector<double>({ 13, -1, 43 }));
+
+	y = { 1, 1, 1 };
+	spmvParallel(csc, TransposeOp::NoTranspose, x.view(),
+		VectorView<double>(y.data(), 3), defaultThreadPool(), 2, -1);
+	assert(y == std::vector<double>({ 13, -1, 43 }));
+
+	y = { 1, 1, 1 };
+	spmvParallel(coo, TransposeOp::NoTranspose, x.view(),
+		VectorView<double>(y.data(), 3), defaultThreadPool(), 2, -1);
+	assert(y == std::vector<double>({ 13, -1, 43 }));
+
+	// Old contents of y are never read when beta is 0
+	y = { NAN, NAN, NAN };
+	spmvParallel(csr, TransposeOp::NoTranspose, x.view(),
+		VectorView<double>(y.data(), 3), defaultThreadPool(), 1, 0);
+	assert(y == expected);
+
+	std::vector<double> y_t(4, NAN);
+	spmvParallel(csr, TransposeOp::Transpose, x_t.view(),
+		VectorView<double>(y_t.data(), 4), defaultThreadPool(), 1, 0);
+	assert(y_t == expected_t);
+
+	// Strided vectors, with x and y interleaved in the same array
+	std::vector<double> interleaved{ 1, 0, 2, 0, 3, 0, 4, 0 };
+	for (int k = 0; k < 2; ++k)
+	{
+		VectorView<double> y_view(interleaved.data() + 1, 3, 2);
+		ConstVectorView<double> x_view(interleaved.data(), 4, 2);
+		if (k == 0)
+			spmvParallel(csr, TransposeOp::NoTranspose, x_view, y_view, defaultThreadPool(), 1, 0);
+		else
+			spmvParallel(csc, TransposeOp::NoTranspose, x_view, y_view, defaultThreadPool(), 1, 0);
+		assert(interleaved == std::vector<double>({ 1, 7, 2, 0, 3, 22, 4, 0 }));
+		interleaved = { 1, 0, 2, 0, 3, 0, 4, 0 };
+	}
+
+	bool caught = false;
+	try
+	{
+		csr * x_t;
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+
+	caught = false;
+	try
+	{
+		product(coo, TransposeOp::Transpose, x);
+	}
+	catch (const InvalidDimensions&)
+	{
+		caught = true;
+	}
+	assert(caught);
+}
+
+void testSparseSpMVParallel()
+{
+	const size_t m = 2000;
+	const size_t n = 50000;
+	const size_t num_entries = 120000;
+
+	// Row i gets about (i + 1)^(-2/3) of the entries of row 0, which
+	// holds a tenth of them, and the last half of the rows are empty
+	std::vector<double> data(num_entries);
+	std::vector<size_t> rows(num_entries);
+	std::vector<size_t> cols(num_entries);
+	for (size_t k = 0; k < num_entries; ++k)
+	{
+		double u = static_cast<double>(rand() % 10000) / 10000;
+		rows[k] = static_cast<size_t>(m / 2 * u * u * u);
+		cols[k] = rand() % n;
+		data[k] = rand() % 9 - 4;
+	}
+	SparseMatrix<double> coo(data, rows, cols, m, n);
+	ThreadPool pool(4);
+	ThreadPool serial_pool(1);
+	CSRMatrix<double> csr(coo, pool);
+	CSCMatrix<double> csc(coo, pool);
+
+	std::vector<double> x(n), x_t(m);
+	for (size_t j = 0; j < n; ++j)
+		x[j] = rand() % 7 - 3;
+	for (size_t i = 0; i < m; ++i)
+		x_t[i] = rand() % 7 - 3;
+
+	// Integer valued data keeps every sum exact in any order
+	std::vector<double> expected(m, -1), expected_t(n, -1);
+	for (size_t k = 0; k < num_entries; ++k)
+	{
+		expected[rows[k]] += 2 * data[k] * x[cols[k]];
+		expected_t[cols[k]] += 2 * data[k] * x_t[rows[k]];
+	}
+
+	for (ThreadPool* p : { &pool, &serial_pool })
+	{
+		std::vector<double> y(m, 1), y_t(n, 1);
+		spmvParallel(csr, TransposeOp::NoTranspose, ConstVectorView<double>(x.data(), n),
+			VectorView<double>(y.data(), m), *p, 2, -1);
+		spmvParallel(csr, TransposeOp::Transpose, ConstVectorView<double>(x_t.data(), m),
+			VectorView<double>(y_t.data(), n), *p, 2, -1);
+		assert(y == expected);
+		assert(y_t == expected_t);
+
+		y.assign(m, 1);
+		y_t.assign(n, 1);
+		spmvParallel(csc, TransposeOp::NoTranspose, ConstVectorView<double>(x.data(), n),
+			VectorView<double>(y.data(), m), *p, 2, -1);
+		spmvParallel(csc, TransposeOp::Transpose, ConstVectorView<double>(x_t.data(), m),
+			VectorView<double>(y_t.data(), n), *p, 2, -1);
+		assert(y == expected);
+		assert(y_t == expected_t);
+
+		y.assign(m, 1);
+		y_t.assign(n, 1);
+		spmvParallel(coo, TransposeOp::NoTranspose, ConstVectorView<double>(x.data(), n),
+			VectorView<double>(y.data(), m), *p, 2, -1);
+		spmvParallel(coo, TransposeOp::Transpose, ConstVectorView<double>(x_t.data(), m),
+			VectorView<double>(y_t.data(), n), *p, 2, -1);
+		assert(y == expected);
+		assert(y_t == expected_t);
+	}
+
+	// Merge path splits row 0 between parts, and every part gets the same
+	// share of lines and entries
+	const std::vector<size_t>& pointers = csr.getPointers();
+	const size_t num_parts = 16;
+	std::vector<MergePathCoordinate> bounds = mergePathPartition(pointers, num_parts);
+	const size_t length = m + csr.getNumNonzero();
+	assert(pointers[1] > length / num_parts);
+	assert(bounds.front().line == 0 && bounds.front().entry == 0);
+	assert(bounds.back().line == m && bounds.back().entry == csr.getNumNonzero());
+	assert(bounds[1].line == 0 && bounds[1].entry > 0);
+	for (size_t part = 0; part < num_parts; ++part)
+	{
+		const MergePathCoordinate& first = bounds[part];
+		const MergePathCoordinate& last = bounds[part + 1];
+		assert(first.line <= last.line && first.entry <= last.entry);
+		assert(last.line + last.entry - first.line - first.entry <= length / num_parts + 1);
+		assert(pointers[last.line] <= last.entry);
+		assert(last.line == m || last.entry <= pointers[last.line + 1]);
+	}
+}